@@ -0,0 +1,72 @@
+// *****************************************************
+// * Benchmark.h and Benchmark.cpp - Alan Bolger, 2021 *
+// *****************************************************
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+
+namespace ab
+{
+	// Small timing harness used by the headless benchmarks.
+	// Each benchmark is run untimed a few times first (to warm the caches and fault in memory), then timed
+	// a number of times, and the median, 99th percentile, fastest and mean times are reported.
+	// Every result is also recorded so the whole run can be written out as JSON and compared between builds.
+	class Benchmark
+	{
+	public:
+		static void header(const std::string &t_title);
+		static double run(const std::string &t_name, int t_runs, long long t_opsPerRun, std::function<void()> t_function);
+		static double runOnce(const std::string &t_name, long long t_ops, std::function<void()> t_function);
+		static void report(const std::string &t_name, double t_value, const std::string &t_unit);
+		static bool check(const std::string &t_name, bool t_passed);
+		static int getFailures();
+		static void setWarmupRuns(int t_runs);
+		static void setMinimumRuns(int t_runs);
+		static bool writeJson(const std::string &t_path);
+
+		/// <summary>
+		/// Stops the compiler from optimising away a value that is otherwise unused.
+		/// </summary>
+		/// <param name="t_value">The value to keep.</param>
+		template <typename T>
+		static void keep(const T &t_value)
+		{
+			static volatile T s_sink;
+			s_sink = t_value;
+		}
+
+	private:
+		// One line of the results: a timing, a reported value or a check
+		struct Result
+		{
+			std::string section;
+			std::string name;
+			std::string unit;
+			int runs; // Timings only
+			double median; // Timings only
+			double p99; // Timings only
+			double fastest; // Timings only
+			double mean; // Timings only, reported values use this for their value
+			bool passed; // Checks only
+		};
+
+		static int s_failures;
+		static int s_warmupRuns;
+		static int s_minimumRuns;
+		static std::string s_section;
+		static std::vector<Result> s_timings;
+		static std::vector<Result> s_values;
+		static std::vector<Result> s_checks;
+
+		static double time(int t_warmupRuns, const std::string &t_name, int t_runs, long long t_opsPerRun, std::function<void()> &t_function);
+	};
+}
+
+#endif // !BENCHMARK_H
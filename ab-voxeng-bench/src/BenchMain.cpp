@@ -0,0 +1,98 @@
+// *******************************************************************************
+// * BenchMain.cpp - Alan Bolger, 2021											 *
+// * Headless benchmarks for the voxel engine.									 *
+// * Only the world, terrain, noise and model loading code is linked, no window	 *
+// * or GPU needed.																 *
+// * Usage: ab-voxeng-bench [--json results.json] [--stats stats.json]			 *
+// *                        [--warmup runs] [--runs runs]						 *
+// *                        [--path camera-path.txt]							 *
+// *******************************************************************************
+
+#include "Benchmark.h"
+#include "Stats.h"
+
+#include <cstdlib>
+#include <cstring>
+
+void chunkBenchmark();
+void meshBenchmark();
+void jobBenchmark();
+void terrainBenchmark();
+void streamBenchmark();
+void regionBenchmark();
+void modelBenchmark();
+void profilerBenchmark();
+void statsBenchmark();
+void frameClockBenchmark();
+bool flythroughBenchmark(const char *t_pathFile);
+
+int main(int argc, char *argv[])
+{
+	const char *f_jsonPath = nullptr;
+	const char *f_statsPath = nullptr;
+	const char *f_cameraPath = nullptr; // Flown by flythroughBenchmark(), instead of its own path
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "--json") == 0)
+		{
+			f_jsonPath = argv[i + 1];
+		}
+		else if (std::strcmp(argv[i], "--stats") == 0)
+		{
+			f_statsPath = argv[i + 1];
+		}
+		else if (std::strcmp(argv[i], "--path") == 0)
+		{
+			f_cameraPath = argv[i + 1];
+		}
+		else if (std::strcmp(argv[i], "--warmup") == 0)
+		{
+			ab::Benchmark::setWarmupRuns(std::atoi(argv[i + 1]));
+		}
+		else if (std::strcmp(argv[i], "--runs") == 0)
+		{
+			ab::Benchmark::setMinimumRuns(std::atoi(argv[i + 1]));
+		}
+		else
+		{
+			std::cout << "Unknown option " << argv[i] << std::endl;
+			return 2;
+		}
+	}
+
+	std::cout << "Voxel Engine Benchmarks" << std::endl;
+	std::cout << "----------------------------" << std::endl;
+
+	chunkBenchmark();
+	meshBenchmark();
+	jobBenchmark();
+	terrainBenchmark();
+	streamBenchmark();
+	regionBenchmark();
+	modelBenchmark();
+	profilerBenchmark();
+	statsBenchmark();
+	frameClockBenchmark();
+
+	if (!flythroughBenchmark(f_cameraPath))
+	{
+		return 1;
+	}
+
+	if (f_jsonPath != nullptr && !ab::Benchmark::writeJson(f_jsonPath))
+	{
+		std::cout << "Couldn't write " << f_jsonPath << std::endl;
+		return 1;
+	}
+
+	// The stats registry, as it was left by the headless run in statsBenchmark()
+	if (f_statsPath != nullptr && !ab::Stats::writeJson(f_statsPath))
+	{
+		std::cout << "Couldn't write " << f_statsPath << std::endl;
+		return 1;
+	}
+
+	// Fail the run if any of the correctness checks failed
+	return ab::Benchmark::getFailures() == 0 ? 0 : 1;
+}
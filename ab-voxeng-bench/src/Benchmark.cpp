@@ -0,0 +1,246 @@
+#include "Benchmark.h"
+#include "Json.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+int ab::Benchmark::s_failures = 0;
+int ab::Benchmark::s_warmupRuns = 1;
+int ab::Benchmark::s_minimumRuns = 1;
+std::string ab::Benchmark::s_section;
+std::vector<ab::Benchmark::Result> ab::Benchmark::s_timings;
+std::vector<ab::Benchmark::Result> ab::Benchmark::s_values;
+std::vector<ab::Benchmark::Result> ab::Benchmark::s_checks;
+
+/// <summary>
+/// Prints a section header. Results are recorded under the latest section.
+/// </summary>
+/// <param name="t_title">The title of the section.</param>
+void ab::Benchmark::header(const std::string &t_title)
+{
+	s_section = t_title;
+
+	std::cout << std::endl;
+	std::cout << "=== " << t_title << " ===" << std::endl;
+}
+
+/// <summary>
+/// Times a function a number of times (after the warmup runs) and prints the result.
+/// </summary>
+/// <param name="t_name">The name of the benchmark.</param>
+/// <param name="t_runs">How many times the function is timed (at least the minimum set with setMinimumRuns()).</param>
+/// <param name="t_opsPerRun">How many operations a single run performs (used for ns/op).</param>
+/// <param name="t_function">The function to time.</param>
+/// <returns>The median time per operation in nanoseconds.</returns>
+double ab::Benchmark::run(const std::string &t_name, int t_runs, long long t_opsPerRun, std::function<void()> t_function)
+{
+	return time(s_warmupRuns, t_name, std::max(t_runs, s_minimumRuns), t_opsPerRun, t_function);
+}
+
+/// <summary>
+/// Times a function that only gives a meaningful time the first time it's run (e.g. a cold start), so it isn't warmed up or repeated.
+/// </summary>
+/// <param name="t_name">The name of the benchmark.</param>
+/// <param name="t_ops">How many operations the function performs (used for ns/op).</param>
+/// <param name="t_function">The function to time.</param>
+/// <returns>The time per operation in nanoseconds.</returns>
+double ab::Benchmark::runOnce(const std::string &t_name, long long t_ops, std::function<void()> t_function)
+{
+	return time(0, t_name, 1, t_ops, t_function);
+}
+
+/// <summary>
+/// Runs a function untimed a number of times, then times it a number of times and prints and records the result.
+/// </summary>
+/// <param name="t_warmupRuns">How many times the function is run before it's timed.</param>
+/// <param name="t_name">The name of the benchmark.</param>
+/// <param name="t_runs">How many times the function is timed.</param>
+/// <param name="t_opsPerRun">How many operations a single run performs (used for ns/op).</param>
+/// <param name="t_function">The function to time.</param>
+/// <returns>The median time per operation in nanoseconds.</returns>
+double ab::Benchmark::time(int t_warmupRuns, const std::string &t_name, int t_runs, long long t_opsPerRun, std::function<void()> &t_function)
+{
+	for (int i = 0; i < t_warmupRuns; ++i)
+	{
+		t_function();
+	}
+
+	std::vector<double> f_times(t_runs);
+
+	for (int i = 0; i < t_runs; ++i)
+	{
+		auto f_start = std::chrono::steady_clock::now();
+		t_function();
+		auto f_end = std::chrono::steady_clock::now();
+
+		f_times[i] = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(f_end - f_start).count() / (double)t_opsPerRun;
+	}
+
+	std::sort(f_times.begin(), f_times.end());
+
+	// The 99th percentile is the nearest rank, so it's the slowest run until there are 100 or more
+	Result f_result = {};
+	f_result.section = s_section;
+	f_result.name = t_name;
+	f_result.unit = "ns/op";
+	f_result.runs = t_runs;
+	f_result.median = t_runs % 2 == 1 ? f_times[t_runs / 2] : (f_times[t_runs / 2 - 1] + f_times[t_runs / 2]) / 2.0;
+	f_result.p99 = f_times[(std::size_t)std::ceil(0.99 * t_runs) - 1];
+	f_result.fastest = f_times[0];
+
+	for (double f_time : f_times)
+	{
+		f_result.mean += f_time / t_runs;
+	}
+
+	s_timings.push_back(f_result);
+
+	std::cout << "  " << std::left << std::setw(44) << t_name << std::right
+		<< std::fixed << std::setprecision(2)
+		<< std::setw(12) << f_result.median << " ns/op (median)"
+		<< std::setw(12) << f_result.p99 << " (p99)"
+		<< std::setw(12) << f_result.fastest << " (fastest)" << std::endl;
+
+	return f_result.median;
+}
+
+/// <summary>
+/// Prints a single named value.
+/// </summary>
+/// <param name="t_name">The name of the value.</param>
+/// <param name="t_value">The value.</param>
+/// <param name="t_unit">The unit the value is in.</param>
+void ab::Benchmark::report(const std::string &t_name, double t_value, const std::string &t_unit)
+{
+	Result f_result = {};
+	f_result.section = s_section;
+	f_result.name = t_name;
+	f_result.unit = t_unit;
+	f_result.mean = t_value;
+	s_values.push_back(f_result);
+
+	std::cout << "  " << std::left << std::setw(44) << t_name << std::right
+		<< std::fixed << std::setprecision(2)
+		<< std::setw(14) << t_value << " " << t_unit << std::endl;
+}
+
+/// <summary>
+/// Prints the result of a correctness check that a benchmark relies on.
+/// </summary>
+/// <param name="t_name">The name of the check.</param>
+/// <param name="t_passed">True if the check passed.</param>
+/// <returns>The value of t_passed.</returns>
+bool ab::Benchmark::check(const std::string &t_name, bool t_passed)
+{
+	Result f_result = {};
+	f_result.section = s_section;
+	f_result.name = t_name;
+	f_result.passed = t_passed;
+	s_checks.push_back(f_result);
+
+	std::cout << "  " << std::left << std::setw(44) << t_name << std::right
+		<< std::setw(14) << (t_passed ? "passed" : "FAILED") << std::endl;
+
+	if (!t_passed)
+	{
+		s_failures++;
+	}
+
+	return t_passed;
+}
+
+/// <summary>
+/// Gets the number of checks that have failed.
+/// </summary>
+/// <returns>The number of failed checks.</returns>
+int ab::Benchmark::getFailures()
+{
+	return s_failures;
+}
+
+/// <summary>
+/// Sets how many times each benchmark is run before it's timed.
+/// </summary>
+/// <param name="t_runs">The number of warmup runs (1 by default).</param>
+void ab::Benchmark::setWarmupRuns(int t_runs)
+{
+	s_warmupRuns = std::max(t_runs, 0);
+}
+
+/// <summary>
+/// Sets the fewest times a benchmark is timed, so slow benchmarks can be given enough runs for a steady median and p99.
+/// </summary>
+/// <param name="t_runs">The minimum number of timed runs (1 by default).</param>
+void ab::Benchmark::setMinimumRuns(int t_runs)
+{
+	s_minimumRuns = std::max(t_runs, 1);
+}
+
+/// <summary>
+/// Writes every timing, reported value and check so far to a JSON file.
+/// </summary>
+/// <param name="t_path">The file to write.</param>
+/// <returns>True if the file was written.</returns>
+bool ab::Benchmark::writeJson(const std::string &t_path)
+{
+	std::ofstream f_file(t_path);
+
+	if (!f_file)
+	{
+		return false;
+	}
+
+	f_file << "{\n\t\"warmupRuns\": " << s_warmupRuns << ",\n\t\"failures\": " << s_failures << ",\n\t\"benchmarks\": [";
+
+	for (std::size_t i = 0; i < s_timings.size(); ++i)
+	{
+		const Result &f_result = s_timings[i];
+		f_file << (i == 0 ? "\n" : ",\n") << "\t\t{ \"section\": ";
+		ab::Json::writeString(f_file, f_result.section);
+		f_file << ", \"name\": ";
+		ab::Json::writeString(f_file, f_result.name);
+		f_file << ", \"unit\": \"ns/op\", \"runs\": " << f_result.runs << ", \"median\": ";
+		ab::Json::writeNumber(f_file, f_result.median);
+		f_file << ", \"p99\": ";
+		ab::Json::writeNumber(f_file, f_result.p99);
+		f_file << ", \"fastest\": ";
+		ab::Json::writeNumber(f_file, f_result.fastest);
+		f_file << ", \"mean\": ";
+		ab::Json::writeNumber(f_file, f_result.mean);
+		f_file << " }";
+	}
+
+	f_file << "\n\t],\n\t\"values\": [";
+
+	for (std::size_t i = 0; i < s_values.size(); ++i)
+	{
+		const Result &f_result = s_values[i];
+		f_file << (i == 0 ? "\n" : ",\n") << "\t\t{ \"section\": ";
+		ab::Json::writeString(f_file, f_result.section);
+		f_file << ", \"name\": ";
+		ab::Json::writeString(f_file, f_result.name);
+		f_file << ", \"value\": ";
+		ab::Json::writeNumber(f_file, f_result.mean);
+		f_file << ", \"unit\": ";
+		ab::Json::writeString(f_file, f_result.unit);
+		f_file << " }";
+	}
+
+	f_file << "\n\t],\n\t\"checks\": [";
+
+	for (std::size_t i = 0; i < s_checks.size(); ++i)
+	{
+		const Result &f_result = s_checks[i];
+		f_file << (i == 0 ? "\n" : ",\n") << "\t\t{ \"section\": ";
+		ab::Json::writeString(f_file, f_result.section);
+		f_file << ", \"name\": ";
+		ab::Json::writeString(f_file, f_result.name);
+		f_file << ", \"passed\": " << (f_result.passed ? "true" : "false") << " }";
+	}
+
+	f_file << "\n\t]\n}\n";
+
+	return (bool)f_file;
+}
@@ -0,0 +1,1066 @@
+#include "Benchmark.h"
+#include "Chunk.h"
+#include "ChunkPool.h"
+#include "ChunkTable.h"
+#include "World.h"
+#include "Terrain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace
+{
+	const int CHUNK_SIZE = CHUNK_WIDTH * CHUNK_HEIGHT * CHUNK_DEPTH;
+	const int CHUNK_COUNT = 1024;
+	const int OPS = 1 << 20;
+
+	// The previous chunk layout (one byte per voxel), kept here as the reference
+	struct DenseChunk
+	{
+		std::vector<char> voxels = std::vector<char>(CHUNK_SIZE, 0);
+	};
+
+	/// <summary>
+	/// Fills a chunk with a terrain-like pattern using the specified number of voxel types.
+	/// The bottom half is solid and the top half is air.
+	/// </summary>
+	template <typename T>
+	void fill(T &t_chunk, int t_types, void (*t_set)(T &, int, char))
+	{
+		for (int i = 0; i < CHUNK_SIZE; ++i)
+		{
+			Indices f_index = Utility::at(i, CHUNK_HEIGHT, CHUNK_DEPTH);
+
+			if (f_index.y < CHUNK_HEIGHT / 2 && t_types > 1)
+			{
+				t_set(t_chunk, i, (char)(1 + (f_index.x + f_index.z) % (t_types - 1)));
+			}
+		}
+	}
+
+	void setDense(DenseChunk &t_chunk, int t_index, char t_type) { t_chunk.voxels[t_index] = t_type; }
+	void setPalette(Chunk &t_chunk, int t_index, char t_type) { t_chunk.setVoxel(t_index, t_type); }
+
+	/// <summary>
+	/// Checks that a palette chunk has the same voxels as a dense one.
+	/// </summary>
+	bool sameVoxels(const Chunk &t_chunk, const DenseChunk &t_dense)
+	{
+		for (int i = 0; i < CHUNK_SIZE; ++i)
+		{
+			if (t_chunk.getVoxel(i) != t_dense.voxels[i])
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// Writes random voxels into a palette chunk and a dense reference, with more voxel types each time so the chunk widens
+	/// from 1 bit to 2, 4 and 8, and compares every voxel whenever it widens.
+	/// </summary>
+	void widenChecks()
+	{
+		Chunk f_chunk;
+		DenseChunk f_dense;
+		std::mt19937 f_random(97531);
+		const int f_types[4] = { 2, 4, 16, 256 };
+		int f_bits = f_chunk.getBitsPerIndex();
+		int f_widened = 0;
+		bool f_same = true;
+
+		for (int f_count : f_types)
+		{
+			for (int i = 0; i < 4 * CHUNK_SIZE; ++i)
+			{
+				int f_index = f_random() % CHUNK_SIZE;
+				char f_type = (char)(f_random() % f_count);
+
+				f_chunk.setVoxel(f_index, f_type);
+				f_dense.voxels[f_index] = f_type;
+
+				if (f_chunk.getBitsPerIndex() != f_bits)
+				{
+					f_same &= f_chunk.getBitsPerIndex() == f_bits * 2 && sameVoxels(f_chunk, f_dense);
+					f_bits = f_chunk.getBitsPerIndex();
+					f_widened++;
+				}
+			}
+
+			f_same &= sameVoxels(f_chunk, f_dense);
+		}
+
+		ab::Benchmark::check("Palette chunks keep voxels as they widen", f_same && f_widened == 3 && f_bits == 8);
+	}
+
+	/// <summary>
+	/// Checks a chunk's solid count against a full scan of its voxels after random writes, including air written over air,
+	/// voxels written with the type they already have, and clearing the whole chunk again.
+	/// </summary>
+	void solidCountChecks()
+	{
+		Chunk f_chunk;
+		std::mt19937 f_random(24680);
+		bool f_same = true;
+
+		auto f_scan = [&]()
+		{
+			int f_solid = 0;
+
+			for (int i = 0; i < CHUNK_SIZE; ++i)
+			{
+				f_solid += f_chunk.getVoxel(i) != BLOCK_AIR;
+			}
+
+			return f_solid == f_chunk.getSolidCount() && f_chunk.checkIsEmpty() == (f_solid == 0);
+		};
+
+		for (int f_round = 0; f_round < 16; ++f_round)
+		{
+			for (int i = 0; i < CHUNK_SIZE; ++i)
+			{
+				int f_index = f_random() % CHUNK_SIZE;
+				char f_type;
+
+				switch (f_random() % 4)
+				{
+				case 0: f_type = BLOCK_AIR; break; // Often over air already
+				case 1: f_type = f_chunk.getVoxel(f_index); break; // The same type again
+				default: f_type = (char)(f_random() % BLOCK_TYPE_COUNT); break;
+				}
+
+				f_chunk.setVoxel(f_index, f_type);
+			}
+
+			f_same &= f_scan();
+		}
+
+		for (int i = 0; i < CHUNK_SIZE; ++i)
+		{
+			f_chunk.setVoxel(i, BLOCK_AIR);
+		}
+
+		ab::Benchmark::check("Solid counts match a full scan", f_same && f_scan() && f_chunk.checkIsEmpty());
+	}
+
+	/// <summary>
+	/// Compares get/set throughput of the dense and palette layouts for a number of voxel types.
+	/// </summary>
+	void throughput(int t_types)
+	{
+		std::vector<DenseChunk> f_dense(CHUNK_COUNT);
+		std::vector<Chunk> f_palette(CHUNK_COUNT);
+
+		for (int i = 0; i < CHUNK_COUNT; ++i)
+		{
+			fill(f_dense[i], t_types, setDense);
+			fill(f_palette[i], t_types, setPalette);
+		}
+
+		// Random access pattern shared by both layouts
+		std::mt19937 f_random(12345);
+		std::vector<int> f_chunks(OPS);
+		std::vector<int> f_voxels(OPS);
+
+		for (int i = 0; i < OPS; ++i)
+		{
+			f_chunks[i] = f_random() % CHUNK_COUNT;
+			f_voxels[i] = f_random() % CHUNK_SIZE;
+		}
+
+		std::string f_suffix = " (" + std::to_string(t_types) + " types)";
+
+		ab::Benchmark::report("Dense bytes/chunk" + f_suffix, (double)CHUNK_SIZE, "bytes");
+		ab::Benchmark::report("Palette bytes/chunk" + f_suffix, (double)f_palette[0].getMemoryUsage(), "bytes");
+
+		ab::Benchmark::run("Dense sequential get" + f_suffix, 5, (long long)CHUNK_COUNT * CHUNK_SIZE, [&]()
+		{
+			int f_sum = 0;
+
+			for (int c = 0; c < CHUNK_COUNT; ++c)
+			{
+				for (int i = 0; i < CHUNK_SIZE; ++i)
+				{
+					f_sum += f_dense[c].voxels[i];
+				}
+			}
+
+			ab::Benchmark::keep(f_sum);
+		});
+
+		ab::Benchmark::run("Palette sequential get" + f_suffix, 5, (long long)CHUNK_COUNT * CHUNK_SIZE, [&]()
+		{
+			int f_sum = 0;
+
+			for (int c = 0; c < CHUNK_COUNT; ++c)
+			{
+				for (int i = 0; i < CHUNK_SIZE; ++i)
+				{
+					f_sum += f_palette[c].getVoxel(i);
+				}
+			}
+
+			ab::Benchmark::keep(f_sum);
+		});
+
+		ab::Benchmark::run("Dense random get" + f_suffix, 5, OPS, [&]()
+		{
+			int f_sum = 0;
+
+			for (int i = 0; i < OPS; ++i)
+			{
+				f_sum += f_dense[f_chunks[i]].voxels[f_voxels[i]];
+			}
+
+			ab::Benchmark::keep(f_sum);
+		});
+
+		ab::Benchmark::run("Palette random get" + f_suffix, 5, OPS, [&]()
+		{
+			int f_sum = 0;
+
+			for (int i = 0; i < OPS; ++i)
+			{
+				f_sum += f_palette[f_chunks[i]].getVoxel(f_voxels[i]);
+			}
+
+			ab::Benchmark::keep(f_sum);
+		});
+
+		ab::Benchmark::run("Dense random set" + f_suffix, 5, OPS, [&]()
+		{
+			for (int i = 0; i < OPS; ++i)
+			{
+				f_dense[f_chunks[i]].voxels[f_voxels[i]] = (char)(1 + i % t_types);
+			}
+		});
+
+		ab::Benchmark::run("Palette random set" + f_suffix, 5, OPS, [&]()
+		{
+			for (int i = 0; i < OPS; ++i)
+			{
+				f_palette[f_chunks[i]].setVoxel(f_voxels[i], (char)(1 + i % t_types));
+			}
+		});
+	}
+
+	/// <summary>
+	/// Casts picking rays into a world from random points above the terrain.
+	/// </summary>
+	void raycasts(World *t_world)
+	{
+		const int f_rays = 1 << 14;
+
+		std::mt19937 f_random(12345);
+		std::uniform_real_distribution<float> f_unit(-1.0f, 1.0f);
+		std::vector<glm::vec3> f_origins(f_rays);
+		std::vector<glm::vec3> f_directions(f_rays);
+
+		for (int i = 0; i < f_rays; ++i)
+		{
+			f_origins[i] = glm::vec3((f_unit(f_random) + 1.0f) * WORLD_WIDTH / 2, 80.0f, (f_unit(f_random) + 1.0f) * WORLD_DEPTH / 2);
+			f_directions[i] = glm::vec3(f_unit(f_random), -1.0f, f_unit(f_random));
+		}
+
+		int f_hits = 0;
+
+		ab::Benchmark::run("World raycast (" + std::to_string((int)PICK_DISTANCE) + " voxels)", 5, f_rays, [&]()
+		{
+			RaycastHit f_hit;
+			f_hits = 0;
+
+			for (int i = 0; i < f_rays; ++i)
+			{
+				f_hits += t_world->raycast(f_origins[i], f_directions[i], PICK_DISTANCE, f_hit);
+			}
+		});
+
+		ab::Benchmark::report("World raycast hits", 100.0 * f_hits / f_rays, "%");
+	}
+
+	/// <summary>
+	/// Casts a ray the slow way, for checking World::raycast(). Marches along the ray in quarter voxel steps and tests every
+	/// solid voxel that each step's bounding box touches against the ray, so even voxels whose corners the ray only clips are found.
+	/// Voxels are unit cubes centred on their positions.
+	/// </summary>
+	bool bruteRaycast(World &t_world, const glm::vec3 &t_origin, const glm::vec3 &t_direction, float t_maxDistance, RaycastHit &t_hit)
+	{
+		const double f_step = 0.25;
+		glm::dvec3 f_origin(t_origin);
+		glm::dvec3 f_direction = glm::normalize(glm::dvec3(t_direction));
+		bool f_found = false;
+		double f_nearest = 0.0;
+
+		for (double t = 0.0; t <= t_maxDistance && !f_found; t += f_step)
+		{
+			glm::dvec3 a = f_origin + f_direction * t;
+			glm::dvec3 b = f_origin + f_direction * std::min(t + f_step, (double)t_maxDistance);
+			glm::ivec3 f_low = glm::ivec3(glm::floor(glm::min(a, b) + 0.5));
+			glm::ivec3 f_high = glm::ivec3(glm::floor(glm::max(a, b) + 0.5));
+
+			for (int x = f_low.x; x <= f_high.x; ++x)
+			{
+				for (int y = f_low.y; y <= f_high.y; ++y)
+				{
+					for (int z = f_low.z; z <= f_high.z; ++z)
+					{
+						char f_type = t_world.getVoxel(x, y, z);
+
+						if (f_type == BLOCK_AIR)
+						{
+							continue;
+						}
+
+						// Where the ray enters and leaves the voxel, and the axis it enters through
+						glm::ivec3 f_voxel(x, y, z);
+						double f_enter = -1.0e30;
+						double f_exit = 1.0e30;
+						int f_axis = -1;
+
+						for (int i = 0; i < 3; ++i)
+						{
+							if (f_direction[i] == 0.0)
+							{
+								f_exit = f_origin[i] < f_voxel[i] - 0.5 || f_origin[i] >= f_voxel[i] + 0.5 ? -1.0 : f_exit;
+								continue;
+							}
+
+							double f_near = (f_voxel[i] - 0.5 - f_origin[i]) / f_direction[i];
+							double f_far = (f_voxel[i] + 0.5 - f_origin[i]) / f_direction[i];
+
+							if (f_near > f_far)
+							{
+								std::swap(f_near, f_far);
+							}
+
+							if (f_near > f_enter)
+							{
+								f_enter = f_near;
+								f_axis = i;
+							}
+
+							f_exit = std::min(f_exit, f_far);
+						}
+
+						if (f_exit < 0.0 || f_enter > f_exit || f_enter > t_maxDistance || (f_found && std::max(f_enter, 0.0) >= f_nearest))
+						{
+							continue;
+						}
+
+						// A ray that starts inside a voxel has no face normal
+						glm::ivec3 f_normal(0);
+
+						if (f_enter > 0.0)
+						{
+							f_normal[f_axis] = f_direction[f_axis] > 0.0 ? -1 : 1;
+						}
+
+						f_found = true;
+						f_nearest = std::max(f_enter, 0.0);
+						t_hit.voxel = { x, y, z };
+						t_hit.previous = { x + f_normal.x, y + f_normal.y, z + f_normal.z };
+						t_hit.normal = { f_normal.x, f_normal.y, f_normal.z };
+						t_hit.distance = (float)f_nearest;
+						t_hit.type = f_type;
+					}
+				}
+			}
+		}
+
+		return f_found;
+	}
+
+	/// <summary>
+	/// Checks World::raycast() against bruteRaycast() in a world of scattered voxels where most chunks are missing, with rays in
+	/// every direction (including straight along each axis), rays that start far away and cross many missing chunks, and rays that miss.
+	/// </summary>
+	void raycastChecks()
+	{
+		World f_world;
+		std::mt19937 f_random(1357);
+		std::uniform_real_distribution<float> f_unit(-1.0f, 1.0f);
+
+		for (int cx = -3; cx < 3; ++cx)
+		{
+			for (int cy = 0; cy < 4; ++cy)
+			{
+				for (int cz = -3; cz < 3; ++cz)
+				{
+					if (f_random() % 3 != 0)
+					{
+						continue; // Left out
+					}
+
+					for (int i = 0; i < 60; ++i)
+					{
+						f_world.setVoxel(cx * CHUNK_WIDTH + f_random() % CHUNK_WIDTH, cy * CHUNK_HEIGHT + f_random() % CHUNK_HEIGHT, cz * CHUNK_DEPTH + f_random() % CHUNK_DEPTH, (char)(1 + f_random() % (BLOCK_TYPE_COUNT - 1)));
+					}
+				}
+			}
+		}
+
+		const glm::vec3 f_axes[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+		int f_rays = 0;
+		int f_matches = 0;
+		int f_hits = 0;
+
+		for (int i = 0; i < 3000; ++i)
+		{
+			glm::vec3 f_origin(f_unit(f_random) * 48.0f, 32.0f + f_unit(f_random) * 32.0f, f_unit(f_random) * 48.0f);
+			glm::vec3 f_direction(f_unit(f_random), f_unit(f_random), f_unit(f_random));
+			float f_maxDistance = PICK_DISTANCE;
+
+			if (i % 4 == 0)
+			{
+				f_direction = f_axes[(i / 4) % 6];
+			}
+			else if (i % 4 == 1)
+			{
+				// From far away, back towards the voxels
+				glm::vec3 f_target = f_origin;
+				f_origin += glm::normalize(f_direction) * 150.0f;
+				f_direction = f_target - f_origin;
+				f_maxDistance = 300.0f;
+			}
+
+			RaycastHit f_hit = {};
+			RaycastHit f_expected = {};
+			bool f_hitSomething = f_world.raycast(f_origin, f_direction, f_maxDistance, f_hit);
+			bool f_expectedHit = bruteRaycast(f_world, f_origin, f_direction, f_maxDistance, f_expected);
+
+			// Too close to the end of the ray to say which way rounding should go
+			if (f_expectedHit && f_expected.distance > f_maxDistance - 0.01f)
+			{
+				continue;
+			}
+
+			f_rays++;
+			f_hits += f_expectedHit ? 1 : 0;
+
+			bool f_same = f_hitSomething == f_expectedHit;
+
+			if (f_same && f_expectedHit)
+			{
+				f_same = f_hit.voxel == f_expected.voxel && f_hit.previous == f_expected.previous && f_hit.normal == f_expected.normal &&
+					f_hit.type == f_expected.type && std::abs(f_hit.distance - f_expected.distance) < 1.0e-3f * std::max(1.0f, f_expected.distance);
+			}
+
+			f_matches += f_same ? 1 : 0;
+		}
+
+		ab::Benchmark::check("Raycasts match a brute force march", f_matches == f_rays && f_hits > 0 && f_hits < f_rays);
+	}
+
+	/// <summary>
+	/// Generates the default world and compares its resident voxel memory against the dense layout.
+	/// </summary>
+	void worldMemory()
+	{
+		ab::Terrain *f_terrain = new ab::Terrain();
+
+		World *f_world = new World();
+		f_world->populate(*f_terrain, nullptr);
+		f_world->optimiseWorldStorage();
+
+		delete f_terrain;
+
+		std::size_t f_chunks = 0;
+		std::size_t f_paletteBytes = 0;
+
+		f_world->chunks.forEach([&](const Indices &t_position, Chunk *t_chunk)
+		{
+			f_chunks++;
+			f_paletteBytes += t_chunk->getMemoryUsage();
+		});
+
+		ab::Benchmark::report("Resident chunks (default seed)", (double)f_chunks, "chunks");
+		ab::Benchmark::report("Dense voxel memory", (double)(f_chunks * CHUNK_SIZE) / (1024.0 * 1024.0), "MB");
+		ab::Benchmark::report("Palette voxel memory", (double)f_paletteBytes / (1024.0 * 1024.0), "MB");
+
+		raycasts(f_world);
+
+		delete f_world;
+	}
+
+	/// <summary>
+	/// Checks that two worlds have the same chunks with the same voxels.
+	/// </summary>
+	bool sameWorld(const World &a, const World &b)
+	{
+		if (a.chunks.getCount() != b.chunks.getCount())
+		{
+			return false;
+		}
+
+		bool f_same = true;
+
+		a.chunks.forEach([&](const Indices &t_position, Chunk *t_chunk)
+		{
+			Chunk *f_other = b.chunks.find(t_position);
+
+			for (int i = 0; i < CHUNK_SIZE && f_same; ++i)
+			{
+				f_same = f_other != nullptr && t_chunk->getVoxel(i) == f_other->getVoxel(i);
+			}
+		});
+
+		return f_same;
+	}
+
+	/// <summary>
+	/// Checks the chunks that a batched edit marked dirty against the same edits made with setVoxel().
+	/// Every chunk has to be marked once, and every chunk that setVoxel() marked has to be marked too.
+	/// A batch marks the neighbours of the box around the voxels it changed in a chunk, so it can also mark
+	/// a few more neighbours than setVoxel() does, but never anything further than one chunk from a chunk that setVoxel() marked.
+	/// </summary>
+	bool sameDirtyChunks(World &t_batched, World &t_single)
+	{
+		std::vector<Indices> f_batched;
+		std::vector<Indices> f_single;
+		t_batched.takeDirtyChunks(f_batched);
+		t_single.takeDirtyChunks(f_single);
+
+		std::unordered_set<Indices, IndicesHash> f_marked(f_batched.begin(), f_batched.end());
+
+		if (f_single.empty() || f_marked.size() != f_batched.size())
+		{
+			return false;
+		}
+
+		for (const Indices &f_position : f_single)
+		{
+			if (f_marked.count(f_position) == 0)
+			{
+				return false;
+			}
+		}
+
+		for (const Indices &f_position : f_batched)
+		{
+			bool f_near = false;
+
+			for (const Indices &f_other : f_single)
+			{
+				f_near |= std::abs(f_position.x - f_other.x) <= 1 && std::abs(f_position.y - f_other.y) <= 1 && std::abs(f_position.z - f_other.z) <= 1;
+			}
+
+			if (!f_near)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// Fills two worlds with the same random voxels (some chunks are left out) to edit over.
+	/// </summary>
+	void prepareWorlds(World &t_batched, World &t_single)
+	{
+		std::mt19937 f_random(4321);
+
+		for (int i = 0; i < 20000; ++i)
+		{
+			int x = (int)(f_random() % 96) - 40;
+			int y = (int)(f_random() % 64);
+			int z = (int)(f_random() % 96) - 40;
+			char f_type = (char)(f_random() % BLOCK_TYPE_COUNT);
+
+			t_batched.setVoxel(x, y, z, f_type);
+			t_single.setVoxel(x, y, z, f_type);
+		}
+
+		t_batched.clearDirtyChunks();
+		t_single.clearDirtyChunks();
+	}
+
+	/// <summary>
+	/// Checks fillBox(), setVoxels() and stamp() against the same edits made one voxel at a time with setVoxel().
+	/// </summary>
+	void editChecks()
+	{
+		std::mt19937 f_random(8765);
+
+		{
+			World f_batched;
+			World f_single;
+			prepareWorlds(f_batched, f_single);
+
+			// Corners in any order, across negative and positive chunks
+			f_batched.fillBox(37, 50, -9, -21, 3, 29, BLOCK_WATER);
+
+			for (int x = -21; x <= 37; ++x)
+			{
+				for (int y = 3; y <= 50; ++y)
+				{
+					for (int z = -9; z <= 29; ++z)
+					{
+						f_single.setVoxel(x, y, z, BLOCK_WATER);
+					}
+				}
+			}
+
+			bool f_dirty = sameDirtyChunks(f_batched, f_single);
+
+			// Emptying a whole chunk frees it
+			f_batched.fillBox(-32, 0, -32, -17, 15, -17, BLOCK_AIR);
+			f_single.fillBox(-32, 0, -32, -17, 15, -17, BLOCK_AIR);
+
+			ab::Benchmark::check("fillBox matches setVoxel", sameWorld(f_batched, f_single) && f_dirty);
+			ab::Benchmark::check("fillBox frees chunks it empties", f_batched.chunks.find({ -2, 0, -2 }) == nullptr);
+		}
+
+		{
+			World f_batched;
+			World f_single;
+			prepareWorlds(f_batched, f_single);
+
+			// Random edits from a small area so most voxels are edited more than once, in chunks out of order
+			std::vector<VoxelEdit> f_edits;
+
+			for (int i = 0; i < 50000; ++i)
+			{
+				f_edits.push_back({ (int)(f_random() % 48) - 16, (int)(f_random() % 40), (int)(f_random() % 48) - 16, (char)(f_random() % BLOCK_TYPE_COUNT) });
+			}
+
+			// The same voxel in two chunks that sort in the opposite order to the edits
+			f_edits.push_back({ 20, 5, 20, BLOCK_TREE });
+			f_edits.push_back({ -20, 5, -20, BLOCK_GRASS });
+			f_edits.push_back({ 20, 5, 20, BLOCK_LEAF });
+			f_edits.push_back({ -20, 5, -20, BLOCK_WATER });
+
+			f_batched.setVoxels(f_edits);
+
+			for (const VoxelEdit &f_edit : f_edits)
+			{
+				f_single.setVoxel(f_edit.x, f_edit.y, f_edit.z, f_edit.type);
+			}
+
+			bool f_dirty = sameDirtyChunks(f_batched, f_single);
+			bool f_lastWins = f_batched.getVoxel(20, 5, 20) == BLOCK_LEAF && f_batched.getVoxel(-20, 5, -20) == BLOCK_WATER;
+
+			// Emptying a whole chunk one voxel at a time frees it
+			std::vector<VoxelEdit> f_clear;
+
+			for (int x = -32; x < -16; ++x)
+			{
+				for (int y = 0; y < 16; ++y)
+				{
+					for (int z = -32; z < -16; ++z)
+					{
+						f_clear.push_back({ x, y, z, BLOCK_AIR });
+					}
+				}
+			}
+
+			std::shuffle(f_clear.begin(), f_clear.end(), f_random);
+			f_batched.setVoxels(f_clear);
+			f_single.fillBox(-32, 0, -32, -17, 15, -17, BLOCK_AIR);
+
+			ab::Benchmark::check("setVoxels matches setVoxel", sameWorld(f_batched, f_single) && f_dirty);
+			ab::Benchmark::check("setVoxels keeps the last edit to a voxel", f_lastWins);
+			ab::Benchmark::check("setVoxels frees chunks it empties", f_batched.chunks.find({ -2, 0, -2 }) == nullptr);
+		}
+
+		{
+			World f_batched;
+			World f_single;
+			prepareWorlds(f_batched, f_single);
+
+			// About half of the template is air, which has to leave the world's voxels alone
+			VoxelTemplate f_template = { 23, 19, 29, std::vector<char>(23 * 19 * 29) };
+
+			for (char &f_voxel : f_template.voxels)
+			{
+				f_voxel = f_random() % 2 == 0 ? BLOCK_AIR : (char)(1 + f_random() % (BLOCK_TYPE_COUNT - 1));
+			}
+
+			f_batched.stamp(f_template, -11, 20, -13);
+			int f_kept = 0;
+			int f_air = 0;
+
+			for (int x = 0; x < f_template.width; ++x)
+			{
+				for (int y = 0; y < f_template.height; ++y)
+				{
+					for (int z = 0; z < f_template.depth; ++z)
+					{
+						char f_type = f_template.voxels[Utility::at(x, y, z, f_template.height, f_template.depth)];
+
+						if (f_type != BLOCK_AIR)
+						{
+							f_single.setVoxel(x - 11, y + 20, z - 13, f_type);
+						}
+						else if (f_single.getVoxel(x - 11, y + 20, z - 13) != BLOCK_AIR)
+						{
+							f_air++;
+							f_kept += f_batched.getVoxel(x - 11, y + 20, z - 13) == f_single.getVoxel(x - 11, y + 20, z - 13);
+						}
+					}
+				}
+			}
+
+			bool f_dirty = sameDirtyChunks(f_batched, f_single);
+
+			ab::Benchmark::check("stamp matches setVoxel", sameWorld(f_batched, f_single) && f_dirty);
+			ab::Benchmark::check("stamp skips air voxels", f_air > 0 && f_kept == f_air);
+		}
+	}
+
+	/// <summary>
+	/// Compares filling a 64^3 box one voxel at a time against the batched edit functions.
+	/// </summary>
+	void edits()
+	{
+		const int f_size = 64;
+		const long long f_voxels = (long long)f_size * f_size * f_size;
+
+		ab::Benchmark::run("Box fill (setVoxel)", 5, f_voxels, [&]()
+		{
+			World f_world;
+
+			for (int x = 0; x < f_size; ++x)
+			{
+				for (int y = 0; y < f_size; ++y)
+				{
+					for (int z = 0; z < f_size; ++z)
+					{
+						f_world.setVoxel(x, y, z, 1);
+					}
+				}
+			}
+		});
+
+		ab::Benchmark::run("Box fill (fillBox)", 5, f_voxels, [&]()
+		{
+			World f_world;
+			f_world.fillBox(0, 0, 0, f_size - 1, f_size - 1, f_size - 1, 1);
+		});
+
+		std::vector<VoxelEdit> f_edits;
+
+		for (int x = 0; x < f_size; ++x)
+		{
+			for (int y = 0; y < f_size; ++y)
+			{
+				for (int z = 0; z < f_size; ++z)
+				{
+					f_edits.push_back({ x, y, z, 1 });
+				}
+			}
+		}
+
+		ab::Benchmark::run("Box fill (setVoxels)", 5, f_voxels, [&]()
+		{
+			World f_world;
+			f_world.setVoxels(f_edits);
+		});
+	}
+
+	/// <summary>
+	/// Times reading and writing single voxels of the generated world, in order and at random, and the empty chunk sweep.
+	/// </summary>
+	void worldAccess()
+	{
+		ab::Terrain f_terrain;
+		std::unique_ptr<World> f_world(new World());
+		f_world->populate(f_terrain, nullptr);
+
+		// A quarter of the generated area, in the order voxels are stored within a chunk (y fastest)
+		const int f_width = WORLD_WIDTH / 2;
+		const int f_depth = WORLD_DEPTH / 2;
+
+		ab::Benchmark::run("World sequential getVoxel", 5, (long long)f_width * WORLD_HEIGHT * f_depth, [&]()
+		{
+			int f_solid = 0;
+
+			for (int x = 0; x < f_width; ++x)
+			{
+				for (int z = 0; z < f_depth; ++z)
+				{
+					for (int y = 0; y < WORLD_HEIGHT; ++y)
+					{
+						f_solid += f_world->getVoxel(x, y, z) != BLOCK_AIR;
+					}
+				}
+			}
+
+			ab::Benchmark::keep(f_solid);
+		});
+
+		std::mt19937 f_random(1234);
+		std::vector<glm::ivec3> f_positions(OPS);
+
+		for (glm::ivec3 &f_position : f_positions)
+		{
+			f_position = { (int)(f_random() % WORLD_WIDTH), (int)(f_random() % WORLD_HEIGHT), (int)(f_random() % WORLD_DEPTH) };
+		}
+
+		ab::Benchmark::run("World random getVoxel", 5, OPS, [&]()
+		{
+			int f_solid = 0;
+
+			for (const glm::ivec3 &f_position : f_positions)
+			{
+				f_solid += f_world->getVoxel(f_position.x, f_position.y, f_position.z) != BLOCK_AIR;
+			}
+
+			ab::Benchmark::keep(f_solid);
+		});
+
+		// A corner of the world in the same order, alternating between two types so that every write changes the voxel
+		const int f_setWidth = f_width / 4;
+		const int f_setDepth = f_depth / 4;
+		int f_run = 0;
+
+		ab::Benchmark::run("World sequential setVoxel", 5, (long long)f_setWidth * WORLD_HEIGHT * f_setDepth, [&]()
+		{
+			char f_type = f_run++ % 2 == 0 ? BLOCK_TREE : BLOCK_LEAF;
+
+			for (int x = 0; x < f_setWidth; ++x)
+			{
+				for (int z = 0; z < f_setDepth; ++z)
+				{
+					for (int y = 0; y < WORLD_HEIGHT; ++y)
+					{
+						f_world->setVoxel(x, y, z, f_type);
+					}
+				}
+			}
+		});
+
+		// Leaves are written over whatever is there, so every run does the same work
+		ab::Benchmark::run("World random setVoxel", 5, OPS, [&]()
+		{
+			for (const glm::ivec3 &f_position : f_positions)
+			{
+				f_world->setVoxel(f_position.x, f_position.y, f_position.z, BLOCK_LEAF);
+			}
+		});
+
+		std::size_t f_chunks = 0;
+		f_world->chunks.forEach([&](const Indices &t_position, Chunk *t_chunk) { f_chunks++; });
+
+		ab::Benchmark::run("optimiseWorldStorage (per chunk)", 5, (long long)f_chunks, [&]()
+		{
+			f_world->optimiseWorldStorage();
+		});
+	}
+
+	/// <summary>
+	/// Finds 16 chunk positions that all start probing in the last two or first two slots of a table,
+	/// so they collide and share one probe run that wraps around the end of the table.
+	/// </summary>
+	std::vector<Indices> collidingKeys(int t_capacity, int t_offset)
+	{
+		std::vector<Indices> f_keys;
+		unsigned int f_mask = (unsigned int)t_capacity - 1;
+		int f_found[4] = {};
+
+		for (int i = 0; f_keys.size() < 16; ++i)
+		{
+			Indices f_key = { t_offset + i % 1000, i / 1000, 7 };
+			unsigned int f_slot = ((unsigned int)IndicesHash()(f_key) + 2) & f_mask;
+
+			if (f_slot < 4 && f_found[f_slot] < 4)
+			{
+				f_found[f_slot]++;
+				f_keys.push_back(f_key);
+			}
+		}
+
+		return f_keys;
+	}
+
+	/// <summary>
+	/// Checks that a table holds exactly the chunks in a reference map, and none of the erased positions.
+	/// </summary>
+	bool sameTable(const ChunkTable &t_table, const std::unordered_map<Indices, Chunk*, IndicesHash> &t_reference, const std::vector<Indices> &t_erased)
+	{
+		if (t_table.getCount() != (int)t_reference.size())
+		{
+			return false;
+		}
+
+		for (const auto &f_pair : t_reference)
+		{
+			if (t_table.find(f_pair.first) != f_pair.second)
+			{
+				return false;
+			}
+		}
+
+		for (const Indices &f_position : t_erased)
+		{
+			if (t_table.find(f_position) != nullptr)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// Checks the chunk table's backward shift deletion and growing against a reference map, using positions that collide.
+	/// </summary>
+	void tableChecks()
+	{
+		ChunkTable f_table;
+		std::unordered_map<Indices, Chunk*, IndicesHash> f_reference;
+		std::vector<Indices> f_erased;
+
+		auto f_insert = [&](const Indices &t_position)
+		{
+			f_reference[t_position] = f_table.findOrCreate(t_position);
+			f_erased.erase(std::remove(f_erased.begin(), f_erased.end(), t_position), f_erased.end());
+		};
+
+		auto f_erase = [&](const Indices &t_position)
+		{
+			f_reference.erase(t_position);
+			f_erased.push_back(t_position);
+			return f_table.erase(t_position);
+		};
+
+		// Erase from the start and the middle of a probe run, including after it wraps around
+		int f_capacity = f_table.getCapacity();
+		std::vector<Indices> f_run = collidingKeys(f_capacity, 0);
+
+		for (const Indices &f_position : f_run)
+		{
+			f_insert(f_position);
+		}
+
+		bool f_erasedRun = f_erase(f_run[5]) && f_erase(f_run[0]) && f_erase(f_run[9]) && f_erase(f_run[14]) && !f_erase(f_run[5]);
+		ab::Benchmark::check("Chunk table erases inside probe runs", f_erasedRun && sameTable(f_table, f_reference, f_erased));
+
+		// Enough positions to grow the table twice, erasing some of them along the way
+		std::mt19937 f_random(2468);
+
+		for (int i = 0; i < f_capacity * 2; ++i)
+		{
+			f_insert({ (int)(f_random() % 256) - 128, (int)(f_random() % 8), (int)(f_random() % 256) - 128 });
+
+			if (i % 3 == 0)
+			{
+				Indices f_position = f_reference.begin()->first;
+				f_erase(f_position);
+			}
+		}
+
+		ab::Benchmark::check("Chunk table keeps every chunk when it grows", f_table.getCapacity() >= f_capacity * 4 && sameTable(f_table, f_reference, f_erased));
+
+		// And again with positions that collide at the new capacity
+		f_run = collidingKeys(f_table.getCapacity(), 100000);
+
+		for (const Indices &f_position : f_run)
+		{
+			f_insert(f_position);
+		}
+
+		f_erasedRun = f_erase(f_run[2]) && f_erase(f_run[7]) && f_erase(f_run[15]) && f_erase(f_run[11]);
+		ab::Benchmark::check("Chunk table erases after growing", f_erasedRun && sameTable(f_table, f_reference, f_erased));
+	}
+
+	/// <summary>
+	/// Reports the pool's statistics for chunk objects and each size of voxel block.
+	/// </summary>
+	void reportPool(const std::string &t_name, const ChunkPool::Stats &t_stats)
+	{
+		ab::Benchmark::report(t_name + " live", (double)t_stats.live, "blocks");
+		ab::Benchmark::report(t_name + " peak", (double)t_stats.peak, "blocks");
+		ab::Benchmark::report(t_name + " recycled", (double)t_stats.recycled, "blocks");
+		ab::Benchmark::report(t_name + " reserved", (double)t_stats.reservedBytes / 1024.0, "KB");
+	}
+
+	/// <summary>
+	/// Repeatedly creates and deletes chunks the way editing does (a chunk is created by the
+	/// first solid voxel and deleted when the last one is removed), comparing the pool
+	/// against plain new/delete.
+	/// </summary>
+	void churn()
+	{
+		const int f_rounds = 64;
+		ChunkPool::Stats f_before = ChunkPool::get().getTotalStats();
+
+		ab::Benchmark::run("Chunk churn (new/delete objects)", 5, (long long)f_rounds * CHUNK_COUNT, [&]()
+		{
+			std::vector<Chunk*> f_chunks(CHUNK_COUNT);
+
+			for (int r = 0; r < f_rounds; ++r)
+			{
+				for (int i = 0; i < CHUNK_COUNT; ++i)
+				{
+					f_chunks[i] = new Chunk();
+					f_chunks[i]->setVoxel(i % CHUNK_SIZE, 1);
+				}
+
+				for (int i = 0; i < CHUNK_COUNT; ++i)
+				{
+					delete f_chunks[i];
+				}
+			}
+		});
+
+		ab::Benchmark::run("Chunk churn (pooled objects)", 5, (long long)f_rounds * CHUNK_COUNT, [&]()
+		{
+			std::vector<Chunk*> f_chunks(CHUNK_COUNT);
+
+			for (int r = 0; r < f_rounds; ++r)
+			{
+				for (int i = 0; i < CHUNK_COUNT; ++i)
+				{
+					f_chunks[i] = ChunkPool::get().createChunk();
+					f_chunks[i]->setVoxel(i % CHUNK_SIZE, 1);
+				}
+
+				for (int i = 0; i < CHUNK_COUNT; ++i)
+				{
+					ChunkPool::get().destroyChunk(f_chunks[i]);
+				}
+			}
+		});
+
+		// Nothing else has any chunks while this runs
+		ChunkPool::Stats f_after = ChunkPool::get().getTotalStats();
+		ab::Benchmark::check("Pool live count goes back to 0 after churn", f_after.live == 0);
+		ab::Benchmark::check("Pool recycles freed blocks", f_after.recycled > f_before.recycled);
+		ab::Benchmark::check("Pool peak covers the live chunks", f_after.peak >= f_after.live && ChunkPool::get().getChunkStats().peak >= CHUNK_COUNT);
+
+		reportPool("Pool chunks", ChunkPool::get().getChunkStats());
+
+		for (int f_bits = 1; f_bits <= 8; f_bits *= 2)
+		{
+			reportPool("Pool " + std::to_string(f_bits) + "-bit blocks", ChunkPool::get().getBlockStats(f_bits));
+		}
+	}
+}
+
+/// <summary>
+/// Compares the palette-compressed chunk layout against the previous dense layout.
+/// </summary>
+void chunkBenchmark()
+{
+	ab::Benchmark::header("Chunk storage");
+
+	widenChecks();
+	solidCountChecks();
+	throughput(2);
+	throughput(5);
+	worldMemory();
+	raycastChecks();
+	editChecks();
+	edits();
+	worldAccess();
+	tableChecks();
+	churn();
+}
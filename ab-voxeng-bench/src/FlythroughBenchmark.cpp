@@ -0,0 +1,205 @@
+#include "Benchmark.h"
+#include "CameraPath.h"
+#include "ChunkStreamer.h"
+#include "FrameClock.h"
+#include "JobSystem.h"
+#include "Mesher.h"
+#include "RemeshQueue.h"
+#include "Stats.h"
+#include "Terrain.h"
+#include "World.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+	const int RADIUS = 8;
+	const glm::vec3 CENTRE(WORLD_WIDTH / 2.0f, 60.0f, WORLD_DEPTH / 2.0f);
+	const float CIRCLE_RADIUS = 192.0f;
+	const double PATH_MS = 12000.0; // About the camera's own speed around the circle
+	const int PATH_KEYFRAMES = 25;
+
+	/// <summary>
+	/// Makes a path that flies a circle round the middle of the world, bobbing up and down, looking where it's going.
+	/// </summary>
+	ab::CameraPath makeCircle()
+	{
+		ab::CameraPath f_path;
+
+		for (int i = 0; i < PATH_KEYFRAMES; ++i)
+		{
+			double f_t = (double)i / (PATH_KEYFRAMES - 1);
+			double f_angle = f_t * 2.0 * 3.14159265358979;
+			glm::vec3 f_eye(CENTRE.x + CIRCLE_RADIUS * (float)std::cos(f_angle), CENTRE.y + 10.0f * (float)std::sin(f_angle * 3.0), CENTRE.z + CIRCLE_RADIUS * (float)std::sin(f_angle));
+
+			// Facing along the circle, (-sin, 0, cos), is a yaw of -angle
+			f_path.add({ f_t * PATH_MS, f_eye, -glm::degrees(f_angle), -10.0 });
+		}
+
+		return f_path;
+	}
+
+	/// <summary>
+	/// Checks keyframe interpolation, saving and loading, and that replays are the same every time.
+	/// </summary>
+	void path()
+	{
+		ab::CameraPath f_path;
+		f_path.add({ 0.0, glm::vec3(0.0f), 350.0, 0.0 });
+		f_path.add({ 100.0, glm::vec3(10.0f, 20.0f, 30.0f), 10.0, 40.0 });
+		bool f_rejected = !f_path.add({ 50.0, glm::vec3(0.0f), 0.0, 0.0 });
+
+		ab::CameraPath::Keyframe f_middle = f_path.sample(50.0);
+		ab::CameraPath::Keyframe f_end = f_path.sample(1000.0);
+		ab::Benchmark::check("Camera paths interpolate between keyframes", glm::length(f_middle.eye - glm::vec3(5.0f, 10.0f, 15.0f)) < 1e-4f && std::abs(f_middle.pitch - 20.0) < 1e-9);
+		ab::Benchmark::check("Camera paths turn the shortest way round", std::abs(f_middle.yaw - 360.0) < 1e-9);
+		ab::Benchmark::check("Camera paths stop at the last keyframe", f_end.eye == glm::vec3(10.0f, 20.0f, 30.0f) && f_path.getDuration() == 100.0);
+		ab::Benchmark::check("Camera paths keep keyframes in time order", f_rejected && f_path.getKeyframes().size() == 2);
+
+		// The same direction that Camera::update() turns (0, 0, 1) to
+		glm::vec3 f_direction = ab::CameraPath::getDirection(90.0, 0.0);
+		glm::vec3 f_up = ab::CameraPath::getDirection(0.0, 90.0);
+		ab::Benchmark::check("Camera path directions match the camera", glm::length(f_direction - glm::vec3(1.0f, 0.0f, 0.0f)) < 1e-5f && glm::length(f_up - glm::vec3(0.0f, 1.0f, 0.0f)) < 1e-5f);
+
+		// Saving and loading keeps the keyframes (to the 4 decimal places saved), so a replay follows the same poses
+		ab::CameraPath f_circle = makeCircle();
+		ab::CameraPath f_loaded;
+		std::string f_file = "bench-camera-path.txt";
+		bool f_roundTrip = f_circle.save(f_file) && f_loaded.load(f_file) && f_loaded.getKeyframes().size() == f_circle.getKeyframes().size();
+
+		for (double t = 0.0; f_roundTrip && t <= PATH_MS; t += SIMULATION_STEP_MS)
+		{
+			ab::CameraPath::Keyframe f_a = f_circle.sample(t);
+			ab::CameraPath::Keyframe f_b = f_loaded.sample(t);
+			f_roundTrip = glm::length(f_a.eye - f_b.eye) < 1e-3f && std::abs(f_a.yaw - f_b.yaw) < 1e-3 && std::abs(f_a.pitch - f_b.pitch) < 1e-3;
+		}
+
+		ab::Benchmark::check("Saved camera paths replay the same poses", f_roundTrip);
+
+		// A file with keyframes out of order is rejected rather than half loaded
+		std::FILE *f_bad = std::fopen(f_file.c_str(), "w");
+
+		if (f_bad != nullptr)
+		{
+			std::fputs("# bad\n0 0 0 0 0 0\n100 1 1 1 0 0\n50 2 2 2 0 0\n", f_bad);
+			std::fclose(f_bad);
+		}
+
+		ab::Benchmark::check("Bad camera path files aren't loaded", !f_loaded.load(f_file) && f_loaded.isEmpty());
+		std::remove(f_file.c_str());
+	}
+
+	/// <summary>
+	/// Flies a path through a streamed world the way the game's --flythrough does: one simulation step per frame, with each frame
+	/// streaming, writing in finished columns and meshing within the remesh budget. Reports the frame times, hitches and
+	/// the column loading and meshing latencies, so two builds flying the same path can be compared.
+	/// </summary>
+	/// <param name="t_path">The path to fly.</param>
+	void fly(const ab::CameraPath &t_path)
+	{
+		World f_world;
+		ab::Terrain f_terrain(WORLD_SEED);
+		ab::JobSystem f_jobs(3);
+		ChunkStreamer f_streamer(f_world, f_terrain, f_jobs);
+		RemeshQueue f_queue;
+		ab::FrameClock f_clock(SIMULATION_STEP_MS, 0.0);
+		std::vector<PackedVertex> f_vertices;
+		std::vector<float> f_frames;
+		double f_timeMs = 0.0;
+		bool f_lockstep = true;
+		long long f_meshed = 0;
+		f_streamer.setLoadRadius(RADIUS);
+		f_clock.setLockstep(true);
+
+		auto f_remesh = [&](const Indices &t_position)
+		{
+			Mesher::meshChunk(f_world, t_position, f_vertices);
+			f_meshed++;
+		};
+
+		while (f_timeMs < t_path.getDuration())
+		{
+			f_clock.beginFrame();
+			int f_steps = 0;
+
+			while (f_clock.step())
+			{
+				f_timeMs += f_clock.getStepMs();
+				f_steps++;
+			}
+
+			f_lockstep = f_lockstep && f_steps == 1;
+			ab::CameraPath::Keyframe f_pose = t_path.sample(f_timeMs);
+			glm::vec3 f_direction = ab::CameraPath::getDirection(f_pose.yaw, f_pose.pitch);
+
+			f_streamer.update(f_pose.eye, f_direction);
+			f_jobs.pump();
+			f_queue.collect(f_world);
+			f_queue.sort([&](const Indices &t_position)
+			{
+				return f_world.chunks.find(t_position) == nullptr ? -1.0f : f_streamer.getPriority(t_position);
+			});
+			f_queue.process(REMESH_BUDGET_MS, f_remesh);
+
+			f_clock.endFrame();
+			f_frames.push_back((float)f_clock.getWorkMs());
+		}
+
+		f_streamer.finish();
+
+		ab::Stats::Stat f_frameTimes = { "Flythrough", "Work time", "ms", 0.0, f_frames };
+		int f_hitches = (int)std::count_if(f_frames.begin(), f_frames.end(), [](float t_workMs)
+		{
+			return t_workMs > FLYTHROUGH_HITCH_MS;
+		});
+
+		ChunkStreamer::Stats f_stats = f_streamer.getStats();
+		const ChunkIO::LatencyHistogram &f_meshLatency = f_queue.getLatency();
+		glm::vec3 f_endEye = t_path.sample(t_path.getDuration()).eye;
+		int f_endX = (int)std::floor(f_endEye.x / CHUNK_WIDTH);
+		int f_endZ = (int)std::floor(f_endEye.z / CHUNK_DEPTH);
+
+		ab::Benchmark::check("Flythroughs simulate one step per frame", f_lockstep && std::abs(f_frames.size() - t_path.getDuration() / SIMULATION_STEP_MS) <= 1.0);
+		ab::Benchmark::check("Flythroughs load and mesh along the path", f_streamer.isResident(f_endX, f_endZ) && f_meshed > 0);
+		ab::Benchmark::report("Flythrough frames", (double)f_frames.size(), "frames");
+		ab::Benchmark::report("Flythrough work time (p50)", ab::Stats::getPercentile(f_frameTimes, 50.0), "ms");
+		ab::Benchmark::report("Flythrough work time (p95)", ab::Stats::getPercentile(f_frameTimes, 95.0), "ms");
+		ab::Benchmark::report("Flythrough work time (p99)", ab::Stats::getPercentile(f_frameTimes, 99.0), "ms");
+		ab::Benchmark::report("Flythrough work time (max)", ab::Stats::getPercentile(f_frameTimes, 100.0), "ms");
+		ab::Benchmark::report("Flythrough hitches (over " + std::to_string((int)FLYTHROUGH_HITCH_MS) + " ms)", f_hitches, "frames");
+		ab::Benchmark::report("Flythrough columns loaded", (double)f_stats.loaded, "columns");
+		ab::Benchmark::report("Flythrough column load latency (p50)", f_stats.loads.getPercentile(50.0) / 1000.0, "ms");
+		ab::Benchmark::report("Flythrough column load latency (p99)", f_stats.loads.getPercentile(99.0) / 1000.0, "ms");
+		ab::Benchmark::report("Flythrough chunks meshed", (double)f_meshed, "chunks");
+		ab::Benchmark::report("Flythrough mesh latency (p50)", f_meshLatency.getPercentile(50.0) / 1000.0, "ms");
+		ab::Benchmark::report("Flythrough mesh latency (p99)", f_meshLatency.getPercentile(99.0) / 1000.0, "ms");
+	}
+}
+
+/// <summary>
+/// Checks camera paths and flies one through a streamed world.
+/// </summary>
+/// <param name="t_pathFile">A camera path recorded in the game, or nullptr to fly a circle round the middle of the world.</param>
+/// <returns>False if the camera path couldn't be loaded.</returns>
+bool flythroughBenchmark(const char *t_pathFile)
+{
+	ab::Benchmark::header("Flythrough");
+
+	path();
+
+	ab::CameraPath f_path = makeCircle();
+
+	if (t_pathFile != nullptr && !f_path.load(t_pathFile))
+	{
+		std::cout << "Couldn't load the camera path " << t_pathFile << std::endl;
+		return false;
+	}
+
+	fly(f_path);
+
+	return true;
+}
@@ -0,0 +1,155 @@
+#include "Benchmark.h"
+#include "FrameClock.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	const double STEP_MS = 10.0;
+	const double FRAME_RATE = 100.0; // 10 ms frames
+	const int FRAMES = 60;
+
+	/// <summary>
+	/// Checks that time is taken out in whole steps, with the rest left for interpolation.
+	/// </summary>
+	void steps()
+	{
+		ab::FrameClock f_clock(STEP_MS, 0.0);
+		int f_steps = 0;
+
+		f_clock.advance(25.0);
+
+		while (f_clock.step())
+		{
+			f_steps++;
+		}
+
+		ab::Benchmark::check("Fixed steps are taken out of the elapsed time", f_steps == 2 && std::abs(f_clock.getInterpolation() - 0.5) < 1e-9);
+
+		// The leftover half step carries over, so another half step makes a whole one
+		f_clock.advance(5.0);
+		f_steps = 0;
+
+		while (f_clock.step())
+		{
+			f_steps++;
+		}
+
+		ab::Benchmark::check("Leftover time carries over to the next frame", f_steps == 1 && f_clock.getInterpolation() < 1e-9);
+
+		// A long stall only counts as MAX_FRAME_MS, so the simulation doesn't spiral trying to catch up
+		f_clock.advance(10000.0);
+		f_steps = 0;
+
+		while (f_clock.step())
+		{
+			f_steps++;
+		}
+
+		ab::Benchmark::check("Long frames are clamped", f_steps == (int)(ab::FrameClock::MAX_FRAME_MS / STEP_MS));
+
+		// The simulated distance only depends on the time, not how it's split into frames
+		ab::FrameClock f_fast(STEP_MS, 0.0);
+		ab::FrameClock f_slow(STEP_MS, 0.0);
+		int f_fastSteps = 0;
+		int f_slowSteps = 0;
+
+		for (int i = 0; i < 300; ++i)
+		{
+			f_fast.advance(1.0);
+
+			while (f_fast.step())
+			{
+				f_fastSteps++;
+			}
+		}
+
+		for (int i = 0; i < 10; ++i)
+		{
+			f_slow.advance(30.0);
+
+			while (f_slow.step())
+			{
+				f_slowSteps++;
+			}
+		}
+
+		ab::Benchmark::check("Steps don't depend on the frame rate", f_fastSteps == 30 && f_slowSteps == 30);
+	}
+
+	/// <summary>
+	/// Runs frames with a millisecond of work and records their lengths.
+	/// </summary>
+	std::vector<double> runFrames(ab::FrameClock &t_clock, double &t_sleepMs)
+	{
+		std::vector<double> f_frames;
+		t_sleepMs = 0.0;
+
+		for (int i = 0; i <= FRAMES; ++i)
+		{
+			double f_frameMs = t_clock.beginFrame();
+
+			if (i > 0)
+			{
+				f_frames.push_back(f_frameMs);
+			}
+
+			while (t_clock.step())
+			{
+			}
+
+			std::chrono::steady_clock::time_point f_workEnd = std::chrono::steady_clock::now() + std::chrono::milliseconds(1);
+
+			while (std::chrono::steady_clock::now() < f_workEnd)
+			{
+			}
+
+			t_clock.endFrame();
+			t_sleepMs += t_clock.getSleepMs();
+		}
+
+		std::sort(f_frames.begin(), f_frames.end());
+
+		return f_frames;
+	}
+
+	/// <summary>
+	/// Checks the frame rate cap: frames with a little work in them should still last the whole budget,
+	/// and uncapped frames shouldn't wait at all.
+	/// </summary>
+	void pacing()
+	{
+		double f_sleepMs;
+		ab::FrameClock f_capped(STEP_MS, FRAME_RATE);
+		std::vector<double> f_frames = runFrames(f_capped, f_sleepMs);
+		double f_median = f_frames[f_frames.size() / 2];
+		double f_p99 = f_frames[(std::size_t)std::ceil(0.99 * f_frames.size()) - 1];
+
+		// Sleeping for the whole budget (the old loop) would make these frames 11 ms
+		ab::Benchmark::check("Capped frames last the frame budget", std::abs(f_median - 1000.0 / FRAME_RATE) < 0.5);
+		ab::Benchmark::report("Capped frame time (p50)", f_median, "ms");
+		ab::Benchmark::report("Capped frame time (p99)", f_p99, "ms");
+
+		ab::FrameClock f_uncapped(STEP_MS, 0.0);
+		f_frames = runFrames(f_uncapped, f_sleepMs);
+		f_median = f_frames[f_frames.size() / 2];
+
+		ab::Benchmark::check("Uncapped frames don't wait", f_uncapped.isUncapped() && f_sleepMs < 1.0 && f_median < 1000.0 / FRAME_RATE);
+		ab::Benchmark::report("Uncapped frame time (p50)", f_median, "ms");
+	}
+}
+
+/// <summary>
+/// Checks the fixed timestep and the frame pacing.
+/// </summary>
+void frameClockBenchmark()
+{
+	ab::Benchmark::header("Frame clock");
+
+	steps();
+	pacing();
+}
@@ -0,0 +1,205 @@
+#include "Benchmark.h"
+#include "JobSystem.h"
+#include "Noise.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	/// <summary>
+	/// Checks that jobs wait for their dependencies, including main thread jobs.
+	/// </summary>
+	void dependencies()
+	{
+		// Always use a few workers, even on a single core machine, so the jobs really do run concurrently
+		ab::JobSystem f_jobs(3);
+
+		// A diamond: A runs first, then B and C (in any order), then D
+		std::atomic<int> f_order(0);
+		int f_a = -1;
+		int f_b = -1;
+		int f_c = -1;
+		int f_d = -1;
+
+		ab::JobSystem::JobHandle f_jobA = f_jobs.add([&]() { f_a = f_order++; });
+		ab::JobSystem::JobHandle f_jobB = f_jobs.add([&]() { f_b = f_order++; }, { f_jobA });
+		ab::JobSystem::JobHandle f_jobC = f_jobs.add([&]() { f_c = f_order++; }, { f_jobA });
+		ab::JobSystem::JobHandle f_jobD = f_jobs.add([&]() { f_d = f_order++; }, { f_jobB, f_jobC });
+		f_jobs.wait(f_jobD);
+
+		ab::Benchmark::check("Jobs run after their dependencies", f_a == 0 && f_b > f_a && f_c > f_a && f_d == 3);
+
+		// A long chain, each job only starts once the previous one has finished (so no atomics needed)
+		int f_counter = 0;
+		bool f_inOrder = true;
+		ab::JobSystem::JobHandle f_previous;
+
+		for (int i = 0; i < 1000; ++i)
+		{
+			f_previous = f_jobs.add([&f_counter, &f_inOrder, i]()
+			{
+				f_inOrder &= f_counter == i;
+				f_counter++;
+			}, { f_previous });
+		}
+
+		f_jobs.wait(f_previous);
+
+		ab::Benchmark::check("Dependency chain runs in order", f_inOrder && f_counter == 1000);
+
+		// Main thread jobs only run on the main thread, during pump() or wait()
+		std::atomic<bool> f_workDone(false);
+		bool f_ranOnMain = false;
+		bool f_ranAfterWork = false;
+
+		ab::JobSystem::JobHandle f_work = f_jobs.add([&]() { f_workDone = true; });
+		ab::JobSystem::JobHandle f_upload = f_jobs.addMainThread([&]()
+		{
+			f_ranOnMain = f_jobs.isMainThread();
+			f_ranAfterWork = f_workDone;
+		}, { f_work });
+
+		while (!f_jobs.isFinished(f_upload))
+		{
+			f_jobs.pump();
+			std::this_thread::yield();
+		}
+
+		ab::Benchmark::check("Main thread jobs run on the main thread", f_ranOnMain && f_ranAfterWork);
+
+		// Every item in a parallel for is visited exactly once
+		std::vector<int> f_visits(100000, 0);
+
+		f_jobs.parallelFor(0, (int)f_visits.size(), 977, [&](int t_begin, int t_end)
+		{
+			for (int i = t_begin; i < t_end; ++i)
+			{
+				f_visits[i]++;
+			}
+		});
+
+		ab::Benchmark::check("Parallel for visits every item once", std::all_of(f_visits.begin(), f_visits.end(), [](int t_visits) { return t_visits == 1; }));
+	}
+
+	/// <summary>
+	/// Measures job overhead and how a noise workload scales from 1 thread to every core.
+	/// </summary>
+	void scaling()
+	{
+		int f_maxThreads = std::max((int)std::thread::hardware_concurrency(), 1);
+		ab::Noise f_noise;
+		double f_singleThreadNs = 0.0;
+
+		ab::Benchmark::report("Hardware threads", (double)f_maxThreads, "threads");
+
+		// 1, 2, 4... threads, finishing with every core
+		std::vector<int> f_threadCounts;
+
+		for (int f_threads = 1; f_threads < f_maxThreads; f_threads *= 2)
+		{
+			f_threadCounts.push_back(f_threads);
+		}
+
+		f_threadCounts.push_back(f_maxThreads);
+
+		for (int f_threads : f_threadCounts)
+		{
+			// The main thread works while it waits, so it counts as one of the threads
+			ab::JobSystem f_jobs(f_threads - 1);
+			std::string f_suffix = " (" + std::to_string(f_threads) + " threads)";
+
+			// Empty jobs, all added from the main thread
+			const int f_jobCount = 100000;
+			std::vector<ab::JobSystem::JobHandle> f_handles;
+			f_handles.reserve(f_jobCount);
+
+			ab::Benchmark::run("Empty job" + f_suffix, 3, f_jobCount, [&]()
+			{
+				f_handles.clear();
+
+				for (int i = 0; i < f_jobCount; ++i)
+				{
+					f_handles.push_back(f_jobs.add(nullptr));
+				}
+
+				f_jobs.wait(f_handles);
+			});
+
+			// Jobs that add their own jobs (so the workers fill their own queues and steal from each other)
+			const int f_parentCount = 64;
+			const int f_childCount = 256;
+
+			ab::Benchmark::run("Nested job" + f_suffix, 3, f_parentCount * f_childCount, [&]()
+			{
+				std::vector<ab::JobSystem::JobHandle> f_parents;
+
+				for (int i = 0; i < f_parentCount; ++i)
+				{
+					f_parents.push_back(f_jobs.add([&]()
+					{
+						std::vector<ab::JobSystem::JobHandle> f_children;
+
+						for (int j = 0; j < f_childCount; ++j)
+						{
+							f_children.push_back(f_jobs.add(nullptr));
+						}
+
+						f_jobs.wait(f_children);
+					}));
+				}
+
+				f_jobs.wait(f_parents);
+			});
+
+			// A terrain sized noise workload, split into 64 x 64 tiles
+			const int f_size = 1024;
+			const int f_tile = 64;
+			std::vector<float> f_heights(f_size * f_size);
+
+			double f_ns = ab::Benchmark::run("Noise tiles" + f_suffix, 3, (long long)f_size * f_size, [&]()
+			{
+				f_jobs.parallelFor(0, (f_size / f_tile) * (f_size / f_tile), 1, [&](int t_begin, int t_end)
+				{
+					for (int f_index = t_begin; f_index < t_end; ++f_index)
+					{
+						int f_tileX = (f_index % (f_size / f_tile)) * f_tile;
+						int f_tileZ = (f_index / (f_size / f_tile)) * f_tile;
+
+						for (int x = f_tileX; x < f_tileX + f_tile; ++x)
+						{
+							for (int z = f_tileZ; z < f_tileZ + f_tile; ++z)
+							{
+								f_heights[x * f_size + z] = (float)f_noise.noise(x / 64.0, z / 64.0);
+							}
+						}
+					}
+				});
+
+				ab::Benchmark::keep(f_heights[0]);
+			});
+
+			if (f_threads == 1)
+			{
+				f_singleThreadNs = f_ns;
+			}
+
+			ab::Benchmark::report("Noise speedup" + f_suffix, f_singleThreadNs / f_ns, "x");
+			ab::Benchmark::report("Jobs stolen" + f_suffix, (double)f_jobs.getStats().stolen, "jobs");
+		}
+	}
+}
+
+/// <summary>
+/// Checks and benchmarks the job system.
+/// </summary>
+void jobBenchmark()
+{
+	ab::Benchmark::header("Job system");
+
+	dependencies();
+	scaling();
+}
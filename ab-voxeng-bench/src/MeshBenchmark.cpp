@@ -0,0 +1,339 @@
+#include "Benchmark.h"
+#include "Mesher.h"
+#include "World.h"
+#include "Terrain.h"
+#include "RemeshQueue.h"
+
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+namespace
+{
+	/// <summary>
+	/// Counts the visible faces in a chunk the slow way, looking up every neighbour through the world.
+	/// Used to check that the mesher culls correctly across chunk boundaries.
+	/// </summary>
+	int countVisibleFaces(World &t_world, const Indices &t_position)
+	{
+		const int f_offsets[6][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+		int f_faces = 0;
+
+		for (int x = 0; x < CHUNK_WIDTH; ++x)
+		{
+			for (int y = 0; y < CHUNK_HEIGHT; ++y)
+			{
+				for (int z = 0; z < CHUNK_DEPTH; ++z)
+				{
+					int f_x = t_position.x * CHUNK_WIDTH + x;
+					int f_y = t_position.y * CHUNK_HEIGHT + y;
+					int f_z = t_position.z * CHUNK_DEPTH + z;
+					char f_type = t_world.getVoxel(f_x, f_y, f_z);
+
+					if (f_type == BLOCK_AIR)
+					{
+						continue;
+					}
+
+					for (int f_face = 0; f_face < 6; ++f_face)
+					{
+						char f_neighbour = t_world.getVoxel(f_x + f_offsets[f_face][0], f_y + f_offsets[f_face][1], f_z + f_offsets[f_face][2]);
+
+						if (Mesher::isFaceVisible(f_type, f_neighbour))
+						{
+							f_faces++;
+						}
+					}
+				}
+			}
+		}
+
+		return f_faces;
+	}
+
+	/// <summary>
+	/// Checks that every vertex survives packing and unpacking.
+	/// </summary>
+	/// <returns>True if every vertex matched.</returns>
+	bool checkVertexPacking()
+	{
+		const int f_maxPosition = CHUNK_WIDTH > CHUNK_HEIGHT ? (CHUNK_WIDTH > CHUNK_DEPTH ? CHUNK_WIDTH : CHUNK_DEPTH) : (CHUNK_HEIGHT > CHUNK_DEPTH ? CHUNK_HEIGHT : CHUNK_DEPTH);
+
+		if (f_maxPosition >= (1 << Mesher::POSITION_BITS) || Mesher::LAYER_SHIFT + Mesher::LAYER_BITS > 32)
+		{
+			return false;
+		}
+
+		for (int x = 0; x <= f_maxPosition; ++x)
+		{
+			for (int y = 0; y <= f_maxPosition; ++y)
+			{
+				for (int z = 0; z <= f_maxPosition; ++z)
+				{
+					for (int f_face = 0; f_face < 6; ++f_face)
+					{
+						for (int f_ao = 0; f_ao < 4; ++f_ao)
+						{
+							for (int f_layer = 0; f_layer < (1 << Mesher::LAYER_BITS); f_layer += 17)
+							{
+								MeshVertex f_vertex = { x, y, z, f_face, f_ao, f_layer };
+								MeshVertex f_unpacked = Mesher::unpackVertex(Mesher::packVertex(f_vertex));
+
+								if (f_unpacked.x != x || f_unpacked.y != y || f_unpacked.z != z ||
+									f_unpacked.face != f_face || f_unpacked.ao != f_ao || f_unpacked.layer != f_layer)
+								{
+									return false;
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// Times single voxel edits followed by remeshing the dirty chunks, and checks that meshing
+	/// only the dirty chunks after a batch of edits gives the same meshes as meshing everything.
+	/// </summary>
+	void remeshing(World *t_world, const std::vector<Indices> &t_positions)
+	{
+		typedef std::unordered_map<Indices, std::vector<PackedVertex>, IndicesHash> MeshMap;
+
+		MeshMap f_meshes;
+		RemeshQueue f_queue;
+		std::vector<PackedVertex> f_vertices;
+
+		auto f_remesh = [&](const Indices &t_position)
+		{
+			if (t_world->chunks.find(t_position) == nullptr)
+			{
+				f_meshes.erase(t_position);
+				return;
+			}
+
+			Mesher::meshChunk(*t_world, t_position, f_meshes[t_position]);
+		};
+
+		double f_fullNs = ab::Benchmark::run("Full world remesh (per chunk)", 3, (long long)t_positions.size(), [&]()
+		{
+			for (const Indices &f_position : t_positions)
+			{
+				f_remesh(f_position);
+			}
+		});
+
+		ab::Benchmark::report("Full world remesh", f_fullNs * t_positions.size() / 1000000.0, "ms");
+
+		t_world->clearDirtyChunks();
+
+		// Find surface voxels to edit by casting rays straight down
+		std::mt19937 f_random(42);
+		std::vector<Indices> f_surface;
+
+		for (int i = 0; i < 256; ++i)
+		{
+			RaycastHit f_hit;
+			glm::vec3 f_origin((float)(f_random() % WORLD_WIDTH), (float)WORLD_HEIGHT * 2, (float)(f_random() % WORLD_DEPTH));
+
+			if (t_world->raycast(f_origin, glm::vec3(0, -1, 0), (float)WORLD_HEIGHT * 4, f_hit))
+			{
+				f_surface.push_back(f_hit.previous);
+			}
+		}
+
+		std::size_t f_remeshed = 0;
+		std::size_t f_edits = 0;
+
+		// Place a block on the surface and then remove it again, meshing the dirty chunks after each edit
+		double f_editNs = ab::Benchmark::run("Single edit + remesh", 3, (long long)f_surface.size() * 2, [&]()
+		{
+			for (const Indices &f_cell : f_surface)
+			{
+				t_world->setVoxel(f_cell.x, f_cell.y, f_cell.z, BLOCK_GRASS);
+				f_queue.collect(*t_world);
+				f_remeshed += f_queue.process(1000.0, f_remesh);
+
+				t_world->setVoxel(f_cell.x, f_cell.y, f_cell.z, BLOCK_AIR);
+				f_queue.collect(*t_world);
+				f_remeshed += f_queue.process(1000.0, f_remesh);
+
+				f_edits += 2;
+			}
+		});
+
+		ab::Benchmark::report("Single edit latency", f_editNs / 1000.0, "us");
+		ab::Benchmark::report("Chunks remeshed per edit", (double)f_remeshed / f_edits, "chunks");
+
+		// A batch of random edits (including boxes across chunk borders), then compare against meshing from scratch
+		for (int i = 0; i < 500; ++i)
+		{
+			int x = f_random() % WORLD_WIDTH;
+			int y = f_random() % 48;
+			int z = f_random() % WORLD_DEPTH;
+			char f_type = (char)(f_random() % BLOCK_TYPE_COUNT);
+
+			if (i % 10 == 0)
+			{
+				t_world->fillBox(x, y, z, x + (int)(f_random() % 20), y + (int)(f_random() % 20), z + (int)(f_random() % 20), f_type);
+			}
+			else
+			{
+				t_world->setVoxel(x, y, z, f_type);
+			}
+		}
+
+		f_queue.collect(*t_world);
+
+		// Use a tiny budget so the queue has to be drained over several calls
+		while (f_queue.getCount() > 0)
+		{
+			f_queue.process(0.01, f_remesh);
+		}
+
+		bool f_matches = true;
+		std::size_t f_chunks = 0;
+
+		t_world->chunks.forEach([&](const Indices &t_position, Chunk *t_chunk)
+		{
+			Mesher::meshChunk(*t_world, t_position, f_vertices);
+
+			auto f_found = f_meshes.find(t_position);
+			f_matches &= f_found != f_meshes.end() && f_found->second == f_vertices;
+			f_chunks++;
+		});
+
+		f_matches &= f_chunks == f_meshes.size();
+
+		ab::Benchmark::check("Dirty chunk remesh matches full remesh", f_matches);
+	}
+}
+
+/// <summary>
+/// Meshes the default world with each meshing mode and compares the mesh sizes against per-voxel instancing.
+/// </summary>
+void meshBenchmark()
+{
+	ab::Benchmark::header("Chunk meshing");
+
+	ab::Terrain *f_terrain = new ab::Terrain();
+
+	World *f_world = new World();
+	f_world->populate(*f_terrain, nullptr);
+	f_world->optimiseWorldStorage();
+
+	delete f_terrain;
+
+	std::vector<Indices> f_positions;
+	std::size_t f_solidVoxels = 0;
+
+	f_world->chunks.forEach([&](const Indices &t_position, Chunk *t_chunk)
+	{
+		f_positions.push_back(t_position);
+		f_solidVoxels += t_chunk->getSolidCount();
+	});
+
+	std::vector<PackedVertex> f_vertices;
+	char f_padded[Mesher::PADDED_SIZE];
+
+	// Compare the three meshing modes (the neighbourhood is gathered once per chunk, so only meshing is timed)
+	const char *f_names[3] = { "Naive", "Culled", "Greedy" };
+	std::size_t f_quads[3] = { 0, 0, 0 };
+	std::vector<char> f_neighbourhoods(f_positions.size() * Mesher::PADDED_SIZE);
+
+	for (std::size_t i = 0; i < f_positions.size(); ++i)
+	{
+		Mesher::gatherNeighbourhood(*f_world, f_positions[i], &f_neighbourhoods[i * Mesher::PADDED_SIZE]);
+	}
+
+	for (int f_mode = Mesher::MESH_NAIVE; f_mode <= Mesher::MESH_GREEDY; ++f_mode)
+	{
+		std::string f_name = std::string(f_names[f_mode]) + " mesh (per chunk)";
+
+		ab::Benchmark::run(f_name, 3, (long long)f_positions.size(), [&]()
+		{
+			f_quads[f_mode] = 0;
+
+			for (std::size_t i = 0; i < f_positions.size(); ++i)
+			{
+				const char *f_neighbourhood = &f_neighbourhoods[i * Mesher::PADDED_SIZE];
+
+				switch (f_mode)
+				{
+				case Mesher::MESH_NAIVE: Mesher::meshNaive(f_neighbourhood, f_vertices); break;
+				case Mesher::MESH_CULLED: Mesher::meshCulled(f_neighbourhood, f_vertices); break;
+				default: Mesher::meshGreedy(f_neighbourhood, f_vertices); break;
+				}
+
+				f_quads[f_mode] += f_vertices.size() / 4;
+			}
+		});
+	}
+
+	ab::Benchmark::run("Gather neighbourhood (per chunk)", 3, (long long)f_positions.size(), [&]()
+	{
+		for (const Indices &f_position : f_positions)
+		{
+			Mesher::gatherNeighbourhood(*f_world, f_position, f_padded);
+		}
+
+		ab::Benchmark::keep(f_padded[0]);
+	});
+
+	// Check the face counts against a brute force count on a sample of chunks
+	bool f_matches = true;
+	bool f_covered = true;
+
+	for (std::size_t i = 0; i < f_positions.size(); i += 7)
+	{
+		Mesher::meshChunk(*f_world, f_positions[i], f_vertices, Mesher::MESH_CULLED);
+		int f_faces = (int)(f_vertices.size() / 4);
+		f_matches &= f_faces == countVisibleFaces(*f_world, f_positions[i]);
+
+		// Every greedy quad covers width x height faces (the first and third corners are opposite each other)
+		Mesher::meshChunk(*f_world, f_positions[i], f_vertices, Mesher::MESH_GREEDY);
+		int f_area = 0;
+
+		for (std::size_t v = 0; v < f_vertices.size(); v += 4)
+		{
+			MeshVertex f_first = Mesher::unpackVertex(f_vertices[v]);
+			MeshVertex f_third = Mesher::unpackVertex(f_vertices[v + 2]);
+			int f_extent[3] = { std::abs(f_third.x - f_first.x), std::abs(f_third.y - f_first.y), std::abs(f_third.z - f_first.z) };
+			f_extent[f_first.face / 2] = 1;
+
+			f_area += f_extent[0] * f_extent[1] * f_extent[2];
+		}
+
+		f_covered &= f_area == f_faces;
+	}
+
+	ab::Benchmark::check("Vertex pack/unpack round trip", checkVertexPacking());
+	ab::Benchmark::check("Culled faces match brute force", f_matches);
+	ab::Benchmark::check("Greedy quads cover the culled faces", f_covered);
+
+	for (int f_mode = Mesher::MESH_NAIVE; f_mode <= Mesher::MESH_GREEDY; ++f_mode)
+	{
+		std::string f_name = f_names[f_mode];
+		ab::Benchmark::report(f_name + " quads", (double)f_quads[f_mode], "quads");
+		ab::Benchmark::report(f_name + " vertices", (double)f_quads[f_mode] * 4, "vertices");
+		ab::Benchmark::report(f_name + " quads (per chunk)", (double)f_quads[f_mode] / f_positions.size(), "quads");
+	}
+
+	// Per-voxel instancing drew 12 triangles (36 indices into 24 vertices) for every voxel and uploaded a mat4 for each one
+	double f_instancedBytes = (double)f_solidVoxels * sizeof(glm::mat4);
+	double f_greedyBytes = (double)f_quads[Mesher::MESH_GREEDY] * 4 * sizeof(PackedVertex);
+
+	ab::Benchmark::report("Solid voxels", (double)f_solidVoxels, "voxels");
+	ab::Benchmark::report("Instanced triangles", (double)f_solidVoxels * 12, "triangles");
+	ab::Benchmark::report("Greedy triangles", (double)f_quads[Mesher::MESH_GREEDY] * 2, "triangles");
+	ab::Benchmark::report("Packed vertex size", (double)sizeof(PackedVertex), "bytes");
+	ab::Benchmark::report("Instanced upload", f_instancedBytes / (1024.0 * 1024.0), "MB");
+	ab::Benchmark::report("Greedy upload", f_greedyBytes / (1024.0 * 1024.0), "MB");
+
+	remeshing(f_world, f_positions);
+
+	delete f_world;
+}
@@ -0,0 +1,106 @@
+#include "Benchmark.h"
+#include "ModelLoader.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	const char *MODEL_PATHS[] = { "models/generic-block.obj", "../ab-voxeng/models/generic-block.obj" };
+	const char *GENERATED_PATH = "bench-cubes.obj";
+	const int CUBES = 500;
+
+	/// <summary>
+	/// Writes an OBJ file of separate cubes, each face with its own normal and UVs (24 distinct vertices per cube).
+	/// </summary>
+	bool writeCubes(const char *t_path, int t_cubes)
+	{
+		const int CORNERS[6][4] = { { 1, 5, 7, 3 }, { 4, 6, 2, 0 }, { 2, 6, 7, 3 }, { 0, 1, 5, 4 }, { 4, 5, 7, 6 }, { 0, 2, 3, 1 } };
+		std::ofstream f_file(t_path);
+
+		f_file << "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n";
+		f_file << "vn 1 0 0\nvn -1 0 0\nvn 0 1 0\nvn 0 -1 0\nvn 0 0 1\nvn 0 0 -1\n";
+
+		for (int i = 0; i < t_cubes; ++i)
+		{
+			// Corner c is at (c & 1, c & 2, c & 4), offset so no two cubes share a position
+			for (int c = 0; c < 8; ++c)
+			{
+				f_file << "v " << (c & 1) + i * 2 << " " << ((c >> 1) & 1) << " " << ((c >> 2) & 1) << "\n";
+			}
+
+			for (int f = 0; f < 6; ++f)
+			{
+				int f_v[4];
+
+				for (int c = 0; c < 4; ++c)
+				{
+					f_v[c] = i * 8 + CORNERS[f][c] + 1;
+				}
+
+				f_file << "f " << f_v[0] << "/1/" << f + 1 << " " << f_v[1] << "/2/" << f + 1 << " " << f_v[2] << "/3/" << f + 1 << "\n";
+				f_file << "f " << f_v[0] << "/1/" << f + 1 << " " << f_v[2] << "/3/" << f + 1 << " " << f_v[3] << "/4/" << f + 1 << "\n";
+			}
+		}
+
+		return (bool)f_file;
+	}
+
+	/// <summary>
+	/// Loads an OBJ file into fresh buffers.
+	/// </summary>
+	bool load(const char *t_path, std::vector<glm::vec3> &t_vertices, std::vector<unsigned short> &t_indices)
+	{
+		std::vector<glm::vec2> f_uvs;
+		std::vector<glm::vec3> f_normals;
+		t_vertices.clear();
+		t_indices.clear();
+
+		return ab::ModelLoader::loadOBJ(t_path, t_vertices, f_uvs, f_normals, t_indices);
+	}
+}
+
+/// <summary>
+/// Checks and benchmarks loading OBJ models.
+/// </summary>
+void modelBenchmark()
+{
+	ab::Benchmark::header("Model loading");
+
+	std::vector<glm::vec3> f_vertices;
+	std::vector<unsigned short> f_indices;
+
+	bool f_written = writeCubes(GENERATED_PATH, CUBES);
+	bool f_loaded = f_written && load(GENERATED_PATH, f_vertices, f_indices);
+
+	ab::Benchmark::check("OBJ vertices are shared between triangles", f_loaded && f_vertices.size() == 24 * CUBES && f_indices.size() == 36 * CUBES);
+
+	double f_loadNs = ab::Benchmark::run("loadOBJ (" + std::to_string(CUBES) + " cubes)/triangle", 5, 12 * CUBES, [&]()
+	{
+		load(GENERATED_PATH, f_vertices, f_indices);
+		ab::Benchmark::keep(f_indices.size());
+	});
+
+	ab::Benchmark::report("loadOBJ", 1000.0 / f_loadNs, "M triangles/s");
+	std::remove(GENERATED_PATH);
+
+	// The game's own block model, if the benchmarks are run from somewhere it can be found
+	for (const char *f_path : MODEL_PATHS)
+	{
+		std::ifstream f_file(f_path);
+
+		if (f_file)
+		{
+			f_file.close();
+			ab::Benchmark::run("loadOBJ (block model)", 20, 1, [&]()
+			{
+				load(f_path, f_vertices, f_indices);
+				ab::Benchmark::keep(f_indices.size());
+			});
+
+			break;
+		}
+	}
+}
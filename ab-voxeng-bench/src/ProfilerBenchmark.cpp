@@ -0,0 +1,199 @@
+#include "Benchmark.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#if AB_PROFILE
+namespace
+{
+	const char *TRACE_PATH = "bench-trace.json";
+
+	/// <summary>
+	/// Finds the captured events of the thread that recorded an event with the specified name.
+	/// </summary>
+	const ab::Profiler::ThreadEvents *findThread(const std::vector<ab::Profiler::ThreadEvents> &t_threads, const char *t_name)
+	{
+		for (const ab::Profiler::ThreadEvents &f_thread : t_threads)
+		{
+			for (const ab::Profiler::Event &f_event : f_thread.events)
+			{
+				if (std::strcmp(f_event.name, t_name) == 0)
+				{
+					return &f_thread;
+				}
+			}
+		}
+
+		return nullptr;
+	}
+
+	/// <summary>
+	/// Finds the first captured event with the specified name on a thread.
+	/// </summary>
+	const ab::Profiler::Event *findEvent(const ab::Profiler::ThreadEvents &t_thread, const char *t_name)
+	{
+		for (const ab::Profiler::Event &f_event : t_thread.events)
+		{
+			if (std::strcmp(f_event.name, t_name) == 0)
+			{
+				return &f_event;
+			}
+		}
+
+		return nullptr;
+	}
+
+	/// <summary>
+	/// Checks that nested zones and counters are recorded, and that clearing forgets them.
+	/// </summary>
+	void nesting()
+	{
+		ab::Profiler::clear();
+
+		{
+			PROFILE_SCOPE("Outer");
+
+			{
+				PROFILE_SCOPE("Inner");
+				PROFILE_COUNTER("Counter", 42);
+			}
+		}
+
+		std::vector<ab::Profiler::ThreadEvents> f_threads = ab::Profiler::capture();
+		const ab::Profiler::ThreadEvents *f_thread = findThread(f_threads, "Outer");
+		bool f_nested = false;
+		bool f_counted = false;
+
+		if (f_thread != nullptr)
+		{
+			const ab::Profiler::Event *f_outer = findEvent(*f_thread, "Outer");
+			const ab::Profiler::Event *f_inner = findEvent(*f_thread, "Inner");
+			const ab::Profiler::Event *f_counter = findEvent(*f_thread, "Counter");
+
+			f_nested = f_inner != nullptr && f_inner->depth == f_outer->depth + 1 && f_inner->start >= f_outer->start &&
+				f_inner->start + f_inner->duration <= f_outer->start + f_outer->duration;
+			f_counted = f_counter != nullptr && f_counter->type == ab::Profiler::EventType::COUNTER && f_counter->value == 42.0 && f_counter->depth == f_inner->depth + 1;
+		}
+
+		ab::Benchmark::check("Profiler records nested zones", f_nested);
+		ab::Benchmark::check("Profiler records counters", f_counted);
+
+		ab::Profiler::clear();
+		ab::Benchmark::check("Clearing the profiler forgets earlier zones", findThread(ab::Profiler::capture(), "Outer") == nullptr);
+	}
+
+	/// <summary>
+	/// Checks that every thread gets a buffer of its own, that a full buffer keeps the newest events, and that the trace can be exported.
+	/// </summary>
+	void threads()
+	{
+		ab::Profiler::clear();
+
+		// Threads get increasing IDs, so the workers are the threads after this one
+		PROFILE_COUNTER("Threads before", 0);
+		std::uint32_t f_lastThread = findThread(ab::Profiler::capture(), "Threads before")->id;
+
+		// The workers have all started (and named themselves) once the job system has been destroyed
+		{
+			ab::JobSystem f_jobs(2);
+			f_jobs.parallelFor(0, 64, 1, [](int t_begin, int t_end) {});
+		}
+
+		const long long EXTRA = 100;
+		std::thread f_thread([EXTRA]()
+		{
+			PROFILE_THREAD("Bench ring");
+
+			for (long long i = 0; i < ab::Profiler::EVENTS_PER_THREAD + EXTRA; ++i)
+			{
+				PROFILE_COUNTER("Ring", i);
+			}
+		});
+
+		f_thread.join();
+
+		std::vector<ab::Profiler::ThreadEvents> f_threads = ab::Profiler::capture();
+		int f_workers = 0;
+		bool f_jobs = false;
+		bool f_wrapped = false;
+
+		for (const ab::Profiler::ThreadEvents &f_events : f_threads)
+		{
+			f_workers += f_events.id > f_lastThread && f_events.name.compare(0, 7, "Worker ") == 0;
+			f_jobs = f_jobs || findEvent(f_events, "Job") != nullptr;
+
+			if (f_events.name == "Bench ring")
+			{
+				f_wrapped = f_events.events.size() == ab::Profiler::EVENTS_PER_THREAD && f_events.events.front().value == (double)EXTRA &&
+					f_events.events.back().value == (double)(ab::Profiler::EVENTS_PER_THREAD + EXTRA - 1);
+			}
+		}
+
+		ab::Benchmark::check("Profiler names worker threads and records jobs", f_workers >= 2 && f_jobs);
+		ab::Benchmark::check("Profiler ring buffers keep the newest events", f_wrapped);
+
+		bool f_written = ab::Profiler::writeChromeTrace(TRACE_PATH);
+		std::ifstream f_file(TRACE_PATH);
+		std::stringstream f_trace;
+		f_trace << f_file.rdbuf();
+		f_file.close();
+		std::string f_text = f_trace.str();
+
+		ab::Benchmark::check("Profiler exports a Chrome trace", f_written && f_text.compare(0, 18, "{\"displayTimeUnit\"") == 0 &&
+			f_text.find("\"name\":\"thread_name\"") != std::string::npos && f_text.find("\"ph\":\"X\",\"name\":\"Job\"") != std::string::npos &&
+			f_text.find("\"ph\":\"C\",\"name\":\"Ring\"") != std::string::npos && f_text.compare(f_text.size() - 4, 4, "\n]}\n") == 0);
+		ab::Benchmark::report("Chrome trace size", f_text.size() / 1024.0, "KB");
+
+		std::remove(TRACE_PATH);
+		ab::Profiler::clear();
+	}
+
+	/// <summary>
+	/// Times recording an empty zone and a counter.
+	/// </summary>
+	void overhead()
+	{
+		const int ZONES = 1 << 20;
+
+		double f_zoneNs = ab::Benchmark::run("PROFILE_SCOPE/zone", 5, ZONES, [&]()
+		{
+			for (int i = 0; i < ZONES; ++i)
+			{
+				PROFILE_SCOPE("Empty");
+			}
+		});
+
+		ab::Benchmark::run("PROFILE_COUNTER/counter", 5, ZONES, [&]()
+		{
+			for (int i = 0; i < ZONES; ++i)
+			{
+				PROFILE_COUNTER("Empty", i);
+			}
+		});
+
+		ab::Benchmark::report("Zones per 16.6 ms frame at 1% overhead", 166000.0 / f_zoneNs, "zones");
+		ab::Profiler::clear();
+	}
+}
+#endif
+
+/// <summary>
+/// Checks and benchmarks the profiler (only when it's compiled in, see AB_PROFILE).
+/// </summary>
+void profilerBenchmark()
+{
+	ab::Benchmark::header("Profiler");
+
+#if AB_PROFILE
+	nesting();
+	threads();
+	overhead();
+#else
+	ab::Benchmark::report("Profiler compiled out (AB_PROFILE is 0)", 0.0, "zones");
+#endif
+}
@@ -0,0 +1,734 @@
+#include "Benchmark.h"
+#include "ChunkIO.h"
+#include "ChunkStreamer.h"
+#include "JobSystem.h"
+#include "RegionFile.h"
+#include "RegionStore.h"
+#include "Terrain.h"
+#include "World.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+	const char *DIRECTORY = "bench-regions";
+	const int COLUMNS = ab::RegionFile::COLUMNS;
+
+	/// <summary>
+	/// Generates one region's worth of columns (starting at column 0, 0) into a world.
+	/// </summary>
+	void generateRegion(World &t_world, const ab::Terrain &t_terrain)
+	{
+		std::vector<char> f_voxels(ab::Terrain::COLUMN_VOXELS);
+		bool f_used[ab::Terrain::COLUMN_CHUNKS];
+
+		for (int x = 0; x < COLUMNS; ++x)
+		{
+			for (int z = 0; z < COLUMNS; ++z)
+			{
+				t_terrain.generateColumn(x, z, f_voxels.data(), f_used);
+
+				for (int cy = 0; cy < ab::Terrain::COLUMN_CHUNKS; ++cy)
+				{
+					if (f_used[cy])
+					{
+						t_world.setChunkVoxels({ x, cy, z }, &f_voxels[cy * ab::Terrain::CHUNK_VOXELS]);
+					}
+				}
+			}
+		}
+	}
+
+	/// <summary>
+	/// Checks that two worlds have the same voxels in a square of columns.
+	/// </summary>
+	bool sameColumns(const World &a, const World &b, int t_x1, int t_z1, int t_x2, int t_z2)
+	{
+		for (int x = t_x1; x <= t_x2; ++x)
+		{
+			for (int z = t_z1; z <= t_z2; ++z)
+			{
+				for (int cy = 0; cy < ab::RegionFile::COLUMN_CHUNKS; ++cy)
+				{
+					Chunk *f_a = a.chunks.find({ x, cy, z });
+					Chunk *f_b = b.chunks.find({ x, cy, z });
+
+					for (int i = 0; i < ab::RegionFile::CHUNK_VOXELS; ++i)
+					{
+						if ((f_a != nullptr ? f_a->getVoxel(i) : 0) != (f_b != nullptr ? f_b->getVoxel(i) : 0))
+						{
+							return false;
+						}
+					}
+				}
+			}
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// Deletes the region files written by the benchmarks (anywhere in the generated area) and their directory.
+	/// </summary>
+	void removeRegions(const RegionStore &t_regions)
+	{
+		for (int x = -1; x <= WORLD_WIDTH / CHUNK_WIDTH / COLUMNS; ++x)
+		{
+			for (int z = -1; z <= WORLD_DEPTH / CHUNK_DEPTH / COLUMNS; ++z)
+			{
+				std::remove(t_regions.getRegionPath(x, z).c_str());
+			}
+		}
+
+#ifdef _WIN32
+		_rmdir(t_regions.getDirectory().c_str());
+#else
+		rmdir(t_regions.getDirectory().c_str());
+#endif
+	}
+
+	/// <summary>
+	/// Checks that chunks survive compression, and that damaged data is rejected.
+	/// </summary>
+	void compression()
+	{
+		const int SIZE = ab::RegionFile::CHUNK_VOXELS;
+		std::vector<char> f_result(SIZE, 0);
+		std::vector<unsigned char> f_data;
+		bool f_passed = true;
+
+		// All air, a single voxel, random voxels (the worst case) and a terrain chunk
+		std::mt19937 f_random(4321);
+		std::vector<std::vector<char>> f_chunks(3, std::vector<char>(SIZE, 0));
+		f_chunks[1][SIZE - 1] = BLOCK_LEAF;
+
+		for (char &f_voxel : f_chunks[2])
+		{
+			f_voxel = (char)(f_random() % BLOCK_TYPE_COUNT);
+		}
+
+		ab::Terrain f_terrain(WORLD_SEED);
+		std::vector<char> f_column(ab::Terrain::COLUMN_VOXELS);
+		bool f_used[ab::Terrain::COLUMN_CHUNKS];
+		f_terrain.generateColumn(3, 5, f_column.data(), f_used);
+		f_chunks.push_back(std::vector<char>(f_column.begin(), f_column.begin() + SIZE));
+
+		for (const std::vector<char> &f_chunk : f_chunks)
+		{
+			ab::RegionFile::compress(f_chunk.data(), f_data);
+			f_passed = f_passed && ab::RegionFile::decompress(f_data.data(), f_data.size(), f_result.data()) && f_result == f_chunk;
+		}
+
+		ab::Benchmark::check("Chunk compression round trip", f_passed);
+
+		// Cut short, one run too many, a run of 0 voxels, and voxel types that don't exist
+		std::vector<unsigned char> f_unknown;
+		std::vector<unsigned char> f_negative;
+		ab::RegionFile::compress(std::vector<char>(SIZE, BLOCK_TYPE_COUNT).data(), f_unknown);
+		ab::RegionFile::compress(std::vector<char>(SIZE, (char)-1).data(), f_negative);
+		ab::RegionFile::compress(f_chunks[3].data(), f_data);
+		std::vector<unsigned char> f_extra = f_data;
+		f_extra.push_back(BLOCK_GRASS);
+		f_extra.push_back(1);
+		unsigned char f_empty[] = { 0, 0 };
+
+		bool f_rejected = !ab::RegionFile::decompress(f_data.data(), f_data.size() - 2, f_result.data()) &&
+			!ab::RegionFile::decompress(f_data.data(), f_data.size() - 1, f_result.data()) &&
+			!ab::RegionFile::decompress(f_extra.data(), f_extra.size(), f_result.data()) &&
+			!ab::RegionFile::decompress(f_empty, 2, f_result.data()) &&
+			!ab::RegionFile::decompress(f_unknown.data(), f_unknown.size(), f_result.data()) &&
+			!ab::RegionFile::decompress(f_negative.data(), f_negative.size(), f_result.data());
+
+		ab::Benchmark::check("Damaged chunk data is rejected", f_rejected);
+		ab::Benchmark::report("Compressed terrain chunk", (double)f_data.size(), "bytes");
+
+		// Throughput over the chunks of a whole region
+		World f_world;
+		generateRegion(f_world, f_terrain);
+		std::vector<std::vector<char>> f_regionChunks;
+
+		f_world.chunks.forEach([&](const Indices &t_position, Chunk *t_chunk)
+		{
+			std::vector<char> f_chunk(SIZE);
+
+			for (int i = 0; i < SIZE; ++i)
+			{
+				f_chunk[i] = t_chunk->getVoxel(i);
+			}
+
+			f_regionChunks.push_back(f_chunk);
+		});
+
+		std::vector<std::vector<unsigned char>> f_compressed(f_regionChunks.size());
+		std::size_t f_compressedBytes = 0;
+		long long f_bytes = (long long)f_regionChunks.size() * SIZE;
+
+		double f_compressNs = ab::Benchmark::run("Chunk compression/voxel", 5, f_bytes, [&]()
+		{
+			for (std::size_t i = 0; i < f_regionChunks.size(); ++i)
+			{
+				ab::RegionFile::compress(f_regionChunks[i].data(), f_compressed[i]);
+			}
+		});
+
+		for (const std::vector<unsigned char> &f_chunk : f_compressed)
+		{
+			f_compressedBytes += f_chunk.size();
+		}
+
+		double f_decompressNs = ab::Benchmark::run("Chunk decompression/voxel", 5, f_bytes, [&]()
+		{
+			for (std::size_t i = 0; i < f_compressed.size(); ++i)
+			{
+				ab::RegionFile::decompress(f_compressed[i].data(), f_compressed[i].size(), f_result.data());
+				ab::Benchmark::keep(f_result[0]);
+			}
+		});
+
+		ab::Benchmark::report("Chunk compression", 1000.0 / f_compressNs, "MB/s");
+		ab::Benchmark::report("Chunk decompression", 1000.0 / f_decompressNs, "MB/s");
+		ab::Benchmark::report("Compression ratio (terrain)", (double)f_bytes / f_compressedBytes, "x");
+	}
+
+	/// <summary>
+	/// Checks that a saved world loads back the same, one column at a time, and that the region files are checked when they're opened.
+	/// </summary>
+	void roundTrip()
+	{
+		ab::Terrain f_terrain(WORLD_SEED);
+		World f_world;
+		generateRegion(f_world, f_terrain);
+
+		// Some edits, including a column that's dug out completely and a column in a negative region
+		f_world.fillBox(20, 0, 20, 40, 100, 22, BLOCK_TREE);
+		f_world.fillBox(32, 0, 32, 47, WORLD_HEIGHT - 1, 47, BLOCK_AIR);
+		f_world.setVoxel(-5, 10, -7, BLOCK_LEAF);
+
+		RegionStore f_regions(DIRECTORY);
+		ab::Benchmark::check("World saves to region files", f_world.save(f_regions) && f_regions.getPendingCount() == 0);
+
+		RegionStore f_loadedRegions(DIRECTORY);
+		World f_loaded;
+		int f_columnsLoaded = 0;
+
+		// Only columns with chunks in them are saved (the dug out column is all air)
+		for (int x = -1; x < COLUMNS; ++x)
+		{
+			for (int z = -1; z < COLUMNS; ++z)
+			{
+				f_columnsLoaded += f_loaded.loadColumn(f_loadedRegions, x, z) ? 1 : 0;
+			}
+		}
+
+		bool f_same = f_columnsLoaded == COLUMNS * COLUMNS && sameColumns(f_world, f_loaded, -1, -1, COLUMNS - 1, COLUMNS - 1);
+		ab::Benchmark::check("Saved world loads back the same", f_same && f_loaded.getVoxel(-5, 10, -7) == BLOCK_LEAF);
+		ab::Benchmark::check("Unsaved columns aren't loaded", !f_loaded.loadColumn(f_loadedRegions, COLUMNS + 3, 0) && !f_loadedRegions.hasColumn(-20, 4));
+
+		// Saving some columns again keeps the rest of the region
+		f_loaded.setVoxel(1, 120, 1, BLOCK_WATER);
+		f_loadedRegions.writeColumn(0, 0, f_loaded);
+		bool f_pendingRead = f_loadedRegions.getPendingCount() == 1;
+		f_pendingRead = f_pendingRead && f_loaded.loadColumn(f_loadedRegions, 0, 0) && f_loaded.getVoxel(1, 120, 1) == BLOCK_WATER;
+		ab::Benchmark::check("Saved columns can be read before they're flushed", f_pendingRead);
+
+		f_loadedRegions.flush();
+		RegionStore f_mergedRegions(DIRECTORY);
+		World f_merged;
+
+		for (int x = 0; x < COLUMNS; ++x)
+		{
+			for (int z = 0; z < COLUMNS; ++z)
+			{
+				f_merged.loadColumn(f_mergedRegions, x, z);
+			}
+		}
+
+		ab::Benchmark::check("Flushing keeps the region's other columns", sameColumns(f_loaded, f_merged, 0, 0, COLUMNS - 1, COLUMNS - 1));
+
+		// A chunk can be read on its own, straight from the mapped file
+		ab::RegionFile f_file;
+		std::vector<char> f_voxels(ab::RegionFile::CHUNK_VOXELS);
+		bool f_opened = f_file.open(f_regions.getRegionPath(0, 0)) && f_file.getRegionX() == 0 && f_file.getRegionZ() == 0;
+		bool f_randomAccess = f_opened && f_file.readChunk(ab::RegionFile::getChunkIndex(ab::RegionFile::getColumn(7, 9), 2), f_voxels.data());
+		Chunk *f_chunk = f_merged.chunks.find({ 7, 2, 9 });
+
+		for (int i = 0; i < ab::RegionFile::CHUNK_VOXELS && f_randomAccess; ++i)
+		{
+			f_randomAccess = f_voxels[i] == (f_chunk != nullptr ? f_chunk->getVoxel(i) : 0);
+		}
+
+		ab::Benchmark::check("Region chunks can be read on their own", f_randomAccess);
+		ab::Benchmark::report("Region file size", f_file.getFileSize() / 1024.0, "KB");
+		f_file.close();
+
+		// Files with a different version, a damaged header or the wrong magic aren't opened
+		std::string f_path = f_regions.getRegionPath(0, 0);
+		std::string f_copy = std::string(DIRECTORY) + "/copy.abr";
+		std::vector<unsigned char> f_bytes;
+		std::FILE *f_in = std::fopen(f_path.c_str(), "rb");
+		int f_byte;
+
+		while (f_in != nullptr && (f_byte = std::fgetc(f_in)) != EOF)
+		{
+			f_bytes.push_back((unsigned char)f_byte);
+		}
+
+		if (f_in != nullptr)
+		{
+			std::fclose(f_in);
+		}
+
+		auto f_opens = [&](std::size_t t_size, std::size_t t_offset, unsigned char t_value)
+		{
+			std::vector<unsigned char> f_changed(f_bytes.begin(), f_bytes.begin() + t_size);
+			f_changed[t_offset] = t_value;
+			std::FILE *f_out = std::fopen(f_copy.c_str(), "wb");
+			std::fwrite(f_changed.data(), 1, f_changed.size(), f_out);
+			std::fclose(f_out);
+
+			ab::RegionFile f_region;
+			return f_region.open(f_copy);
+		};
+
+		bool f_checked = f_bytes.size() > 1024 && f_opens(f_bytes.size(), 4, f_bytes[4]) &&
+			!f_opens(f_bytes.size(), 4, (unsigned char)(ab::RegionFile::VERSION + 1)) &&
+			!f_opens(f_bytes.size(), 0, 'X') &&
+			!f_opens(f_bytes.size(), 16, CHUNK_WIDTH * 2) &&
+			!f_opens(1024, 4, f_bytes[4]);
+
+		ab::Benchmark::check("Region files are checked when they're opened", f_checked);
+		std::remove(f_copy.c_str());
+
+		removeRegions(f_regions);
+	}
+
+	/// <summary>
+	/// Checks that edits survive the streamer unloading their column, and being saved and loaded again.
+	/// </summary>
+	void streaming()
+	{
+		ab::Terrain f_terrain(WORLD_SEED);
+		ab::JobSystem f_jobs(2);
+		RegionStore f_regions(DIRECTORY);
+		glm::vec3 f_eye(8.0f, 60.0f, 8.0f);
+		glm::vec3 f_direction(1.0f, 0.0f, 0.0f);
+		bool f_kept;
+		bool f_outside;
+		bool f_onlyEdited;
+
+		{
+			// The streamer is destroyed first, it waits for its reads
+			ChunkIO f_io(f_regions, f_jobs);
+			World f_world;
+			ChunkStreamer f_streamer(f_world, f_terrain, f_jobs);
+			f_streamer.setLoadRadius(4);
+			f_streamer.setChunkIO(&f_io);
+
+			for (int i = 0; i < 20; ++i)
+			{
+				f_streamer.update(f_eye, f_direction);
+				f_streamer.finish();
+			}
+
+			f_world.setVoxel(3, 126, 3, BLOCK_LEAF);
+
+			// Above and below the world's height, where chunks would never be saved or unloaded
+			f_world.setVoxel(3, WORLD_HEIGHT, 3, BLOCK_LEAF);
+			f_world.setVoxel(3, -1, 3, BLOCK_LEAF);
+			f_world.fillBox(5, WORLD_HEIGHT - 1, 5, 6, WORLD_HEIGHT + 40, 6, BLOCK_TREE);
+			f_world.setVoxels({ { 7, -20, 7, BLOCK_WATER } });
+			f_outside = f_world.getVoxel(3, WORLD_HEIGHT, 3) == BLOCK_AIR && f_world.getVoxel(3, -1, 3) == BLOCK_AIR &&
+				f_world.getVoxel(5, WORLD_HEIGHT - 1, 5) == BLOCK_TREE && f_world.getVoxel(5, WORLD_HEIGHT, 5) == BLOCK_AIR;
+
+			// Far enough away that the edited column is unloaded, then come back
+			for (int i = 0; i < 20; ++i)
+			{
+				f_streamer.update(f_eye + glm::vec3(400.0f, 0.0f, 0.0f), f_direction);
+				f_streamer.finish();
+			}
+
+			bool f_unloaded = !f_streamer.isResident(0, 0);
+			f_onlyEdited = f_unloaded && f_regions.hasColumn(0, 0) && !f_regions.hasColumn(1, 1) && !f_world.isColumnModified(0, 0);
+			f_outside = f_outside && f_unloaded && f_world.chunks.find({ 0, ab::RegionFile::COLUMN_CHUNKS, 0 }) == nullptr && f_world.chunks.find({ 0, -1, 0 }) == nullptr;
+
+			for (int i = 0; i < 20; ++i)
+			{
+				f_streamer.update(f_eye, f_direction);
+				f_streamer.finish();
+			}
+
+			f_kept = f_unloaded && f_world.getVoxel(3, 126, 3) == BLOCK_LEAF;
+			f_world.setVoxel(4, 126, 4, BLOCK_WATER);
+			f_streamer.save();
+		}
+
+		ab::Benchmark::check("Edits survive their column being unloaded", f_kept);
+		ab::Benchmark::check("Edits outside the world's height are ignored", f_outside);
+		ab::Benchmark::check("Only edited columns are saved", f_onlyEdited);
+
+		// A new streamer loads the saved world instead of generating it
+		RegionStore f_saved(DIRECTORY);
+		ChunkIO f_io(f_saved, f_jobs);
+		World f_world;
+
+		{
+			ChunkStreamer f_streamer(f_world, f_terrain, f_jobs);
+			f_streamer.setLoadRadius(4);
+			f_streamer.setChunkIO(&f_io);
+			f_streamer.update(f_eye, f_direction);
+			f_streamer.finish();
+		}
+
+		ab::Benchmark::check("Saved edits are streamed back in", f_world.getVoxel(3, 126, 3) == BLOCK_LEAF && f_world.getVoxel(4, 126, 4) == BLOCK_WATER);
+
+		removeRegions(f_regions);
+	}
+
+	/// <summary>
+	/// Checks that ChunkIO reads and writes columns off the main thread, and times how long reads take and how long a frame takes while streaming a saved world.
+	/// </summary>
+	void chunkIO()
+	{
+		ab::Terrain f_terrain(WORLD_SEED);
+		ab::JobSystem f_jobs(2);
+
+		{
+			World f_world;
+			RegionStore f_regions(DIRECTORY);
+			generateRegion(f_world, f_terrain);
+			f_world.save(f_regions);
+		}
+
+		RegionStore f_regions(DIRECTORY);
+		std::vector<char> f_expected(ab::RegionFile::COLUMN_CHUNKS * ab::RegionFile::CHUNK_VOXELS);
+		bool f_expectedUsed[ab::RegionFile::COLUMN_CHUNKS];
+		bool f_mainThread = true;
+		bool f_same = true;
+		bool f_missing = false;
+		int f_callbacks = 0;
+		ChunkIO::Stats f_stats;
+
+		{
+			ChunkIO f_io(f_regions, f_jobs);
+
+			// Every column is asked for twice
+			for (int i = 0; i < 2; ++i)
+			{
+				for (int x = 0; x < COLUMNS; ++x)
+				{
+					for (int z = 0; z < 4; ++z)
+					{
+						f_io.readColumn(x, z, [&, x, z](const std::shared_ptr<ChunkIO::ColumnData> &t_column)
+						{
+							f_callbacks++;
+							f_mainThread = f_mainThread && f_jobs.isMainThread();
+							f_same = f_same && t_column->found && f_regions.readColumn(x, z, f_expected.data(), f_expectedUsed);
+
+							for (int cy = 0; f_same && cy < ab::RegionFile::COLUMN_CHUNKS; ++cy)
+							{
+								int f_offset = cy * ab::RegionFile::CHUNK_VOXELS;
+								f_same = t_column->used[cy] == f_expectedUsed[cy] &&
+									(!f_expectedUsed[cy] || std::memcmp(&t_column->voxels[f_offset], &f_expected[f_offset], ab::RegionFile::CHUNK_VOXELS) == 0);
+							}
+						});
+					}
+				}
+			}
+
+			f_io.readColumn(COLUMNS + 3, 0, [&](const std::shared_ptr<ChunkIO::ColumnData> &t_column)
+			{
+				f_callbacks++;
+				f_missing = !t_column->found;
+			});
+
+			f_io.finish();
+			f_stats = f_io.getStats();
+		}
+
+		ab::Benchmark::check("Chunk I/O callbacks run on the main thread", f_mainThread && f_callbacks == 2 * COLUMNS * 4 + 1);
+		ab::Benchmark::check("Chunk I/O reads the saved columns", f_same);
+		ab::Benchmark::check("Chunk I/O reports unsaved columns as missing", f_missing);
+		ab::Benchmark::check("Chunk I/O merges reads of the same column", f_stats.columnsRead < f_stats.readRequests);
+
+		// Writes wait for a flush, or for enough of them to be worth one
+		bool f_waited;
+		bool f_readBack = false;
+		bool f_flushed;
+		bool f_batched = false;
+
+		{
+			ChunkIO f_io(f_regions, f_jobs);
+			World f_world;
+			f_world.loadColumn(f_regions, 2, 2);
+			f_world.setVoxel(2 * CHUNK_WIDTH + 1, 126, 2 * CHUNK_DEPTH + 1, BLOCK_LEAF);
+			f_io.writeColumn(2, 2, f_world);
+			f_waited = f_io.getStats().pendingWrites == 1;
+
+			// The write is only queued, a read asked for after it still has to see it
+			f_io.readColumn(2, 2, [&](const std::shared_ptr<ChunkIO::ColumnData> &t_column)
+			{
+				int f_index = (126 / CHUNK_HEIGHT) * ab::RegionFile::CHUNK_VOXELS + World::getVoxelIndex(1, 126, 1);
+				f_readBack = t_column->found && t_column->voxels[f_index] == BLOCK_LEAF;
+			});
+
+			f_io.flush();
+			f_io.finish();
+			RegionStore f_reopened(DIRECTORY);
+			World f_check;
+			f_flushed = f_io.getStats().pendingWrites == 0 && f_check.loadColumn(f_reopened, 2, 2) && f_check.getVoxel(2 * CHUNK_WIDTH + 1, 126, 2 * CHUNK_DEPTH + 1) == BLOCK_LEAF;
+
+			for (int i = 0; i < REGION_FLUSH_COLUMNS; ++i)
+			{
+				f_io.writeColumn(2, 2, f_world);
+			}
+
+			// Well before CHUNK_IO_WRITE_DELAY_MS
+			for (int i = 0; i < 100 && !f_batched; ++i)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(5));
+				f_batched = f_io.getStats().pendingWrites == 0;
+			}
+		}
+
+		ab::Benchmark::check("Chunk I/O writes wait to be flushed", f_waited);
+		ab::Benchmark::check("Chunk I/O reads see columns saved before them", f_readBack);
+		ab::Benchmark::check("Chunk I/O flushes saved columns to disk", f_flushed);
+		ab::Benchmark::check("Chunk I/O flushes once enough columns are saved", f_batched);
+
+		// Histogram buckets are powers of 2 microseconds
+		ChunkIO::LatencyHistogram f_histogram;
+		f_histogram.add(0.5);
+		f_histogram.add(3.0);
+		f_histogram.add(3.0);
+		f_histogram.add(3.0);
+		f_histogram.add(100.0);
+
+		ab::Benchmark::check("Latency histogram percentiles", f_histogram.getPercentile(0.0) == 1.0 && f_histogram.getPercentile(50.0) == 4.0 &&
+			f_histogram.getPercentile(99.0) == 100.0 && f_histogram.getBucket(2) == 3 && std::abs(f_histogram.getMean() - 21.9) < 0.001);
+
+		// Fly over the saved region, timing the main thread's share of each frame
+		double f_worstFrameMs = 0.0;
+		int f_frames = 0;
+
+		{
+			ChunkIO f_io(f_regions, f_jobs);
+			World f_world;
+			ChunkStreamer f_streamer(f_world, f_terrain, f_jobs);
+			f_streamer.setLoadRadius(4);
+			f_streamer.setChunkIO(&f_io);
+
+			for (float x = 0.0f; x < COLUMNS * CHUNK_WIDTH; x += 2.0f)
+			{
+				auto f_start = std::chrono::steady_clock::now();
+				f_streamer.update(glm::vec3(x, 60.0f, COLUMNS * CHUNK_DEPTH / 2), glm::vec3(1.0f, 0.0f, 0.0f));
+				f_jobs.pump();
+				f_worstFrameMs = std::max(f_worstFrameMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - f_start).count());
+				f_frames++;
+			}
+
+			f_streamer.finish();
+			f_stats = f_io.getStats();
+		}
+
+		ab::Benchmark::report("Chunk I/O read latency p50", f_stats.reads.getPercentile(50.0) / 1000.0, "ms");
+		ab::Benchmark::report("Chunk I/O read latency p99", f_stats.reads.getPercentile(99.0) / 1000.0, "ms");
+		ab::Benchmark::report("Chunk I/O columns per read batch", (double)f_stats.columnsRead / std::max(f_stats.readBatches, 1LL), "columns");
+		ab::Benchmark::report("Worst frame streaming a saved world (" + std::to_string(f_frames) + " frames)", f_worstFrameMs, "ms");
+
+		removeRegions(f_regions);
+	}
+
+	/// <summary>
+	/// Checks that generated columns are cached under a key that changes with the seed, and compares populating the world from the cache with generating it.
+	/// </summary>
+	void generatedCache()
+	{
+		ab::Terrain f_terrain(WORLD_SEED);
+		ab::Terrain f_otherTerrain(WORLD_SEED + 1);
+		ab::JobSystem f_jobs;
+		const std::string CACHE_PREFIX = "bench-cache";
+		const int COLUMNS_X = WORLD_WIDTH / CHUNK_WIDTH;
+		const int COLUMNS_Z = WORLD_DEPTH / CHUNK_DEPTH;
+
+		ab::Benchmark::check("Cache key only depends on the seed and generation values", f_terrain.getCacheKey() == ab::Terrain(WORLD_SEED).getCacheKey() &&
+			f_terrain.getCacheKey() != f_otherTerrain.getCacheKey() && f_terrain.getCacheDirectory(CACHE_PREFIX) != f_otherTerrain.getCacheDirectory(CACHE_PREFIX));
+
+		std::unique_ptr<World> f_generated(new World());
+		f_generated->populate(f_terrain, &f_jobs);
+
+		std::unique_ptr<RegionStore> f_cache(new RegionStore(f_terrain.getCacheDirectory(CACHE_PREFIX)));
+		std::unique_ptr<World> f_cold;
+		std::unique_ptr<World> f_warm;
+
+		double f_coldNs = ab::Benchmark::runOnce("Populate (cold cache)", 1, [&]()
+		{
+			f_cold.reset(new World());
+			f_cold->populate(f_terrain, &f_jobs, f_cache.get());
+		});
+
+		bool f_written = f_cache->getPendingCount() == 0 && f_cache->hasColumn(0, 0) && f_cache->hasColumn(COLUMNS_X - 1, COLUMNS_Z - 1);
+
+		// A warm start only opens the cache
+		double f_warmNs = ab::Benchmark::run("Populate (warm cache)", 3, 1, [&]()
+		{
+			RegionStore f_warmCache(f_terrain.getCacheDirectory(CACHE_PREFIX));
+			f_warm.reset(new World());
+			f_warm->populate(f_terrain, &f_jobs, &f_warmCache);
+		});
+
+		ab::Benchmark::check("Populating fills the cache", f_written);
+		ab::Benchmark::check("Cached world is the same as the generated one", sameColumns(*f_generated, *f_cold, 0, 0, COLUMNS_X - 1, COLUMNS_Z - 1) &&
+			sameColumns(*f_generated, *f_warm, 0, 0, COLUMNS_X - 1, COLUMNS_Z - 1));
+
+		// A different seed doesn't see the cached columns
+		RegionStore f_otherCache(f_otherTerrain.getCacheDirectory(CACHE_PREFIX));
+		ab::Benchmark::check("Changing the seed misses the cache", !f_otherCache.hasColumn(0, 0));
+
+		// Columns the streamer generates are cached, and a new streamer reads them back
+		RegionStore f_streamCache(f_terrain.getCacheDirectory(CACHE_PREFIX + "-stream"));
+		glm::vec3 f_eye(8.0f, 60.0f, 8.0f);
+		glm::vec3 f_direction(1.0f, 0.0f, 0.0f);
+		bool f_streamed;
+
+		{
+			ChunkIO f_io(f_streamCache, f_jobs);
+
+			{
+				World f_world;
+				ChunkStreamer f_streamer(f_world, f_terrain, f_jobs);
+				f_streamer.setLoadRadius(4);
+				f_streamer.setGeneratedCache(&f_io);
+				f_streamer.update(f_eye, f_direction);
+				f_streamer.finish();
+			}
+
+			f_io.flush();
+			f_io.finish();
+			std::unique_ptr<World> f_world(new World());
+			ChunkStreamer f_streamer(*f_world, f_otherTerrain, f_jobs); // Would generate different columns
+			f_streamer.setLoadRadius(4);
+			f_streamer.setGeneratedCache(&f_io);
+			f_streamer.update(f_eye, f_direction);
+			f_streamer.finish();
+			f_streamed = f_streamCache.hasColumn(0, 0) && f_streamer.isResident(0, 0) && sameColumns(*f_generated, *f_world, 0, 0, 0, 0);
+		}
+
+		ab::Benchmark::check("Streamed columns are cached and read back", f_streamed);
+		ab::Benchmark::report("Populate from cold cache", f_coldNs / 1000000.0, "ms");
+		ab::Benchmark::report("Populate from warm cache", f_warmNs / 1000000.0, "ms");
+		ab::Benchmark::report("Warm cache speedup", f_coldNs / f_warmNs, "x");
+
+		f_cache.reset();
+		removeRegions(RegionStore(f_terrain.getCacheDirectory(CACHE_PREFIX)));
+		removeRegions(f_streamCache);
+	}
+
+	/// <summary>
+	/// Times saving a region, opening a saved world, and loading its columns.
+	/// </summary>
+	void throughput()
+	{
+		ab::Terrain f_terrain(WORLD_SEED);
+		World f_world;
+		generateRegion(f_world, f_terrain);
+		const long long COLUMN_COUNT = COLUMNS * COLUMNS;
+
+		RegionStore f_regions(DIRECTORY);
+
+		double f_saveNs = ab::Benchmark::run("Save region/column", 5, COLUMN_COUNT, [&]()
+		{
+			f_world.save(f_regions);
+		});
+
+		// Opening only maps the file, the columns are read as they're needed
+		double f_openNs = ab::Benchmark::run("Open saved world + read 1 column", 20, 1, [&]()
+		{
+			RegionStore f_saved(DIRECTORY);
+			std::vector<char> f_voxels(ab::RegionFile::COLUMN_CHUNKS * ab::RegionFile::CHUNK_VOXELS);
+			bool f_used[ab::RegionFile::COLUMN_CHUNKS];
+			f_saved.readColumn(5, 5, f_voxels.data(), f_used);
+			ab::Benchmark::keep(f_voxels[0]);
+		});
+
+		RegionStore f_saved(DIRECTORY);
+		std::vector<char> f_voxels(ab::RegionFile::COLUMN_CHUNKS * ab::RegionFile::CHUNK_VOXELS);
+		bool f_used[ab::RegionFile::COLUMN_CHUNKS];
+
+		double f_readNs = ab::Benchmark::run("Read column/column", 5, COLUMN_COUNT, [&]()
+		{
+			for (int x = 0; x < COLUMNS; ++x)
+			{
+				for (int z = 0; z < COLUMNS; ++z)
+				{
+					f_saved.readColumn(x, z, f_voxels.data(), f_used);
+					ab::Benchmark::keep(f_voxels[0]);
+				}
+			}
+		});
+
+		World f_loaded;
+
+		double f_loadNs = ab::Benchmark::run("Load column into world/column", 5, COLUMN_COUNT, [&]()
+		{
+			for (int x = 0; x < COLUMNS; ++x)
+			{
+				for (int z = 0; z < COLUMNS; ++z)
+				{
+					f_loaded.loadColumn(f_saved, x, z);
+				}
+			}
+		});
+
+		std::vector<char> f_generated(ab::Terrain::COLUMN_VOXELS);
+
+		double f_generateNs = ab::Benchmark::run("Generate column/column", 3, COLUMN_COUNT, [&]()
+		{
+			for (int x = 0; x < COLUMNS; ++x)
+			{
+				for (int z = 0; z < COLUMNS; ++z)
+				{
+					f_terrain.generateColumn(x, z, f_generated.data(), f_used);
+					ab::Benchmark::keep(f_generated[0]);
+				}
+			}
+		});
+
+		ab::Benchmark::report("Region save", 1000000000.0 / f_saveNs, "columns/s");
+		ab::Benchmark::report("Open saved world + read 1 column", f_openNs / 1000.0, "us");
+		ab::Benchmark::report("Region read", 1000000000.0 / f_readNs, "columns/s");
+		ab::Benchmark::report("Region load into world", 1000000000.0 / f_loadNs, "columns/s");
+		ab::Benchmark::report("Read speedup over generating", f_generateNs / f_readNs, "x");
+
+		removeRegions(f_regions);
+	}
+}
+
+/// <summary>
+/// Checks and benchmarks saving and loading worlds as region files.
+/// </summary>
+void regionBenchmark()
+{
+	ab::Benchmark::header("Region files");
+
+	compression();
+	roundTrip();
+	streaming();
+	chunkIO();
+	generatedCache();
+	throughput();
+}
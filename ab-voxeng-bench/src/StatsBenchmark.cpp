@@ -0,0 +1,149 @@
+#include "Benchmark.h"
+#include "ChunkStreamer.h"
+#include "JobSystem.h"
+#include "Stats.h"
+#include "Terrain.h"
+#include "World.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace
+{
+	const char *JSON_PATH = "bench-stats.json";
+	const int FRAMES = 120;
+	const int RADIUS = 8;
+
+	/// <summary>
+	/// Checks that stats keep their order, that sampled stats keep their newest values, and the percentiles and output.
+	/// </summary>
+	void registry()
+	{
+		ab::Stats::clear();
+		ab::Stats::set("Bench A", "First", 1.0, "");
+		ab::Stats::set("Bench B", "Second", 2.0, "MB");
+		ab::Stats::set("Bench A", "First", 3.0, "");
+
+		std::vector<ab::Stats::Stat> f_stats = ab::Stats::getAll();
+		ab::Benchmark::check("Stats are kept in the order they were first set", f_stats.size() == 2 && f_stats[0].name == "First" &&
+			f_stats[0].value == 3.0 && f_stats[1].group == "Bench B" && f_stats[1].unit == "MB");
+
+		const int EXTRA = 10;
+
+		for (int i = 0; i < ab::Stats::HISTORY_LENGTH + EXTRA; ++i)
+		{
+			ab::Stats::addSample("Bench A", "Sampled", i, "ms");
+		}
+
+		ab::Stats::Stat f_sampled;
+		bool f_found = ab::Stats::get("Bench A", "Sampled", f_sampled);
+		ab::Benchmark::check("Sampled stats keep their newest values", f_found && (int)f_sampled.history.size() == ab::Stats::HISTORY_LENGTH &&
+			f_sampled.history.front() == (float)EXTRA && f_sampled.history.back() == (float)(ab::Stats::HISTORY_LENGTH + EXTRA - 1) &&
+			f_sampled.value == ab::Stats::HISTORY_LENGTH + EXTRA - 1);
+
+		// 1 to 100, so each percentile is its own value
+		ab::Stats::Stat f_hundred = { "Bench", "Hundred", "", 0.0, std::vector<float>() };
+
+		for (int i = 100; i >= 1; --i)
+		{
+			f_hundred.history.push_back((float)i);
+		}
+
+		ab::Benchmark::check("Stats percentiles are the nearest rank", ab::Stats::getPercentile(f_hundred, 50.0) == 50.0 &&
+			ab::Stats::getPercentile(f_hundred, 99.0) == 99.0 && ab::Stats::getPercentile(f_hundred, 100.0) == 100.0 && ab::Stats::getPercentile(f_hundred, 0.0) == 1.0);
+
+		std::stringstream f_text;
+		ab::Stats::write(f_text);
+		ab::Benchmark::check("Stats are written as text", f_text.str().find("=== Bench B ===") != std::string::npos && f_text.str().find("p99") != std::string::npos);
+
+		bool f_written = ab::Stats::writeJson(JSON_PATH);
+		std::ifstream f_file(JSON_PATH);
+		std::stringstream f_json;
+		f_json << f_file.rdbuf();
+		f_file.close();
+		std::remove(JSON_PATH);
+
+		ab::Benchmark::check("Stats are written as JSON", f_written && f_json.str().find("{ \"group\": \"Bench A\", \"name\": \"Sampled\", \"value\": 249.000000, \"unit\": \"ms\", \"samples\": 240") != std::string::npos);
+
+		ab::Benchmark::run("Stats::set/stat", 5, 100000, [&]()
+		{
+			for (int i = 0; i < 100000; ++i)
+			{
+				ab::Stats::set("Bench A", "First", i, "");
+			}
+		});
+
+		ab::Benchmark::run("Stats::addSample/sample", 5, 100000, [&]()
+		{
+			for (int i = 0; i < 100000; ++i)
+			{
+				ab::Stats::addSample("Bench A", "Sampled", i, "ms");
+			}
+		});
+
+		ab::Stats::clear();
+	}
+
+	/// <summary>
+	/// Streams a world around a moving camera without a window, filling the registry with what the game's stats panel
+	/// shows (frame times, world counts and memory, queue depths), then prints it. Run with --stats to keep it as JSON.
+	/// </summary>
+	void headless()
+	{
+		World f_world;
+		ab::Terrain f_terrain(WORLD_SEED);
+		ab::JobSystem f_jobs(3);
+		ChunkStreamer f_streamer(f_world, f_terrain, f_jobs);
+		f_streamer.setLoadRadius(RADIUS);
+		glm::vec3 f_eye(WORLD_WIDTH / 2 + 8.0f, 60.0f, WORLD_DEPTH / 2 + 8.0f);
+
+		for (int i = 0; i < FRAMES; ++i)
+		{
+			std::chrono::steady_clock::time_point f_start = std::chrono::steady_clock::now();
+			f_streamer.update(f_eye, glm::vec3(1.0f, 0.0f, 0.0f));
+			f_jobs.pump();
+			f_eye.x += 4.0f;
+
+			ab::Stats::addSample("Frame", "Frame time", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - f_start).count(), "ms");
+			ab::Stats::set("Queues", "Columns generating", f_streamer.getStats().loading, "");
+		}
+
+		// The camera moves faster than columns are generated, so the ones still loading can all be out of range by now.
+		// Load around where it stopped as well, so there's always something in the world.
+		f_streamer.finish();
+		f_streamer.update(f_eye, glm::vec3(1.0f, 0.0f, 0.0f));
+		f_streamer.finish();
+
+		World::Stats f_worldStats = f_world.getStats();
+		ChunkStreamer::Stats f_streamStats = f_streamer.getStats();
+		ab::Stats::set("World", "Chunks", f_worldStats.chunks, "");
+		ab::Stats::set("World", "Solid voxels", (double)f_worldStats.solidVoxels, "");
+		ab::Stats::set("World", "Voxel storage", f_worldStats.memoryBytes / (1024.0 * 1024.0), "MB");
+		ab::Stats::set("World", "Columns loaded", f_streamStats.resident, "");
+		ab::Stats::set("World", "Columns unloaded", (double)f_streamStats.unloaded, "");
+		ab::Stats::set("Queues", "Columns generating", f_streamStats.loading, "");
+
+		ab::Stats::Stat f_frame;
+		ab::Stats::get("Frame", "Frame time", f_frame);
+		ab::Benchmark::check("Headless stats record every frame", f_frame.history.size() == FRAMES && f_worldStats.chunks > 0 && f_worldStats.solidVoxels > 0);
+		ab::Benchmark::report("Streaming frame time (p50)", ab::Stats::getPercentile(f_frame, 50.0), "ms");
+		ab::Benchmark::report("Streaming frame time (p99)", ab::Stats::getPercentile(f_frame, 99.0), "ms");
+
+		std::cout << std::endl;
+		ab::Stats::write(std::cout);
+	}
+}
+
+/// <summary>
+/// Checks and benchmarks the stats registry, and fills it from a headless streaming run.
+/// </summary>
+void statsBenchmark()
+{
+	ab::Benchmark::header("Stats");
+
+	registry();
+	headless();
+}
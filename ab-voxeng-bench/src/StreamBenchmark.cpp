@@ -0,0 +1,305 @@
+#include "Benchmark.h"
+#include "ChunkStreamer.h"
+#include "JobSystem.h"
+#include "Terrain.h"
+#include "World.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+	const int RADIUS = 8;
+	const glm::vec3 START_EYE(WORLD_WIDTH / 2 + 8.0f, 60.0f, WORLD_DEPTH / 2 + 8.0f);
+	const glm::vec3 FORWARD(1.0f, 0.0f, 0.0f);
+
+	/// <summary>
+	/// Updates the streamer until every column it wants is loaded.
+	/// </summary>
+	/// <returns>The number of updates it took.</returns>
+	int settle(ChunkStreamer &t_streamer, ab::JobSystem &t_jobs, const glm::vec3 &t_eye, const glm::vec3 &t_direction)
+	{
+		for (int i = 0; i < 10000; ++i)
+		{
+			long long f_loaded = t_streamer.getStats().loaded;
+			t_streamer.update(t_eye, t_direction);
+			t_streamer.finish();
+
+			if (t_streamer.getStats().loaded == f_loaded && t_streamer.getStats().loading == 0)
+			{
+				return i + 1;
+			}
+		}
+
+		return -1;
+	}
+
+	/// <summary>
+	/// Checks which columns are loaded compared with the load and unload radius.
+	/// </summary>
+	/// <param name="t_inside">Set to true if every column within the load radius is loaded.</param>
+	/// <param name="t_outside">Set to true if no column past the unload radius is loaded.</param>
+	void checkRange(const ChunkStreamer &t_streamer, const glm::vec3 &t_eye, bool &t_inside, bool &t_outside)
+	{
+		int f_radius = t_streamer.getLoadRadius();
+		int f_search = f_radius + STREAM_UNLOAD_MARGIN + 4;
+		int f_cameraX = (int)std::floor(t_eye.x / CHUNK_WIDTH);
+		int f_cameraZ = (int)std::floor(t_eye.z / CHUNK_DEPTH);
+		t_inside = true;
+		t_outside = true;
+
+		for (int x = f_cameraX - f_search; x <= f_cameraX + f_search; ++x)
+		{
+			for (int z = f_cameraZ - f_search; z <= f_cameraZ + f_search; ++z)
+			{
+				float f_distance = glm::length(glm::vec2((x + 0.5f) * CHUNK_WIDTH - t_eye.x, (z + 0.5f) * CHUNK_DEPTH - t_eye.z));
+
+				if (f_distance <= f_radius * CHUNK_WIDTH && !t_streamer.isResident(x, z))
+				{
+					t_inside = false;
+				}
+
+				if (f_distance > (f_radius + STREAM_UNLOAD_MARGIN) * CHUNK_WIDTH && t_streamer.isResident(x, z))
+				{
+					t_outside = false;
+				}
+			}
+		}
+	}
+
+	/// <summary>
+	/// Checks that the columns around the camera are loaded, match the terrain, and are unloaded once the camera moves away.
+	/// </summary>
+	void residency()
+	{
+		World f_world;
+		ab::Terrain f_terrain(WORLD_SEED);
+		ab::JobSystem f_jobs(3);
+		ChunkStreamer f_streamer(f_world, f_terrain, f_jobs);
+		f_streamer.setLoadRadius(RADIUS);
+
+		settle(f_streamer, f_jobs, START_EYE, FORWARD);
+
+		bool f_inside;
+		bool f_outside;
+		checkRange(f_streamer, START_EYE, f_inside, f_outside);
+		ab::Benchmark::check("Streaming loads every column in range", f_inside);
+		ab::Benchmark::check("Streaming loads nothing out of range", f_outside);
+
+		// The streamed chunks should be exactly what the terrain generates
+		std::vector<char> f_voxels(ab::Terrain::COLUMN_VOXELS);
+		bool f_used[ab::Terrain::COLUMN_CHUNKS];
+		bool f_matches = true;
+		int f_cameraX = (int)std::floor(START_EYE.x / CHUNK_WIDTH);
+		int f_cameraZ = (int)std::floor(START_EYE.z / CHUNK_DEPTH);
+
+		for (int x = f_cameraX - 2; x <= f_cameraX + 2; ++x)
+		{
+			for (int z = f_cameraZ - 2; z <= f_cameraZ + 2; ++z)
+			{
+				f_terrain.generateColumn(x, z, f_voxels.data(), f_used);
+
+				for (int cy = 0; cy < ab::Terrain::COLUMN_CHUNKS; ++cy)
+				{
+					Chunk *f_chunk = f_world.chunks.find({ x, cy, z });
+
+					for (int i = 0; i < ab::Terrain::CHUNK_VOXELS; ++i)
+					{
+						char f_expected = f_voxels[cy * ab::Terrain::CHUNK_VOXELS + i];
+						char f_actual = f_chunk != nullptr ? f_chunk->getVoxel(i) : 0;
+
+						if (f_expected != f_actual)
+						{
+							f_matches = false;
+						}
+					}
+				}
+			}
+		}
+
+		ab::Benchmark::check("Streamed columns match the terrain", f_matches);
+
+		// Walk the camera 4 load radii along X, then check the old columns are gone
+		ChunkStreamer::Stats f_before = f_streamer.getStats();
+		glm::vec3 f_eye = START_EYE;
+
+		for (int i = 0; i < RADIUS * 4; ++i)
+		{
+			f_eye.x += CHUNK_WIDTH;
+			settle(f_streamer, f_jobs, f_eye, FORWARD);
+		}
+
+		ChunkStreamer::Stats f_after = f_streamer.getStats();
+		checkRange(f_streamer, f_eye, f_inside, f_outside);
+		ab::Benchmark::check("Streaming follows the camera", f_inside && f_outside && !f_streamer.isResident(f_cameraX, f_cameraZ));
+		ab::Benchmark::check("Streaming unloads columns behind the camera", f_after.unloaded > f_before.unloaded && f_after.loaded - f_after.unloaded == f_after.resident);
+
+		// Chunks that aren't in any loaded column shouldn't be left in the world
+		bool f_leftovers = false;
+
+		for (int x = f_cameraX - RADIUS; x <= f_cameraX + RADIUS; ++x)
+		{
+			for (int cy = 0; cy < ab::Terrain::COLUMN_CHUNKS; ++cy)
+			{
+				if (f_world.chunks.find({ x, cy, f_cameraZ }) != nullptr && !f_streamer.isResident(x, f_cameraZ))
+				{
+					f_leftovers = true;
+				}
+			}
+		}
+
+		ab::Benchmark::check("Unloaded columns are removed from the world", !f_leftovers);
+		ab::Benchmark::report("Resident columns (radius " + std::to_string(RADIUS) + ")", (double)f_after.resident, "columns");
+	}
+
+	/// <summary>
+	/// Checks that the most important columns are loaded first: the camera's column, then the ones in front of it.
+	/// </summary>
+	void ordering()
+	{
+		World f_world;
+		ab::Terrain f_terrain(WORLD_SEED);
+		ab::JobSystem f_jobs(0);
+		ChunkStreamer f_streamer(f_world, f_terrain, f_jobs);
+		f_streamer.setLoadRadius(RADIUS);
+
+		// With no workers the first update loads 2 columns straight away
+		f_streamer.update(START_EYE, FORWARD);
+		int f_cameraX = (int)std::floor(START_EYE.x / CHUNK_WIDTH);
+		int f_cameraZ = (int)std::floor(START_EYE.z / CHUNK_DEPTH);
+
+		ab::Benchmark::check("Streaming loads the camera's column first", f_streamer.isResident(f_cameraX, f_cameraZ));
+		ab::Benchmark::check("Streaming loads columns in front of the camera next", f_streamer.isResident(f_cameraX + 1, f_cameraZ) && f_streamer.getStats().resident == 2);
+
+		// Columns in front of the camera are more important than columns the same distance behind it
+		Indices f_ahead = { f_cameraX + 4, 3, f_cameraZ };
+		Indices f_astern = { f_cameraX - 4, 3, f_cameraZ };
+		ab::Benchmark::check("Columns in front of the camera have priority", f_streamer.getPriority(f_ahead) < f_streamer.getPriority(f_astern));
+
+		// By the time half of the columns in range are loaded, the ones in front should be ahead of the ones behind
+		while (f_streamer.getStats().resident < (int)(3.14159f * RADIUS * RADIUS / 2.0f))
+		{
+			f_streamer.update(START_EYE, FORWARD);
+		}
+
+		int f_front = 0;
+		int f_behind = 0;
+
+		for (int x = 1; x <= RADIUS; ++x)
+		{
+			f_front += f_streamer.isResident(f_cameraX + x, f_cameraZ) ? 1 : 0;
+			f_behind += f_streamer.isResident(f_cameraX - x, f_cameraZ) ? 1 : 0;
+		}
+
+		ab::Benchmark::check("Streaming fills in front of the camera first", f_front > f_behind);
+	}
+
+	/// <summary>
+	/// Checks that the loaded columns stay within a small memory budget, keeping the most important ones.
+	/// </summary>
+	void memoryBudget()
+	{
+		const float BUDGET_MB = 0.125f;
+
+		World f_world;
+		ab::Terrain f_terrain(WORLD_SEED);
+		ab::JobSystem f_jobs(3);
+		ChunkStreamer f_streamer(f_world, f_terrain, f_jobs);
+		f_streamer.setLoadRadius(RADIUS);
+		f_streamer.setMemoryBudget(BUDGET_MB);
+
+		std::size_t f_peak = 0;
+		glm::vec3 f_eye = START_EYE;
+
+		for (int i = 0; i < 64; ++i)
+		{
+			f_eye.x += CHUNK_WIDTH / 2;
+			f_streamer.update(f_eye, FORWARD);
+			f_streamer.finish();
+			f_peak = std::max(f_peak, f_streamer.getStats().memoryBytes);
+		}
+
+		settle(f_streamer, f_jobs, f_eye, FORWARD);
+		f_peak = std::max(f_peak, f_streamer.getStats().memoryBytes);
+
+		// Columns that were already being generated can go over the budget, but by no more than one batch of them
+		std::size_t f_budget = (std::size_t)(BUDGET_MB * 1024.0f * 1024.0f);
+		std::size_t f_columnBytes = ab::Terrain::COLUMN_VOXELS + ab::Terrain::COLUMN_CHUNKS * sizeof(Chunk);
+		std::size_t f_slack = std::max(2 * f_jobs.getWorkerCount(), 2) * f_columnBytes;
+
+		int f_cameraX = (int)std::floor(f_eye.x / CHUNK_WIDTH);
+		int f_cameraZ = (int)std::floor(f_eye.z / CHUNK_DEPTH);
+
+		ab::Benchmark::check("Streaming stays within the memory budget", f_peak <= f_budget + f_slack && f_streamer.getStats().resident < 3.14159f * RADIUS * RADIUS);
+		ab::Benchmark::check("Streaming keeps the camera's column within the budget", f_streamer.isResident(f_cameraX, f_cameraZ));
+		ab::Benchmark::report("Resident columns (" + std::to_string((int)(BUDGET_MB * 1024.0f)) + " KB budget)", (double)f_streamer.getStats().resident, "columns");
+		ab::Benchmark::report("Peak streamed memory", f_peak / 1024.0, "KB");
+	}
+
+	/// <summary>
+	/// Compares the time until the camera's surroundings are loaded with generating the whole world up front.
+	/// </summary>
+	void firstFrame()
+	{
+		ab::Terrain f_terrain(WORLD_SEED);
+		ab::JobSystem f_jobs;
+		int f_cameraX = (int)std::floor(START_EYE.x / CHUNK_WIDTH);
+		int f_cameraZ = (int)std::floor(START_EYE.z / CHUNK_DEPTH);
+
+		// Frames until the camera's column and its 8 neighbours are in
+		double f_streamNs = ab::Benchmark::run("Streaming: first columns", 5, 1, [&]()
+		{
+			std::unique_ptr<World> f_world(new World());
+			ChunkStreamer f_streamer(*f_world, f_terrain, f_jobs);
+			bool f_ready = false;
+
+			while (!f_ready)
+			{
+				f_streamer.update(START_EYE, FORWARD);
+				f_jobs.pump();
+				f_ready = true;
+
+				for (int x = -1; x <= 1; ++x)
+				{
+					for (int z = -1; z <= 1; ++z)
+					{
+						f_ready = f_ready && f_streamer.isResident(f_cameraX + x, f_cameraZ + z);
+					}
+				}
+			}
+		});
+
+		double f_fullNs = ab::Benchmark::run("Streaming: whole radius", 3, 1, [&]()
+		{
+			std::unique_ptr<World> f_world(new World());
+			ChunkStreamer f_streamer(*f_world, f_terrain, f_jobs);
+			settle(f_streamer, f_jobs, START_EYE, FORWARD);
+		});
+
+		double f_populateNs = ab::Benchmark::run("Whole world populate", 3, 1, [&]()
+		{
+			std::unique_ptr<World> f_world(new World());
+			f_world->populate(f_terrain, &f_jobs);
+		});
+
+		ab::Benchmark::report("Time to first columns (streaming)", f_streamNs / 1000000.0, "ms");
+		ab::Benchmark::report("Time to load radius " + std::to_string(STREAM_LOAD_RADIUS) + " (streaming)", f_fullNs / 1000000.0, "ms");
+		ab::Benchmark::report("Time to generate whole world", f_populateNs / 1000000.0, "ms");
+	}
+}
+
+/// <summary>
+/// Checks and benchmarks streaming chunks around the camera.
+/// </summary>
+void streamBenchmark()
+{
+	ab::Benchmark::header("Chunk streaming");
+
+	residency();
+	ordering();
+	memoryBudget();
+	firstFrame();
+}
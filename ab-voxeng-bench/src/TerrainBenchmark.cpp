@@ -0,0 +1,576 @@
+#include "Benchmark.h"
+#include "JobSystem.h"
+#include "Terrain.h"
+#include "World.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	const char *SIMD_NAMES[] = { "scalar", "SSE2", "AVX2" };
+
+	/// <summary>
+	/// Checks the batched noise kernels against the scalar reference and measures their throughput.
+	/// </summary>
+	void noiseKernels()
+	{
+		const int f_count = 1 << 20;
+		ab::Noise f_noise(WORLD_SEED);
+
+		std::mt19937 f_random(12345);
+		std::uniform_real_distribution<double> f_coordinate(-256.0, 256.0);
+		std::vector<double> f_x(f_count);
+		std::vector<double> f_y(f_count);
+		std::vector<float> f_xf(f_count);
+		std::vector<float> f_yf(f_count);
+
+		for (int i = 0; i < f_count; ++i)
+		{
+			f_x[i] = f_coordinate(f_random);
+			f_y[i] = f_coordinate(f_random);
+			f_xf[i] = (float)f_x[i];
+			f_yf[i] = (float)f_y[i];
+		}
+
+		double f_referenceNs = ab::Benchmark::run("Reference noise(x, y)", 3, f_count, [&]()
+		{
+			double f_sum = 0.0;
+
+			for (int i = 0; i < f_count; ++i)
+			{
+				f_sum += f_noise.noise(f_x[i], f_y[i]);
+			}
+
+			ab::Benchmark::keep(f_sum);
+		});
+
+		ab::Benchmark::report("Reference noise(x, y)", 1000.0 / f_referenceNs, "Msamples/s");
+
+		std::vector<double> f_resultsD(f_count);
+		std::vector<float> f_resultsF(f_count);
+		std::vector<double> f_firstD;
+		std::vector<float> f_firstF;
+		bool f_identical = true;
+		bool f_withinBound = true;
+
+		for (int f_level = ab::Noise::SIMD_SCALAR; f_level <= ab::Noise::getSupportedSimdLevel(); ++f_level)
+		{
+			f_noise.setSimdLevel((ab::Noise::SimdLevel)f_level);
+			std::string f_suffix = std::string(" (") + SIMD_NAMES[f_level] + ")";
+
+			double f_floatNs = ab::Benchmark::run("Batched noise, float" + f_suffix, 5, f_count, [&]()
+			{
+				f_noise.noise(f_xf.data(), f_yf.data(), f_resultsF.data(), f_count);
+				ab::Benchmark::keep(f_resultsF[0]);
+			});
+
+			double f_doubleNs = ab::Benchmark::run("Batched noise, double" + f_suffix, 5, f_count, [&]()
+			{
+				f_noise.noise(f_x.data(), f_y.data(), f_resultsD.data(), f_count);
+				ab::Benchmark::keep(f_resultsD[0]);
+			});
+
+			ab::Benchmark::report("Batched noise, float" + f_suffix, 1000.0 / f_floatNs, "Msamples/s");
+			ab::Benchmark::report("Batched noise, double" + f_suffix, 1000.0 / f_doubleNs, "Msamples/s");
+
+			// Every kernel should give exactly the same results as the first (scalar) one
+			if (f_level == ab::Noise::SIMD_SCALAR)
+			{
+				f_firstD = f_resultsD;
+				f_firstF = f_resultsF;
+			}
+			else
+			{
+				f_identical &= f_firstD == f_resultsD && f_firstF == f_resultsF;
+			}
+
+			// The error bound documented in Noise.h
+			for (int i = 0; i < f_count; ++i)
+			{
+				double f_reference = f_noise.noise((double)f_xf[i], (double)f_yf[i]);
+				double f_floatBound = 3.0e-7 * std::max(1.0, std::fabs((double)f_xf[i]) + std::fabs((double)f_yf[i]));
+
+				f_withinBound &= std::fabs(f_resultsD[i] - f_noise.noise(f_x[i], f_y[i])) <= 1.0e-7;
+				f_withinBound &= std::fabs(f_resultsF[i] - f_reference) <= f_floatBound;
+			}
+		}
+
+		ab::Benchmark::check("Noise kernels give identical results", f_identical);
+		ab::Benchmark::check("Batched noise within error bound", f_withinBound);
+	}
+
+	/// <summary>
+	/// Checks the batched 3D and 4D noise kernels against the scalar reference and measures their throughput.
+	/// </summary>
+	void noiseKernels3D4D()
+	{
+		const int f_count = 1 << 18;
+		ab::Noise f_noise(WORLD_SEED);
+
+		std::mt19937 f_random(54321);
+		std::uniform_real_distribution<double> f_coordinate(-256.0, 256.0);
+		std::vector<double> f_coordinates[4];
+		std::vector<float> f_coordinatesF[4];
+
+		for (int f_axis = 0; f_axis < 4; ++f_axis)
+		{
+			f_coordinates[f_axis].resize(f_count);
+			f_coordinatesF[f_axis].resize(f_count);
+
+			for (int i = 0; i < f_count; ++i)
+			{
+				f_coordinatesF[f_axis][i] = (float)f_coordinate(f_random);
+				f_coordinates[f_axis][i] = f_coordinatesF[f_axis][i];
+			}
+		}
+
+		const double *x = f_coordinates[0].data();
+		const double *y = f_coordinates[1].data();
+		const double *z = f_coordinates[2].data();
+		const double *w = f_coordinates[3].data();
+		const float *xf = f_coordinatesF[0].data();
+		const float *yf = f_coordinatesF[1].data();
+		const float *zf = f_coordinatesF[2].data();
+		const float *wf = f_coordinatesF[3].data();
+
+		// The scalar references (the float coordinates are exactly representable as doubles)
+		std::vector<double> f_reference3(f_count);
+		std::vector<double> f_reference4(f_count);
+
+		for (int i = 0; i < f_count; ++i)
+		{
+			f_reference3[i] = f_noise.noise(x[i], y[i], z[i]);
+			f_reference4[i] = f_noise.noise(x[i], y[i], z[i], w[i]);
+		}
+
+		std::vector<double> f_resultsD(f_count);
+		std::vector<float> f_resultsF(f_count);
+		std::vector<double> f_first[2];
+		std::vector<float> f_firstF[2];
+		bool f_identical = true;
+		bool f_withinBound = true;
+
+		for (int f_level = ab::Noise::SIMD_SCALAR; f_level <= ab::Noise::getSupportedSimdLevel(); ++f_level)
+		{
+			f_noise.setSimdLevel((ab::Noise::SimdLevel)f_level);
+
+			for (int f_dimensions = 3; f_dimensions <= 4; ++f_dimensions)
+			{
+				std::string f_name = "Batched " + std::to_string(f_dimensions) + "D noise, float (" + SIMD_NAMES[f_level] + ")";
+				const std::vector<double> &f_reference = f_dimensions == 3 ? f_reference3 : f_reference4;
+
+				double f_ns = ab::Benchmark::run(f_name, 5, f_count, [&]()
+				{
+					if (f_dimensions == 3)
+					{
+						f_noise.noise(xf, yf, zf, f_resultsF.data(), f_count);
+					}
+					else
+					{
+						f_noise.noise(xf, yf, zf, wf, f_resultsF.data(), f_count);
+					}
+
+					ab::Benchmark::keep(f_resultsF[0]);
+				});
+
+				ab::Benchmark::report(f_name, 1000.0 / f_ns, "Msamples/s");
+
+				if (f_dimensions == 3)
+				{
+					f_noise.noise(x, y, z, f_resultsD.data(), f_count);
+				}
+				else
+				{
+					f_noise.noise(x, y, z, w, f_resultsD.data(), f_count);
+				}
+
+				// Every kernel should give exactly the same results as the first (scalar) one
+				if (f_level == ab::Noise::SIMD_SCALAR)
+				{
+					f_first[f_dimensions - 3] = f_resultsD;
+					f_firstF[f_dimensions - 3] = f_resultsF;
+				}
+				else
+				{
+					f_identical &= f_first[f_dimensions - 3] == f_resultsD && f_firstF[f_dimensions - 3] == f_resultsF;
+				}
+
+				// The error bound documented in Noise.h
+				for (int i = 0; i < f_count; ++i)
+				{
+					double f_size = std::fabs(x[i]) + std::fabs(y[i]) + std::fabs(z[i]) + (f_dimensions == 4 ? std::fabs(w[i]) : 0.0);
+
+					f_withinBound &= std::fabs(f_resultsD[i] - f_reference[i]) <= 1.0e-7;
+					f_withinBound &= std::fabs(f_resultsF[i] - f_reference[i]) <= 5.0e-6 * std::max(1.0, f_size);
+				}
+			}
+		}
+
+		ab::Benchmark::check("3D and 4D noise kernels give identical results", f_identical);
+		ab::Benchmark::check("3D and 4D batched noise within error bound", f_withinBound);
+	}
+
+	/// <summary>
+	/// Generates every chunk of density terrain, the same way Terrain::generateColumn() does when DENSITY_TERRAIN is set.
+	/// </summary>
+	std::vector<char> generateDensity(const ab::Terrain &t_terrain, ab::JobSystem *t_jobs)
+	{
+		const int CHUNKS_Y = WORLD_HEIGHT / CHUNK_HEIGHT;
+		const int CHUNKS_Z = WORLD_DEPTH / CHUNK_DEPTH;
+		const int CHUNK_COUNT = WORLD_WIDTH / CHUNK_WIDTH * CHUNKS_Y * CHUNKS_Z;
+		const int CHUNK_VOXELS = CHUNK_WIDTH * CHUNK_HEIGHT * CHUNK_DEPTH;
+
+		std::vector<char> f_voxels((std::size_t)CHUNK_COUNT * CHUNK_VOXELS);
+
+		t_jobs->parallelFor(0, CHUNK_COUNT, 8, [&](int t_begin, int t_end)
+		{
+			for (int i = t_begin; i < t_end; ++i)
+			{
+				t_terrain.generateChunkDensity(Utility::at(i, CHUNKS_Y, CHUNKS_Z), &f_voxels[(std::size_t)i * CHUNK_VOXELS]);
+			}
+		});
+
+		return f_voxels;
+	}
+
+	/// <summary>
+	/// Checks and times density terrain, and measures how often the interpolated voxels agree with the full resolution density.
+	/// </summary>
+	void densityTerrain()
+	{
+		ab::Terrain *f_terrain = new ab::Terrain(WORLD_SEED);
+		std::vector<char> f_reference;
+		bool f_same = true;
+
+		for (int f_workers : { 0, 3, 7 })
+		{
+			ab::JobSystem f_jobs(f_workers);
+			std::vector<char> f_voxels = generateDensity(*f_terrain, &f_jobs);
+
+			if (f_reference.empty())
+			{
+				f_reference.swap(f_voxels);
+			}
+			else
+			{
+				f_same &= f_voxels == f_reference;
+			}
+		}
+
+		ab::Benchmark::check("Density terrain identical at any thread count", f_same);
+
+		// Compare solid voxels against the density evaluated at every voxel, in a 128 x 128 corner of the map
+		long long f_agree = 0;
+		long long f_total = 0;
+		char f_voxels[CHUNK_WIDTH * CHUNK_HEIGHT * CHUNK_DEPTH];
+
+		for (int cx = 0; cx < 8; ++cx)
+		{
+			for (int cy = 0; cy < WORLD_HEIGHT / CHUNK_HEIGHT; ++cy)
+			{
+				for (int cz = 0; cz < 8; ++cz)
+				{
+					f_terrain->generateChunkDensity({ cx, cy, cz }, f_voxels);
+
+					for (int i = 0; i < CHUNK_WIDTH * CHUNK_HEIGHT * CHUNK_DEPTH; ++i)
+					{
+						Indices f_local = Utility::at(i, CHUNK_HEIGHT, CHUNK_DEPTH);
+						bool f_solid = f_terrain->getDensity(cx * CHUNK_WIDTH + f_local.x, cy * CHUNK_HEIGHT + f_local.y, cz * CHUNK_DEPTH + f_local.z) > 0.0f;
+
+						f_agree += f_solid == (f_voxels[i] == BLOCK_GRASS);
+						f_total++;
+					}
+				}
+			}
+		}
+
+		ab::Benchmark::report("Density lattice agreement", 100.0 * f_agree / f_total, "%");
+
+		int f_maxThreads = std::max((int)std::thread::hardware_concurrency(), 1);
+		ab::JobSystem f_jobs(f_maxThreads - 1);
+		std::string f_suffix = " (" + std::to_string(f_maxThreads) + " threads)";
+
+		double f_ns = ab::Benchmark::run("Density terrain generation/column" + f_suffix, 3, (long long)WORLD_WIDTH * WORLD_DEPTH, [&]()
+		{
+			ab::Benchmark::keep(generateDensity(*f_terrain, &f_jobs)[0]);
+		});
+
+		ab::Benchmark::report("Density terrain generation" + f_suffix, f_ns * WORLD_WIDTH * WORLD_DEPTH / 1000000.0, "ms");
+
+		delete f_terrain;
+	}
+
+	/// <summary>
+	/// The neighbourhood max that tree placement used before Terrain::maxFilter(), every value of every window.
+	/// </summary>
+	void bruteForceMax(const std::vector<float> &t_values, std::vector<float> &t_results, int t_width, int t_height, int t_radius)
+	{
+		for (int x = 0; x < t_width; ++x)
+		{
+			for (int z = 0; z < t_height; ++z)
+			{
+				float f_max = 0.0f;
+
+				for (int xn = std::max(x - t_radius, 0); xn <= std::min(x + t_radius, t_width - 1); ++xn)
+				{
+					for (int zn = std::max(z - t_radius, 0); zn <= std::min(z + t_radius, t_height - 1); ++zn)
+					{
+						f_max = std::max(f_max, t_values[xn * t_height + zn]);
+					}
+				}
+
+				t_results[x * t_height + z] = f_max;
+			}
+		}
+	}
+
+	/// <summary>
+	/// The 2D max filter used by tree placement, one axis at a time.
+	/// </summary>
+	void separableMax(const std::vector<float> &t_values, std::vector<float> &t_results, int t_width, int t_height, int t_radius)
+	{
+		for (int z = 0; z < t_height; ++z)
+		{
+			ab::Terrain::maxFilter(&t_values[z], &t_results[z], t_width, t_height, t_radius);
+		}
+
+		for (int x = 0; x < t_width; ++x)
+		{
+			ab::Terrain::maxFilter(&t_results[x * t_height], &t_results[x * t_height], t_height, 1, t_radius);
+		}
+	}
+
+	/// <summary>
+	/// Checks the tree placement max filter against the brute force version and times both across radii.
+	/// </summary>
+	void treeFilter()
+	{
+		std::mt19937 f_random(777);
+		std::uniform_real_distribution<float> f_value(0.0f, 1.0f);
+		bool f_same = true;
+
+		// Odd sizes, and radii bigger than the map, to cover the ends of the lines
+		for (int f_radius : { 0, 1, 3, 8, 20, 200 })
+		{
+			const int f_width = 157;
+			const int f_height = 93;
+			std::vector<float> f_values(f_width * f_height);
+			std::vector<float> f_expected(f_width * f_height);
+			std::vector<float> f_results(f_width * f_height);
+
+			for (float &f_v : f_values)
+			{
+				f_v = f_value(f_random);
+			}
+
+			bruteForceMax(f_values, f_expected, f_width, f_height, f_radius);
+			separableMax(f_values, f_results, f_width, f_height, f_radius);
+			f_same &= f_expected == f_results;
+		}
+
+		ab::Benchmark::check("Tree max filter matches brute force", f_same);
+
+		std::vector<float> f_values(WORLD_WIDTH * WORLD_DEPTH);
+		std::vector<float> f_results(WORLD_WIDTH * WORLD_DEPTH);
+
+		for (float &f_v : f_values)
+		{
+			f_v = f_value(f_random);
+		}
+
+		// The brute force version is only timed on a corner of the map, it takes seconds for the whole map at large radii
+		const int BRUTE_FORCE_SIZE = 128;
+		std::vector<float> f_corner(f_values.begin(), f_values.begin() + BRUTE_FORCE_SIZE * BRUTE_FORCE_SIZE);
+		std::vector<float> f_cornerResults(BRUTE_FORCE_SIZE * BRUTE_FORCE_SIZE);
+
+		for (int f_radius : { 4, 8, 16, 32 })
+		{
+			std::string f_suffix = " (R = " + std::to_string(f_radius) + ")";
+
+			ab::Benchmark::run("Tree max filter/column" + f_suffix, 5, (long long)WORLD_WIDTH * WORLD_DEPTH, [&]()
+			{
+				separableMax(f_values, f_results, WORLD_WIDTH, WORLD_DEPTH, f_radius);
+				ab::Benchmark::keep(f_results[0]);
+			});
+
+			ab::Benchmark::run("Brute force max/column" + f_suffix, 3, (long long)BRUTE_FORCE_SIZE * BRUTE_FORCE_SIZE, [&]()
+			{
+				bruteForceMax(f_corner, f_cornerResults, BRUTE_FORCE_SIZE, BRUTE_FORCE_SIZE, f_radius);
+				ab::Benchmark::keep(f_cornerResults[0]);
+			});
+		}
+	}
+
+	/// <summary>
+	/// Generates every column of the world (the area World::populate() fills) and hashes each one.
+	/// </summary>
+	std::vector<unsigned int> hashColumns(const ab::Terrain &t_terrain, ab::JobSystem *t_jobs, int &t_trees)
+	{
+		const int COLUMNS_Z = WORLD_DEPTH / CHUNK_DEPTH;
+		const int COLUMN_COUNT = WORLD_WIDTH / CHUNK_WIDTH * COLUMNS_Z;
+
+		std::vector<unsigned int> f_hashes(COLUMN_COUNT);
+		std::vector<int> f_trees(COLUMN_COUNT);
+
+		t_jobs->parallelFor(0, COLUMN_COUNT, 1, [&](int t_begin, int t_end)
+		{
+			std::vector<char> f_voxels(ab::Terrain::COLUMN_VOXELS);
+			bool f_used[ab::Terrain::COLUMN_CHUNKS];
+
+			for (int i = t_begin; i < t_end; ++i)
+			{
+				t_terrain.generateColumn(i / COLUMNS_Z, i % COLUMNS_Z, f_voxels.data(), f_used);
+
+				// FNV-1a
+				unsigned int f_hash = 2166136261u;
+
+				for (char f_voxel : f_voxels)
+				{
+					f_hash = (f_hash ^ (unsigned char)f_voxel) * 16777619u;
+				}
+
+				f_hashes[i] = f_hash;
+
+				// Trunks standing on grass
+				auto f_voxel = [&](int x, int y, int z)
+				{
+					return f_voxels[(y / CHUNK_HEIGHT) * ab::Terrain::CHUNK_VOXELS + Utility::at(x, y % CHUNK_HEIGHT, z, CHUNK_HEIGHT, CHUNK_DEPTH)];
+				};
+
+				for (int x = 0; x < CHUNK_WIDTH; ++x)
+				{
+					for (int z = 0; z < CHUNK_DEPTH; ++z)
+					{
+						for (int y = 1; y < WORLD_HEIGHT; ++y)
+						{
+							f_trees[i] += f_voxel(x, y, z) == BLOCK_TREE && f_voxel(x, y - 1, z) == BLOCK_GRASS;
+						}
+					}
+				}
+			}
+		});
+
+		t_trees = 0;
+
+		for (int f_count : f_trees)
+		{
+			t_trees += f_count;
+		}
+
+		return f_hashes;
+	}
+
+	/// <summary>
+	/// Checks that the terrain is exactly the same whatever the thread count, and that the seed changes it.
+	/// </summary>
+	void determinism()
+	{
+		ab::Terrain f_terrain(WORLD_SEED);
+		std::vector<unsigned int> f_reference;
+		int f_trees = 0;
+		bool f_same = true;
+
+		// Always try a few workers, even on a single core machine, so the columns really are generated out of order
+		for (int f_workers : { 0, 1, 3, 7 })
+		{
+			ab::JobSystem f_jobs(f_workers);
+			std::vector<unsigned int> f_hashes = hashColumns(f_terrain, &f_jobs, f_trees);
+
+			if (f_reference.empty())
+			{
+				f_reference.swap(f_hashes);
+			}
+			else
+			{
+				f_same &= f_hashes == f_reference;
+			}
+		}
+
+		ab::Benchmark::check("Terrain identical at any thread count", f_same);
+
+		ab::JobSystem f_jobs(0);
+		ab::Terrain f_other(WORLD_SEED + 1);
+		int f_otherTrees = 0;
+
+		ab::Benchmark::check("Different seeds give different terrain", hashColumns(f_other, &f_jobs, f_otherTrees) != f_reference);
+		ab::Benchmark::report("Trees (default seed)", (double)f_trees, "trees");
+
+		// There are no world-sized maps left, so this doesn't grow with the world
+		ab::Benchmark::report("Terrain generator size", (double)sizeof(ab::Terrain), "bytes");
+	}
+
+	/// <summary>
+	/// Times generating the whole world (part of startup) from 1 thread to every core.
+	/// </summary>
+	void startup()
+	{
+		int f_maxThreads = std::max((int)std::thread::hardware_concurrency(), 1);
+		ab::Terrain f_terrain(WORLD_SEED);
+		double f_singleThreadNs = 0.0;
+
+		// 1, 2, 4... threads, finishing with every core
+		std::vector<int> f_threadCounts;
+
+		for (int f_threads = 1; f_threads < f_maxThreads; f_threads *= 2)
+		{
+			f_threadCounts.push_back(f_threads);
+		}
+
+		f_threadCounts.push_back(f_maxThreads);
+
+		const int COLUMNS_Z = WORLD_DEPTH / CHUNK_DEPTH;
+		const int COLUMN_COUNT = WORLD_WIDTH / CHUNK_WIDTH * COLUMNS_Z;
+
+		for (int f_threads : f_threadCounts)
+		{
+			ab::JobSystem f_jobs(f_threads - 1);
+			std::string f_suffix = " (" + std::to_string(f_threads) + " threads)";
+
+			double f_ns = ab::Benchmark::run("Terrain generation/column" + f_suffix, 3, (long long)WORLD_WIDTH * WORLD_DEPTH, [&]()
+			{
+				f_jobs.parallelFor(0, COLUMN_COUNT, 1, [&](int t_begin, int t_end)
+				{
+					std::vector<char> f_voxels(ab::Terrain::COLUMN_VOXELS);
+					bool f_used[ab::Terrain::COLUMN_CHUNKS];
+
+					for (int i = t_begin; i < t_end; ++i)
+					{
+						f_terrain.generateColumn(i / COLUMNS_Z, i % COLUMNS_Z, f_voxels.data(), f_used);
+						ab::Benchmark::keep(f_voxels[0]);
+					}
+				});
+			});
+
+			if (f_threads == 1)
+			{
+				f_singleThreadNs = f_ns;
+			}
+
+			ab::Benchmark::report("Terrain generation" + f_suffix, f_ns * WORLD_WIDTH * WORLD_DEPTH / 1000000.0, "ms");
+			ab::Benchmark::report("Terrain speedup" + f_suffix, f_singleThreadNs / f_ns, "x");
+		}
+	}
+}
+
+/// <summary>
+/// Checks and benchmarks noise and terrain generation.
+/// </summary>
+void terrainBenchmark()
+{
+	ab::Benchmark::header("Noise");
+
+	noiseKernels();
+	noiseKernels3D4D();
+
+	ab::Benchmark::header("Terrain generation");
+
+	determinism();
+	treeFilter();
+	startup();
+	densityTerrain();
+}
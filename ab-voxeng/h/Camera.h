@@ -23,6 +23,9 @@ namespace ab
 		glm::vec3 getDirection();
 		glm::vec3 getEye();
 		void setEye(glm::vec3 t_position);
+		void setPose(glm::vec3 t_eye, double t_yaw, double t_pitch);
+		double getYaw();
+		double getPitch();
 		void getEyeRay(float t_x, float t_y, glm::vec3 &t_result);
 		glm::vec3 getRayFromMousePos(float t_x, float t_y);
 		void update(double t_deltaTime);
@@ -0,0 +1,47 @@
+// *******************************************************
+// * CameraPath.h and CameraPath.cpp - Alan Bolger, 2021 *
+// *******************************************************
+
+#ifndef CAMERAPATH_H
+#define CAMERAPATH_H
+
+#include "glm/glm.hpp"
+
+#include <string>
+#include <vector>
+
+namespace ab
+{
+	// A path for the camera to follow, so performance runs can be repeated exactly.
+	// A path is a list of keyframes (where the camera is and which way it's facing at a time), recorded from a
+	// live session by adding a keyframe every so often. Replaying samples the path at the simulation time, which
+	// moves in fixed steps, so every replay puts the camera in exactly the same places whatever the frame rate.
+	// Paths are saved as text, one keyframe per line: time (milliseconds), eye x, y and z, yaw and pitch (degrees).
+	// Blank lines and lines starting with # are ignored.
+	class CameraPath
+	{
+	public:
+		struct Keyframe
+		{
+			double time; // Milliseconds from the start of the path
+			glm::vec3 eye;
+			double yaw; // In degrees
+			double pitch; // In degrees
+		};
+
+		bool add(const Keyframe &t_keyframe);
+		void clear();
+		bool load(const std::string &t_path);
+		bool save(const std::string &t_path) const;
+		Keyframe sample(double t_time) const;
+		double getDuration() const;
+		bool isEmpty() const;
+		const std::vector<Keyframe> &getKeyframes() const;
+		static glm::vec3 getDirection(double t_yaw, double t_pitch);
+
+	private:
+		std::vector<Keyframe> m_keyframes; // In time order
+	};
+}
+
+#endif // !CAMERAPATH_H
@@ -0,0 +1,129 @@
+// *************************************************
+// * ChunkIO.h and ChunkIO.cpp - Alan Bolger, 2021 *
+// *************************************************
+
+#ifndef CHUNKIO_H
+#define CHUNKIO_H
+
+#include "Globals.h"
+#include "RegionStore.h"
+#include "JobSystem.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class World;
+
+// Reads and writes saved columns on a thread of its own, so the main thread never waits for the disk.
+// Reads are queued and the I/O thread takes everything that's waiting at once: requests for the same
+// column are merged, and the rest are read a region at a time in the order they're stored in the file.
+// Each request's callback is run on the main thread by JobSystem::pump().
+// Saved columns are written behind: the main thread only copies their voxels into the queue, the I/O thread
+// compresses them and flushes them to their region files once REGION_FLUSH_COLUMNS are waiting, or the
+// oldest has waited CHUNK_IO_WRITE_DELAY_MS. Queued writes are always handed to the RegionStore before the
+// reads that were asked for after them, so a column that's read back straight away is still up to date.
+class ChunkIO
+{
+public:
+	// A column that was read, in the same layout as Terrain::generateColumn()
+	struct ColumnData
+	{
+		bool found; // False if the column hasn't been saved
+		std::vector<char> voxels;
+		bool used[ab::RegionFile::COLUMN_CHUNKS];
+	};
+
+	typedef std::function<void(const std::shared_ptr<ColumnData> &)> ReadCallback;
+
+	// Counts of latencies in power of 2 buckets: bucket i counts latencies under 2^i microseconds
+	// (and at least half that, except for bucket 0)
+	class LatencyHistogram
+	{
+	public:
+		static const int BUCKETS = 32;
+
+		LatencyHistogram();
+		void add(double t_microseconds);
+		double getPercentile(double t_percentile) const;
+		double getMean() const;
+		double getMax() const;
+		long long getCount() const;
+		long long getBucket(int t_bucket) const;
+
+	private:
+		long long m_counts[BUCKETS];
+		long long m_count;
+		double m_total;
+		double m_max;
+	};
+
+	struct Stats
+	{
+		LatencyHistogram reads; // From asking for a column to its data being ready
+		LatencyHistogram writes; // From saving a column to it being in its region file
+		LatencyHistogram flushes; // How long each flush took
+		long long readRequests;
+		long long columnsRead; // Columns actually read, after merging requests for the same column
+		long long readBatches;
+		int queuedReads;
+		int pendingWrites; // Saved columns that aren't on disk yet
+	};
+
+	ChunkIO(RegionStore &t_regions, ab::JobSystem &t_jobs);
+	~ChunkIO();
+	ChunkIO(const ChunkIO &) = delete;
+	ChunkIO &operator=(const ChunkIO &) = delete;
+	void readColumn(int t_columnX, int t_columnZ, const ReadCallback &t_callback);
+	void writeColumn(int t_columnX, int t_columnZ, const World &t_world);
+	void writeColumn(int t_columnX, int t_columnZ, const char *t_voxels, const bool *t_used);
+	void flush();
+	void finish();
+	Stats getStats() const;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct ReadRequest
+	{
+		int x;
+		int z;
+		ReadCallback callback;
+		Clock::time_point submitted;
+	};
+
+	struct WriteRequest
+	{
+		int x;
+		int z;
+		ColumnData column;
+	};
+
+	RegionStore &m_regions;
+	ab::JobSystem &m_jobs;
+	std::thread m_thread;
+
+	mutable std::mutex m_mutex; // Guards everything below
+	std::condition_variable m_wake; // Wakes the I/O thread
+	std::condition_variable m_idle; // Wakes finish() when the I/O thread runs out of work
+	std::vector<ReadRequest> m_reads;
+	std::vector<WriteRequest> m_writes; // Saved columns that haven't been handed to the RegionStore yet
+	std::vector<Clock::time_point> m_unflushed; // When each column waiting to be flushed was saved
+	std::vector<ab::JobSystem::JobHandle> m_callbacks; // Main thread jobs that haven't run yet
+	bool m_flushRequested;
+	bool m_busy;
+	bool m_stopping;
+	Stats m_stats;
+
+	void ioLoop();
+	void queueWrite(WriteRequest &t_request);
+	void store(std::vector<WriteRequest> &t_requests);
+	void read(std::vector<ReadRequest> &t_requests);
+	void write(const std::vector<Clock::time_point> &t_saved);
+};
+
+#endif // !CHUNKIO_H
@@ -0,0 +1,85 @@
+// *****************************************************
+// * ChunkPool.h and ChunkPool.cpp - Alan Bolger, 2021 *
+// *****************************************************
+
+#ifndef CHUNKPOOL_H
+#define CHUNKPOOL_H
+
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+class Chunk;
+
+// Slab allocator for chunks.
+// Chunk objects and the voxel blocks they use (bit-packed indices plus the palette, with
+// one size class for each of the 1, 2, 4 and 8 bit index widths) are carved out of large slabs and recycled
+// through free lists, and the pool keeps statistics for each of them (see Stats).
+// It isn't reliably faster than new/delete (see the chunk churn benchmark), and taking the lock is only a small part
+// of creating a chunk. Slabs are only released when the program exits, so the memory reserved stays at the peak.
+class ChunkPool
+{
+public:
+	struct Stats
+	{
+		std::size_t live = 0; // Blocks currently handed out
+		std::size_t peak = 0; // Highest number of live blocks at any one time
+		std::size_t allocations = 0; // Total number of allocations
+		std::size_t recycled = 0; // Allocations that reused a freed block
+		std::size_t slabs = 0; // Number of slabs allocated
+		std::size_t reservedBytes = 0; // Bytes reserved by the slabs
+	};
+
+	static ChunkPool &get();
+
+	Chunk *createChunk();
+	void destroyChunk(Chunk *t_chunk);
+	uint32_t *allocateBlock(int t_bitsPerIndex);
+	void freeBlock(uint32_t *t_block, int t_bitsPerIndex);
+	Stats getChunkStats() const;
+	Stats getBlockStats(int t_bitsPerIndex) const;
+	Stats getTotalStats() const;
+
+	static std::size_t getBlockSize(int t_bitsPerIndex);
+
+private:
+	// A pool of fixed-size blocks
+	class FixedPool
+	{
+	public:
+		FixedPool(std::size_t t_blockSize, std::size_t t_blocksPerSlab);
+		~FixedPool();
+		void *allocate();
+		void free(void *t_block);
+
+		Stats stats;
+
+	private:
+		struct FreeBlock
+		{
+			FreeBlock *next;
+		};
+
+		std::size_t m_blockSize;
+		std::size_t m_blocksPerSlab;
+		std::vector<char*> m_slabs;
+		FreeBlock *m_freeList;
+		std::size_t m_slabUsed; // Blocks used from the newest slab
+
+		void addSlab();
+	};
+
+	ChunkPool();
+	~ChunkPool();
+	ChunkPool(const ChunkPool &) = delete;
+	ChunkPool &operator=(const ChunkPool &) = delete;
+
+	static int getSizeClass(int t_bitsPerIndex);
+
+	FixedPool m_chunks;
+	FixedPool *m_blocks[4];
+	mutable std::mutex m_mutex;
+};
+
+#endif // !CHUNKPOOL_H
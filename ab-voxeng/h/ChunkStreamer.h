@@ -0,0 +1,97 @@
+// *************************************************************
+// * ChunkStreamer.h and ChunkStreamer.cpp - Alan Bolger, 2021 *
+// *************************************************************
+
+#ifndef CHUNKSTREAMER_H
+#define CHUNKSTREAMER_H
+
+#include "Globals.h"
+#include "World.h"
+#include "Terrain.h"
+#include "JobSystem.h"
+#include "ChunkIO.h"
+#include "glm/glm.hpp"
+
+#include <chrono>
+#include <vector>
+#include <unordered_map>
+
+// Keeps the columns of chunks around the camera loaded.
+// Every update, the columns within the load radius that aren't loaded yet are sorted by priority
+// (distance from the camera, with columns in front of the camera counting as closer) and the best
+// few are generated on the job system. Finished columns are written into the world on the main
+// thread by JobSystem::pump(), which marks them dirty so they're meshed like any other edit.
+// Columns past the unload radius are removed, and if the loaded columns use more memory than the
+// budget then the lowest priority columns are removed until they don't.
+// With a ChunkIO, saved columns are read on its I/O thread instead of being generated, and removed
+// columns that have been edited are saved (so edits aren't lost), otherwise edits to a column are lost when it's removed.
+// Columns that haven't been edited since they were loaded are never saved, they can be read or generated again.
+// With a generated cache, columns that haven't been saved are read from it instead of being generated again.
+class ChunkStreamer
+{
+public:
+	struct Stats
+	{
+		int resident; // Columns loaded
+		int loading; // Columns being generated
+		long long loaded; // Columns loaded since the start
+		long long unloaded; // Columns removed since the start (out of range or over the memory budget)
+		std::size_t memoryBytes; // Voxel memory of the loaded columns
+		ChunkIO::LatencyHistogram loads; // From asking for a column to it being in the world
+	};
+
+	ChunkStreamer(World &t_world, const ab::Terrain &t_terrain, ab::JobSystem &t_jobs);
+	~ChunkStreamer();
+	void update(const glm::vec3 &t_eye, const glm::vec3 &t_direction);
+	void finish();
+	void save();
+	void setChunkIO(ChunkIO *t_io);
+	void setGeneratedCache(ChunkIO *t_cache);
+	float getPriority(const Indices &t_chunkPosition) const;
+	bool isResident(int t_columnX, int t_columnZ) const;
+	void setLoadRadius(int t_radius);
+	int getLoadRadius() const;
+	void setMemoryBudget(float t_megabytes);
+	float getMemoryBudget() const;
+	Stats getStats() const;
+	void clearLatency();
+
+private:
+	// A column that has been loaded, or is being generated
+	struct Column
+	{
+		bool loading;
+		std::size_t memoryBytes;
+		std::chrono::steady_clock::time_point requested;
+	};
+
+	World &m_world;
+	const ab::Terrain &m_terrain;
+	ab::JobSystem &m_jobs;
+	ChunkIO *m_io; // Can be nullptr
+	ChunkIO *m_cache; // Generated columns, can be nullptr
+	std::unordered_map<Indices, Column, IndicesHash> m_columns; // Keyed by column position (y is always 0)
+	std::vector<ab::JobSystem::JobHandle> m_pending; // The jobs that write finished columns into the world
+	std::vector<Indices> m_candidates; // Reused by update()
+	glm::vec3 m_eye;
+	glm::vec2 m_forward; // The camera direction along the ground
+	int m_loadRadius;
+	std::size_t m_memoryBudget;
+	std::size_t m_memoryBytes;
+	int m_loading;
+	long long m_loaded;
+	long long m_unloaded;
+	ChunkIO::LatencyHistogram m_loadLatency;
+
+	float getColumnPriority(int t_columnX, int t_columnZ) const;
+	float getColumnDistance(int t_columnX, int t_columnZ) const;
+	void requestColumn(const Indices &t_column);
+	void loadGenerated(const Indices &t_column);
+	void generateColumn(const Indices &t_column);
+	void waitForPending();
+	void applyColumn(const Indices &t_column, const std::vector<char> &t_voxels, const bool *t_used);
+	void unloadColumn(const Indices &t_column);
+	bool unloadLowestPriority(float t_keepBelow);
+};
+
+#endif // !CHUNKSTREAMER_H
@@ -0,0 +1,48 @@
+// *******************************************************
+// * ChunkTable.h and ChunkTable.cpp - Alan Bolger, 2021 *
+// *******************************************************
+
+#ifndef CHUNKTABLE_H
+#define CHUNKTABLE_H
+
+#include "Globals.h"
+#include "Chunk.h"
+
+#include <vector>
+#include <functional>
+
+// Sparse storage for chunks, keyed by chunk position.
+// This is an open addressing hash map (linear probing) so a lookup is normally
+// a single probe into one flat array. Chunks only exist once something has been
+// written to them, so the size of the world is only limited by memory.
+// The table owns the chunks stored in it.
+class ChunkTable
+{
+public:
+	ChunkTable();
+	~ChunkTable();
+	Chunk *find(const Indices &t_position) const;
+	Chunk *findOrCreate(const Indices &t_position);
+	bool erase(const Indices &t_position);
+	void clear();
+	int getCount() const;
+	int getCapacity() const;
+	std::size_t getMemoryUsage() const;
+	void forEach(const std::function<void(const Indices &, Chunk *)> &t_function) const;
+
+private:
+	struct Slot
+	{
+		Indices position;
+		Chunk *chunk; // nullptr means the slot is empty
+	};
+
+	std::vector<Slot> m_slots;
+	unsigned int m_mask; // Capacity - 1 (capacity is always a power of 2)
+	int m_count;
+
+	unsigned int findSlot(const Indices &t_position) const;
+	void grow();
+};
+
+#endif // !CHUNKTABLE_H
@@ -0,0 +1,65 @@
+// *******************************************************
+// * FrameClock.h and FrameClock.cpp - Alan Bolger, 2021 *
+// *******************************************************
+
+#ifndef FRAMECLOCK_H
+#define FRAMECLOCK_H
+
+#include <chrono>
+
+namespace ab
+{
+	// Paces the game loop and runs the simulation at a fixed timestep.
+	// Each frame's real time goes into an accumulator that the simulation takes fixed steps out of, so the camera
+	// moves the same distance whatever the frame rate. What's left over (less than a step) gives how far to
+	// interpolate between the last two simulation states when drawing.
+	// When the frame rate is capped the clock sleeps for whatever is left of the frame's budget, measured on
+	// steady_clock. Deadlines are scheduled a whole frame apart (rather than a frame after the work finished)
+	// so a late frame doesn't push every later frame back.
+	// On Windows the system timer is set to 1 ms while a clock exists (it ticks every 15.6 ms by default, far longer
+	// than SPIN_MS), so sleeps wake up on time without SDL or anything else having to ask for it.
+	// In lockstep every frame simulates exactly one step whatever the real time, so a replay (see CameraPath)
+	// does the same work in the same frames on every machine.
+	class FrameClock
+	{
+	public:
+		typedef std::chrono::steady_clock Clock;
+
+		static constexpr double MAX_FRAME_MS = 250.0; // Longer frames (e.g. a stall or a breakpoint) only count as this long
+		static constexpr double SPIN_MS = 2.0; // Sleeping can overshoot by a millisecond or more, so the end of the wait is spent yielding
+
+		FrameClock(double t_stepMs, double t_framesPerSecond);
+		~FrameClock();
+		FrameClock(const FrameClock &) = delete;
+		FrameClock &operator=(const FrameClock &) = delete;
+		double beginFrame();
+		void advance(double t_elapsedMs);
+		bool step();
+		void endFrame();
+		void setFrameRate(double t_framesPerSecond);
+		void setLockstep(bool t_lockstep);
+		bool isUncapped() const;
+		double getStepMs() const;
+		double getInterpolation() const;
+		double getFrameMs() const;
+		double getWorkMs() const;
+		double getSleepMs() const;
+		int getStepCount() const;
+
+	private:
+		double m_stepMs;
+		double m_targetMs; // 0 when uncapped
+		double m_accumulatorMs; // Real time the simulation hasn't caught up with yet
+		bool m_started;
+		bool m_lockstep; // One step per frame
+		Clock::time_point m_frameStart;
+		Clock::time_point m_deadline; // When the current frame should end
+		double m_frameMs; // Between the starts of the last two frames
+		double m_workMs; // The last frame, not counting the sleep
+		double m_sleepMs;
+		int m_steps; // Taken this frame
+		int m_lastSteps; // Taken last frame
+	};
+}
+
+#endif // !FRAMECLOCK_H
@@ -9,6 +9,11 @@
 #include <windows.h>
 #include <psapi.h>
 #include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+#include <cstdio>
 
 #include "Globals.h"
 #include "glew/glew.h"
@@ -30,6 +35,16 @@
 #include "Terrain.h"
 #include "Debug.h"
 #include "World.h"
+#include "Mesher.h"
+#include "RemeshQueue.h"
+#include "ChunkStreamer.h"
+#include "RegionStore.h"
+#include "ChunkIO.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "Stats.h"
+#include "FrameClock.h"
+#include "CameraPath.h"
 #include "Timer.h" // Thanks to Paul O' Callaghan for this!
 
 class Game
@@ -38,14 +53,17 @@ public:
 	Game(int t_width, int t_height);
 	~Game();
 	void start();
+	void setUncapped(bool t_uncapped);
+	bool startFlythrough(const std::string &t_path, bool t_exitWhenDone);
 
 private:
-	HitInfo m_hitInfo; // Used for ray casting
+	RaycastHit m_raycastHit; // Used for ray casting
+	VoxelTemplate m_treeTemplate; // Planted with the middle mouse button
 
 	SDL_Window *m_window;
 	SDL_GLContext m_glContext;
-	double m_frameRate;
-	double m_frameMs;
+	ab::FrameClock *m_frameClock; // Paces the loop and steps the simulation
+	bool m_uncapped = false; // No frame rate cap, for benchmarking
 	bool m_looping;
 	ab::XboxOneController *m_controller;
 	ab::Camera *m_camera;
@@ -54,11 +72,8 @@ private:
 	ab::Shader *m_computeShader;
 	ab::Shader *m_skyboxShader;
 	ab::Terrain *m_terrain;
+	ab::JobSystem *m_jobs; // Shared by world generation, meshing and asset loading
 	SDL_Cursor *cursor;
-	ab::Model m_cube;
-	ab::Model m_waterBlock;
-	ab::Model m_treeBlock;
-	ab::Model m_leafBlock;
 	glm::vec3 m_directionalLightDirection = glm::vec3(1, -5, 1);
 	float m_directionalLightAmbient[3] = { 1.f, 1.f, 1.f };
 	float m_directionalLightDiffuse[3] = { 1.f, 1.f, 1.f };
@@ -66,13 +81,52 @@ private:
 	glm::vec2 m_mousePos;
 	glm::vec3 m_rayDirection;
 	glm::vec3 m_cameraEye;
+	glm::vec3 m_previousEye; // Where the camera was before the last simulation step
+	glm::vec3 m_renderEye; // Where the camera is drawn from, between m_previousEye and where it is now
+	glm::mat4 m_renderView;
 	glm::vec4 m_selectedCube;
-	glm::vec3 m_hitPoint;
 	int m_comboType = 0;
+	int m_meshMode = Mesher::MESH_GREEDY; // Mesher::MeshMode
 	bool m_raytracingOn = false;
-	bool m_instanceArrayUpdated = false;
 	World *world;
 
+	// Chunk meshes
+	struct ChunkMesh
+	{
+		GLuint vertexArrayObjectID;
+		GLuint vertexBufferID;
+		GLsizei quadCount;
+	};
+
+	std::unordered_map<Indices, ChunkMesh, IndicesHash> m_chunkMeshes;
+	std::vector<PackedVertex> m_meshVertices; // Reused every time a chunk is meshed
+	GLuint m_quadElementBufferID; // Shared by all chunk meshes
+	std::size_t m_meshBytes = 0; // The size of every chunk mesh's vertex buffer
+	GLuint m_blockTextureArrayID;
+	RemeshQueue m_remeshQueue; // Edited chunks waiting to be meshed
+	float m_remeshBudgetMs = REMESH_BUDGET_MS;
+	ChunkStreamer *m_streamer; // Loads the chunks around the camera
+	RegionStore *m_regions; // The saved world
+	ChunkIO *m_io; // Reads and writes the saved world off the main thread
+	RegionStore *m_cache; // Generated columns, so they're only generated once
+	ChunkIO *m_cacheIO;
+	int m_streamRadius = STREAM_LOAD_RADIUS;
+	float m_streamBudgetMB = STREAM_MEMORY_BUDGET_MB;
+
+	// Stats
+	int m_statsFrame = 0; // Frames since the start
+	std::int64_t m_statsFrameStart = 0; // When the last frame started on the profiler's clock
+	int m_drawCalls = 0; // In the last frame, not counting ImGui
+
+	// Camera paths
+	ab::CameraPath m_cameraPath;
+	bool m_recordingPath = false;
+	bool m_replayingPath = false; // A flythrough
+	bool m_exitAfterFlythrough = false;
+	double m_pathTimeMs = 0.0; // Simulation time since recording or replaying started
+	std::vector<float> m_flythroughFrames; // Each replayed frame's work time
+	long long m_flythroughLoadedStart = 0; // Columns loaded before the flythrough started
+
 	// Quad for render to texture
 	GLuint m_quadVertexArrayObjectID;
 	GLuint m_quadVertexBufferObjectID;
@@ -149,15 +203,24 @@ private:
 
 	void initialise();
 	void processEvents();
-	void update(double t_deltaTime);
+	void simulate(double t_stepMs);
+	void update();
 	void draw();
+	void updateStats();
+	void drawStats();
+	void drawCameraPath();
+	void finishFlythrough();
 	int getChunkIndex(int x, int y, int z);
 	void updateEntireMap();
+	void createQuadElementBuffer();
+	void updateChunkMesh(const Indices &t_position);
+	void uploadChunkMesh(const Indices &t_position, const std::vector<PackedVertex> &t_vertices);
+	void deleteChunkMesh(const Indices &t_position);
 	void initialiseRaytracing();
 	void raytrace();
 	void renderTextureToQuad(GLuint &t_textureID);
-	Indices getChunkXYZ(int x, int y, int z);
-	bool checkForVoxelIntersections(glm::vec3 t_origin, glm::vec3 t_direction, glm::vec3& t_hitPoint);
+	bool pickVoxel();
+	void createTreeTemplate();
 };
 
 #endif // !GAME_H
\ No newline at end of file
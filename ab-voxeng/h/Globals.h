@@ -7,32 +7,109 @@
 
 #include "glm/glm.hpp"
 
+#include <cstddef>
+
 // Values below should ALWAYS be power of 2 numbers,
 // otherwise things may break quite horribly.....
-// Also, keep the world height and the map height the same
 
 // Screen dimensions
 static unsigned int SCREEN_WIDTH;
 static unsigned int SCREEN_HEIGHT;
 
 // World data
+// This is only the size of the area that gets generated, the world itself
+// is stored sparsely and isn't limited to these dimensions (except for the
+// height, voxels can only be edited between 0 and WORLD_HEIGHT - 1)
 static const int WORLD_WIDTH = 1024;
 static const int WORLD_HEIGHT = 128;
 static const int WORLD_DEPTH = 1024;
 
 // Map generation data
-static const int MAP_WIDTH = 256;
-static const int MAP_HEIGHT = 128;
-static const int MAP_DEPTH = 256;
+static const unsigned int WORLD_SEED = 12345; // The same seed always generates the same world
 static const int WATER_HEIGHT = 1;
 static const float EXP = 4.0f; // This adjusts hills and valleys
+static const int TREE_SPACING = 8; // A tree needs the highest tree noise within this many columns, so higher values mean fewer trees
 static const bool DAYTIME = true; // Set this to false for night
+static const bool DENSITY_TERRAIN = false; // Set this to true for 3D terrain with caves and overhangs (no trees)
+static const int DENSITY_SURFACE_HEIGHT = 48; // Density terrain is half solid at this height
+static const float DENSITY_FALLOFF = 40.0f; // Higher values mean more overhangs and caves
+static const float DENSITY_FREQUENCY = 1.0f / 64.0f;
+
+// Voxel types
+enum BlockType : char
+{
+	BLOCK_AIR = 0,
+	BLOCK_GRASS = 1,
+	BLOCK_WATER = 2,
+	BLOCK_TREE = 3,
+	BLOCK_LEAF = 4,
+	BLOCK_TYPE_COUNT = 5
+};
+
+// Faces next to transparent blocks are still drawn (unless both blocks are the same type)
+static const bool BLOCK_TRANSPARENT[BLOCK_TYPE_COUNT] = { true, false, true, false, true };
+
+// Furthest distance the mouse can reach when adding or removing voxels
+static const float PICK_DISTANCE = 64.0f;
+
+// Time spent meshing edited chunks each frame (in milliseconds), the rest wait for the next frame
+static const float REMESH_BUDGET_MS = 2.0f;
+
+// The simulation (camera movement) runs in steps of this many milliseconds whatever the frame rate,
+// and frames are capped at FRAME_RATE_LIMIT per second unless the game is run with --uncapped
+// (the cap paces the loop on its own, v-sync is off)
+static const double SIMULATION_STEP_MS = 1000.0 / 60.0;
+static const double FRAME_RATE_LIMIT = 60.0;
+
+// Columns of chunks within this many chunks of the camera are loaded, and they're unloaded once
+// they're STREAM_UNLOAD_MARGIN chunks further away than that (so they don't flicker at the edge)
+static const int STREAM_LOAD_RADIUS = 24;
+static const int STREAM_UNLOAD_MARGIN = 2;
+
+// Memory for the voxels of the loaded columns (in megabytes), the least important columns are unloaded past this
+static const float STREAM_MEMORY_BUDGET_MB = 256.0f;
+
+// Saved worlds are kept in this directory (as region files)
+static const char *const WORLD_SAVE_DIRECTORY = "world";
+
+// Generated columns are cached so they're only generated once, in a directory named after this and
+// Terrain::getCacheKey() (the seed, the generation values above and the generator version)
+static const char *const WORLD_CACHE_DIRECTORY = "cache";
+
+// Profiler captures are written here (open it in chrome://tracing or https://ui.perfetto.dev)
+static const char *const PROFILER_TRACE_PATH = "trace.json";
+
+// The stats panel counts the voxels and measures the world's memory every this many frames (it visits every chunk)
+static const int STATS_WORLD_INTERVAL_FRAMES = 30;
+
+// The stats registry is written here by the "DUMP STATS" button
+static const char *const STATS_DUMP_PATH = "stats.json";
+
+// Camera paths are recorded here (a keyframe every CAMERA_PATH_KEYFRAME_MS of simulation time) and replayed from here
+// by the "REPLAY PATH" button, or from the file given to --flythrough
+static const char *const CAMERA_PATH_FILE = "camera-path.txt";
+static const double CAMERA_PATH_KEYFRAME_MS = 250.0;
+
+// A flythrough's results are written here, and frames whose work takes longer than FLYTHROUGH_HITCH_MS count as hitches
+static const char *const FLYTHROUGH_RESULTS_PATH = "flythrough.json";
+static const double FLYTHROUGH_HITCH_MS = 2.0 * SIMULATION_STEP_MS;
+
+// Columns that are unloaded get saved, and they're written to their region files once this many are
+// waiting or the oldest has waited CHUNK_IO_WRITE_DELAY_MS (in milliseconds)
+static const int REGION_FLUSH_COLUMNS = 64;
+static const int CHUNK_IO_WRITE_DELAY_MS = 2000;
 
 // This is the size of a chunk in voxels
 static const int CHUNK_WIDTH = 16;
 static const int CHUNK_HEIGHT = 16;
 static const int CHUNK_DEPTH = 16;
 
+// These are log2 of the chunk dimensions above, used to convert world
+// positions into chunk positions (this also works for negative positions)
+static const int CHUNK_WIDTH_SHIFT = 4;
+static const int CHUNK_HEIGHT_SHIFT = 4;
+static const int CHUNK_DEPTH_SHIFT = 4;
+
 
 // Simple struct for storing array [x, y, z] index values
 struct Indices
@@ -42,6 +119,33 @@ struct Indices
 	int z;
 };
 
+inline bool operator==(const Indices &a, const Indices &b)
+{
+	return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+inline bool operator!=(const Indices &a, const Indices &b)
+{
+	return !(a == b);
+}
+
+// Hash function for Indices so they can be used as keys (e.g. chunk positions)
+struct IndicesHash
+{
+	std::size_t operator()(const Indices &t_indices) const
+	{
+		// Multiply by large primes and then mix the bits (MurmurHash3 finaliser)
+		unsigned int h = (unsigned int)t_indices.x * 73856093u ^ (unsigned int)t_indices.y * 19349663u ^ (unsigned int)t_indices.z * 83492791u;
+		h ^= h >> 16;
+		h *= 0x85ebca6bu;
+		h ^= h >> 13;
+		h *= 0xc2b2ae35u;
+		h ^= h >> 16;
+
+		return h;
+	}
+};
+
 // A small collection of useful functions for various things and stuff and whatnot
 class Utility
 {
@@ -77,15 +181,26 @@ public:
 
 		return indices;
 	}
-};
 
-// Used to store ray casting hit data
-struct HitInfo
-{
-	int bi;
-	glm::vec2 lambda;
-	glm::vec3 intersectPoint;
-	glm::vec3 center;
+	/// <summary>
+	/// Hashes a seed together with a 2D coordinate, e.g. to give every terrain tile its own seed.
+	/// The result only depends on the inputs, so it's the same on every thread and every platform.
+	/// </summary>
+	/// <param name="t_seed">The seed.</param>
+	/// <param name="t_x">The X coordinate.</param>
+	/// <param name="t_z">The Z coordinate.</param>
+	/// <returns>The hashed value.</returns>
+	static unsigned int hash(unsigned int t_seed, int t_x, int t_z)
+	{
+		unsigned int h = t_seed * 2654435761u ^ (unsigned int)t_x * 73856093u ^ (unsigned int)t_z * 83492791u;
+		h ^= h >> 16;
+		h *= 0x85ebca6bu;
+		h ^= h >> 13;
+		h *= 0xc2b2ae35u;
+		h ^= h >> 16;
+
+		return h;
+	}
 };
 
 #endif // !GLOBALS_H
@@ -0,0 +1,89 @@
+// *****************************************************
+// * JobSystem.h and JobSystem.cpp - Alan Bolger, 2021 *
+// *****************************************************
+
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ab
+{
+	// A work stealing job scheduler.
+	// Every worker thread has its own queue: jobs a worker adds go on the back of its own queue
+	// and it takes its next job from the back too (the most recently added, so its data is likely
+	// still in the cache). When a worker runs out of jobs it steals from the front of another queue.
+	// Jobs can depend on other jobs and only start once all of their dependencies have finished.
+	// Main thread jobs (anything that uses OpenGL) are never run by a worker, they wait until
+	// the main thread calls pump() or wait().
+	// The thread that creates the job system is treated as the main thread, and it runs jobs too
+	// while it's waiting, so a job system with no workers still works (everything runs in wait()).
+	class JobSystem
+	{
+	public:
+		struct Job;
+		typedef std::shared_ptr<Job> JobHandle;
+
+		struct Stats
+		{
+			long long executed; // Jobs run
+			long long stolen; // Jobs taken from another thread's queue
+		};
+
+		explicit JobSystem(int t_workerCount = -1);
+		~JobSystem();
+		JobHandle add(const std::function<void()> &t_function, const std::vector<JobHandle> &t_dependencies = std::vector<JobHandle>());
+		JobHandle addMainThread(const std::function<void()> &t_function, const std::vector<JobHandle> &t_dependencies = std::vector<JobHandle>());
+		void wait(const JobHandle &t_job);
+		void wait(const std::vector<JobHandle> &t_jobs);
+		void parallelFor(int t_begin, int t_end, int t_grainSize, const std::function<void(int, int)> &t_function);
+		int pump();
+		bool isFinished(const JobHandle &t_job) const;
+		bool isMainThread() const;
+		int getWorkerCount() const;
+		Stats getStats() const;
+		static int getDefaultWorkerCount();
+
+	private:
+		// A queue of jobs that are ready to run
+		struct WorkQueue
+		{
+			std::mutex mutex;
+			std::deque<JobHandle> jobs;
+		};
+
+		std::vector<std::thread> m_workers;
+		std::vector<std::unique_ptr<WorkQueue>> m_queues; // One for each worker, plus one for jobs added by other threads
+		WorkQueue m_mainThreadQueue;
+		std::thread::id m_mainThreadID;
+		std::atomic<unsigned int> m_nextQueue; // Spreads out jobs added by other threads
+
+		// Used to put idle workers to sleep
+		std::mutex m_wakeMutex;
+		std::condition_variable m_wake;
+		std::atomic<int> m_queued;
+		std::atomic<int> m_sleeping;
+		std::atomic<bool> m_stopping;
+
+		std::atomic<long long> m_executed;
+		std::atomic<long long> m_stolen;
+
+		JobHandle create(const std::function<void()> &t_function, const std::vector<JobHandle> &t_dependencies, bool t_mainThread);
+		void release(const JobHandle &t_job);
+		void schedule(const JobHandle &t_job);
+		bool takeJob(JobHandle &t_job);
+		bool runMainThreadJob();
+		void execute(const JobHandle &t_job);
+		void workerLoop(int t_index);
+		int getQueueIndex() const;
+	};
+}
+
+#endif // !JOBSYSTEM_H
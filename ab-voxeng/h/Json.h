@@ -0,0 +1,22 @@
+// *******************************************
+// * Json.h and Json.cpp - Alan Bolger, 2021 *
+// *******************************************
+
+#ifndef JSON_H
+#define JSON_H
+
+#include <ostream>
+#include <string>
+
+namespace ab
+{
+	// Writes JSON values, for the files that the profiler, the stats registry and the benchmarks write out.
+	class Json
+	{
+	public:
+		static void writeString(std::ostream &t_stream, const std::string &t_string);
+		static void writeNumber(std::ostream &t_stream, double t_value);
+	};
+}
+
+#endif // !JSON_H
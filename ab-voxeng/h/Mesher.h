@@ -0,0 +1,90 @@
+// ***********************************************
+// * Mesher.h and Mesher.cpp - Alan Bolger, 2021 *
+// ***********************************************
+
+#ifndef MESHER_H
+#define MESHER_H
+
+#include "Globals.h"
+#include "World.h"
+
+#include <cstdint>
+#include <vector>
+
+// A single vertex of a chunk mesh, before it's packed.
+// Every face is a quad of 4 vertices, drawn with a shared index buffer (0, 1, 2, 2, 3, 0 for each quad).
+struct MeshVertex
+{
+	int x; // Corner position relative to the chunk (0 to the chunk size, voxel (0, 0, 0) spans 0 to 1)
+	int y;
+	int z;
+	int face; // Mesher::Face
+	int ao; // Ambient occlusion (0 is fully occluded, 3 is not occluded)
+	int layer; // Texture array layer (block type - 1)
+};
+
+// A chunk mesh vertex packed into 32 bits, unpacked by passthrough.vert:
+// bits 0-4 x, 5-9 y, 10-14 z, 15-17 face, 18-19 ao, 20-27 layer (28-31 are unused).
+// Texture coordinates aren't stored, the shader takes them from the position.
+typedef uint32_t PackedVertex;
+
+// Builds chunk meshes on the CPU (no OpenGL calls are made here).
+// Chunks are meshed from a padded copy of the chunk that includes a one voxel
+// border from the neighbouring chunks, so faces are culled across chunk boundaries too.
+// There are three modes:
+// - Naive: every face of every voxel (only useful for comparison)
+// - Culled: only faces that border air or a different transparent block
+// - Greedy: culled faces, with neighbouring faces of the same block type merged into larger quads
+// Each vertex gets an ambient occlusion value from the three voxels that touch its corner in front of the face.
+// Greedy meshing only merges faces with the same ambient occlusion.
+class Mesher
+{
+public:
+	enum Face
+	{
+		FACE_POS_X,
+		FACE_NEG_X,
+		FACE_POS_Y,
+		FACE_NEG_Y,
+		FACE_POS_Z,
+		FACE_NEG_Z
+	};
+
+	enum MeshMode
+	{
+		MESH_NAIVE,
+		MESH_CULLED,
+		MESH_GREEDY
+	};
+
+	static const int PADDED_WIDTH = CHUNK_WIDTH + 2;
+	static const int PADDED_HEIGHT = CHUNK_HEIGHT + 2;
+	static const int PADDED_DEPTH = CHUNK_DEPTH + 2;
+	static const int PADDED_SIZE = PADDED_WIDTH * PADDED_HEIGHT * PADDED_DEPTH;
+	static const int MAX_QUADS = CHUNK_WIDTH * CHUNK_HEIGHT * CHUNK_DEPTH * 6; // Every face of every voxel (naive mode)
+
+	// PackedVertex bit layout
+	static const int POSITION_BITS = 5;
+	static const int FACE_BITS = 3;
+	static const int AO_BITS = 2;
+	static const int LAYER_BITS = 8;
+	static const int X_SHIFT = 0;
+	static const int Y_SHIFT = X_SHIFT + POSITION_BITS;
+	static const int Z_SHIFT = Y_SHIFT + POSITION_BITS;
+	static const int FACE_SHIFT = Z_SHIFT + POSITION_BITS;
+	static const int AO_SHIFT = FACE_SHIFT + FACE_BITS;
+	static const int LAYER_SHIFT = AO_SHIFT + AO_BITS;
+
+	static void meshChunk(World &t_world, const Indices &t_chunkPosition, std::vector<PackedVertex> &t_vertices, MeshMode t_mode = MESH_GREEDY);
+	static void gatherNeighbourhood(World &t_world, const Indices &t_chunkPosition, char *t_padded);
+	static void meshNaive(const char *t_padded, std::vector<PackedVertex> &t_vertices);
+	static void meshCulled(const char *t_padded, std::vector<PackedVertex> &t_vertices);
+	static void meshGreedy(const char *t_padded, std::vector<PackedVertex> &t_vertices);
+	static PackedVertex packVertex(const MeshVertex &t_vertex);
+	static MeshVertex unpackVertex(PackedVertex t_packed);
+	static int getFaceAO(const char *t_padded, int t_index, int t_face);
+	static int paddedIndex(int x, int y, int z);
+	static bool isFaceVisible(char t_type, char t_neighbour);
+};
+
+#endif // !MESHER_H
@@ -10,6 +10,7 @@
 #include "glew/glew.h"
 #include "glm/glm.hpp"
 
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -9,18 +9,37 @@
 
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
+#include "Globals.h"
+#include "NoiseKernel.h"
 
 #include <math.h>
 #include <vector>
 #include <random>
 #include <iostream>
+#include <utility>
 
 namespace ab
 {
+	// Simplex noise in 2, 3 and 4 dimensions, all scaled to [0, 1].
+	// noise(x, y...) evaluates a single sample. The array versions evaluate many samples at once with
+	// the widest kernel the CPU supports (AVX2, SSE2 or scalar, picked at runtime). Every kernel gives
+	// exactly the same results, in float or double. Compared with the single sample versions the
+	// difference is at most 1e-7 in double (2D noise(x, y) rounds to float), and in float it's at most
+	// 3e-7 * max(1, |x| + |y|) for 2D and 5e-6 * max(1, |x| + |y| + ...) for 3D and 4D (the error of
+	// float grows with the size of the coordinates, and 3D and 4D noise has tiny jumps between
+	// simplices that float can land on the wrong side of).
 	class Noise
 	{
 	public:
+		enum SimdLevel
+		{
+			SIMD_SCALAR,
+			SIMD_SSE2,
+			SIMD_AVX2
+		};
+
 		Noise();
+		explicit Noise(unsigned int t_seed);
 		~Noise();
 		void initialise();
 		int fastFloor(double t_x);
@@ -28,6 +47,17 @@ namespace ab
 		double dot(int t_g[], double t_x, double t_y, double t_z);
 		double dot(int t_g[], double t_x, double t_y, double t_z, double t_w);
 		double noise(double t_xin, double t_yin); // 2D simplex noise
+		double noise(double t_xin, double t_yin, double t_zin); // 3D simplex noise
+		double noise(double t_xin, double t_yin, double t_zin, double t_win); // 4D simplex noise
+		void noise(const float *t_x, const float *t_y, float *t_results, int t_count) const;
+		void noise(const double *t_x, const double *t_y, double *t_results, int t_count) const;
+		void noise(const float *t_x, const float *t_y, const float *t_z, float *t_results, int t_count) const;
+		void noise(const double *t_x, const double *t_y, const double *t_z, double *t_results, int t_count) const;
+		void noise(const float *t_x, const float *t_y, const float *t_z, const float *t_w, float *t_results, int t_count) const;
+		void noise(const double *t_x, const double *t_y, const double *t_z, const double *t_w, double *t_results, int t_count) const;
+		SimdLevel getSimdLevel() const;
+		void setSimdLevel(SimdLevel t_level);
+		static SimdLevel getSupportedSimdLevel();
 		float normaliseToRange(float t_value, float t_min, float t_max);
 
 	private:
@@ -57,9 +87,25 @@ namespace ab
 						49,192,214, 31,181,199,106,157,184, 84,204,176,115,121,50,45,127, 4,150,254,
 						138,236,205,93,222,114,67,29,24,72,243,141,128,195,78,66,215,61,156,180 };
 
+		void shuffle(unsigned int t_seed);
+
 		// To remove the need for index wrapping, double the permutation table length
 		int perm[512];
 
+		// The gradient for each entry of perm (grad3[perm[i] % 12] and grad4[perm[i] % 32]), used by the array versions of noise()
+		int m_gradX[512];
+		int m_gradY[512];
+		int m_gradZ[512];
+		int m_grad4X[512];
+		int m_grad4Y[512];
+		int m_grad4Z[512];
+		int m_grad4W[512];
+
+		SimdLevel m_simdLevel;
+
+		template <typename T>
+		void noiseBatch(int t_dimensions, const T *const *t_coordinates, T *t_results, int t_count) const;
+
 		// This is a lookup table used to traverse the simplex around a given point in 4D
 		int simplex[64][4] = {
 		{0,1,2,3},{0,1,3,2},{0,0,0,0},{0,2,3,1},{0,0,0,0},{0,0,0,0},{0,0,0,0},{1,2,3,0},
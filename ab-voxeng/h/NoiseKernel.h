@@ -0,0 +1,435 @@
+// *********************************************************************************************
+// * NoiseKernel.h, NoiseKernel.cpp and NoiseKernelAVX2.cpp - Alan Bolger, 2021                *
+// * Batched simplex noise, based on 'Simplex Noise Demystified' by Stefan Gustavson, 2005.    *
+// *********************************************************************************************
+
+#ifndef NOISEKERNEL_H
+#define NOISEKERNEL_H
+
+// SSE2 and AVX2 are only available on x86, everything else uses the scalar kernel
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define NOISE_KERNEL_X86
+#endif
+
+namespace ab
+{
+	// The lookup tables a batch of noise is evaluated with (owned by a Noise object).
+	// The gradient tables are indexed the same way as perm and already include the % 12 or % 32.
+	struct NoiseTables
+	{
+		const int *perm; // Doubled permutation table (512 entries)
+		const int *gradX; // grad3[perm[i] % 12], for 2D and 3D noise
+		const int *gradY;
+		const int *gradZ;
+		const int *grad4X; // grad4[perm[i] % 32], for 4D noise
+		const int *grad4Y;
+		const int *grad4Z;
+		const int *grad4W;
+	};
+
+	// Entry points for each instruction set, used by Noise::noise() for arrays of coordinates.
+	// t_coordinates has one array for each dimension (2, 3 or 4), each with t_count values.
+	// The AVX2 versions live in NoiseKernelAVX2.cpp, the only file that's compiled with AVX2 enabled,
+	// and they must only be called if isAVX2Supported() returns true.
+	class NoiseKernel
+	{
+	public:
+		static void simplexScalar(const NoiseTables &t_tables, int t_dimensions, const float *const *t_coordinates, float *t_results, int t_count);
+		static void simplexScalar(const NoiseTables &t_tables, int t_dimensions, const double *const *t_coordinates, double *t_results, int t_count);
+		static void simplexSSE2(const NoiseTables &t_tables, int t_dimensions, const float *const *t_coordinates, float *t_results, int t_count);
+		static void simplexSSE2(const NoiseTables &t_tables, int t_dimensions, const double *const *t_coordinates, double *t_results, int t_count);
+		static void simplexAVX2(const NoiseTables &t_tables, int t_dimensions, const float *const *t_coordinates, float *t_results, int t_count);
+		static void simplexAVX2(const NoiseTables &t_tables, int t_dimensions, const double *const *t_coordinates, double *t_results, int t_count);
+		static bool isSSE2Supported();
+		static bool isAVX2Supported();
+	};
+
+	// The batched simplex noise functions below are the same for every instruction set, S wraps
+	// the instructions (see NoiseKernel.cpp). There are no branches: the simplex is picked by
+	// ranking the coordinates with compares and masks, and the gradients come from the tables.
+	// Every instruction set does exactly the same operations in the same order, so they all give
+	// exactly the same results. Only the S functions are used (nothing from the standard library),
+	// because this is compiled separately for each instruction set.
+
+	/// <summary>
+	/// Runs a sample function over arrays of coordinates, S::WIDTH at a time.
+	/// The last few coordinates are copied into a full width batch.
+	/// </summary>
+	/// <param name="t_coordinates">One array for each dimension.</param>
+	/// <param name="t_results">Filled with a result for every coordinate.</param>
+	/// <param name="t_count">The number of coordinates.</param>
+	/// <param name="t_sample">Takes DIMENSIONS vectors of coordinates and returns a vector of results.</param>
+	template <typename S, int DIMENSIONS, typename Sample>
+	void simplexBatches(const typename S::T *const *t_coordinates, typename S::T *t_results, int t_count, const Sample &t_sample)
+	{
+		typedef typename S::T T;
+		typedef typename S::V V;
+
+		V f_coordinates[DIMENSIONS];
+		int i = 0;
+
+		for (; i + S::WIDTH <= t_count; i += S::WIDTH)
+		{
+			for (int d = 0; d < DIMENSIONS; ++d)
+			{
+				f_coordinates[d] = S::load(t_coordinates[d] + i);
+			}
+
+			S::store(t_results + i, t_sample(f_coordinates));
+		}
+
+		if (i < t_count)
+		{
+			T f_padded[DIMENSIONS][S::WIDTH] = {};
+			T f_results[S::WIDTH];
+
+			for (int d = 0; d < DIMENSIONS; ++d)
+			{
+				for (int j = 0; i + j < t_count; ++j)
+				{
+					f_padded[d][j] = t_coordinates[d][i + j];
+				}
+
+				f_coordinates[d] = S::load(f_padded[d]);
+			}
+
+			S::store(f_results, t_sample(f_coordinates));
+
+			for (int j = 0; i + j < t_count; ++j)
+			{
+				t_results[i + j] = f_results[j];
+			}
+		}
+	}
+
+	/// <summary>
+	/// Evaluates 2D simplex noise (scaled to [0, 1]) for arrays of coordinates.
+	/// </summary>
+	/// <param name="t_tables">The permutation and gradient tables.</param>
+	/// <param name="t_coordinates">The X and Y coordinates.</param>
+	/// <param name="t_results">Filled with a noise value for every coordinate.</param>
+	/// <param name="t_count">The number of coordinates.</param>
+	template <typename S>
+	void simplex2Batch(const NoiseTables &t_tables, const typename S::T *const *t_coordinates, typename S::T *t_results, int t_count)
+	{
+		typedef typename S::T T;
+		typedef typename S::V V;
+		typedef typename S::I I;
+
+		const V F2 = S::set((T)0.36602540378443864676); // 0.5 * (sqrt(3) - 1)
+		const V G2 = S::set((T)0.21132486540518711775); // (3 - sqrt(3)) / 6
+		const V G2_MINUS_ONE = S::set((T)(2.0 * 0.21132486540518711775 - 1.0));
+		const V ONE = S::set((T)1.0);
+		const V HALF = S::set((T)0.5);
+		const V ZERO = S::set((T)0.0);
+		const V SCALE = S::set((T)35.0); // 70 to scale to [-1, 1], then halved to scale to [0, 1]
+
+		// Contribution from one corner of the simplex
+		auto corner = [&](V t_cornerX, V t_cornerY, I t_gradient)
+		{
+			V f_t = S::max(S::sub(S::sub(HALF, S::mul(t_cornerX, t_cornerX)), S::mul(t_cornerY, t_cornerY)), ZERO);
+			f_t = S::mul(f_t, f_t);
+			f_t = S::mul(f_t, f_t);
+
+			V f_dot = S::add(S::mul(S::gatherGradient(t_tables.gradX, t_gradient), t_cornerX), S::mul(S::gatherGradient(t_tables.gradY, t_gradient), t_cornerY));
+
+			return S::mul(f_t, f_dot);
+		};
+
+		simplexBatches<S, 2>(t_coordinates, t_results, t_count, [&](const V *t_sample)
+		{
+			// Skew the input space to determine which simplex cell we're in
+			V f_s = S::mul(S::add(t_sample[0], t_sample[1]), F2);
+			I f_i;
+			I f_j;
+			V f_cellX = S::floor(S::add(t_sample[0], f_s), f_i);
+			V f_cellY = S::floor(S::add(t_sample[1], f_s), f_j);
+			V f_t = S::mul(S::add(f_cellX, f_cellY), G2);
+
+			// The distances from the cell origin
+			V f_x0 = S::sub(t_sample[0], S::sub(f_cellX, f_t));
+			V f_y0 = S::sub(t_sample[1], S::sub(f_cellY, f_t));
+
+			// Lower triangle (i1 = 1, j1 = 0) or upper triangle (i1 = 0, j1 = 1)
+			V f_i1 = S::select(S::greater(f_x0, f_y0), ONE);
+			V f_j1 = S::sub(ONE, f_i1);
+
+			V f_x1 = S::add(S::sub(f_x0, f_i1), G2);
+			V f_y1 = S::add(S::sub(f_y0, f_j1), G2);
+			V f_x2 = S::add(f_x0, G2_MINUS_ONE);
+			V f_y2 = S::add(f_y0, G2_MINUS_ONE);
+
+			// Hashed gradient indices of the three corners
+			I f_ii = S::wrap(f_i);
+			I f_jj = S::wrap(f_j);
+			I f_g0 = S::addInt(f_ii, S::gather(t_tables.perm, f_jj));
+			I f_g1 = S::addInt(S::addInt(f_ii, S::toInt(f_i1)), S::gather(t_tables.perm, S::addInt(f_jj, S::toInt(f_j1))));
+			I f_g2 = S::addInt(S::addInt(f_ii, S::intOne()), S::gather(t_tables.perm, S::addInt(f_jj, S::intOne())));
+
+			V f_noise = S::add(S::add(corner(f_x0, f_y0, f_g0), corner(f_x1, f_y1, f_g1)), corner(f_x2, f_y2, f_g2));
+
+			return S::add(S::mul(f_noise, SCALE), HALF);
+		});
+	}
+
+	/// <summary>
+	/// Evaluates 3D simplex noise (scaled to [0, 1]) for arrays of coordinates.
+	/// </summary>
+	/// <param name="t_tables">The permutation and gradient tables.</param>
+	/// <param name="t_coordinates">The X, Y and Z coordinates.</param>
+	/// <param name="t_results">Filled with a noise value for every coordinate.</param>
+	/// <param name="t_count">The number of coordinates.</param>
+	template <typename S>
+	void simplex3Batch(const NoiseTables &t_tables, const typename S::T *const *t_coordinates, typename S::T *t_results, int t_count)
+	{
+		typedef typename S::T T;
+		typedef typename S::V V;
+		typedef typename S::I I;
+
+		const V F3 = S::set((T)(1.0 / 3.0));
+		const V G3 = S::set((T)(1.0 / 6.0));
+		const V G3_TWICE = S::set((T)(2.0 / 6.0));
+		const V G3_MINUS_ONE = S::set((T)(3.0 / 6.0 - 1.0));
+		const V ONE = S::set((T)1.0);
+		const V TWO = S::set((T)2.0);
+		const V HALF = S::set((T)0.5);
+		const V ONE_AND_HALF = S::set((T)1.5);
+		const V ZERO = S::set((T)0.0);
+		const V RADIUS = S::set((T)0.6);
+		const V SCALE = S::set((T)16.0); // 32 to scale to [-1, 1], then halved to scale to [0, 1]
+
+		// Contribution from one corner of the simplex
+		auto corner = [&](V t_x, V t_y, V t_z, I t_gradient)
+		{
+			V f_t = S::sub(S::sub(S::sub(RADIUS, S::mul(t_x, t_x)), S::mul(t_y, t_y)), S::mul(t_z, t_z));
+			f_t = S::max(f_t, ZERO);
+			f_t = S::mul(f_t, f_t);
+			f_t = S::mul(f_t, f_t);
+
+			V f_dot = S::add(S::add(S::mul(S::gatherGradient(t_tables.gradX, t_gradient), t_x),
+				S::mul(S::gatherGradient(t_tables.gradY, t_gradient), t_y)),
+				S::mul(S::gatherGradient(t_tables.gradZ, t_gradient), t_z));
+
+			return S::mul(f_t, f_dot);
+		};
+
+		simplexBatches<S, 3>(t_coordinates, t_results, t_count, [&](const V *t_sample)
+		{
+			// Skew the input space to determine which simplex cell we're in
+			V f_s = S::mul(S::add(S::add(t_sample[0], t_sample[1]), t_sample[2]), F3);
+			I f_i;
+			I f_j;
+			I f_k;
+			V f_cellX = S::floor(S::add(t_sample[0], f_s), f_i);
+			V f_cellY = S::floor(S::add(t_sample[1], f_s), f_j);
+			V f_cellZ = S::floor(S::add(t_sample[2], f_s), f_k);
+			V f_t = S::mul(S::add(S::add(f_cellX, f_cellY), f_cellZ), G3);
+
+			// The distances from the cell origin
+			V f_x0 = S::sub(t_sample[0], S::sub(f_cellX, f_t));
+			V f_y0 = S::sub(t_sample[1], S::sub(f_cellY, f_t));
+			V f_z0 = S::sub(t_sample[2], S::sub(f_cellZ, f_t));
+
+			// Rank the distances (2 is the largest), the simplex steps along the largest axis first.
+			// Ties go to the earlier axis, the same as the x0 >= y0 tests in the scalar version
+			V f_xy = S::sub(ONE, S::select(S::greater(f_y0, f_x0), ONE));
+			V f_xz = S::sub(ONE, S::select(S::greater(f_z0, f_x0), ONE));
+			V f_yz = S::sub(ONE, S::select(S::greater(f_z0, f_y0), ONE));
+			V f_rankX = S::add(f_xy, f_xz);
+			V f_rankY = S::add(S::sub(ONE, f_xy), f_yz);
+			V f_rankZ = S::sub(S::sub(TWO, f_xz), f_yz);
+
+			// Offsets of the second and third corners
+			V f_i1 = S::select(S::greater(f_rankX, ONE_AND_HALF), ONE);
+			V f_j1 = S::select(S::greater(f_rankY, ONE_AND_HALF), ONE);
+			V f_k1 = S::select(S::greater(f_rankZ, ONE_AND_HALF), ONE);
+			V f_i2 = S::select(S::greater(f_rankX, HALF), ONE);
+			V f_j2 = S::select(S::greater(f_rankY, HALF), ONE);
+			V f_k2 = S::select(S::greater(f_rankZ, HALF), ONE);
+
+			V f_x1 = S::add(S::sub(f_x0, f_i1), G3);
+			V f_y1 = S::add(S::sub(f_y0, f_j1), G3);
+			V f_z1 = S::add(S::sub(f_z0, f_k1), G3);
+			V f_x2 = S::add(S::sub(f_x0, f_i2), G3_TWICE);
+			V f_y2 = S::add(S::sub(f_y0, f_j2), G3_TWICE);
+			V f_z2 = S::add(S::sub(f_z0, f_k2), G3_TWICE);
+			V f_x3 = S::add(f_x0, G3_MINUS_ONE);
+			V f_y3 = S::add(f_y0, G3_MINUS_ONE);
+			V f_z3 = S::add(f_z0, G3_MINUS_ONE);
+
+			// Hashed gradient indices of the four corners
+			I f_ii = S::wrap(f_i);
+			I f_jj = S::wrap(f_j);
+			I f_kk = S::wrap(f_k);
+
+			auto hash = [&](I t_i, I t_j, I t_k)
+			{
+				I f_index = S::gather(t_tables.perm, S::addInt(f_kk, t_k));
+				f_index = S::gather(t_tables.perm, S::addInt(S::addInt(f_jj, t_j), f_index));
+
+				return S::addInt(S::addInt(f_ii, t_i), f_index);
+			};
+
+			I f_zero = S::toInt(ZERO);
+			I f_one = S::intOne();
+			I f_g0 = hash(f_zero, f_zero, f_zero);
+			I f_g1 = hash(S::toInt(f_i1), S::toInt(f_j1), S::toInt(f_k1));
+			I f_g2 = hash(S::toInt(f_i2), S::toInt(f_j2), S::toInt(f_k2));
+			I f_g3 = hash(f_one, f_one, f_one);
+
+			V f_noise = S::add(S::add(corner(f_x0, f_y0, f_z0, f_g0), corner(f_x1, f_y1, f_z1, f_g1)),
+				S::add(corner(f_x2, f_y2, f_z2, f_g2), corner(f_x3, f_y3, f_z3, f_g3)));
+
+			return S::add(S::mul(f_noise, SCALE), HALF);
+		});
+	}
+
+	/// <summary>
+	/// Evaluates 4D simplex noise (scaled to [0, 1]) for arrays of coordinates.
+	/// </summary>
+	/// <param name="t_tables">The permutation and gradient tables.</param>
+	/// <param name="t_coordinates">The X, Y, Z and W coordinates.</param>
+	/// <param name="t_results">Filled with a noise value for every coordinate.</param>
+	/// <param name="t_count">The number of coordinates.</param>
+	template <typename S>
+	void simplex4Batch(const NoiseTables &t_tables, const typename S::T *const *t_coordinates, typename S::T *t_results, int t_count)
+	{
+		typedef typename S::T T;
+		typedef typename S::V V;
+		typedef typename S::I I;
+
+		const V F4 = S::set((T)0.30901699437494742410); // (sqrt(5) - 1) / 4
+		const V G4 = S::set((T)0.13819660112501051518); // (5 - sqrt(5)) / 20
+		const V G4_TWICE = S::set((T)(2.0 * 0.13819660112501051518));
+		const V G4_THRICE = S::set((T)(3.0 * 0.13819660112501051518));
+		const V G4_MINUS_ONE = S::set((T)(4.0 * 0.13819660112501051518 - 1.0));
+		const V ONE = S::set((T)1.0);
+		const V HALF = S::set((T)0.5);
+		const V ONE_AND_HALF = S::set((T)1.5);
+		const V TWO_AND_HALF = S::set((T)2.5);
+		const V ZERO = S::set((T)0.0);
+		const V RADIUS = S::set((T)0.6);
+		const V SCALE = S::set((T)13.5); // 27 to scale to [-1, 1], then halved to scale to [0, 1]
+
+		// Contribution from one corner of the simplex
+		auto corner = [&](const V *t_position, I t_gradient)
+		{
+			V f_t = S::sub(S::sub(RADIUS, S::mul(t_position[0], t_position[0])), S::mul(t_position[1], t_position[1]));
+			f_t = S::sub(S::sub(f_t, S::mul(t_position[2], t_position[2])), S::mul(t_position[3], t_position[3]));
+			f_t = S::max(f_t, ZERO);
+			f_t = S::mul(f_t, f_t);
+			f_t = S::mul(f_t, f_t);
+
+			V f_dot = S::add(S::add(S::mul(S::gatherGradient(t_tables.grad4X, t_gradient), t_position[0]),
+				S::mul(S::gatherGradient(t_tables.grad4Y, t_gradient), t_position[1])),
+				S::add(S::mul(S::gatherGradient(t_tables.grad4Z, t_gradient), t_position[2]),
+				S::mul(S::gatherGradient(t_tables.grad4W, t_gradient), t_position[3])));
+
+			return S::mul(f_t, f_dot);
+		};
+
+		simplexBatches<S, 4>(t_coordinates, t_results, t_count, [&](const V *t_sample)
+		{
+			// Skew the input space to determine which simplex cell we're in
+			V f_s = S::mul(S::add(S::add(t_sample[0], t_sample[1]), S::add(t_sample[2], t_sample[3])), F4);
+			I f_cell[4];
+			V f_cellPosition[4];
+
+			for (int d = 0; d < 4; ++d)
+			{
+				f_cellPosition[d] = S::floor(S::add(t_sample[d], f_s), f_cell[d]);
+			}
+
+			V f_t = S::mul(S::add(S::add(f_cellPosition[0], f_cellPosition[1]), S::add(f_cellPosition[2], f_cellPosition[3])), G4);
+
+			// The distances from the cell origin
+			V f_corner0[4];
+
+			for (int d = 0; d < 4; ++d)
+			{
+				f_corner0[d] = S::sub(t_sample[d], S::sub(f_cellPosition[d], f_t));
+			}
+
+			// Rank the distances (3 is the largest), this does the same job as the simplex[64][4] lookup table
+			V f_xy = S::select(S::greater(f_corner0[0], f_corner0[1]), ONE);
+			V f_xz = S::select(S::greater(f_corner0[0], f_corner0[2]), ONE);
+			V f_xw = S::select(S::greater(f_corner0[0], f_corner0[3]), ONE);
+			V f_yz = S::select(S::greater(f_corner0[1], f_corner0[2]), ONE);
+			V f_yw = S::select(S::greater(f_corner0[1], f_corner0[3]), ONE);
+			V f_zw = S::select(S::greater(f_corner0[2], f_corner0[3]), ONE);
+			V f_rank[4];
+			f_rank[0] = S::add(S::add(f_xy, f_xz), f_xw);
+			f_rank[1] = S::add(S::add(S::sub(ONE, f_xy), f_yz), f_yw);
+			f_rank[2] = S::add(S::add(S::sub(ONE, f_xz), S::sub(ONE, f_yz)), f_zw);
+			f_rank[3] = S::add(S::add(S::sub(ONE, f_xw), S::sub(ONE, f_yw)), S::sub(ONE, f_zw));
+
+			// Offsets and distances of the other four corners
+			V f_offset1[4];
+			V f_offset2[4];
+			V f_offset3[4];
+			V f_corner1[4];
+			V f_corner2[4];
+			V f_corner3[4];
+			V f_corner4[4];
+			I f_wrapped[4];
+
+			for (int d = 0; d < 4; ++d)
+			{
+				f_offset1[d] = S::select(S::greater(f_rank[d], TWO_AND_HALF), ONE);
+				f_offset2[d] = S::select(S::greater(f_rank[d], ONE_AND_HALF), ONE);
+				f_offset3[d] = S::select(S::greater(f_rank[d], HALF), ONE);
+				f_corner1[d] = S::add(S::sub(f_corner0[d], f_offset1[d]), G4);
+				f_corner2[d] = S::add(S::sub(f_corner0[d], f_offset2[d]), G4_TWICE);
+				f_corner3[d] = S::add(S::sub(f_corner0[d], f_offset3[d]), G4_THRICE);
+				f_corner4[d] = S::add(f_corner0[d], G4_MINUS_ONE);
+				f_wrapped[d] = S::wrap(f_cell[d]);
+			}
+
+			// Hashed gradient indices of the five corners
+			auto hash = [&](const V *t_offset)
+			{
+				I f_index = S::gather(t_tables.perm, S::addInt(f_wrapped[3], S::toInt(t_offset[3])));
+				f_index = S::gather(t_tables.perm, S::addInt(S::addInt(f_wrapped[2], S::toInt(t_offset[2])), f_index));
+				f_index = S::gather(t_tables.perm, S::addInt(S::addInt(f_wrapped[1], S::toInt(t_offset[1])), f_index));
+
+				return S::addInt(S::addInt(f_wrapped[0], S::toInt(t_offset[0])), f_index);
+			};
+
+			const V ZEROS[4] = { ZERO, ZERO, ZERO, ZERO };
+			const V ONES[4] = { ONE, ONE, ONE, ONE };
+
+			V f_noise = S::add(S::add(corner(f_corner0, hash(ZEROS)), corner(f_corner1, hash(f_offset1))),
+				S::add(corner(f_corner2, hash(f_offset2)), corner(f_corner3, hash(f_offset3))));
+			f_noise = S::add(f_noise, corner(f_corner4, hash(ONES)));
+
+			return S::add(S::mul(f_noise, SCALE), HALF);
+		});
+	}
+
+	/// <summary>
+	/// Evaluates 2D, 3D or 4D simplex noise for arrays of coordinates.
+	/// </summary>
+	/// <param name="t_tables">The permutation and gradient tables.</param>
+	/// <param name="t_dimensions">The number of dimensions (2, 3 or 4).</param>
+	/// <param name="t_coordinates">One array of coordinates for each dimension.</param>
+	/// <param name="t_results">Filled with a noise value for every coordinate.</param>
+	/// <param name="t_count">The number of coordinates.</param>
+	template <typename S>
+	void simplexBatch(const NoiseTables &t_tables, int t_dimensions, const typename S::T *const *t_coordinates, typename S::T *t_results, int t_count)
+	{
+		switch (t_dimensions)
+		{
+		case 2:
+			simplex2Batch<S>(t_tables, t_coordinates, t_results, t_count);
+			break;
+		case 3:
+			simplex3Batch<S>(t_tables, t_coordinates, t_results, t_count);
+			break;
+		case 4:
+			simplex4Batch<S>(t_tables, t_coordinates, t_results, t_count);
+			break;
+		}
+	}
+}
+
+#endif // !NOISEKERNEL_H
@@ -11,6 +11,7 @@
 #include "Model.h"
 #include "ModelLoader.h"
 #include "Shader.h"
+#include "JobSystem.h"
 
 namespace ab
 {
@@ -21,6 +22,7 @@ namespace ab
 		static void draw(ab::Model &t_model, Shader *t_shader, std::string t_uniformName = "");
 		static GLuint createFBO(GLsizei t_width, GLsizei t_height);
 		static GLuint loadSkyBoxCubeMap(std::vector<std::string> &t_faces);
+		static GLuint loadTextureArray(std::vector<std::string> &t_layers, JobSystem *t_jobs = nullptr);
 		static int nextPowerOfTwo(int x);		
 
 		static void uniform1f(Shader &t_shader, std::string t_uniformName, float t_float);
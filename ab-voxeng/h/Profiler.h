@@ -0,0 +1,132 @@
+// ***************************************************
+// * Profiler.h and Profiler.cpp - Alan Bolger, 2021 *
+// ***************************************************
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Profiling is on unless NDEBUG is defined (release builds), define AB_PROFILE as 0 or 1 to override that.
+// With it off the macros below are empty, so nothing is recorded and there's no cost at all.
+#ifndef AB_PROFILE
+#ifdef NDEBUG
+#define AB_PROFILE 0
+#else
+#define AB_PROFILE 1
+#endif
+#endif
+
+#define AB_PROFILE_CONCAT_INNER(a, b) a##b
+#define AB_PROFILE_CONCAT(a, b) AB_PROFILE_CONCAT_INNER(a, b)
+
+// MACROS for profiling, names must be string literals (only the pointer is stored)
+// PROFILE_SCOPE("Name") times from here to the end of the enclosing scope, PROFILE_FUNCTION() names it after the function
+// PROFILE_COUNTER("Name", value) records a value that's drawn as a graph
+// PROFILE_THREAD("Name") names the calling thread on the timeline
+#if AB_PROFILE
+#define PROFILE_SCOPE(name) ab::Profiler::Zone AB_PROFILE_CONCAT(f_profileZone, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#define PROFILE_COUNTER(name, value) ab::Profiler::counter(name, (double)(value))
+#define PROFILE_THREAD(name) ab::Profiler::setThreadName(name)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_COUNTER(name, value)
+#define PROFILE_THREAD(name)
+#endif
+
+namespace ab
+{
+	// A scoped CPU profiler that records nested zones and counters from every thread onto one timeline.
+	// Each thread writes to a ring buffer of its own, so recording never takes a lock or waits for
+	// another thread: the owning thread fills in an event and then publishes it by moving the head on.
+	// The buffers keep the most recent EVENTS_PER_THREAD events of each thread, and writeChromeTrace()
+	// copies them out (without stopping the threads) for chrome://tracing or https://ui.perfetto.dev.
+	// A thread's buffer outlives it (so its events can still be exported) until a new thread reuses it.
+	// Times come from steady_clock and are measured from when the profiler was first used.
+	class Profiler
+	{
+	public:
+		static const std::uint32_t EVENTS_PER_THREAD = 1 << 16;
+
+		enum class EventType : std::uint8_t
+		{
+			ZONE,
+			COUNTER
+		};
+
+		struct Event
+		{
+			const char *name;
+			std::int64_t start; // Nanoseconds since the profiler's epoch
+			std::int64_t duration; // Zones only
+			double value; // Counters only
+			std::uint32_t depth; // How many zones this zone is nested in
+			EventType type;
+		};
+
+		// Times its own lifetime, use PROFILE_SCOPE() instead of creating these directly
+		class Zone
+		{
+		public:
+			explicit Zone(const char *t_name);
+			~Zone();
+			Zone(const Zone &) = delete;
+			Zone &operator=(const Zone &) = delete;
+
+		private:
+			const char *m_name;
+			std::int64_t m_start;
+		};
+
+		// A copy of one thread's events, oldest first
+		struct ThreadEvents
+		{
+			std::uint32_t id;
+			std::string name;
+			std::vector<Event> events;
+		};
+
+		static void counter(const char *t_name, double t_value);
+		static void setThreadName(const std::string &t_name);
+		static std::int64_t now();
+		static std::vector<ThreadEvents> capture();
+		static std::vector<Event> getRecentEvents(std::int64_t t_since);
+		static bool writeChromeTrace(const std::string &t_path);
+		static void clear();
+
+	private:
+		struct ThreadBuffer
+		{
+			std::uint32_t id;
+			std::string name; // Guarded by s_mutex
+			std::uint32_t depth; // Only used by the owning thread
+			bool retired; // Its thread has ended, guarded by s_mutex
+			std::atomic<std::uint64_t> head; // Events written so far, the next goes at head % EVENTS_PER_THREAD
+			std::atomic<std::uint64_t> tail; // Events before this have been cleared
+			Event events[EVENTS_PER_THREAD];
+		};
+
+		static std::mutex s_mutex; // Guards the list of buffers (not the events in them)
+		static std::vector<std::unique_ptr<ThreadBuffer>> s_buffers; // Kept after their thread ends so its events can still be exported
+		static std::uint32_t s_threadCount; // Every thread gets a new ID, even when it reuses a buffer
+
+		// Retires the calling thread's buffer when the thread ends
+		struct BufferOwner
+		{
+			ThreadBuffer *buffer = nullptr;
+			~BufferOwner();
+		};
+
+		static ThreadBuffer &getBuffer();
+		static void record(ThreadBuffer &t_buffer, const Event &t_event);
+	};
+}
+
+#endif // !PROFILER_H
@@ -0,0 +1,78 @@
+// *******************************************************
+// * RegionFile.h and RegionFile.cpp - Alan Bolger, 2021 *
+// *******************************************************
+
+#ifndef REGIONFILE_H
+#define REGIONFILE_H
+
+#include "Globals.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ab
+{
+	// A saved square of chunk columns, read through a memory mapped view of the file.
+	// The file starts with a fixed size header and a table with the offset and size of every
+	// chunk, so one chunk can be read without touching the rest of the file:
+	//
+	//   magic "ABRG", version (u32), region X and Z (i32)
+	//   chunk width, height and depth, chunks per column (u8 each)
+	//   saved flag for every column (u8 each)
+	//   offset and size of every chunk (u32 each, a size of 0 means the chunk is all air)
+	//   compressed chunk data
+	//
+	// Numbers are stored little endian. Each chunk is compressed on its own as runs of
+	// (voxel type, run length) in Utility::at() order, with the run length stored 7 bits per byte.
+	class RegionFile
+	{
+	public:
+		static const int COLUMNS = 16; // Columns along each side of a region
+		static const int COLUMN_CHUNKS = WORLD_HEIGHT / CHUNK_HEIGHT;
+		static const int CHUNKS = COLUMNS * COLUMNS * COLUMN_CHUNKS;
+		static const int CHUNK_VOXELS = CHUNK_WIDTH * CHUNK_HEIGHT * CHUNK_DEPTH;
+		static const std::uint32_t VERSION = 1; // Increase this whenever the layout changes, older files are then ignored
+
+		// A compressed chunk
+		struct ChunkData
+		{
+			const unsigned char *data;
+			std::uint32_t size;
+		};
+
+		RegionFile();
+		~RegionFile();
+		RegionFile(const RegionFile &) = delete;
+		RegionFile &operator=(const RegionFile &) = delete;
+		bool open(const std::string &t_path);
+		void close();
+		bool isOpen() const;
+		bool hasColumn(int t_column) const;
+		ChunkData getChunk(int t_chunk) const;
+		bool readChunk(int t_chunk, char *t_voxels) const;
+		void prefetch(int t_firstChunk, int t_lastChunk) const;
+		int getRegionX() const;
+		int getRegionZ() const;
+		std::size_t getFileSize() const;
+
+		static int getColumn(int t_localX, int t_localZ);
+		static int getChunkIndex(int t_column, int t_chunkY);
+		static bool write(const std::string &t_path, int t_regionX, int t_regionZ, const bool *t_columns, const ChunkData *t_chunks);
+		static bool replace(const std::string &t_from, const std::string &t_to);
+		static void compress(const char *t_voxels, std::vector<unsigned char> &t_data);
+		static bool decompress(const unsigned char *t_data, std::size_t t_size, char *t_voxels);
+
+	private:
+		const unsigned char *m_data; // The mapped file, nullptr when closed
+		std::size_t m_size;
+		int m_regionX;
+		int m_regionZ;
+#ifdef _WIN32
+		void *m_file;
+		void *m_mapping;
+#endif
+	};
+}
+
+#endif // !REGIONFILE_H
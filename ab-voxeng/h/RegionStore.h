@@ -0,0 +1,78 @@
+// *********************************************************
+// * RegionStore.h and RegionStore.cpp - Alan Bolger, 2021 *
+// *********************************************************
+
+#ifndef REGIONSTORE_H
+#define REGIONSTORE_H
+
+#include "Globals.h"
+#include "RegionFile.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class World;
+
+// The saved columns of a world, as a directory of region files.
+// Region files are only mapped the first time one of their columns is read, so opening a saved
+// world costs nothing until chunks are actually needed.
+// Saved columns are compressed and kept in memory until flush() merges them into their region files.
+// There are two locks: one for the columns waiting to be flushed, only ever held to look them up or swap
+// them in and out, and one for the region files, held while they're mapped, read or copied from. Saving a
+// column only takes the first, so it never waits for the disk (or for a read or flush to finish with it).
+// Columns can be read, saved and flushed from any thread, except for saving from a World which has to be
+// done on the main thread.
+class RegionStore
+{
+public:
+	// One column to read with readColumns()
+	struct ColumnRead
+	{
+		int x;
+		int z;
+		char *voxels;
+		bool *used;
+		bool found;
+	};
+
+	RegionStore(const std::string &t_directory);
+	~RegionStore();
+	bool hasColumn(int t_columnX, int t_columnZ);
+	bool readColumn(int t_columnX, int t_columnZ, char *t_voxels, bool *t_used);
+	void readColumns(std::vector<ColumnRead> &t_reads);
+	void writeColumn(int t_columnX, int t_columnZ, const char *t_voxels, const bool *t_used);
+	void writeColumn(int t_columnX, int t_columnZ, const World &t_world);
+	bool flush();
+	int getPendingCount() const;
+	const std::string &getDirectory() const;
+	std::string getRegionPath(int t_regionX, int t_regionZ) const;
+	static void getRegionPosition(int t_columnX, int t_columnZ, int &t_regionX, int &t_regionZ, int &t_column);
+
+private:
+	// The compressed chunks of a saved column (empty vectors are all air).
+	// They're never changed once they're pending, saving the column again replaces them, so they can be read
+	// without the lock and a flush can tell if the column it wrote has been saved again since.
+	struct PendingColumn
+	{
+		std::vector<std::vector<unsigned char>> chunks;
+	};
+
+	typedef std::shared_ptr<const PendingColumn> PendingPtr;
+
+	std::string m_directory;
+	std::unordered_map<Indices, PendingPtr, IndicesHash> m_pending; // Keyed by column position (y is always 0)
+	std::unordered_map<Indices, std::unique_ptr<ab::RegionFile>, IndicesHash> m_regions; // Keyed by region position (y is always 0)
+	mutable std::mutex m_mutex; // Guards m_pending
+	std::mutex m_fileMutex; // Guards m_regions
+	std::mutex m_flushMutex; // Only one flush at a time
+
+	PendingPtr findPending(int t_columnX, int t_columnZ) const;
+	ab::RegionFile &getRegion(int t_regionX, int t_regionZ);
+	static bool readPending(const PendingColumn &t_pending, char *t_voxels, bool *t_used);
+	static bool readFile(const ab::RegionFile &t_file, int t_column, char *t_voxels, bool *t_used);
+};
+
+#endif // !REGIONSTORE_H
@@ -0,0 +1,44 @@
+// *********************************************************
+// * RemeshQueue.h and RemeshQueue.cpp - Alan Bolger, 2021 *
+// *********************************************************
+
+#ifndef REMESHQUEUE_H
+#define REMESHQUEUE_H
+
+#include "Globals.h"
+#include "World.h"
+#include "ChunkIO.h"
+
+#include <chrono>
+#include <deque>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+
+// A queue of chunks waiting to be meshed again.
+// Dirty chunks are collected from the world each frame and meshed in the order they were
+// edited (or in priority order, see sort()), stopping once the frame's time budget is used up. Anything left over waits for
+// the next frame, so a big edit is spread over several frames instead of causing a stall.
+// The time from a chunk being queued to it being meshed is kept in a latency histogram.
+class RemeshQueue
+{
+public:
+	void collect(World &t_world);
+	void push(const Indices &t_position);
+	void sort(const std::function<float(const Indices &)> &t_priority);
+	int process(double t_budgetMs, const std::function<void(const Indices &)> &t_remesh);
+	std::size_t getCount() const;
+	void clear();
+	const ChunkIO::LatencyHistogram &getLatency() const;
+	void clearLatency();
+
+private:
+	std::deque<Indices> m_queue;
+	std::unordered_map<Indices, std::chrono::steady_clock::time_point, IndicesHash> m_queued; // When each waiting chunk was queued, stops a chunk being queued twice
+	std::vector<Indices> m_dirty; // Reused by collect()
+	std::vector<std::pair<float, Indices>> m_sorted; // Reused by sort()
+	ChunkIO::LatencyHistogram m_latency;
+};
+
+#endif // !REMESHQUEUE_H
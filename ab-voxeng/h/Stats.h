@@ -0,0 +1,59 @@
+// *********************************************
+// * Stats.h and Stats.cpp - Alan Bolger, 2021 *
+// *********************************************
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ab
+{
+	// A registry of named values (timings, counts, memory sizes, queue depths) that the engine updates as it runs.
+	// Stats are kept in groups, in the order they were first set, so a panel can be drawn from the registry alone.
+	// Stats that are sampled (e.g. the frame time) also keep their last HISTORY_LENGTH values for graphs and percentiles.
+	// Nothing here needs a window, so the registry can be written out as text or JSON by headless tools too.
+	class Stats
+	{
+	public:
+		static const int HISTORY_LENGTH = 240;
+
+		struct Stat
+		{
+			std::string group;
+			std::string name;
+			std::string unit;
+			double value; // The latest value
+			std::vector<float> history; // Oldest first, sampled stats only
+		};
+
+		static void set(const std::string &t_group, const std::string &t_name, double t_value, const std::string &t_unit);
+		static void addSample(const std::string &t_group, const std::string &t_name, double t_value, const std::string &t_unit);
+		static bool get(const std::string &t_group, const std::string &t_name, Stat &t_stat);
+		static std::vector<Stat> getAll();
+		static double getPercentile(const Stat &t_stat, double t_percentile);
+		static void write(std::ostream &t_stream);
+		static bool writeJson(const std::string &t_path);
+		static void clear();
+
+	private:
+		struct Entry
+		{
+			Stat stat;
+			std::size_t next; // Where the next sample goes once the history is full
+		};
+
+		static std::mutex s_mutex;
+		static std::vector<Entry> s_stats;
+		static std::unordered_map<std::string, std::size_t> s_indices; // The group and name (split by a newline) to the index in s_stats
+
+		static Entry &find(const std::string &t_group, const std::string &t_name, const std::string &t_unit);
+		static Stat copy(const Entry &t_entry);
+	};
+}
+
+#endif // !STATS_H
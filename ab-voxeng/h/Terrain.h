@@ -13,26 +13,65 @@
 #include "Globals.h"
 
 #include <math.h>
+#include <cstdint>
+#include <string>
 #include <vector>
-#include <random>
 
 namespace ab
 {
+	// Generates the voxels of the world one chunk column at a time, straight from the seed.
+	// There are no world-sized maps: a column only needs the noise of its own columns and of the
+	// neighbouring columns whose trees can reach it, so memory use doesn't depend on the size of the world.
+	// Heights are normalised with a fixed range (sampled once from the seed) instead of the min and max
+	// of a whole map, so every column can be generated on its own, in any order, on any thread.
+	// Density terrain is generated a chunk at a time instead (see generateChunkDensity()).
 	class Terrain
 	{
 	public:
-		int heightMap[WORLD_WIDTH][WORLD_DEPTH];
-		int waterMap[WORLD_WIDTH][WORLD_DEPTH];
-		int treeMap[WORLD_WIDTH][WORLD_DEPTH];
+		// A column of chunks, CHUNK_WIDTH x WORLD_HEIGHT x CHUNK_DEPTH voxels
+		static const int COLUMN_CHUNKS = WORLD_HEIGHT / CHUNK_HEIGHT;
+		static const int CHUNK_VOXELS = CHUNK_WIDTH * CHUNK_HEIGHT * CHUNK_DEPTH;
+		static const int COLUMN_VOXELS = COLUMN_CHUNKS * CHUNK_VOXELS;
 
-		Terrain();
+		// Tree trunks are 4 to 10 voxels tall and the pointy tops reach 4 to 7 voxels from the trunk
+		static const int TREE_MIN_HEIGHT = 4;
+		static const int TREE_HEIGHT_RANGE = 7;
+		static const int TREE_MIN_TOP = 4;
+		static const int TREE_TOP_RANGE = 4;
+		static const int TREE_MAX_TOP = TREE_MIN_TOP + TREE_TOP_RANGE - 1;
+
+		// Density terrain: 3D noise is evaluated every DENSITY_STEP voxels and interpolated in between
+		static const int DENSITY_STEP = 4;
+		static const int DENSITY_POINTS_X = CHUNK_WIDTH / DENSITY_STEP + 1;
+		static const int DENSITY_POINTS_Y = CHUNK_HEIGHT / DENSITY_STEP + 1;
+		static const int DENSITY_POINTS_Z = CHUNK_DEPTH / DENSITY_STEP + 1;
+		static const int DENSITY_POINTS = DENSITY_POINTS_X * DENSITY_POINTS_Y * DENSITY_POINTS_Z;
+
+		// Increase this whenever a change to the code changes the terrain, cached columns are then generated again
+		static const std::uint32_t GENERATOR_VERSION = 1;
+
+		explicit Terrain(unsigned int t_seed = WORLD_SEED);
 		~Terrain();
-		void generate(int t_width, int t_height);
+		void generateColumn(int t_chunkX, int t_chunkZ, char *t_voxels, bool *t_used) const;
+		int getHeight(int x, int z) const;
+		unsigned int getSeed() const;
+		std::uint64_t getCacheKey() const;
+		std::string getCacheDirectory(const std::string &t_prefix) const;
+		bool generateChunkDensity(const Indices &t_chunkPosition, char *t_voxels) const;
+		float getDensity(int x, int y, int z) const;
+		static void maxFilter(const float *t_values, float *t_results, int t_count, int t_stride, int t_radius);
 
 	private:
 		Noise *m_noise;
+		unsigned int m_seed;
+		float m_elevationMin; // The fixed range that elevation is normalised with
+		float m_elevationMax;
 
 		void initialise();
+		void sampleElevation(const float *t_x, const float *t_z, float *t_elevation, int t_count) const;
+		void sampleTreeNoise(const float *t_x, const float *t_z, float *t_treeNoise, int t_count) const;
+		int toHeight(float t_elevation) const;
+		void sampleDensity(const float *t_x, const float *t_y, const float *t_z, float *t_density, int t_count) const;
 	};
 }
 
@@ -6,25 +6,111 @@
 #define WORLD_H
 
 #include "Globals.h"
-#include "Map.h"
+#include "Chunk.h"
+#include "ChunkTable.h"
 
 #include <iostream>
 #include <vector>
 #include <functional>
+#include <unordered_set>
 
+namespace ab
+{
+	class Terrain;
+	class JobSystem;
+}
+
+class RegionStore;
+
+// A single voxel write, used for batched edits
+struct VoxelEdit
+{
+	int x;
+	int y;
+	int z;
+	char type;
+};
+
+// A prefab block of voxels (e.g. a building) that can be stamped into the world.
+// Voxels are stored using Utility::at() ordering and air voxels are skipped when stamping.
+struct VoxelTemplate
+{
+	int width;
+	int height;
+	int depth;
+	std::vector<char> voxels;
+};
+
+// The result of a ray cast
+struct RaycastHit
+{
+	Indices voxel; // The voxel that was hit
+	Indices previous; // The empty cell the ray passed through just before the hit (where a new voxel would be placed)
+	Indices normal; // The normal of the face that was hit
+	float distance; // Distance along the ray to the hit
+	char type; // The type of voxel that was hit
+};
+
+// Chunks are marked dirty whenever their voxels change, along with any neighbouring chunks
+// whose meshes depend on the changed voxels (edits on a chunk's border), so that only
+// those chunks need to be meshed again. See RemeshQueue.
+// Columns are also remembered as modified when they're edited, so that only edited columns need saving.
+// The world is unlimited across the ground but edits are kept between 0 and WORLD_HEIGHT - 1, the height
+// that columns are generated, saved and streamed at.
 class World
 {
 public:
+	struct Stats
+	{
+		int chunks; // Chunks loaded
+		long long solidVoxels; // Voxels that aren't air
+		std::size_t memoryBytes; // The chunk table and every chunk's voxels
+	};
+
 	World();
 	~World();
 	void optimiseWorldStorage();
 	void setVoxel(int x, int y, int z, char type);
 	char getVoxel(int x, int y, int z);
-	void populate(int heightMap[WORLD_WIDTH][WORLD_DEPTH], int treeMap[WORLD_WIDTH][WORLD_DEPTH], int waterMap[WORLD_WIDTH][WORLD_DEPTH]);
-	void placeScenery(int treeMap[WORLD_WIDTH][WORLD_DEPTH]);
+	void fillBox(int x1, int y1, int z1, int x2, int y2, int z2, char type);
+	void setVoxels(const std::vector<VoxelEdit> &edits);
+	void stamp(const VoxelTemplate &voxelTemplate, int x, int y, int z);
+	void markDirty(const Indices &position);
+	void takeDirtyChunks(std::vector<Indices> &positions);
+	void clearDirtyChunks();
+	std::size_t getDirtyCount() const;
+	bool isColumnModified(int columnX, int columnZ) const;
+	void clearColumnModified(int columnX, int columnZ);
+	Stats getStats() const;
+	bool raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, RaycastHit &hit);
+	void populate(const ab::Terrain &terrain, ab::JobSystem *jobs, RegionStore *cache = nullptr);
+	void setChunkVoxels(const Indices &position, const char *voxels);
+	void unloadChunk(const Indices &position);
+	void copyColumn(int columnX, int columnZ, char *voxels, bool *used) const;
+	bool save(RegionStore &regions) const;
+	bool loadColumn(RegionStore &regions, int columnX, int columnZ);
+	static Indices getChunkPosition(int x, int y, int z);
+	static int getVoxelIndex(int x, int y, int z);
+	static bool isEditable(int y);
 
-	std::vector<Map*> maps;
+	ChunkTable chunks;
+
+private:
+	// The voxels that an edit changed within one chunk
+	struct EditBounds
+	{
+		bool changed;
+		Indices min; // Local positions within the chunk
+		Indices max;
+	};
+
+	std::vector<Indices> m_dirtyChunks; // In the order they were marked
+	std::unordered_set<Indices, IndicesHash> m_dirtySet;
+	std::unordered_set<Indices, IndicesHash> m_modifiedColumns; // Columns edited since they were loaded (y is always 0)
+
+	bool writeVoxel(Chunk *&t_chunk, const Indices &t_position, int t_index, char t_type, EditBounds &t_edit);
+	void finishChunkEdit(Chunk *t_chunk, const Indices &t_position, const EditBounds &t_edit, bool t_modified);
+	void forEachChunkInBox(const Indices &t_min, const Indices &t_max, const std::function<void(const Indices &, const Indices &, const Indices &)> &t_function);
 };
 
 #endif // !WORLD_H
-
@@ -1,11 +1,14 @@
 #version 330 core
 
-uniform sampler2D diffuseTexture;
+uniform sampler2DArray diffuseTexture; // One block texture per layer
 uniform vec3 viewPosition;
 
 in vec3 fragPos;
 in vec2 texCoords;
 in vec3 normal;
+in float occlusion;
+flat in int face;
+flat in float layer;
 
 out vec4 fragColour;
 
@@ -18,6 +21,24 @@ struct directionalLight
 
 uniform directionalLight dirLight;
 
+// Each block texture is a cube net, these map a face's texture coordinates (0 to 1 across
+// the face) to its part of the net: uv = origin + fract(u) * uAxis + fract(v) * vAxis
+// Same order as Mesher::Face
+const vec2 faceOrigin[6] = vec2[6](
+    vec2(0.666413, 0.250594), vec2(0.666413, 0.999452),
+    vec2(0.666413, 0.749833), vec2(0.666413, 0.000975),
+    vec2(0.000761, 0.749833), vec2(0.999239, 0.749833));
+
+const vec2 faceUAxis[6] = vec2[6](
+    vec2(-0.332826, 0.0), vec2(-0.332826, 0.0),
+    vec2(0.0, -0.249619), vec2(0.0, 0.249619),
+    vec2(0.0, -0.249619), vec2(0.0, -0.249619));
+
+const vec2 faceVAxis[6] = vec2[6](
+    vec2(0.0, 0.249619), vec2(0.0, -0.249619),
+    vec2(-0.332826, 0.0), vec2(-0.332826, 0.0),
+    vec2(0.332826, 0.0), vec2(-0.332826, 0.0));
+
 vec3 calculateDirectionalLight(directionalLight light, vec3 t_normal, vec3 viewDir, vec3 texColour)
 {
     vec3 lightDir = normalize(-light.direction);
@@ -36,8 +57,10 @@ void main()
 {
     vec3 norm = normalize(normal);
     vec3 viewDir = normalize(viewPosition - fragPos);
-    vec3 texColour = texture(diffuseTexture, texCoords).rgb;
-    vec3 result = calculateDirectionalLight(dirLight, norm, viewDir, texColour);    	
+    vec2 tiled = fract(texCoords);
+    vec2 atlasCoords = faceOrigin[face] + tiled.x * faceUAxis[face] + tiled.y * faceVAxis[face];
+    vec3 texColour = texture(diffuseTexture, vec3(atlasCoords, layer)).rgb;
+    vec3 result = calculateDirectionalLight(dirLight, norm, viewDir, texColour) * occlusion;    	
 
     fragColour = vec4(result, 1.0);
 }
\ No newline at end of file
@@ -1,23 +1,42 @@
 #version 330 core
 
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec2 aTexCoords;
-layout (location = 2) in vec3 aNormal;
-layout (location = 6) in mat4 matrixInstance;
+layout (location = 0) in uint aPacked; // Mesher's PackedVertex
 
-uniform mat4 model;
+uniform vec3 chunkOffset; // World position of the chunk's first voxel
 uniform mat4 view;
 uniform mat4 projection;
 
 out vec2 texCoords;
 out vec3 fragPos;
 out vec3 normal;
+out float occlusion;
+flat out int face;
+flat out float layer;
+
+// Same order as Mesher::Face
+const vec3 faceNormals[6] = vec3[6](
+    vec3(1.0, 0.0, 0.0), vec3(-1.0, 0.0, 0.0),
+    vec3(0.0, 1.0, 0.0), vec3(0.0, -1.0, 0.0),
+    vec3(0.0, 0.0, 1.0), vec3(0.0, 0.0, -1.0));
+
+// The axes that run across each face (texture coordinates follow them)
+const int faceSAxis[6] = int[6](2, 2, 0, 0, 0, 0);
+const int faceTAxis[6] = int[6](1, 1, 2, 2, 1, 1);
+
+// Brightness for each ambient occlusion value (0 is fully occluded)
+const float aoBrightness[4] = float[4](0.45, 0.65, 0.85, 1.0);
 
 void main()
 {
-    texCoords = aTexCoords;
-    fragPos = vec3(matrixInstance * vec4(aPos, 1.0)); // Uncomment this for instancing
-    // fragPos = vec3(model * vec4(aPos, 1.0)); // Used for individual draw calls
-    normal = transpose(inverse(mat3(matrixInstance))) * aNormal;
+    // Same bit layout as Mesher::packVertex()
+    vec3 corner = vec3(float(aPacked & 31u), float((aPacked >> 5u) & 31u), float((aPacked >> 10u) & 31u));
+    face = int((aPacked >> 15u) & 7u);
+    occlusion = aoBrightness[(aPacked >> 18u) & 3u];
+    layer = float((aPacked >> 20u) & 255u);
+
+    // Voxels are unit cubes centred on their positions, corners are at the half positions
+    fragPos = chunkOffset + corner - 0.5;
+    texCoords = vec2(corner[faceSAxis[face]], corner[faceTAxis[face]]);
+    normal = faceNormals[face];
     gl_Position = projection * view * vec4(fragPos, 1.0);
-} 
\ No newline at end of file
+}
@@ -1,4 +1,5 @@
 #include "Camera.h"
+#include "CameraPath.h"
 
 /// <summary>
 /// Constructor for the Camera class.
@@ -90,6 +91,41 @@ void ab::Camera::setEye(glm::vec3 t_position)
 	m_eye = t_position;
 }
 
+/// <summary>
+/// Puts the camera at a position facing a direction, e.g. to replay a CameraPath.
+/// </summary>
+/// <param name="t_eye">The position of the camera.</param>
+/// <param name="t_yaw">The yaw in degrees.</param>
+/// <param name="t_pitch">The pitch in degrees.</param>
+void ab::Camera::setPose(glm::vec3 t_eye, double t_yaw, double t_pitch)
+{
+	glm::vec3 f_direction = CameraPath::getDirection(t_yaw, t_pitch);
+
+	m_eye = t_eye;
+	m_yaw = t_yaw;
+	m_pitch = t_pitch;
+	m_direction = glm::vec4(f_direction, 0.0f);
+	camera(m_eye, m_pitch, m_yaw);
+}
+
+/// <summary>
+/// Get the current yaw.
+/// </summary>
+/// <returns>The yaw in degrees.</returns>
+double ab::Camera::getYaw()
+{
+	return m_yaw;
+}
+
+/// <summary>
+/// Get the current pitch.
+/// </summary>
+/// <returns>The pitch in degrees.</returns>
+double ab::Camera::getPitch()
+{
+	return m_pitch;
+}
+
 /// <summary>
 /// Compute the world direction vector.
 /// This function is used for ray tracing.
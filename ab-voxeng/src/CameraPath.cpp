@@ -0,0 +1,179 @@
+#include "CameraPath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+/// <summary>
+/// Adds a keyframe to the end of the path.
+/// </summary>
+/// <param name="t_keyframe">The keyframe, its time has to be later than the last keyframe's.</param>
+/// <returns>True if the keyframe was added.</returns>
+bool ab::CameraPath::add(const Keyframe &t_keyframe)
+{
+	if (!m_keyframes.empty() && t_keyframe.time <= m_keyframes.back().time)
+	{
+		return false;
+	}
+
+	m_keyframes.push_back(t_keyframe);
+
+	return true;
+}
+
+/// <summary>
+/// Removes every keyframe.
+/// </summary>
+void ab::CameraPath::clear()
+{
+	m_keyframes.clear();
+}
+
+/// <summary>
+/// Loads a path from a text file, replacing the current keyframes.
+/// </summary>
+/// <param name="t_path">The file to read.</param>
+/// <returns>True if the file was read and every keyframe in it is valid (the path is left empty if not).</returns>
+bool ab::CameraPath::load(const std::string &t_path)
+{
+	std::ifstream f_file(t_path);
+	m_keyframes.clear();
+
+	if (!f_file)
+	{
+		return false;
+	}
+
+	std::string f_line;
+
+	while (std::getline(f_file, f_line))
+	{
+		std::size_t f_start = f_line.find_first_not_of(" \t\r");
+
+		if (f_start == std::string::npos || f_line[f_start] == '#')
+		{
+			continue;
+		}
+
+		std::istringstream f_stream(f_line);
+		Keyframe f_keyframe;
+
+		if (!(f_stream >> f_keyframe.time >> f_keyframe.eye.x >> f_keyframe.eye.y >> f_keyframe.eye.z >> f_keyframe.yaw >> f_keyframe.pitch) || !add(f_keyframe))
+		{
+			m_keyframes.clear();
+			return false;
+		}
+	}
+
+	return !m_keyframes.empty();
+}
+
+/// <summary>
+/// Saves the path as a text file.
+/// </summary>
+/// <param name="t_path">The file to write.</param>
+/// <returns>True if the file was written.</returns>
+bool ab::CameraPath::save(const std::string &t_path) const
+{
+	std::ofstream f_file(t_path);
+
+	if (!f_file)
+	{
+		return false;
+	}
+
+	f_file << "# time (ms), eye x, y, z, yaw, pitch (degrees)" << std::endl;
+	f_file << std::fixed << std::setprecision(4);
+
+	for (const Keyframe &f_keyframe : m_keyframes)
+	{
+		f_file << f_keyframe.time << " " << f_keyframe.eye.x << " " << f_keyframe.eye.y << " " << f_keyframe.eye.z << " " << f_keyframe.yaw << " " << f_keyframe.pitch << std::endl;
+	}
+
+	return (bool)f_file;
+}
+
+/// <summary>
+/// Gets where the camera is on the path at a time, interpolating between the keyframes either side.
+/// Yaw and pitch turn the shortest way round, so a camera that turned past 360 degrees doesn't spin back.
+/// </summary>
+/// <param name="t_time">The time in milliseconds, it's clamped to the start and end of the path.</param>
+/// <returns>The camera's position and direction (all zero if the path is empty).</returns>
+ab::CameraPath::Keyframe ab::CameraPath::sample(double t_time) const
+{
+	if (m_keyframes.empty())
+	{
+		return { 0.0, glm::vec3(0.0f), 0.0, 0.0 };
+	}
+
+	if (t_time <= m_keyframes.front().time)
+	{
+		return m_keyframes.front();
+	}
+
+	if (t_time >= m_keyframes.back().time)
+	{
+		return m_keyframes.back();
+	}
+
+	// The first keyframe after the time
+	auto f_next = std::upper_bound(m_keyframes.begin(), m_keyframes.end(), t_time, [](double t_value, const Keyframe &t_keyframe)
+	{
+		return t_value < t_keyframe.time;
+	});
+
+	const Keyframe &f_a = *(f_next - 1);
+	const Keyframe &f_b = *f_next;
+	double f_t = (t_time - f_a.time) / (f_b.time - f_a.time);
+
+	auto f_turn = [f_t](double t_from, double t_to)
+	{
+		double f_difference = std::fmod(std::fmod(t_to - t_from, 360.0) + 540.0, 360.0) - 180.0;
+		return t_from + f_difference * f_t;
+	};
+
+	return { t_time, glm::mix(f_a.eye, f_b.eye, (float)f_t), f_turn(f_a.yaw, f_b.yaw), f_turn(f_a.pitch, f_b.pitch) };
+}
+
+/// <summary>
+/// Gets the time of the last keyframe.
+/// </summary>
+/// <returns>The duration in milliseconds.</returns>
+double ab::CameraPath::getDuration() const
+{
+	return m_keyframes.empty() ? 0.0 : m_keyframes.back().time;
+}
+
+/// <summary>
+/// Gets whether the path has any keyframes.
+/// </summary>
+/// <returns>True if there are none.</returns>
+bool ab::CameraPath::isEmpty() const
+{
+	return m_keyframes.empty();
+}
+
+/// <summary>
+/// Gets the keyframes.
+/// </summary>
+/// <returns>The keyframes in time order.</returns>
+const std::vector<ab::CameraPath::Keyframe> &ab::CameraPath::getKeyframes() const
+{
+	return m_keyframes;
+}
+
+/// <summary>
+/// Gets the direction the camera faces for a yaw and pitch, the same direction that Camera::update() turns the camera to.
+/// </summary>
+/// <param name="t_yaw">The yaw in degrees.</param>
+/// <param name="t_pitch">The pitch in degrees.</param>
+/// <returns>The direction.</returns>
+glm::vec3 ab::CameraPath::getDirection(double t_yaw, double t_pitch)
+{
+	double f_yaw = glm::radians(t_yaw);
+	double f_pitch = glm::radians(t_pitch);
+
+	return glm::vec3(std::sin(f_yaw) * std::cos(f_pitch), std::sin(f_pitch), std::cos(f_yaw) * std::cos(f_pitch));
+}
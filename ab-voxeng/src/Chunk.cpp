@@ -0,0 +1,266 @@
+#include "Chunk.h"
+#include "ChunkPool.h"
+
+#include <cstring>
+
+/// <summary>
+/// Constructor for the Chunk class.
+/// The chunk starts off as a single palette entry (air) using 1 bit per voxel.
+/// </summary>
+Chunk::Chunk()
+{
+	int size = CHUNK_WIDTH * CHUNK_HEIGHT * CHUNK_DEPTH; // Array size
+
+	m_bitsPerIndex = 1;
+	m_indicesPerWordShift = 5;
+	m_indexMask = 1;
+	allocateBlock();
+
+	m_palette[0] = 0; // Initialise chunk with air
+	m_paletteCounts[0] = size;
+	m_paletteSize = 1;
+	m_solidCount = 0;
+}
+
+/// <summary>
+/// Destructor for the Chunk class.
+/// </summary>
+Chunk::~Chunk()
+{
+	ChunkPool::get().freeBlock(m_indices, m_bitsPerIndex);
+	m_indices = nullptr;
+	m_paletteCounts = nullptr;
+	m_palette = nullptr;
+}
+
+/// <summary>
+/// Checks the chunk to see if it's empty.
+/// </summary>
+/// <returns>True if the chunk is empty.</returns>
+bool Chunk::checkIsEmpty()
+{
+	return m_solidCount == 0;
+}
+
+/// <summary>
+/// Gets a voxel's type using its position within the chunk.
+/// </summary>
+/// <param name="x">The voxel's X position within the chunk.</param>
+/// <param name="y">The voxel's Y position within the chunk.</param>
+/// <param name="z">The voxel's Z position within the chunk.</param>
+/// <returns>The voxel type.</returns>
+char Chunk::getVoxel(int x, int y, int z) const
+{
+	return getVoxel(Utility::at(x, y, z, CHUNK_HEIGHT, CHUNK_DEPTH));
+}
+
+/// <summary>
+/// Gets a voxel's type using its 1D array index.
+/// </summary>
+/// <param name="t_index">The voxel's 1D array index.</param>
+/// <returns>The voxel type.</returns>
+char Chunk::getVoxel(int t_index) const
+{
+	return m_palette[readIndex(t_index)];
+}
+
+/// <summary>
+/// Sets a voxel to the specified type using its position within the chunk.
+/// </summary>
+/// <param name="x">The voxel's X position within the chunk.</param>
+/// <param name="y">The voxel's Y position within the chunk.</param>
+/// <param name="z">The voxel's Z position within the chunk.</param>
+/// <param name="type">The voxel type.</param>
+void Chunk::setVoxel(int x, int y, int z, char type)
+{
+	setVoxel(Utility::at(x, y, z, CHUNK_HEIGHT, CHUNK_DEPTH), type);
+}
+
+/// <summary>
+/// Sets a voxel to the specified type using its 1D array index.
+/// </summary>
+/// <param name="t_index">The voxel's 1D array index.</param>
+/// <param name="type">The voxel type.</param>
+void Chunk::setVoxel(int t_index, char type)
+{
+	unsigned int f_oldEntry = readIndex(t_index);
+	char f_oldType = m_palette[f_oldEntry];
+
+	if (f_oldType == type)
+	{
+		return; // Nothing to do
+	}
+
+	// Release the old entry first so that its slot can be reused
+	m_paletteCounts[f_oldEntry]--;
+
+	unsigned int f_newEntry = findOrAddPaletteEntry(type);
+	m_paletteCounts[f_newEntry]++;
+	writeIndex(t_index, f_newEntry);
+
+	// Keep track of how many voxels aren't air
+	if (f_oldType == 0)
+	{
+		m_solidCount++;
+	}
+	else if (type == 0)
+	{
+		m_solidCount--;
+	}
+}
+
+/// <summary>
+/// Gets the number of voxels in the chunk that aren't air.
+/// </summary>
+/// <returns>The number of solid voxels.</returns>
+int Chunk::getSolidCount() const
+{
+	return m_solidCount;
+}
+
+/// <summary>
+/// Gets the number of bits currently used to store each voxel.
+/// </summary>
+/// <returns>1, 2, 4 or 8.</returns>
+int Chunk::getBitsPerIndex() const
+{
+	return m_bitsPerIndex;
+}
+
+/// <summary>
+/// Gets the number of entries in the chunk's palette (including unused ones).
+/// </summary>
+/// <returns>The palette size.</returns>
+int Chunk::getPaletteSize() const
+{
+	return m_paletteSize;
+}
+
+/// <summary>
+/// Gets the number of bytes used by this chunk, including the chunk object itself.
+/// </summary>
+/// <returns>The memory usage in bytes.</returns>
+std::size_t Chunk::getMemoryUsage() const
+{
+	return sizeof(Chunk) + ChunkPool::getBlockSize(m_bitsPerIndex);
+}
+
+/// <summary>
+/// Reads a palette index from the packed index array.
+/// </summary>
+/// <param name="t_index">The voxel's 1D array index.</param>
+/// <returns>The palette index.</returns>
+unsigned int Chunk::readIndex(int t_index) const
+{
+	int f_word = t_index >> m_indicesPerWordShift;
+	int f_shift = (t_index & ((1 << m_indicesPerWordShift) - 1)) * m_bitsPerIndex;
+
+	return (m_indices[f_word] >> f_shift) & m_indexMask;
+}
+
+/// <summary>
+/// Writes a palette index into the packed index array.
+/// </summary>
+/// <param name="t_index">The voxel's 1D array index.</param>
+/// <param name="t_paletteIndex">The palette index to store.</param>
+void Chunk::writeIndex(int t_index, unsigned int t_paletteIndex)
+{
+	int f_word = t_index >> m_indicesPerWordShift;
+	int f_shift = (t_index & ((1 << m_indicesPerWordShift) - 1)) * m_bitsPerIndex;
+
+	m_indices[f_word] = (m_indices[f_word] & ~(m_indexMask << f_shift)) | (t_paletteIndex << f_shift);
+}
+
+/// <summary>
+/// Finds the palette entry for a voxel type.
+/// If the type isn't in the palette then an unused entry is recycled, and if
+/// there are no unused entries then a new one is added (widening the indices if needed).
+/// </summary>
+/// <param name="t_type">The voxel type.</param>
+/// <returns>The palette index for the voxel type.</returns>
+unsigned int Chunk::findOrAddPaletteEntry(char t_type)
+{
+	int f_unused = -1;
+
+	for (int i = 0; i < m_paletteSize; ++i)
+	{
+		if (m_palette[i] == t_type)
+		{
+			return i;
+		}
+
+		if (f_unused < 0 && m_paletteCounts[i] == 0)
+		{
+			f_unused = i;
+		}
+	}
+
+	// Recycle an entry that no voxel is using anymore
+	if (f_unused >= 0)
+	{
+		m_palette[f_unused] = t_type;
+		return f_unused;
+	}
+
+	// The palette is full for the current index width
+	if (m_paletteSize == 1 << m_bitsPerIndex)
+	{
+		widen();
+	}
+
+	m_palette[m_paletteSize] = t_type;
+	m_paletteCounts[m_paletteSize] = 0;
+
+	return m_paletteSize++;
+}
+
+/// <summary>
+/// Allocates a cleared block from the pool for the current index width and points
+/// the index array and palette at it.
+/// The layout is [packed indices][palette counts][palette types].
+/// </summary>
+void Chunk::allocateBlock()
+{
+	int size = CHUNK_WIDTH * CHUNK_HEIGHT * CHUNK_DEPTH;
+	int f_paletteCapacity = 1 << m_bitsPerIndex;
+
+	m_indices = ChunkPool::get().allocateBlock(m_bitsPerIndex);
+	std::memset(m_indices, 0, ChunkPool::getBlockSize(m_bitsPerIndex));
+
+	m_paletteCounts = reinterpret_cast<unsigned short*>(m_indices + (size >> m_indicesPerWordShift));
+	m_palette = reinterpret_cast<char*>(m_paletteCounts + f_paletteCapacity);
+}
+
+/// <summary>
+/// Doubles the number of bits used for each palette index and repacks the chunk
+/// into a block of the next size up.
+/// </summary>
+void Chunk::widen()
+{
+	int size = CHUNK_WIDTH * CHUNK_HEIGHT * CHUNK_DEPTH;
+
+	uint32_t *f_oldIndices = m_indices;
+	unsigned short *f_oldCounts = m_paletteCounts;
+	char *f_oldPalette = m_palette;
+	int f_oldBitsPerIndex = m_bitsPerIndex;
+	int f_oldShift = m_indicesPerWordShift;
+	uint32_t f_oldMask = m_indexMask;
+
+	m_bitsPerIndex *= 2;
+	m_indicesPerWordShift -= 1;
+	m_indexMask = (1u << m_bitsPerIndex) - 1;
+	allocateBlock();
+
+	std::memcpy(m_paletteCounts, f_oldCounts, m_paletteSize * sizeof(unsigned short));
+	std::memcpy(m_palette, f_oldPalette, m_paletteSize * sizeof(char));
+
+	for (int i = 0; i < size; ++i)
+	{
+		int f_word = i >> f_oldShift;
+		int f_shift = (i & ((1 << f_oldShift) - 1)) * f_oldBitsPerIndex;
+
+		writeIndex(i, (f_oldIndices[f_word] >> f_shift) & f_oldMask);
+	}
+
+	ChunkPool::get().freeBlock(f_oldIndices, f_oldBitsPerIndex);
+}
@@ -0,0 +1,417 @@
+#include "ChunkIO.h"
+#include "Profiler.h"
+#include "World.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+/// <summary>
+/// Constructor for the LatencyHistogram class.
+/// </summary>
+ChunkIO::LatencyHistogram::LatencyHistogram() :
+	m_count(0),
+	m_total(0.0),
+	m_max(0.0)
+{
+	std::fill(m_counts, m_counts + BUCKETS, 0);
+}
+
+/// <summary>
+/// Adds a latency to the histogram.
+/// </summary>
+/// <param name="t_microseconds">The latency in microseconds.</param>
+void ChunkIO::LatencyHistogram::add(double t_microseconds)
+{
+	int f_bucket = t_microseconds < 1.0 ? 0 : (int)std::log2(t_microseconds) + 1;
+	m_counts[std::min(f_bucket, BUCKETS - 1)]++;
+	m_count++;
+	m_total += t_microseconds;
+	m_max = std::max(m_max, t_microseconds);
+}
+
+/// <summary>
+/// Gets a percentile of the latencies, to the nearest bucket.
+/// </summary>
+/// <param name="t_percentile">The percentile (0 to 100).</param>
+/// <returns>The top of the bucket that the percentile falls in (or the highest latency if that's lower), in microseconds.</returns>
+double ChunkIO::LatencyHistogram::getPercentile(double t_percentile) const
+{
+	if (m_count == 0)
+	{
+		return 0.0;
+	}
+
+	double f_target = std::max(t_percentile / 100.0 * m_count, 1.0);
+	long long f_total = 0;
+
+	for (int i = 0; i < BUCKETS; ++i)
+	{
+		f_total += m_counts[i];
+
+		if (f_total >= f_target)
+		{
+			return std::min(std::ldexp(1.0, i), m_max);
+		}
+	}
+
+	return m_max;
+}
+
+/// <summary>
+/// Gets the mean latency.
+/// </summary>
+/// <returns>The mean in microseconds.</returns>
+double ChunkIO::LatencyHistogram::getMean() const
+{
+	return m_count > 0 ? m_total / m_count : 0.0;
+}
+
+/// <summary>
+/// Gets the highest latency.
+/// </summary>
+/// <returns>The highest latency in microseconds.</returns>
+double ChunkIO::LatencyHistogram::getMax() const
+{
+	return m_max;
+}
+
+/// <summary>
+/// Gets the number of latencies added.
+/// </summary>
+/// <returns>The count.</returns>
+long long ChunkIO::LatencyHistogram::getCount() const
+{
+	return m_count;
+}
+
+/// <summary>
+/// Gets the number of latencies in a bucket.
+/// </summary>
+/// <param name="t_bucket">The bucket, latencies under 2^t_bucket microseconds.</param>
+/// <returns>The count.</returns>
+long long ChunkIO::LatencyHistogram::getBucket(int t_bucket) const
+{
+	return m_counts[t_bucket];
+}
+
+/// <summary>
+/// Constructor for the ChunkIO class. Starts the I/O thread.
+/// </summary>
+/// <param name="t_regions">The saved columns.</param>
+/// <param name="t_jobs">The job system that runs the callbacks on the main thread.</param>
+ChunkIO::ChunkIO(RegionStore &t_regions, ab::JobSystem &t_jobs) :
+	m_regions(t_regions),
+	m_jobs(t_jobs),
+	m_flushRequested(false),
+	m_busy(false),
+	m_stopping(false),
+	m_stats()
+{
+	m_thread = std::thread(&ChunkIO::ioLoop, this);
+}
+
+/// <summary>
+/// Destructor for the ChunkIO class.
+/// Writes every saved column to disk and stops the I/O thread. Call finish() first if any callbacks still need to run.
+/// </summary>
+ChunkIO::~ChunkIO()
+{
+	{
+		std::lock_guard<std::mutex> f_lock(m_mutex);
+		m_stopping = true;
+	}
+
+	m_wake.notify_one();
+	m_thread.join();
+}
+
+/// <summary>
+/// Asks for a saved column to be read.
+/// </summary>
+/// <param name="t_columnX">The X position of the column (in chunks).</param>
+/// <param name="t_columnZ">The Z position of the column (in chunks).</param>
+/// <param name="t_callback">Run on the main thread with the column (its found flag is false if it hasn't been saved).</param>
+void ChunkIO::readColumn(int t_columnX, int t_columnZ, const ReadCallback &t_callback)
+{
+	{
+		std::lock_guard<std::mutex> f_lock(m_mutex);
+		m_reads.push_back({ t_columnX, t_columnZ, t_callback, Clock::now() });
+		m_stats.readRequests++;
+	}
+
+	m_wake.notify_one();
+}
+
+/// <summary>
+/// Saves a column of the world. Its voxels are copied now, and the I/O thread compresses them and writes them to the region file later.
+/// Call this from the main thread.
+/// </summary>
+/// <param name="t_columnX">The X position of the column (in chunks).</param>
+/// <param name="t_columnZ">The Z position of the column (in chunks).</param>
+/// <param name="t_world">The world to save the column from.</param>
+void ChunkIO::writeColumn(int t_columnX, int t_columnZ, const World &t_world)
+{
+	WriteRequest f_request = { t_columnX, t_columnZ, ColumnData() };
+	f_request.column.voxels.resize(ab::RegionFile::COLUMN_CHUNKS * ab::RegionFile::CHUNK_VOXELS);
+	t_world.copyColumn(t_columnX, t_columnZ, f_request.column.voxels.data(), f_request.column.used);
+	queueWrite(f_request);
+}
+
+/// <summary>
+/// Saves a column's voxels (e.g. one that has just been generated). They're copied now, and the I/O thread compresses them
+/// and writes them to the region file later.
+/// </summary>
+/// <param name="t_columnX">The X position of the column (in chunks).</param>
+/// <param name="t_columnZ">The Z position of the column (in chunks).</param>
+/// <param name="t_voxels">The column's voxels, in the same layout as Terrain::generateColumn().</param>
+/// <param name="t_used">Whether each chunk has anything other than air in it.</param>
+void ChunkIO::writeColumn(int t_columnX, int t_columnZ, const char *t_voxels, const bool *t_used)
+{
+	WriteRequest f_request = { t_columnX, t_columnZ, ColumnData() };
+	f_request.column.voxels.assign(t_voxels, t_voxels + ab::RegionFile::COLUMN_CHUNKS * ab::RegionFile::CHUNK_VOXELS);
+	std::copy(t_used, t_used + ab::RegionFile::COLUMN_CHUNKS, f_request.column.used);
+	queueWrite(f_request);
+}
+
+/// <summary>
+/// Asks for every saved column to be written to disk now, rather than waiting.
+/// </summary>
+void ChunkIO::flush()
+{
+	{
+		std::lock_guard<std::mutex> f_lock(m_mutex);
+		m_flushRequested = true;
+	}
+
+	m_wake.notify_one();
+}
+
+/// <summary>
+/// Waits until every read that has been asked for is done and its callback has run, and any flush that has been asked for is done.
+/// Call this from the main thread.
+/// </summary>
+void ChunkIO::finish()
+{
+	std::vector<ab::JobSystem::JobHandle> f_callbacks;
+
+	{
+		std::unique_lock<std::mutex> f_lock(m_mutex);
+		m_idle.wait(f_lock, [this]() { return !m_busy && m_reads.empty() && m_writes.empty() && !m_flushRequested; });
+		f_callbacks.swap(m_callbacks);
+	}
+
+	m_jobs.wait(f_callbacks);
+}
+
+/// <summary>
+/// Gets the I/O stats, including latency histograms.
+/// </summary>
+/// <returns>The stats.</returns>
+ChunkIO::Stats ChunkIO::getStats() const
+{
+	std::lock_guard<std::mutex> f_lock(m_mutex);
+	Stats f_stats = m_stats;
+	f_stats.queuedReads = (int)m_reads.size();
+	f_stats.pendingWrites = (int)m_unflushed.size();
+
+	return f_stats;
+}
+
+/// <summary>
+/// Queues a saved column for the I/O thread.
+/// </summary>
+/// <param name="t_request">The column, its voxels are moved into the queue.</param>
+void ChunkIO::queueWrite(WriteRequest &t_request)
+{
+	{
+		std::lock_guard<std::mutex> f_lock(m_mutex);
+		m_writes.push_back(std::move(t_request));
+		m_unflushed.push_back(Clock::now());
+	}
+
+	m_wake.notify_one();
+}
+
+/// <summary>
+/// The I/O thread. Sleeps until there are reads to do, or writes to compress or flush.
+/// </summary>
+void ChunkIO::ioLoop()
+{
+	PROFILE_THREAD("Chunk I/O");
+	const Clock::duration WRITE_DELAY = std::chrono::milliseconds(CHUNK_IO_WRITE_DELAY_MS);
+	std::unique_lock<std::mutex> f_lock(m_mutex);
+
+	while (true)
+	{
+		auto f_ready = [this]()
+		{
+			return m_stopping || !m_reads.empty() || !m_writes.empty() || m_flushRequested || (int)m_unflushed.size() >= REGION_FLUSH_COLUMNS;
+		};
+
+		// Wake up in time to flush the oldest write
+		if (m_unflushed.empty())
+		{
+			m_wake.wait(f_lock, f_ready);
+		}
+		else
+		{
+			m_wake.wait_until(f_lock, m_unflushed.front() + WRITE_DELAY, f_ready);
+		}
+
+		// Writes are taken together with the reads, so they're stored before any read that was asked for after them
+		std::vector<ReadRequest> f_reads;
+		std::vector<WriteRequest> f_writes;
+		std::vector<Clock::time_point> f_saved;
+		f_reads.swap(m_reads);
+		f_writes.swap(m_writes);
+		bool f_flush = m_flushRequested || m_stopping || (int)m_unflushed.size() >= REGION_FLUSH_COLUMNS ||
+			(!m_unflushed.empty() && Clock::now() >= m_unflushed.front() + WRITE_DELAY);
+
+		if (f_flush)
+		{
+			f_saved.swap(m_unflushed);
+		}
+
+		m_flushRequested = false;
+		m_busy = true;
+		f_lock.unlock();
+
+		if (!f_writes.empty())
+		{
+			store(f_writes);
+		}
+
+		if (!f_reads.empty())
+		{
+			read(f_reads);
+		}
+
+		if (f_flush)
+		{
+			write(f_saved);
+		}
+
+		f_lock.lock();
+		m_busy = false;
+
+		if (m_reads.empty() && m_writes.empty() && !m_flushRequested)
+		{
+			m_idle.notify_all();
+		}
+
+		// Stopping always flushes, so there's nothing left to write
+		if (m_stopping && m_reads.empty() && m_writes.empty())
+		{
+			break;
+		}
+	}
+}
+
+/// <summary>
+/// Compresses saved columns on the I/O thread and hands them to the RegionStore, where they wait to be flushed.
+/// </summary>
+/// <param name="t_requests">The saved columns.</param>
+void ChunkIO::store(std::vector<WriteRequest> &t_requests)
+{
+	PROFILE_SCOPE("ChunkIO::store");
+
+	for (const WriteRequest &f_request : t_requests)
+	{
+		m_regions.writeColumn(f_request.x, f_request.z, f_request.column.voxels.data(), f_request.column.used);
+	}
+}
+
+/// <summary>
+/// Reads a batch of columns on the I/O thread, and queues their callbacks for the main thread.
+/// </summary>
+/// <param name="t_requests">The read requests.</param>
+void ChunkIO::read(std::vector<ReadRequest> &t_requests)
+{
+	PROFILE_SCOPE("ChunkIO::read");
+	PROFILE_COUNTER("Column reads per batch", t_requests.size());
+
+	// Requests for the same column share one read
+	std::unordered_map<Indices, std::size_t, IndicesHash> f_indices;
+	std::vector<RegionStore::ColumnRead> f_reads;
+	std::vector<std::shared_ptr<ColumnData>> f_columns;
+	std::vector<std::size_t> f_requestColumns(t_requests.size());
+
+	for (std::size_t i = 0; i < t_requests.size(); ++i)
+	{
+		Indices f_position = { t_requests[i].x, 0, t_requests[i].z };
+		auto f_found = f_indices.find(f_position);
+
+		if (f_found == f_indices.end())
+		{
+			std::shared_ptr<ColumnData> f_column = std::make_shared<ColumnData>();
+			f_column->voxels.resize(ab::RegionFile::COLUMN_CHUNKS * ab::RegionFile::CHUNK_VOXELS);
+			f_found = f_indices.insert({ f_position, f_columns.size() }).first;
+			f_reads.push_back({ f_position.x, f_position.z, f_column->voxels.data(), f_column->used, false });
+			f_columns.push_back(f_column);
+		}
+
+		f_requestColumns[i] = f_found->second;
+	}
+
+	m_regions.readColumns(f_reads);
+
+	for (std::size_t i = 0; i < f_columns.size(); ++i)
+	{
+		f_columns[i]->found = f_reads[i].found;
+
+		if (!f_reads[i].found)
+		{
+			std::vector<char>().swap(f_columns[i]->voxels);
+		}
+	}
+
+	Clock::time_point f_now = Clock::now();
+	std::lock_guard<std::mutex> f_lock(m_mutex);
+	m_stats.columnsRead += (long long)f_columns.size();
+	m_stats.readBatches++;
+
+	m_callbacks.erase(std::remove_if(m_callbacks.begin(), m_callbacks.end(), [this](const ab::JobSystem::JobHandle &t_job)
+	{
+		return m_jobs.isFinished(t_job);
+	}), m_callbacks.end());
+
+	for (std::size_t i = 0; i < t_requests.size(); ++i)
+	{
+		ReadCallback f_callback = t_requests[i].callback;
+		std::shared_ptr<ColumnData> f_column = f_columns[f_requestColumns[i]];
+
+		m_stats.reads.add(std::chrono::duration<double, std::micro>(f_now - t_requests[i].submitted).count());
+		m_callbacks.push_back(m_jobs.addMainThread([f_callback, f_column]()
+		{
+			f_callback(f_column);
+		}));
+	}
+}
+
+/// <summary>
+/// Flushes the saved columns to their region files on the I/O thread.
+/// </summary>
+/// <param name="t_saved">When each of the columns being flushed was saved.</param>
+void ChunkIO::write(const std::vector<Clock::time_point> &t_saved)
+{
+	PROFILE_SCOPE("ChunkIO::write");
+	Clock::time_point f_start = Clock::now();
+	bool f_flushed = m_regions.flush();
+	Clock::time_point f_end = Clock::now();
+
+	std::lock_guard<std::mutex> f_lock(m_mutex);
+	m_stats.flushes.add(std::chrono::duration<double, std::micro>(f_end - f_start).count());
+
+	if (!f_flushed)
+	{
+		// Try again after another delay
+		m_unflushed.insert(m_unflushed.begin(), t_saved.size(), f_end);
+		return;
+	}
+
+	for (const Clock::time_point &f_written : t_saved)
+	{
+		m_stats.writes.add(std::chrono::duration<double, std::micro>(f_end - f_written).count());
+	}
+}
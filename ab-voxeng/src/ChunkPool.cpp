@@ -0,0 +1,277 @@
+#include "ChunkPool.h"
+#include "Chunk.h"
+
+#include <new>
+
+namespace
+{
+	const std::size_t CHUNKS_PER_SLAB = 256;
+	const std::size_t BLOCKS_PER_SLAB = 64;
+
+	/// <summary>
+	/// Rounds a size up so that every block in a slab stays suitably aligned.
+	/// </summary>
+	std::size_t alignSize(std::size_t t_size)
+	{
+		const std::size_t f_alignment = alignof(std::max_align_t);
+		return (t_size + f_alignment - 1) & ~(f_alignment - 1);
+	}
+}
+
+/// <summary>
+/// Gets the pool used by all chunks.
+/// </summary>
+/// <returns>The chunk pool.</returns>
+ChunkPool &ChunkPool::get()
+{
+	static ChunkPool s_pool;
+	return s_pool;
+}
+
+/// <summary>
+/// Constructor for the ChunkPool class.
+/// </summary>
+ChunkPool::ChunkPool() : m_chunks(sizeof(Chunk), CHUNKS_PER_SLAB)
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		m_blocks[i] = new FixedPool(getBlockSize(1 << i), BLOCKS_PER_SLAB);
+	}
+}
+
+/// <summary>
+/// Destructor for the ChunkPool class.
+/// </summary>
+ChunkPool::~ChunkPool()
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		delete m_blocks[i];
+		m_blocks[i] = nullptr;
+	}
+}
+
+/// <summary>
+/// Creates a new (empty) chunk using memory from the pool.
+/// </summary>
+/// <returns>The new chunk.</returns>
+Chunk *ChunkPool::createChunk()
+{
+	void *f_memory;
+
+	{
+		std::lock_guard<std::mutex> f_lock(m_mutex);
+		f_memory = m_chunks.allocate();
+	}
+
+	// The chunk constructor allocates its voxel block from the pool, so construct outside the lock
+	return new (f_memory) Chunk();
+}
+
+/// <summary>
+/// Destroys a chunk that was created with createChunk() and returns its memory to the pool.
+/// </summary>
+/// <param name="t_chunk">The chunk to destroy.</param>
+void ChunkPool::destroyChunk(Chunk *t_chunk)
+{
+	if (t_chunk == nullptr)
+	{
+		return;
+	}
+
+	t_chunk->~Chunk();
+
+	std::lock_guard<std::mutex> f_lock(m_mutex);
+	m_chunks.free(t_chunk);
+}
+
+/// <summary>
+/// Allocates a block big enough to hold the packed indices and palette of a whole chunk.
+/// </summary>
+/// <param name="t_bitsPerIndex">The index width (1, 2, 4 or 8).</param>
+/// <returns>The block (its contents are undefined).</returns>
+uint32_t *ChunkPool::allocateBlock(int t_bitsPerIndex)
+{
+	std::lock_guard<std::mutex> f_lock(m_mutex);
+	return static_cast<uint32_t*>(m_blocks[getSizeClass(t_bitsPerIndex)]->allocate());
+}
+
+/// <summary>
+/// Returns a block to the pool.
+/// </summary>
+/// <param name="t_block">The block to free.</param>
+/// <param name="t_bitsPerIndex">The index width the block was allocated with.</param>
+void ChunkPool::freeBlock(uint32_t *t_block, int t_bitsPerIndex)
+{
+	if (t_block == nullptr)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> f_lock(m_mutex);
+	m_blocks[getSizeClass(t_bitsPerIndex)]->free(t_block);
+}
+
+/// <summary>
+/// Gets the allocation statistics for chunk objects.
+/// </summary>
+/// <returns>The statistics.</returns>
+ChunkPool::Stats ChunkPool::getChunkStats() const
+{
+	std::lock_guard<std::mutex> f_lock(m_mutex);
+	return m_chunks.stats;
+}
+
+/// <summary>
+/// Gets the allocation statistics for one size of voxel block.
+/// </summary>
+/// <param name="t_bitsPerIndex">The index width (1, 2, 4 or 8).</param>
+/// <returns>The statistics.</returns>
+ChunkPool::Stats ChunkPool::getBlockStats(int t_bitsPerIndex) const
+{
+	std::lock_guard<std::mutex> f_lock(m_mutex);
+	return m_blocks[getSizeClass(t_bitsPerIndex)]->stats;
+}
+
+/// <summary>
+/// Gets the allocation statistics for chunk objects and all voxel blocks added together.
+/// The peak value is the sum of the individual peaks.
+/// </summary>
+/// <returns>The statistics.</returns>
+ChunkPool::Stats ChunkPool::getTotalStats() const
+{
+	std::lock_guard<std::mutex> f_lock(m_mutex);
+
+	Stats f_total = m_chunks.stats;
+
+	for (int i = 0; i < 4; ++i)
+	{
+		const Stats &f_stats = m_blocks[i]->stats;
+		f_total.live += f_stats.live;
+		f_total.peak += f_stats.peak;
+		f_total.allocations += f_stats.allocations;
+		f_total.recycled += f_stats.recycled;
+		f_total.slabs += f_stats.slabs;
+		f_total.reservedBytes += f_stats.reservedBytes;
+	}
+
+	return f_total;
+}
+
+/// <summary>
+/// Gets the size of a voxel block in bytes.
+/// A block holds the packed indices followed by a palette with room for 2^bits entries
+/// (a 16-bit count and a voxel type for each).
+/// </summary>
+/// <param name="t_bitsPerIndex">The index width (1, 2, 4 or 8).</param>
+/// <returns>The block size in bytes.</returns>
+std::size_t ChunkPool::getBlockSize(int t_bitsPerIndex)
+{
+	std::size_t f_indexBytes = (std::size_t)CHUNK_WIDTH * CHUNK_HEIGHT * CHUNK_DEPTH * t_bitsPerIndex / 8;
+	std::size_t f_paletteBytes = ((std::size_t)1 << t_bitsPerIndex) * (sizeof(unsigned short) + sizeof(char));
+
+	return alignSize(f_indexBytes + f_paletteBytes);
+}
+
+/// <summary>
+/// Converts an index width into a size class.
+/// </summary>
+/// <param name="t_bitsPerIndex">The index width (1, 2, 4 or 8).</param>
+/// <returns>0, 1, 2 or 3.</returns>
+int ChunkPool::getSizeClass(int t_bitsPerIndex)
+{
+	switch (t_bitsPerIndex)
+	{
+	case 1: return 0;
+	case 2: return 1;
+	case 4: return 2;
+	default: return 3;
+	}
+}
+
+/// <summary>
+/// Constructor for the FixedPool class.
+/// </summary>
+/// <param name="t_blockSize">The size of each block in bytes.</param>
+/// <param name="t_blocksPerSlab">How many blocks are allocated at a time.</param>
+ChunkPool::FixedPool::FixedPool(std::size_t t_blockSize, std::size_t t_blocksPerSlab)
+{
+	m_blockSize = alignSize(t_blockSize < sizeof(FreeBlock) ? sizeof(FreeBlock) : t_blockSize);
+	m_blocksPerSlab = t_blocksPerSlab;
+	m_freeList = nullptr;
+	m_slabUsed = t_blocksPerSlab; // Forces a slab to be added on the first allocation
+}
+
+/// <summary>
+/// Destructor for the FixedPool class.
+/// </summary>
+ChunkPool::FixedPool::~FixedPool()
+{
+	for (char *f_slab : m_slabs)
+	{
+		::operator delete(f_slab);
+	}
+
+	m_slabs.clear();
+}
+
+/// <summary>
+/// Allocates a block, reusing a freed block if there is one.
+/// </summary>
+/// <returns>The block.</returns>
+void *ChunkPool::FixedPool::allocate()
+{
+	void *f_block;
+
+	if (m_freeList != nullptr)
+	{
+		f_block = m_freeList;
+		m_freeList = m_freeList->next;
+		stats.recycled++;
+	}
+	else
+	{
+		if (m_slabUsed == m_blocksPerSlab)
+		{
+			addSlab();
+		}
+
+		f_block = m_slabs.back() + m_slabUsed * m_blockSize;
+		m_slabUsed++;
+	}
+
+	stats.allocations++;
+	stats.live++;
+
+	if (stats.live > stats.peak)
+	{
+		stats.peak = stats.live;
+	}
+
+	return f_block;
+}
+
+/// <summary>
+/// Puts a block on the free list so it can be reused.
+/// </summary>
+/// <param name="t_block">The block to free.</param>
+void ChunkPool::FixedPool::free(void *t_block)
+{
+	FreeBlock *f_block = static_cast<FreeBlock*>(t_block);
+	f_block->next = m_freeList;
+	m_freeList = f_block;
+
+	stats.live--;
+}
+
+/// <summary>
+/// Allocates a new slab.
+/// </summary>
+void ChunkPool::FixedPool::addSlab()
+{
+	m_slabs.push_back(static_cast<char*>(::operator new(m_blockSize * m_blocksPerSlab)));
+	m_slabUsed = 0;
+
+	stats.slabs++;
+	stats.reservedBytes += m_blockSize * m_blocksPerSlab;
+}
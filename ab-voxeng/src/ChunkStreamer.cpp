@@ -0,0 +1,511 @@
+#include "ChunkStreamer.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+namespace
+{
+	// The voxels of a column, filled in by a worker
+	struct GeneratedColumn
+	{
+		std::vector<char> voxels;
+		bool used[ab::Terrain::COLUMN_CHUNKS];
+	};
+}
+
+/// <summary>
+/// Constructor for the ChunkStreamer class.
+/// Nothing is loaded until the first update().
+/// </summary>
+/// <param name="t_world">The world that columns are loaded into.</param>
+/// <param name="t_terrain">The terrain that generates the columns.</param>
+/// <param name="t_jobs">The job system that columns are generated on.</param>
+ChunkStreamer::ChunkStreamer(World &t_world, const ab::Terrain &t_terrain, ab::JobSystem &t_jobs) :
+	m_world(t_world),
+	m_terrain(t_terrain),
+	m_jobs(t_jobs),
+	m_io(nullptr),
+	m_cache(nullptr),
+	m_eye(0.0f),
+	m_forward(0.0f),
+	m_loadRadius(STREAM_LOAD_RADIUS),
+	m_memoryBytes(0),
+	m_loading(0),
+	m_loaded(0),
+	m_unloaded(0)
+{
+	setMemoryBudget(STREAM_MEMORY_BUDGET_MB);
+}
+
+/// <summary>
+/// Destructor for the ChunkStreamer class.
+/// Waits for the columns that are still being read or generated, their jobs use this object.
+/// </summary>
+ChunkStreamer::~ChunkStreamer()
+{
+	finish();
+}
+
+/// <summary>
+/// Unloads the columns that are out of range and starts generating the most important columns that are missing.
+/// Call this once a frame from the main thread, before JobSystem::pump().
+/// </summary>
+/// <param name="t_eye">The camera position.</param>
+/// <param name="t_direction">The direction the camera is facing.</param>
+void ChunkStreamer::update(const glm::vec3 &t_eye, const glm::vec3 &t_direction)
+{
+	PROFILE_SCOPE("ChunkStreamer::update");
+	m_eye = t_eye;
+	glm::vec2 f_forward(t_direction.x, t_direction.z);
+	m_forward = glm::length(f_forward) > 0.0001f ? glm::normalize(f_forward) : glm::vec2(0.0f);
+
+	// Forget the jobs that have already written their columns
+	m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(), [this](const ab::JobSystem::JobHandle &t_job)
+	{
+		return m_jobs.isFinished(t_job);
+	}), m_pending.end());
+
+	// Unload columns past the unload radius (columns still being generated are dropped when they finish)
+	float f_unloadDistance = (float)((m_loadRadius + STREAM_UNLOAD_MARGIN) * CHUNK_WIDTH);
+	m_candidates.clear();
+
+	for (const auto &f_pair : m_columns)
+	{
+		if (!f_pair.second.loading && getColumnDistance(f_pair.first.x, f_pair.first.z) > f_unloadDistance)
+		{
+			m_candidates.push_back(f_pair.first);
+		}
+	}
+
+	for (const Indices &f_column : m_candidates)
+	{
+		unloadColumn(f_column);
+	}
+
+	// The columns within the load radius that aren't loaded, most important first
+	int f_cameraX = (int)std::floor(m_eye.x / CHUNK_WIDTH);
+	int f_cameraZ = (int)std::floor(m_eye.z / CHUNK_DEPTH);
+	float f_loadDistance = (float)(m_loadRadius * CHUNK_WIDTH);
+	m_candidates.clear();
+
+	for (int x = f_cameraX - m_loadRadius; x <= f_cameraX + m_loadRadius; ++x)
+	{
+		for (int z = f_cameraZ - m_loadRadius; z <= f_cameraZ + m_loadRadius; ++z)
+		{
+			Indices f_column = { x, 0, z };
+
+			if (getColumnDistance(x, z) <= f_loadDistance && m_columns.find(f_column) == m_columns.end())
+			{
+				m_candidates.push_back(f_column);
+			}
+		}
+	}
+
+	std::sort(m_candidates.begin(), m_candidates.end(), [this](const Indices &a, const Indices &b)
+	{
+		return getColumnPriority(a.x, a.z) < getColumnPriority(b.x, b.z);
+	});
+
+	// Keep every worker busy, with a few columns waiting so they never run dry
+	int f_maxLoading = std::max(2 * m_jobs.getWorkerCount(), 2);
+
+	for (const Indices &f_column : m_candidates)
+	{
+		if (m_loading >= f_maxLoading)
+		{
+			break;
+		}
+
+		// Over the budget, a less important column has to go to make room
+		if (m_memoryBytes >= m_memoryBudget && !unloadLowestPriority(getColumnPriority(f_column.x, f_column.z)))
+		{
+			break;
+		}
+
+		requestColumn(f_column);
+	}
+
+	// With no workers nothing else would run the jobs (columns being read are left to the I/O thread)
+	if (m_jobs.getWorkerCount() == 0)
+	{
+		waitForPending();
+	}
+}
+
+/// <summary>
+/// Waits for every column that's being read or generated and writes them into the world.
+/// </summary>
+void ChunkStreamer::finish()
+{
+	// Columns that haven't been saved are looked for in the cache, and then generated, so wait for the reads first
+	if (m_io != nullptr)
+	{
+		m_io->finish();
+	}
+
+	if (m_cache != nullptr)
+	{
+		m_cache->finish();
+	}
+
+	waitForPending();
+}
+
+/// <summary>
+/// Waits for the jobs in m_pending. Read callbacks can start more columns generating while this waits, so it waits for those too.
+/// </summary>
+void ChunkStreamer::waitForPending()
+{
+	std::vector<ab::JobSystem::JobHandle> f_jobs;
+
+	while (!m_pending.empty())
+	{
+		f_jobs.swap(m_pending);
+		m_jobs.wait(f_jobs);
+		f_jobs.clear();
+	}
+}
+
+/// <summary>
+/// Saves every loaded column that has been edited. They're written to the region files by the I/O thread, ChunkIO::finish() waits for that.
+/// </summary>
+void ChunkStreamer::save()
+{
+	if (m_io == nullptr)
+	{
+		return;
+	}
+
+	for (const auto &f_pair : m_columns)
+	{
+		if (!f_pair.second.loading && m_world.isColumnModified(f_pair.first.x, f_pair.first.z))
+		{
+			m_io->writeColumn(f_pair.first.x, f_pair.first.z, m_world);
+			m_world.clearColumnModified(f_pair.first.x, f_pair.first.z);
+		}
+	}
+
+	m_io->flush();
+}
+
+/// <summary>
+/// Sets where columns are saved to and loaded from.
+/// </summary>
+/// <param name="t_io">The saved columns, or nullptr to always generate columns and not save them.</param>
+void ChunkStreamer::setChunkIO(ChunkIO *t_io)
+{
+	m_io = t_io;
+}
+
+/// <summary>
+/// Sets where generated columns are cached. Columns that haven't been saved are read from the cache
+/// instead of being generated, and columns that do get generated are added to it.
+/// </summary>
+/// <param name="t_cache">The cached columns for this streamer's terrain (see Terrain::getCacheDirectory()), or nullptr to not cache them.</param>
+void ChunkStreamer::setGeneratedCache(ChunkIO *t_cache)
+{
+	m_cache = t_cache;
+}
+
+/// <summary>
+/// Gets the priority of a chunk, lower values are more important.
+/// This is the distance from the camera, but chunks behind the camera count as up to twice as far away.
+/// </summary>
+/// <param name="t_chunkPosition">The chunk position.</param>
+/// <returns>The priority.</returns>
+float ChunkStreamer::getPriority(const Indices &t_chunkPosition) const
+{
+	glm::vec3 f_centre((t_chunkPosition.x + 0.5f) * CHUNK_WIDTH, (t_chunkPosition.y + 0.5f) * CHUNK_HEIGHT, (t_chunkPosition.z + 0.5f) * CHUNK_DEPTH);
+	glm::vec3 f_offset = f_centre - m_eye;
+	float f_distance = glm::length(f_offset);
+	glm::vec2 f_ground(f_offset.x, f_offset.z);
+
+	// 1 straight ahead, -1 straight behind
+	float f_facing = glm::length(f_ground) > 0.0001f ? glm::dot(glm::normalize(f_ground), m_forward) : 1.0f;
+
+	return f_distance * (1.5f - 0.5f * f_facing);
+}
+
+/// <summary>
+/// Gets the priority of a column, the priority of its chunk at the camera's height.
+/// </summary>
+/// <param name="t_columnX">The X position of the column (in chunks).</param>
+/// <param name="t_columnZ">The Z position of the column (in chunks).</param>
+/// <returns>The priority.</returns>
+float ChunkStreamer::getColumnPriority(int t_columnX, int t_columnZ) const
+{
+	return getPriority({ t_columnX, (int)std::floor(m_eye.y / CHUNK_HEIGHT), t_columnZ });
+}
+
+/// <summary>
+/// Gets the distance along the ground from the camera to the centre of a column.
+/// </summary>
+/// <param name="t_columnX">The X position of the column (in chunks).</param>
+/// <param name="t_columnZ">The Z position of the column (in chunks).</param>
+/// <returns>The distance in voxels.</returns>
+float ChunkStreamer::getColumnDistance(int t_columnX, int t_columnZ) const
+{
+	return glm::length(glm::vec2((t_columnX + 0.5f) * CHUNK_WIDTH - m_eye.x, (t_columnZ + 0.5f) * CHUNK_DEPTH - m_eye.z));
+}
+
+/// <summary>
+/// Starts loading a column. Saved columns are read by the I/O thread, the rest are generated (see generateColumn()).
+/// </summary>
+/// <param name="t_column">The column position (y is ignored).</param>
+void ChunkStreamer::requestColumn(const Indices &t_column)
+{
+	Indices f_column = { t_column.x, 0, t_column.z };
+	m_columns[f_column] = { true, 0, std::chrono::steady_clock::now() };
+	m_loading++;
+
+	if (m_io == nullptr)
+	{
+		loadGenerated(f_column);
+		return;
+	}
+
+	m_io->readColumn(f_column.x, f_column.z, [this, f_column](const std::shared_ptr<ChunkIO::ColumnData> &t_column)
+	{
+		if (t_column->found)
+		{
+			applyColumn(f_column, t_column->voxels, t_column->used);
+		}
+		else
+		{
+			loadGenerated(f_column);
+		}
+	});
+}
+
+/// <summary>
+/// Starts loading a column that hasn't been saved: from the generated cache if it's in there, otherwise it's generated.
+/// </summary>
+/// <param name="t_column">The column position.</param>
+void ChunkStreamer::loadGenerated(const Indices &t_column)
+{
+	if (m_cache == nullptr)
+	{
+		generateColumn(t_column);
+		return;
+	}
+
+	Indices f_column = t_column;
+
+	m_cache->readColumn(f_column.x, f_column.z, [this, f_column](const std::shared_ptr<ChunkIO::ColumnData> &t_column)
+	{
+		if (t_column->found)
+		{
+			applyColumn(f_column, t_column->voxels, t_column->used);
+		}
+		else
+		{
+			generateColumn(f_column);
+		}
+	});
+}
+
+/// <summary>
+/// Starts generating a column on a worker. The column is written into the world (and the generated cache) by a main thread job once it's ready.
+/// </summary>
+/// <param name="t_column">The column position.</param>
+void ChunkStreamer::generateColumn(const Indices &t_column)
+{
+	Indices f_column = t_column;
+	std::shared_ptr<GeneratedColumn> f_result = std::make_shared<GeneratedColumn>();
+	const ab::Terrain &f_terrain = m_terrain;
+
+	ab::JobSystem::JobHandle f_generate = m_jobs.add([f_result, &f_terrain, f_column]()
+	{
+		PROFILE_SCOPE("Generate column");
+		f_result->voxels.resize(ab::Terrain::COLUMN_VOXELS);
+		f_terrain.generateColumn(f_column.x, f_column.z, f_result->voxels.data(), f_result->used);
+	});
+
+	m_pending.push_back(m_jobs.addMainThread([this, f_result, f_column]()
+	{
+		applyColumn(f_column, f_result->voxels, f_result->used);
+
+		// Columns that moved out of range while they were generated aren't in the world to cache
+		if (m_cache != nullptr && m_columns.count(f_column) > 0)
+		{
+			m_cache->writeColumn(f_column.x, f_column.z, f_result->voxels.data(), f_result->used);
+		}
+	}, { f_generate }));
+}
+
+/// <summary>
+/// Writes a generated column into the world, unless the camera has moved out of range while it was being generated.
+/// </summary>
+/// <param name="t_column">The column position.</param>
+/// <param name="t_voxels">The column's voxels, from Terrain::generateColumn().</param>
+/// <param name="t_used">The chunks of the column that aren't all air.</param>
+void ChunkStreamer::applyColumn(const Indices &t_column, const std::vector<char> &t_voxels, const bool *t_used)
+{
+	m_loading--;
+	auto f_found = m_columns.find(t_column);
+
+	if (getColumnDistance(t_column.x, t_column.z) > (m_loadRadius + STREAM_UNLOAD_MARGIN) * CHUNK_WIDTH)
+	{
+		m_columns.erase(f_found);
+		return;
+	}
+
+	std::size_t f_bytes = 0;
+
+	for (int cy = 0; cy < ab::Terrain::COLUMN_CHUNKS; ++cy)
+	{
+		Indices f_position = { t_column.x, cy, t_column.z };
+
+		if (t_used[cy])
+		{
+			m_world.setChunkVoxels(f_position, &t_voxels[cy * ab::Terrain::CHUNK_VOXELS]);
+		}
+
+		Chunk *f_chunk = m_world.chunks.find(f_position);
+
+		if (f_chunk != nullptr)
+		{
+			f_bytes += f_chunk->getMemoryUsage(); // Includes the chunk object
+		}
+	}
+
+	// Edits made while the column was loading were written over
+	m_world.clearColumnModified(t_column.x, t_column.z);
+	f_found->second.loading = false;
+	f_found->second.memoryBytes = f_bytes;
+	m_memoryBytes += f_bytes;
+	m_loaded++;
+	m_loadLatency.add(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - f_found->second.requested).count());
+}
+
+/// <summary>
+/// Saves a loaded column if it has been edited (and there's a ChunkIO) and removes its chunks from the world.
+/// </summary>
+/// <param name="t_column">The column position.</param>
+void ChunkStreamer::unloadColumn(const Indices &t_column)
+{
+	auto f_found = m_columns.find(t_column);
+
+	if (m_io != nullptr && m_world.isColumnModified(t_column.x, t_column.z))
+	{
+		m_io->writeColumn(t_column.x, t_column.z, m_world);
+	}
+
+	m_world.clearColumnModified(t_column.x, t_column.z);
+
+	for (int cy = 0; cy < ab::Terrain::COLUMN_CHUNKS; ++cy)
+	{
+		m_world.unloadChunk({ t_column.x, cy, t_column.z });
+	}
+
+	m_memoryBytes -= f_found->second.memoryBytes;
+	m_columns.erase(f_found);
+	m_unloaded++;
+}
+
+/// <summary>
+/// Unloads the loaded column with the lowest priority (the highest value), as long as it's less important than a given priority.
+/// </summary>
+/// <param name="t_keepBelow">Columns with this priority value or lower are kept.</param>
+/// <returns>True if a column was unloaded.</returns>
+bool ChunkStreamer::unloadLowestPriority(float t_keepBelow)
+{
+	Indices f_lowest = {};
+	float f_lowestPriority = t_keepBelow;
+	bool f_found = false;
+
+	for (const auto &f_pair : m_columns)
+	{
+		float f_priority = getColumnPriority(f_pair.first.x, f_pair.first.z);
+
+		if (!f_pair.second.loading && f_priority > f_lowestPriority)
+		{
+			f_lowest = f_pair.first;
+			f_lowestPriority = f_priority;
+			f_found = true;
+		}
+	}
+
+	if (f_found)
+	{
+		unloadColumn(f_lowest);
+	}
+
+	return f_found;
+}
+
+/// <summary>
+/// Checks if a column is loaded.
+/// </summary>
+/// <param name="t_columnX">The X position of the column (in chunks).</param>
+/// <param name="t_columnZ">The Z position of the column (in chunks).</param>
+/// <returns>True if the column is loaded (not just being generated).</returns>
+bool ChunkStreamer::isResident(int t_columnX, int t_columnZ) const
+{
+	auto f_found = m_columns.find({ t_columnX, 0, t_columnZ });
+
+	return f_found != m_columns.end() && !f_found->second.loading;
+}
+
+/// <summary>
+/// Sets the load radius. Columns are unloaded once they're STREAM_UNLOAD_MARGIN chunks past it.
+/// </summary>
+/// <param name="t_radius">The radius in chunks.</param>
+void ChunkStreamer::setLoadRadius(int t_radius)
+{
+	m_loadRadius = std::max(t_radius, 1);
+}
+
+/// <summary>
+/// Gets the load radius.
+/// </summary>
+/// <returns>The radius in chunks.</returns>
+int ChunkStreamer::getLoadRadius() const
+{
+	return m_loadRadius;
+}
+
+/// <summary>
+/// Sets the memory budget for the voxels of the loaded columns.
+/// </summary>
+/// <param name="t_megabytes">The budget in megabytes.</param>
+void ChunkStreamer::setMemoryBudget(float t_megabytes)
+{
+	m_memoryBudget = (std::size_t)(std::max(t_megabytes, 0.0f) * 1024.0f * 1024.0f);
+}
+
+/// <summary>
+/// Gets the memory budget for the voxels of the loaded columns.
+/// </summary>
+/// <returns>The budget in megabytes.</returns>
+float ChunkStreamer::getMemoryBudget() const
+{
+	return m_memoryBudget / (1024.0f * 1024.0f);
+}
+
+/// <summary>
+/// Gets the streaming stats.
+/// </summary>
+/// <returns>The stats.</returns>
+ChunkStreamer::Stats ChunkStreamer::getStats() const
+{
+	Stats f_stats;
+	f_stats.resident = (int)m_columns.size() - m_loading;
+	f_stats.loading = m_loading;
+	f_stats.loaded = m_loaded;
+	f_stats.unloaded = m_unloaded;
+	f_stats.memoryBytes = m_memoryBytes;
+	f_stats.loads = m_loadLatency;
+
+	return f_stats;
+}
+
+/// <summary>
+/// Forgets the column load latencies so far, e.g. before a benchmark run.
+/// </summary>
+void ChunkStreamer::clearLatency()
+{
+	m_loadLatency = ChunkIO::LatencyHistogram();
+}
@@ -0,0 +1,211 @@
+#include "ChunkTable.h"
+#include "ChunkPool.h"
+
+namespace
+{
+	const int INITIAL_CAPACITY = 1024;
+}
+
+/// <summary>
+/// Constructor for the ChunkTable class.
+/// </summary>
+ChunkTable::ChunkTable()
+{
+	m_slots.resize(INITIAL_CAPACITY, { { 0, 0, 0 }, nullptr });
+	m_mask = INITIAL_CAPACITY - 1;
+	m_count = 0;
+}
+
+/// <summary>
+/// Destructor for the ChunkTable class.
+/// </summary>
+ChunkTable::~ChunkTable()
+{
+	clear();
+}
+
+/// <summary>
+/// Finds a chunk using its chunk position.
+/// </summary>
+/// <param name="t_position">The chunk position (world position / chunk size).</param>
+/// <returns>The chunk, or nullptr if it doesn't exist.</returns>
+Chunk *ChunkTable::find(const Indices &t_position) const
+{
+	return m_slots[findSlot(t_position)].chunk;
+}
+
+/// <summary>
+/// Finds a chunk using its chunk position, creating it if it doesn't exist.
+/// </summary>
+/// <param name="t_position">The chunk position (world position / chunk size).</param>
+/// <returns>The chunk.</returns>
+Chunk *ChunkTable::findOrCreate(const Indices &t_position)
+{
+	unsigned int f_slot = findSlot(t_position);
+
+	if (m_slots[f_slot].chunk != nullptr)
+	{
+		return m_slots[f_slot].chunk;
+	}
+
+	// Keep the load factor at or below 0.5 so probe sequences stay short
+	if ((m_count + 1) * 2 > (int)m_slots.size())
+	{
+		grow();
+		f_slot = findSlot(t_position);
+	}
+
+	m_slots[f_slot].position = t_position;
+	m_slots[f_slot].chunk = ChunkPool::get().createChunk();
+	m_count++;
+
+	return m_slots[f_slot].chunk;
+}
+
+/// <summary>
+/// Removes and deletes a chunk.
+/// Uses backward shift deletion so no tombstones are left behind.
+/// </summary>
+/// <param name="t_position">The chunk position (world position / chunk size).</param>
+/// <returns>True if a chunk was removed.</returns>
+bool ChunkTable::erase(const Indices &t_position)
+{
+	unsigned int f_hole = findSlot(t_position);
+
+	if (m_slots[f_hole].chunk == nullptr)
+	{
+		return false;
+	}
+
+	ChunkPool::get().destroyChunk(m_slots[f_hole].chunk);
+	m_slots[f_hole].chunk = nullptr;
+	m_count--;
+
+	// Move any following entries back if the hole is between them and their ideal slot
+	unsigned int f_next = (f_hole + 1) & m_mask;
+
+	while (m_slots[f_next].chunk != nullptr)
+	{
+		unsigned int f_ideal = IndicesHash()(m_slots[f_next].position) & m_mask;
+
+		// Distances from the ideal slot, allowing for wrap-around
+		unsigned int f_distanceToHole = (f_hole - f_ideal) & m_mask;
+		unsigned int f_distanceToNext = (f_next - f_ideal) & m_mask;
+
+		if (f_distanceToHole < f_distanceToNext)
+		{
+			m_slots[f_hole] = m_slots[f_next];
+			m_slots[f_next].chunk = nullptr;
+			f_hole = f_next;
+		}
+
+		f_next = (f_next + 1) & m_mask;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Deletes all chunks.
+/// </summary>
+void ChunkTable::clear()
+{
+	for (Slot &f_slot : m_slots)
+	{
+		ChunkPool::get().destroyChunk(f_slot.chunk);
+		f_slot.chunk = nullptr;
+	}
+
+	m_count = 0;
+}
+
+/// <summary>
+/// Gets the number of chunks in the table.
+/// </summary>
+/// <returns>The number of chunks.</returns>
+int ChunkTable::getCount() const
+{
+	return m_count;
+}
+
+/// <summary>
+/// Gets the number of slots in the table.
+/// </summary>
+/// <returns>The capacity of the table.</returns>
+int ChunkTable::getCapacity() const
+{
+	return (int)m_slots.size();
+}
+
+/// <summary>
+/// Gets the number of bytes used by the table and all of its chunks.
+/// </summary>
+/// <returns>The memory usage in bytes.</returns>
+std::size_t ChunkTable::getMemoryUsage() const
+{
+	std::size_t f_bytes = m_slots.capacity() * sizeof(Slot);
+
+	for (const Slot &f_slot : m_slots)
+	{
+		if (f_slot.chunk != nullptr)
+		{
+			f_bytes += f_slot.chunk->getMemoryUsage();
+		}
+	}
+
+	return f_bytes;
+}
+
+/// <summary>
+/// Calls a function for every chunk in the table.
+/// Chunks must not be added or removed from inside the function.
+/// </summary>
+/// <param name="t_function">The function to call with each chunk position and chunk.</param>
+void ChunkTable::forEach(const std::function<void(const Indices &, Chunk *)> &t_function) const
+{
+	for (const Slot &f_slot : m_slots)
+	{
+		if (f_slot.chunk != nullptr)
+		{
+			t_function(f_slot.position, f_slot.chunk);
+		}
+	}
+}
+
+/// <summary>
+/// Finds the slot for a chunk position.
+/// This is either the slot holding the chunk or the empty slot where it would go.
+/// </summary>
+/// <param name="t_position">The chunk position.</param>
+/// <returns>The slot index.</returns>
+unsigned int ChunkTable::findSlot(const Indices &t_position) const
+{
+	unsigned int f_slot = IndicesHash()(t_position) & m_mask;
+
+	while (m_slots[f_slot].chunk != nullptr && m_slots[f_slot].position != t_position)
+	{
+		f_slot = (f_slot + 1) & m_mask;
+	}
+
+	return f_slot;
+}
+
+/// <summary>
+/// Doubles the capacity of the table and re-inserts every chunk.
+/// </summary>
+void ChunkTable::grow()
+{
+	std::vector<Slot> f_oldSlots;
+	f_oldSlots.swap(m_slots);
+
+	m_slots.resize(f_oldSlots.size() * 2, { { 0, 0, 0 }, nullptr });
+	m_mask = (unsigned int)m_slots.size() - 1;
+
+	for (const Slot &f_slot : f_oldSlots)
+	{
+		if (f_slot.chunk != nullptr)
+		{
+			m_slots[findSlot(f_slot.position)] = f_slot;
+		}
+	}
+}
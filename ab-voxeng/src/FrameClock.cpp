@@ -0,0 +1,213 @@
+#include "FrameClock.h"
+
+#include <algorithm>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+constexpr double ab::FrameClock::MAX_FRAME_MS;
+constexpr double ab::FrameClock::SPIN_MS;
+
+/// <summary>
+/// Constructor for the FrameClock class.
+/// </summary>
+/// <param name="t_stepMs">The length of a simulation step in milliseconds.</param>
+/// <param name="t_framesPerSecond">The frame rate to cap the loop at, or 0 for no cap.</param>
+ab::FrameClock::FrameClock(double t_stepMs, double t_framesPerSecond) :
+	m_stepMs(t_stepMs),
+	m_targetMs(0.0),
+	m_accumulatorMs(0.0),
+	m_started(false),
+	m_lockstep(false),
+	m_frameMs(0.0),
+	m_workMs(0.0),
+	m_sleepMs(0.0),
+	m_steps(0),
+	m_lastSteps(0)
+{
+	setFrameRate(t_framesPerSecond);
+
+#ifdef _WIN32
+	timeBeginPeriod(1);
+#endif
+}
+
+/// <summary>
+/// Destructor for the FrameClock class.
+/// </summary>
+ab::FrameClock::~FrameClock()
+{
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+}
+
+/// <summary>
+/// Starts a frame. Call this at the top of the loop, then step() until it returns false.
+/// </summary>
+/// <returns>The time since the last frame started in milliseconds (0 the first time).</returns>
+double ab::FrameClock::beginFrame()
+{
+	Clock::time_point f_now = Clock::now();
+	Clock::duration f_target = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(m_targetMs));
+	m_frameMs = m_started ? std::chrono::duration<double, std::milli>(f_now - m_frameStart).count() : 0.0;
+
+	// A frame or more behind means the schedule can't be caught up with, so start a new one from now
+	if (!m_started || f_now >= m_deadline + f_target)
+	{
+		m_deadline = f_now + f_target;
+	}
+	else
+	{
+		m_deadline += f_target;
+	}
+
+	m_frameStart = f_now;
+	m_started = true;
+	m_lastSteps = m_steps;
+	m_steps = 0;
+	advance(m_lockstep ? m_stepMs : m_frameMs);
+
+	return m_frameMs;
+}
+
+/// <summary>
+/// Adds time for the simulation to catch up with. beginFrame() does this with the real time.
+/// </summary>
+/// <param name="t_elapsedMs">The time in milliseconds, anything over MAX_FRAME_MS is dropped.</param>
+void ab::FrameClock::advance(double t_elapsedMs)
+{
+	m_accumulatorMs += std::min(std::max(t_elapsedMs, 0.0), MAX_FRAME_MS);
+}
+
+/// <summary>
+/// Takes a simulation step out of the accumulated time, if there's enough left.
+/// </summary>
+/// <returns>True if the simulation should be stepped by getStepMs().</returns>
+bool ab::FrameClock::step()
+{
+	if (m_accumulatorMs < m_stepMs)
+	{
+		return false;
+	}
+
+	m_accumulatorMs -= m_stepMs;
+	m_steps++;
+
+	return true;
+}
+
+/// <summary>
+/// Ends a frame. If the frame rate is capped this waits until the frame's deadline, otherwise it returns straight away.
+/// </summary>
+void ab::FrameClock::endFrame()
+{
+	Clock::time_point f_workEnd = Clock::now();
+	m_workMs = std::chrono::duration<double, std::milli>(f_workEnd - m_frameStart).count();
+
+	if (m_targetMs > 0.0)
+	{
+		Clock::time_point f_spinStart = m_deadline - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(SPIN_MS));
+
+		if (f_workEnd < f_spinStart)
+		{
+			std::this_thread::sleep_until(f_spinStart);
+		}
+
+		while (Clock::now() < m_deadline)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	m_sleepMs = std::chrono::duration<double, std::milli>(Clock::now() - f_workEnd).count();
+}
+
+/// <summary>
+/// Sets the frame rate cap.
+/// </summary>
+/// <param name="t_framesPerSecond">The most frames per second, or 0 for no cap (e.g. for benchmarking).</param>
+void ab::FrameClock::setFrameRate(double t_framesPerSecond)
+{
+	m_targetMs = t_framesPerSecond > 0.0 ? 1000.0 / t_framesPerSecond : 0.0;
+}
+
+/// <summary>
+/// Turns lockstep on or off. In lockstep each frame simulates exactly one step, however long it really took.
+/// </summary>
+/// <param name="t_lockstep">True for one step per frame (e.g. to replay a camera path), false to follow the real time.</param>
+void ab::FrameClock::setLockstep(bool t_lockstep)
+{
+	m_lockstep = t_lockstep;
+	m_accumulatorMs = 0.0;
+}
+
+/// <summary>
+/// Gets whether the frame rate is capped.
+/// </summary>
+/// <returns>True if endFrame() never waits.</returns>
+bool ab::FrameClock::isUncapped() const
+{
+	return m_targetMs <= 0.0;
+}
+
+/// <summary>
+/// Gets the length of a simulation step.
+/// </summary>
+/// <returns>The step in milliseconds.</returns>
+double ab::FrameClock::getStepMs() const
+{
+	return m_stepMs;
+}
+
+/// <summary>
+/// Gets how far the real time is past the last simulation step, as a fraction of a step.
+/// Drawing the state this far between the previous step and the last one keeps movement smooth when the frame rate and step rate differ.
+/// </summary>
+/// <returns>0 (at the last step) up to 1 (the next step is due).</returns>
+double ab::FrameClock::getInterpolation() const
+{
+	return m_accumulatorMs / m_stepMs;
+}
+
+/// <summary>
+/// Gets the time between the starts of the last two frames.
+/// </summary>
+/// <returns>The frame time in milliseconds.</returns>
+double ab::FrameClock::getFrameMs() const
+{
+	return m_frameMs;
+}
+
+/// <summary>
+/// Gets how long the last frame's work took, from beginFrame() to endFrame().
+/// </summary>
+/// <returns>The time in milliseconds.</returns>
+double ab::FrameClock::getWorkMs() const
+{
+	return m_workMs;
+}
+
+/// <summary>
+/// Gets how long endFrame() waited at the end of the last frame.
+/// </summary>
+/// <returns>The time in milliseconds.</returns>
+double ab::FrameClock::getSleepMs() const
+{
+	return m_sleepMs;
+}
+
+/// <summary>
+/// Gets the number of simulation steps taken in the frame before the current one.
+/// </summary>
+/// <returns>The number of steps.</returns>
+int ab::FrameClock::getStepCount() const
+{
+	return m_lastSteps;
+}
@@ -10,7 +10,7 @@
 /// <param name="t_height">The height of the window.</param>
 Game::Game(int t_width, int t_height) 
 {
-	std::srand(12345); // This needs to be manually entered
+	PROFILE_THREAD("Main");
 
 	SCREEN_WIDTH = t_width;
 	SCREEN_HEIGHT = t_height;
@@ -29,9 +29,26 @@ Game::Game(int t_width, int t_height)
 /// </summary>
 Game::~Game()
 {
+	for (auto &f_pair : m_chunkMeshes)
+	{
+		glDeleteBuffers(1, &f_pair.second.vertexBufferID);
+		glDeleteVertexArrays(1, &f_pair.second.vertexArrayObjectID);
+	}
+
+	m_chunkMeshes.clear();
+	glDeleteBuffers(1, &m_quadElementBufferID);
+	glDeleteTextures(1, &m_blockTextureArrayID);
+
 	SDL_DestroyWindow(m_window);
 	m_window = NULL;
 
+	m_streamer->save();
+	delete m_streamer; // Waits for the columns still being read or generated
+	delete m_io; // Writes the saved columns
+	delete m_regions;
+	delete m_cacheIO;
+	delete m_cache;
+	delete m_terrain;
 	delete m_controller;
 	delete m_camera;
 	delete m_mainShader;
@@ -43,6 +60,9 @@ Game::~Game()
 	ImGui_ImplSDL2_Shutdown();
 	ImGui::DestroyContext();
 	
+	delete m_jobs;
+	delete m_frameClock;
+
 	IMG_Quit();
 	SDL_Quit();
 }
@@ -52,21 +72,79 @@ Game::~Game()
 /// </summary>
 void Game::start()
 {
-	double f_startMs;
-	double f_endMs;
-	double f_delayMs;
-
 	while (m_looping)
 	{		
-		f_startMs = SDL_GetTicks();
-		f_endMs = SDL_GetTicks();
-		f_delayMs = m_frameMs - (f_endMs - f_startMs);
-		SDL_Delay((Uint32)f_delayMs);
+		m_frameClock->beginFrame();
+		updateStats();
 
+		PROFILE_SCOPE("Frame");
 		processEvents();
-		update(f_delayMs);
+
+		// Catch the simulation up with the real time in fixed steps
+		while (m_frameClock->step())
+		{
+			simulate(m_frameClock->getStepMs());
+		}
+
+		update();
 		draw();
+
+		// Sleep for whatever is left of the frame (unless the frame rate is uncapped)
+		PROFILE_SCOPE("Frame wait");
+		m_frameClock->endFrame();
+
+		if (m_replayingPath)
+		{
+			m_flythroughFrames.push_back((float)m_frameClock->getWorkMs());
+
+			if (m_pathTimeMs >= m_cameraPath.getDuration())
+			{
+				finishFlythrough();
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Turns the frame rate cap off (for benchmarking) or back on.
+/// </summary>
+/// <param name="t_uncapped">True to draw frames as fast as possible.</param>
+void Game::setUncapped(bool t_uncapped)
+{
+	m_uncapped = t_uncapped;
+	m_frameClock->setFrameRate(t_uncapped ? 0.0 : FRAME_RATE_LIMIT);
+}
+
+/// <summary>
+/// Starts flying the camera along a recorded path, one simulation step per frame, timing every frame.
+/// When the path ends the results are put into the stats registry (group "Flythrough") and written to FLYTHROUGH_RESULTS_PATH,
+/// so runs of two builds can be compared.
+/// </summary>
+/// <param name="t_path">The camera path file (see CameraPath).</param>
+/// <param name="t_exitWhenDone">True to stop the game loop when the path ends (e.g. for --flythrough).</param>
+/// <returns>True if the path was loaded and the flythrough started.</returns>
+bool Game::startFlythrough(const std::string &t_path, bool t_exitWhenDone)
+{
+	if (!m_cameraPath.load(t_path))
+	{
+		std::cout << "Couldn't load the camera path " << t_path << std::endl;
+		return false;
 	}
+
+	ab::CameraPath::Keyframe f_start = m_cameraPath.sample(0.0);
+	m_camera->setPose(f_start.eye, f_start.yaw, f_start.pitch);
+	m_previousEye = f_start.eye;
+	m_recordingPath = false;
+	m_replayingPath = true;
+	m_exitAfterFlythrough = t_exitWhenDone;
+	m_pathTimeMs = 0.0;
+	m_flythroughFrames.clear();
+	m_flythroughLoadedStart = m_streamer->getStats().loaded;
+	m_streamer->clearLatency();
+	m_remeshQueue.clearLatency();
+	m_frameClock->setLockstep(true);
+
+	return true;
 }
 
 /// <summary>
@@ -74,6 +152,8 @@ void Game::start()
 /// </summary>
 void Game::initialise()
 {
+	PROFILE_SCOPE("Game::initialise");
+
 	// Create context for window
 	m_glContext = SDL_GL_CreateContext(m_window);
 	SDL_GL_MakeCurrent(m_window, m_glContext);
@@ -116,11 +196,10 @@ void Game::initialise()
 		std::cout << glewGetErrorString(glewInit()) << std::endl;
 	}
 
-	// Use v-sync
-	// TODO: Still not sure about v-sync - Can I toggle this during runtime?
-	if (SDL_GL_SetSwapInterval(1) < 0)
+	// No v-sync, the frame clock paces the loop (two pacers would fight over when frames start)
+	if (SDL_GL_SetSwapInterval(0) < 0)
 	{
-		std::cout << "Warning: Unable to set VSync! Error: %s\n", SDL_GetError();
+		std::cout << "Warning: Unable to turn VSync off! Error: " << SDL_GetError() << std::endl;
 	}
 
 	// Renderer settings
@@ -141,16 +220,20 @@ void Game::initialise()
 	}
 
 	// Frame rate / Game loop
-	m_frameRate = 60.0;
-	m_frameMs = 1000.0f / m_frameRate;
+	m_frameClock = new ab::FrameClock(SIMULATION_STEP_MS, FRAME_RATE_LIMIT);
 	m_looping = true;
 
+	// Worker threads (one for every core except this one)
+	m_jobs = new ab::JobSystem();
+
 	// Controller
 	m_controller = new ab::XboxOneController(0); // Zero is the controller index value
 
 	// Camera
 	m_camera = new ab::Camera(*m_controller);
+	m_camera->update(0.0); // Sets up the view matrix before the first simulation step
 	m_cameraEye = m_camera->getEye();
+	m_previousEye = m_cameraEye;
 
 	// Shaders
 	m_mainShader = new ab::Shader("shaders/passthrough.vert", "shaders/passthrough.frag");
@@ -158,24 +241,30 @@ void Game::initialise()
 	m_computeShader = new ab::Shader("shaders/raytracer.comp");
 	m_skyboxShader = new ab::Shader("shaders/skybox.vert", "shaders/skybox.frag");
 
-	// Create height maps for use in map object
-	m_terrain = new ab::Terrain();
-	m_terrain->generate(WORLD_WIDTH, WORLD_DEPTH);
-
-	// Create map object and populate map using height maps
+	// Create map object, the chunks around the camera are loaded (or read from the cache or generated, if they haven't been saved) as it moves (see update())
+	m_terrain = new ab::Terrain(WORLD_SEED);
 	world = new World();
-	world->populate(m_terrain->heightMap, m_terrain->treeMap, m_terrain->waterMap);
-
-	delete m_terrain; // Don't need this anymore
+	m_regions = new RegionStore(WORLD_SAVE_DIRECTORY);
+	m_streamer = new ChunkStreamer(*world, *m_terrain, *m_jobs);
+	m_io = new ChunkIO(*m_regions, *m_jobs);
+	m_streamer->setChunkIO(m_io);
+	m_cache = new RegionStore(m_terrain->getCacheDirectory(WORLD_CACHE_DIRECTORY));
+	m_cacheIO = new ChunkIO(*m_cache, *m_jobs);
+	m_streamer->setGeneratedCache(m_cacheIO);
+	createTreeTemplate();
+
+	// Load block textures (one layer per block type, starting with grass)
+	std::vector<std::string> f_blockTextures
+	{
+		"models/grass-block.png",
+		"models/water-block.png",
+		"models/tree-block.png",
+		"models/leaf-block.png"
+	};
 
-	world->optimiseWorldStorage();	
-	updateEntireMap(); // This copies all map voxels to the GPU
+	m_blockTextureArrayID = ab::OpenGL::loadTextureArray(f_blockTextures, m_jobs);
 
-	// Load models
-	ab::OpenGL::import("models/generic-block.obj", m_cube, "models/grass-block.png");
-	ab::OpenGL::import("models/generic-block.obj", m_waterBlock, "models/water-block.png");
-	ab::OpenGL::import("models/generic-block.obj", m_treeBlock, "models/tree-block.png");
-	ab::OpenGL::import("models/generic-block.obj", m_leafBlock, "models/leaf-block.png");
+	createQuadElementBuffer();
 
 	// Load cube map for skybox
 
@@ -240,6 +329,7 @@ void Game::initialise()
 /// </summary>
 void Game::processEvents()
 {
+	PROFILE_SCOPE("Game::processEvents");
 	SDL_Event f_event;
 	Uint32 f_windowID = SDL_GetWindowID(m_window);
 
@@ -261,29 +351,38 @@ void Game::processEvents()
 			m_mousePos.y = 1.0f - (2.0f * f_event.motion.y) / SCREEN_HEIGHT;
 		}
 
-		// Handle left and right mouse button clicks
+		// Handle left, middle and right mouse button clicks
 		if (f_event.type == SDL_MOUSEBUTTONDOWN)
 		{
-			//if (f_event.button.button == SDL_BUTTON_LEFT) // Add voxel
-			//{
-			//	m_rayDirection = m_camera->getRayFromMousePos(m_mousePos.x, m_mousePos.y);
-
-			//	if (checkForVoxelIntersections(m_camera->getEye(), m_rayDirection, m_hitPoint))
-			//	{
-			//		world->setVoxel((int)m_hitInfo.center.x, (int)m_hitInfo.center.y, (int)m_hitInfo.center.z, 0);
-			//		updateEntireMap();
-			//	}
-			//}
-			//else if (f_event.button.button == SDL_BUTTON_RIGHT) // Delete voxel
-			//{
-			//	m_rayDirection = m_camera->getRayFromMousePos(m_mousePos.x, m_mousePos.y);
-
-			//	if (checkForVoxelIntersections(m_camera->getEye(), m_rayDirection, m_hitPoint))
-			//	{
-			//		map->voxel((int)m_hitInfo.center.x, (int)m_hitInfo.center.y, (int)m_hitInfo.center.z, 0);
-			//		updateEntireMap();
-			//	}
-			//}
+			// Ignore clicks on the ImGUI windows
+			if (!ImGui::GetIO().WantCaptureMouse && pickVoxel())
+			{
+				if (f_event.button.button == SDL_BUTTON_LEFT) // Add voxel
+				{
+					const Indices &f_cell = m_raycastHit.previous;
+
+					// A ray that starts inside a voxel has nowhere to place a new one
+					if (m_raycastHit.previous != m_raycastHit.voxel)
+					{
+						world->setVoxel(f_cell.x, f_cell.y, f_cell.z, BLOCK_GRASS);
+					}
+				}
+				else if (f_event.button.button == SDL_BUTTON_RIGHT) // Delete voxel
+				{
+					world->setVoxel(m_raycastHit.voxel.x, m_raycastHit.voxel.y, m_raycastHit.voxel.z, BLOCK_AIR);
+				}
+				else if (f_event.button.button == SDL_BUTTON_MIDDLE) // Plant a tree
+				{
+					const Indices &f_cell = m_raycastHit.previous;
+					int f_top = m_treeTemplate.width / 2;
+
+					// The trunk goes in the cell a new voxel would be added to
+					if (m_raycastHit.previous != m_raycastHit.voxel)
+					{
+						world->stamp(m_treeTemplate, f_cell.x - f_top, f_cell.y, f_cell.z - f_top);
+					}
+				}
+			}
 		}
 
 		m_controller->processEvents(f_event);
@@ -291,22 +390,87 @@ void Game::processEvents()
 }
 
 /// <summary>
-/// Update logic.
+/// Steps the simulation (the camera and controls) forward by a fixed amount of time.
+/// </summary>
+/// <param name="t_stepMs">The step in milliseconds.</param>
+void Game::simulate(double t_stepMs)
+{
+	PROFILE_SCOPE("Game::simulate");
+	m_previousEye = m_camera->getEye();
+
+	// A flythrough puts the camera wherever the path says instead of reading the controller
+	if (m_replayingPath)
+	{
+		m_pathTimeMs += t_stepMs;
+		ab::CameraPath::Keyframe f_pose = m_cameraPath.sample(m_pathTimeMs);
+		m_camera->setPose(f_pose.eye, f_pose.yaw, f_pose.pitch);
+		return;
+	}
+
+	m_camera->update(t_stepMs);
+
+	if (m_recordingPath)
+	{
+		m_pathTimeMs += t_stepMs;
+
+		if (m_pathTimeMs >= m_cameraPath.getDuration() + CAMERA_PATH_KEYFRAME_MS)
+		{
+			m_cameraPath.add({ m_pathTimeMs, m_camera->getEye(), m_camera->getYaw(), m_camera->getPitch() });
+		}
+	}
+}
+
+/// <summary>
+/// Update logic, once a frame after the simulation has been stepped.
 /// </summary>
-/// <param name="t_deltaTime">The current delta time.</param>
-void Game::update(double t_deltaTime)
+void Game::update()
 {
+	PROFILE_SCOPE("Game::update");
+
 	// Start the Dear ImGui frame
 	ImGui_ImplOpenGL3_NewFrame();
 	ImGui_ImplSDL2_NewFrame(m_window);
 	ImGui::NewFrame();
 
-	// Update camera and controls
-	m_camera->update(t_deltaTime);
+	// Draw the camera part of the way from its previous step to its last one, so it moves smoothly whatever the frame rate
+	// (the view matrix is R * T(-eye), so moving the eye only changes the translation)
+	glm::vec3 f_eye = m_camera->getEye();
+	m_renderEye = glm::mix(m_previousEye, f_eye, (float)m_frameClock->getInterpolation());
+	m_renderView = glm::translate(m_camera->getView(), f_eye - m_renderEye);
+
+	// Start generating the chunks the camera needs next, and unload the ones it has left behind
+	m_streamer->update(m_camera->getEye(), m_camera->getDirection());
+
+	// Run any OpenGL work that background jobs have handed back (and write finished chunks into the world)
+	m_jobs->pump();
+
+	// Mesh the chunks that have been edited (the compute shader needs every voxel position, so raytracing rebuilds everything)
+	if (m_raytracingOn)
+	{
+		if (world->getDirtyCount() > 0)
+		{
+			updateEntireMap();
+		}
+	}
+	else
+	{
+		m_remeshQueue.collect(*world);
+
+		// Nearest chunks first, and unloaded chunks before anything else so their meshes are freed straight away
+		m_remeshQueue.sort([this](const Indices &t_position)
+		{
+			return world->chunks.find(t_position) == nullptr ? -1.0f : m_streamer->getPriority(t_position);
+		});
+
+		m_remeshQueue.process(m_remeshBudgetMs, [this](const Indices &t_position)
+		{
+			updateChunkMesh(t_position);
+		});
+	}
 
 	// Update view and projection matrices
 	glUseProgram(m_mainShader->m_programID);
-	ab::OpenGL::uniformMatrix4fv(*m_mainShader, "view", &m_camera->getView()[0][0]);
+	ab::OpenGL::uniformMatrix4fv(*m_mainShader, "view", &m_renderView[0][0]);
 	ab::OpenGL::uniformMatrix4fv(*m_mainShader, "projection", &m_camera->getProjection()[0][0]);
 
 	// ****************************
@@ -316,6 +480,18 @@ void Game::update(double t_deltaTime)
 	// Settings
 	ImGui::Begin("SETTINGS");
 
+	// Performance
+	drawStats();
+	ImGui::Separator();
+	ImGui::Separator();
+	ImGui::Separator();
+
+	// Recording and replaying camera paths
+	drawCameraPath();
+	ImGui::Separator();
+	ImGui::Separator();
+	ImGui::Separator();
+
 	// Mouse
 	ImGui::Text("MOUSE");
 	ImGui::Separator();
@@ -372,6 +548,60 @@ void Game::update(double t_deltaTime)
 
 	// Graphics settings
 	ImGui::Checkbox("Wireframe Mode (only works with rasterization)", &m_wireframeMode);
+
+	if (ImGui::Checkbox("Uncapped frame rate (benchmarking)", &m_uncapped))
+	{
+		setUncapped(m_uncapped);
+	}
+
+	if (ImGui::Combo("Meshing", &m_meshMode, "Naive\0Culled\0Greedy\0") && !m_raytracingOn)
+	{
+		updateEntireMap();
+	}
+
+	ImGui::SliderFloat("Remesh budget (ms)", &m_remeshBudgetMs, 0.1f, 16.0f);
+	ImGui::Text("Chunks waiting to be meshed: %d", (int)m_remeshQueue.getCount());
+	PROFILE_COUNTER("Chunks waiting to be meshed", m_remeshQueue.getCount());
+	ImGui::Separator();
+
+	// Chunk streaming
+	ChunkStreamer::Stats f_streamStats = m_streamer->getStats();
+
+	if (ImGui::SliderInt("Load radius (chunks)", &m_streamRadius, 4, 64))
+	{
+		m_streamer->setLoadRadius(m_streamRadius);
+	}
+
+	if (ImGui::SliderFloat("Chunk memory budget (MB)", &m_streamBudgetMB, 16.0f, 2048.0f))
+	{
+		m_streamer->setMemoryBudget(m_streamBudgetMB);
+	}
+
+	ImGui::Text("Columns loaded: %d (%d loading)", f_streamStats.resident, f_streamStats.loading);
+	ImGui::Text("Chunk memory: %.1f MB", f_streamStats.memoryBytes / (1024.0 * 1024.0));
+	PROFILE_COUNTER("Columns loaded", f_streamStats.resident);
+	PROFILE_COUNTER("Columns loading", f_streamStats.loading);
+	ChunkIO::Stats f_ioStats = m_io->getStats();
+	ImGui::Text("Columns waiting to be saved: %d", f_ioStats.pendingWrites);
+	ImGui::Text("Column reads: %d queued, %.2f ms p50, %.2f ms p99", f_ioStats.queuedReads,
+		f_ioStats.reads.getPercentile(50.0) / 1000.0, f_ioStats.reads.getPercentile(99.0) / 1000.0);
+
+	if (ImGui::Button("SAVE WORLD"))
+	{
+		m_streamer->save();
+	}
+
+#if AB_PROFILE
+	// Writes the last few seconds of every thread's zones (see Profiler::EVENTS_PER_THREAD)
+	ImGui::Separator();
+
+	if (ImGui::Button("CAPTURE TRACE"))
+	{
+		bool f_written = ab::Profiler::writeChromeTrace(PROFILER_TRACE_PATH);
+		DEBUG_MSG(std::string(f_written ? "Trace written to " : "Couldn't write ") + PROFILER_TRACE_PATH);
+	}
+#endif
+
 	ImGui::End();
 
 	// Update lighting parameters	
@@ -384,6 +614,8 @@ void Game::update(double t_deltaTime)
 /// </summary>
 void Game::draw()
 {
+	PROFILE_SCOPE("Game::draw");
+
 	// Activate wireframe mode
 	if (m_wireframeMode)
 	{
@@ -392,31 +624,37 @@ void Game::draw()
 
 	// Clear screen
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	m_drawCalls = 0;
 
 	if (!m_raytracingOn)
 	{
 		// Activate shader
 		glUseProgram(m_mainShader->m_programID);
 
-		// If the instance array has changed then update it
-		// This only gets done if a voxel is added or removed
-		// TODO: This really needs to be split up somehow, updating the entire array is a bit mad
-		if (m_instanceArrayUpdated)
+		// Send camera position to shader
+		ab::OpenGL::uniform3f(*m_mainShader, "viewPosition", m_renderEye.x, m_renderEye.y, m_renderEye.z);
+
+		// Bind block textures
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, m_blockTextureArrayID);
+		ab::OpenGL::uniform1i(*m_mainShader, "diffuseTexture", 0);
+
+		// Draw chunk meshes
+		GLint f_chunkOffsetLocation = glGetUniformLocation(m_mainShader->m_programID, "chunkOffset");
+
+		for (const auto &f_pair : m_chunkMeshes)
 		{
-			glBindBuffer(GL_ARRAY_BUFFER, m_cube.instanceBufferID);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, m_cube.instancingPositions.size() * sizeof(glm::mat4), &m_cube.instancingPositions[0]);
+			const Indices &f_position = f_pair.first;
+			const ChunkMesh &f_mesh = f_pair.second;
 
-			m_instanceArrayUpdated = false;
+			glUniform3f(f_chunkOffsetLocation, (float)(f_position.x * CHUNK_WIDTH), (float)(f_position.y * CHUNK_HEIGHT), (float)(f_position.z * CHUNK_DEPTH));
+			glBindVertexArray(f_mesh.vertexArrayObjectID);
+			glDrawElements(GL_TRIANGLES, f_mesh.quadCount * 6, GL_UNSIGNED_INT, (void*)0);
+			m_drawCalls++;
 		}
 
-		// Send camera position to shader
-		ab::OpenGL::uniform3f(*m_mainShader, "viewPosition", m_camera->getEye().x, m_camera->getEye().y, m_camera->getEye().z);
-
-		// Draw cubes using instancing
-		ab::OpenGL::draw(m_cube, m_mainShader, "diffuseTexture");
-		ab::OpenGL::draw(m_waterBlock, m_mainShader, "diffuseTexture");
-		ab::OpenGL::draw(m_treeBlock, m_mainShader, "diffuseTexture");
-		ab::OpenGL::draw(m_leafBlock, m_mainShader, "diffuseTexture");
+		glBindVertexArray(0);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
 
 		if (true) // TODO: Add this to ImGUI as an option
 		{
@@ -437,6 +675,7 @@ void Game::draw()
 			// Bind VAO and draw
 			glBindVertexArray(m_skyboxVAO);
 			glDrawArrays(GL_TRIANGLES, 0, 36);
+			m_drawCalls++;
 			glBindVertexArray(0);
 
 			glDepthFunc(GL_LESS);
@@ -461,6 +700,220 @@ void Game::draw()
 	}
 }
 
+/// <summary>
+/// Puts the last frame's numbers into the stats registry: its time, how long each stage took (from the profiler),
+/// what's loaded, the GPU buffers, the draw calls and how much work is waiting. Call this after FrameClock::beginFrame().
+/// </summary>
+void Game::updateStats()
+{
+	const double MB = 1024.0 * 1024.0;
+
+	// There's no last frame to time the first time round
+	if (m_statsFrame > 0)
+	{
+		double f_frameMs = m_frameClock->getFrameMs();
+		ab::Stats::addSample("Frame", "Frame time", f_frameMs, "ms");
+		ab::Stats::addSample("Frame", "Work time", m_frameClock->getWorkMs(), "ms");
+		ab::Stats::set("Frame", "Sleep time", m_frameClock->getSleepMs(), "ms");
+		ab::Stats::set("Frame", "Frame rate", f_frameMs > 0.0 ? 1000.0 / f_frameMs : 0.0, "fps");
+		ab::Stats::set("Frame", "Simulation steps", m_frameClock->getStepCount(), "");
+		ab::Stats::set("Frame", "Draw calls", m_drawCalls, "");
+	}
+
+#if AB_PROFILE
+	// The zones directly inside the last "Frame" zone, and the ones inside those
+	std::int64_t f_frameStart = ab::Profiler::now();
+	std::vector<std::pair<const char *, std::int64_t>> f_stages;
+
+	for (const ab::Profiler::Event &f_event : ab::Profiler::getRecentEvents(m_statsFrameStart))
+	{
+		if (f_event.type != ab::Profiler::EventType::ZONE || f_event.depth < 1 || f_event.depth > 2)
+		{
+			continue;
+		}
+
+		auto f_stage = std::find_if(f_stages.begin(), f_stages.end(), [&](const std::pair<const char *, std::int64_t> &t_stage)
+		{
+			return t_stage.first == f_event.name;
+		});
+
+		if (f_stage == f_stages.end())
+		{
+			f_stages.push_back({ f_event.name, f_event.duration });
+		}
+		else
+		{
+			f_stage->second += f_event.duration;
+		}
+	}
+
+	for (const std::pair<const char *, std::int64_t> &f_stage : f_stages)
+	{
+		ab::Stats::set("CPU", f_stage.first, f_stage.second / 1000000.0, "ms");
+	}
+
+	m_statsFrameStart = f_frameStart;
+#endif
+
+	// Counting the voxels means visiting every chunk, so it isn't done every frame
+	if (m_statsFrame % STATS_WORLD_INTERVAL_FRAMES == 0)
+	{
+		World::Stats f_worldStats = world->getStats();
+		ab::Stats::set("World", "Chunks", f_worldStats.chunks, "");
+		ab::Stats::set("World", "Solid voxels", (double)f_worldStats.solidVoxels, "");
+		ab::Stats::set("World", "Voxel storage", f_worldStats.memoryBytes / MB, "MB");
+	}
+
+	ChunkStreamer::Stats f_streamStats = m_streamer->getStats();
+	ChunkIO::Stats f_ioStats = m_io->getStats();
+
+	ab::Stats::set("World", "Columns loaded", f_streamStats.resident, "");
+	ab::Stats::set("World", "Chunk meshes", (double)m_chunkMeshes.size(), "");
+	ab::Stats::set("GPU", "Chunk vertex buffers", m_meshBytes / MB, "MB");
+
+	if (m_raytracingOn)
+	{
+		ab::Stats::set("GPU", "Voxel position buffer", m_voxelPositions.size() * sizeof(glm::vec4) / MB, "MB");
+	}
+
+	ab::Stats::set("Queues", "Chunks waiting to be meshed", (double)m_remeshQueue.getCount(), "");
+	ab::Stats::set("Queues", "Columns generating", f_streamStats.loading, "");
+	ab::Stats::set("Queues", "Column reads queued", f_ioStats.queuedReads, "");
+	ab::Stats::set("Queues", "Columns waiting to be saved", f_ioStats.pendingWrites, "");
+
+	m_statsFrame++;
+}
+
+/// <summary>
+/// Shows the stats registry in the settings window: a graph of the frame times with their percentiles,
+/// each stage's share of the frame, and the rest of the stats as text.
+/// </summary>
+void Game::drawStats()
+{
+	ImGui::Text("PERFORMANCE");
+	ImGui::Separator();
+
+	ab::Stats::Stat f_frame;
+	bool f_hasFrame = ab::Stats::get("Frame", "Frame time", f_frame) && f_frame.value > 0.0;
+	std::string f_group;
+
+	for (const ab::Stats::Stat &f_stat : ab::Stats::getAll())
+	{
+		if (f_stat.group != f_group)
+		{
+			f_group = f_stat.group;
+			ImGui::BulletText("%s", f_group.c_str());
+		}
+
+		if (!f_stat.history.empty())
+		{
+			char f_overlay[128];
+			std::snprintf(f_overlay, sizeof(f_overlay), "p50 %.2f  p95 %.2f  p99 %.2f %s", ab::Stats::getPercentile(f_stat, 50.0),
+				ab::Stats::getPercentile(f_stat, 95.0), ab::Stats::getPercentile(f_stat, 99.0), f_stat.unit.c_str());
+			ImGui::PlotLines(f_stat.name.c_str(), f_stat.history.data(), (int)f_stat.history.size(), 0, f_overlay, 0.0f, FLT_MAX, ImVec2(0.0f, 60.0f));
+		}
+		else if (f_stat.group == "CPU" && f_hasFrame)
+		{
+			char f_overlay[128];
+			std::snprintf(f_overlay, sizeof(f_overlay), "%s %.2f ms", f_stat.name.c_str(), f_stat.value);
+			ImGui::ProgressBar((float)(f_stat.value / f_frame.value), ImVec2(-1.0f, 0.0f), f_overlay);
+		}
+		else if (f_stat.unit.empty())
+		{
+			ImGui::Text("%s: %.0f", f_stat.name.c_str(), f_stat.value);
+		}
+		else
+		{
+			ImGui::Text("%s: %.2f %s", f_stat.name.c_str(), f_stat.value, f_stat.unit.c_str());
+		}
+	}
+
+	if (ImGui::Button("DUMP STATS"))
+	{
+		bool f_written = ab::Stats::writeJson(STATS_DUMP_PATH);
+		DEBUG_MSG(std::string(f_written ? "Stats written to " : "Couldn't write ") + STATS_DUMP_PATH);
+	}
+}
+
+/// <summary>
+/// Shows the buttons for recording a camera path and replaying it as a flythrough.
+/// </summary>
+void Game::drawCameraPath()
+{
+	ImGui::Text("CAMERA PATH");
+	ImGui::Separator();
+
+	if (m_replayingPath)
+	{
+		ImGui::Text("Flythrough: %.1f / %.1f s", m_pathTimeMs / 1000.0, m_cameraPath.getDuration() / 1000.0);
+		return;
+	}
+
+	if (!m_recordingPath && ImGui::Button("RECORD PATH"))
+	{
+		m_cameraPath.clear();
+		m_cameraPath.add({ 0.0, m_camera->getEye(), m_camera->getYaw(), m_camera->getPitch() });
+		m_pathTimeMs = 0.0;
+		m_recordingPath = true;
+	}
+	else if (m_recordingPath && ImGui::Button("STOP RECORDING"))
+	{
+		m_recordingPath = false;
+		bool f_written = m_cameraPath.save(CAMERA_PATH_FILE);
+		DEBUG_MSG(std::string(f_written ? "Camera path written to " : "Couldn't write ") + CAMERA_PATH_FILE);
+	}
+
+	if (m_recordingPath)
+	{
+		ImGui::Text("Recording: %.1f s, %d keyframes", m_pathTimeMs / 1000.0, (int)m_cameraPath.getKeyframes().size());
+	}
+	else if (ImGui::Button("REPLAY PATH"))
+	{
+		startFlythrough(CAMERA_PATH_FILE, false);
+	}
+}
+
+/// <summary>
+/// Ends a flythrough: puts the frame times, hitches and the column loading and meshing latencies into the stats registry
+/// and writes it to FLYTHROUGH_RESULTS_PATH.
+/// </summary>
+void Game::finishFlythrough()
+{
+	ab::Stats::Stat f_frames = { "Flythrough", "Work time", "ms", 0.0, m_flythroughFrames };
+	int f_hitches = (int)std::count_if(m_flythroughFrames.begin(), m_flythroughFrames.end(), [](float t_workMs)
+	{
+		return t_workMs > FLYTHROUGH_HITCH_MS;
+	});
+
+	ChunkStreamer::Stats f_streamStats = m_streamer->getStats();
+	const ChunkIO::LatencyHistogram &f_meshLatency = m_remeshQueue.getLatency();
+
+	ab::Stats::set("Flythrough", "Frames", (double)m_flythroughFrames.size(), "");
+	ab::Stats::set("Flythrough", "Work time (p50)", ab::Stats::getPercentile(f_frames, 50.0), "ms");
+	ab::Stats::set("Flythrough", "Work time (p95)", ab::Stats::getPercentile(f_frames, 95.0), "ms");
+	ab::Stats::set("Flythrough", "Work time (p99)", ab::Stats::getPercentile(f_frames, 99.0), "ms");
+	ab::Stats::set("Flythrough", "Work time (max)", ab::Stats::getPercentile(f_frames, 100.0), "ms");
+	ab::Stats::set("Flythrough", "Hitches", f_hitches, "");
+	ab::Stats::set("Flythrough", "Columns loaded", (double)(f_streamStats.loaded - m_flythroughLoadedStart), "");
+	ab::Stats::set("Flythrough", "Column load latency (p50)", f_streamStats.loads.getPercentile(50.0) / 1000.0, "ms");
+	ab::Stats::set("Flythrough", "Column load latency (p99)", f_streamStats.loads.getPercentile(99.0) / 1000.0, "ms");
+	ab::Stats::set("Flythrough", "Mesh latency (p50)", f_meshLatency.getPercentile(50.0) / 1000.0, "ms");
+	ab::Stats::set("Flythrough", "Mesh latency (p99)", f_meshLatency.getPercentile(99.0) / 1000.0, "ms");
+
+	bool f_written = ab::Stats::writeJson(FLYTHROUGH_RESULTS_PATH);
+	std::cout << "Flythrough: " << m_flythroughFrames.size() << " frames, " << ab::Stats::getPercentile(f_frames, 50.0) << " ms p50, "
+		<< ab::Stats::getPercentile(f_frames, 99.0) << " ms p99, " << f_hitches << " hitches"
+		<< (f_written ? ", written to " : ", couldn't write ") << FLYTHROUGH_RESULTS_PATH << std::endl;
+
+	m_replayingPath = false;
+	m_frameClock->setLockstep(false);
+
+	if (m_exitAfterFlythrough)
+	{
+		m_looping = false;
+	}
+}
+
 /// <summary>
 /// Gets the chunk array index using a world position.
 /// </summary>
@@ -483,202 +936,254 @@ int Game::getChunkIndex(int x, int y, int z)
 }
 
 /// <summary>
-/// Adds voxel positions ALL arrays that are to be sent to the GPU.
+/// Meshes every chunk and copies the meshes to the GPU.
+/// If raytracing is on then the voxel positions are gathered for the compute shader instead.
 /// </summary>
 void Game::updateEntireMap()
 {
-	// Find out how many maps are in the world
-	int world_w = WORLD_WIDTH / MAP_WIDTH;
-	int world_h = WORLD_HEIGHT / MAP_HEIGHT;
-	int world_d = WORLD_DEPTH / MAP_DEPTH;
+	PROFILE_SCOPE("Game::updateEntireMap");
+
+	// Everything is rebuilt below, so nothing is left waiting
+	world->clearDirtyChunks();
+	m_remeshQueue.clear();
 
-	if (m_cube.instancingPositions.size() > 0)
+	if (m_raytracingOn)
 	{
-		m_cube.instancingPositions.clear();
+		m_voxelPositions.clear();
+
+		world->chunks.forEach([&](const Indices &t_position, Chunk *t_chunk)
+		{
+			for (int cZ = 0; cZ < CHUNK_DEPTH; ++cZ)
+			{
+				for (int cY = 0; cY < CHUNK_HEIGHT; ++cY)
+				{
+					for (int cX = 0; cX < CHUNK_WIDTH; ++cX)
+					{
+						if (t_chunk->getVoxel(cX, cY, cZ) == BLOCK_AIR)
+						{
+							continue;
+						}
+
+						glm::vec3 f_position((t_position.x * CHUNK_WIDTH) + cX, (t_position.y * CHUNK_HEIGHT) + cY, (t_position.z * CHUNK_DEPTH) + cZ);
+						m_voxelPositions.push_back(glm::vec4(f_position, 1));
+					}
+				}
+			}
+		});
+
+		return;
 	}
 
-	if (m_waterBlock.instancingPositions.size() > 0)
+	// Remove meshes for chunks that no longer exist
+	std::vector<Indices> f_removed;
+
+	for (const auto &f_pair : m_chunkMeshes)
 	{
-		m_waterBlock.instancingPositions.clear();
+		if (world->chunks.find(f_pair.first) == nullptr)
+		{
+			f_removed.push_back(f_pair.first);
+		}
 	}
 
-	if (m_treeBlock.instancingPositions.size() > 0)
+	for (const Indices &f_position : f_removed)
 	{
-		m_treeBlock.instancingPositions.clear();
+		deleteChunkMesh(f_position);
 	}
 
-	if (m_leafBlock.instancingPositions.size() > 0)
+	std::vector<Indices> f_positions;
+
+	world->chunks.forEach([&](const Indices &t_position, Chunk *t_chunk)
 	{
-		m_leafBlock.instancingPositions.clear();
-	}
+		f_positions.push_back(t_position);
+	});
 
-	for (int wZ = 0; wZ < world_d; ++wZ)
+	// Mesh the chunks in batches on every core, then upload each batch on this thread (OpenGL isn't thread safe)
+	const int f_batchSize = 1024;
+	std::vector<std::vector<PackedVertex>> f_meshes(f_batchSize);
+
+	for (int f_batchStart = 0; f_batchStart < (int)f_positions.size(); f_batchStart += f_batchSize)
 	{
-		for (int wY = 0; wY < world_h; ++wY)
+		int f_batchEnd = std::min(f_batchStart + f_batchSize, (int)f_positions.size());
+
+		m_jobs->parallelFor(f_batchStart, f_batchEnd, 16, [&](int t_begin, int t_end)
 		{
-			for (int wX = 0; wX < world_w; ++wX)
+			for (int i = t_begin; i < t_end; ++i)
 			{
-				if (world->maps[Utility::at(wX, wY, wZ, world_h, world_d)] == nullptr) // Don't check empty maps
-				{
-					continue;
-				}
-				else
-				{
-					for (int mZ = 0; mZ < MAP_WIDTH / CHUNK_WIDTH; ++mZ)
-					{
-						for (int mY = 0; mY < MAP_HEIGHT / CHUNK_HEIGHT; ++mY)
-						{
-							for (int mX = 0; mX < MAP_DEPTH / CHUNK_DEPTH; ++mX)
-							{
-								if (world->maps[Utility::at(wX, wY, wZ, world_h, world_d)]->chunks[Utility::at(mX, mY, mZ, MAP_HEIGHT / CHUNK_HEIGHT, MAP_DEPTH / CHUNK_DEPTH)] == nullptr) // Don't check empty chunks
-								{
-									continue;
-								}
-								else
-								{
-									for (int cZ = 0; cZ < CHUNK_DEPTH; ++cZ)
-									{
-										for (int cY = 0; cY < CHUNK_HEIGHT; ++cY)
-										{
-											for (int cX = 0; cX < CHUNK_WIDTH; ++cX)
-											{
-												char *voxel = &world->maps[Utility::at(wX, wY, wZ, world_h, world_d)]->chunks[Utility::at(mX, mY, mZ, MAP_HEIGHT / CHUNK_HEIGHT, MAP_DEPTH / CHUNK_DEPTH)]->voxels[Utility::at(cX, cY, cZ, CHUNK_HEIGHT, CHUNK_DEPTH)];
-
-												if (*voxel == 0) // Air
-												{
-													continue; // Break from current loop if voxel is air
-												}
-
-												if (*voxel == 1) // Grass
-												{
-													if (m_raytracingOn)
-													{
-														m_voxelPositions.push_back(glm::vec4((wX * MAP_WIDTH) + (mX * CHUNK_WIDTH) + cX, (wY * MAP_HEIGHT) + (mY * CHUNK_HEIGHT) + cY, (wZ * MAP_DEPTH) + (mZ * CHUNK_DEPTH) + cZ, 1));
-													}				
-													else
-													{
-														m_cube.instancingPositions.push_back(glm::translate(glm::mat4(1.0f), glm::vec3((wX * MAP_WIDTH) + (mX * CHUNK_WIDTH) + cX, (wY * MAP_HEIGHT) + (mY * CHUNK_HEIGHT) + cY, (wZ * MAP_DEPTH) + (mZ * CHUNK_DEPTH) + cZ)));
-													}
-												}
-												else if (*voxel == 2) // Water
-												{
-													if (m_raytracingOn)
-													{
-														m_voxelPositions.push_back(glm::vec4((wX * MAP_WIDTH) + (mX * CHUNK_WIDTH) + cX, (wY * MAP_HEIGHT) + (mY * CHUNK_HEIGHT) + cY, (wZ * MAP_DEPTH) + (mZ * CHUNK_DEPTH) + cZ, 1));
-													}
-													else
-													{
-														m_waterBlock.instancingPositions.push_back(glm::translate(glm::mat4(1.0f), glm::vec3((wX * MAP_WIDTH) + (mX * CHUNK_WIDTH) + cX, (wY * MAP_HEIGHT) + (mY * CHUNK_HEIGHT) + cY, (wZ * MAP_DEPTH) + (mZ * CHUNK_DEPTH) + cZ)));
-													}
-												}
-												else if (*voxel == 3) // Tree
-												{									
-													if (m_raytracingOn)
-													{
-														m_voxelPositions.push_back(glm::vec4((wX * MAP_WIDTH) + (mX * CHUNK_WIDTH) + cX, (wY * MAP_HEIGHT) + (mY * CHUNK_HEIGHT) + cY, (wZ * MAP_DEPTH) + (mZ * CHUNK_DEPTH) + cZ, 1));
-													}
-													else
-													{
-														m_treeBlock.instancingPositions.push_back(glm::translate(glm::mat4(1.0f), glm::vec3((wX * MAP_WIDTH) + (mX * CHUNK_WIDTH) + cX, (wY * MAP_HEIGHT) + (mY * CHUNK_HEIGHT) + cY, (wZ * MAP_DEPTH) + (mZ * CHUNK_DEPTH) + cZ)));
-													}
-												}
-												else if (*voxel == 4) // Leaf
-												{												
-													if (m_raytracingOn)
-													{
-														m_voxelPositions.push_back(glm::vec4((wX * MAP_WIDTH) + (mX * CHUNK_WIDTH) + cX, (wY * MAP_HEIGHT) + (mY * CHUNK_HEIGHT) + cY, (wZ * MAP_DEPTH) + (mZ * CHUNK_DEPTH) + cZ, 1));
-													}
-													else
-													{
-														m_leafBlock.instancingPositions.push_back(glm::translate(glm::mat4(1.0f), glm::vec3((wX * MAP_WIDTH) + (mX * CHUNK_WIDTH) + cX, (wY * MAP_HEIGHT) + (mY * CHUNK_HEIGHT) + cY, (wZ * MAP_DEPTH) + (mZ * CHUNK_DEPTH) + cZ)));
-													}
-												}
-											}
-										}
-									}
-								}
-							}
-						}
-					}
-				}
+				Mesher::meshChunk(*world, f_positions[i], f_meshes[i - f_batchStart], (Mesher::MeshMode)m_meshMode);
 			}
+		});
+
+		for (int i = f_batchStart; i < f_batchEnd; ++i)
+		{
+			uploadChunkMesh(f_positions[i], f_meshes[i - f_batchStart]);
 		}
 	}
+}
 
-	m_instanceArrayUpdated = true;
+/// <summary>
+/// Creates the element buffer shared by all chunk meshes.
+/// Every chunk mesh is a list of quads (4 vertices each), so the indices are always the same.
+/// </summary>
+void Game::createQuadElementBuffer()
+{
+	// Naive meshes can have more than 65536 vertices, so 32-bit indices are needed
+	std::vector<GLuint> f_indices(Mesher::MAX_QUADS * 6);
+
+	for (int i = 0; i < Mesher::MAX_QUADS; ++i)
+	{
+		GLuint f_first = (GLuint)(i * 4);
+
+		f_indices[i * 6 + 0] = f_first;
+		f_indices[i * 6 + 1] = f_first + 1;
+		f_indices[i * 6 + 2] = f_first + 2;
+		f_indices[i * 6 + 3] = f_first + 2;
+		f_indices[i * 6 + 4] = f_first + 3;
+		f_indices[i * 6 + 5] = f_first;
+	}
+
+	glGenBuffers(1, &m_quadElementBufferID);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_quadElementBufferID);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, f_indices.size() * sizeof(GLuint), &f_indices[0], GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	ab::Stats::set("GPU", "Quad index buffer", f_indices.size() * sizeof(GLuint) / (1024.0 * 1024.0), "MB");
 }
 
 /// <summary>
-/// Gets the chunk [x, y, z] positions in the array from a world position.
+/// Meshes a chunk and copies the mesh to the GPU.
+/// The mesh is deleted if the chunk no longer exists or has nothing to draw.
 /// </summary>
-/// <param name="x">X</param>
-/// <param name="y">Y</param>
-/// <param name="z">Z</param>
-/// <returns>An index value.</returns>
-Indices Game::getChunkXYZ(int x, int y, int z)
+/// <param name="t_position">The chunk position.</param>
+void Game::updateChunkMesh(const Indices &t_position)
 {
-	Indices indices;
+	PROFILE_SCOPE("Game::updateChunkMesh");
 
-	indices.x = std::floor(x / 16);
-	indices.y = std::floor(y / 16);
-	indices.z = std::floor(z / 16);
+	if (world->chunks.find(t_position) == nullptr)
+	{
+		deleteChunkMesh(t_position);
+		return;
+	}
 
-	return indices;
+	Mesher::meshChunk(*world, t_position, m_meshVertices, (Mesher::MeshMode)m_meshMode);
+	uploadChunkMesh(t_position, m_meshVertices);
 }
 
 /// <summary>
-/// Used for mouse interaction with voxels.
+/// Copies a chunk's mesh to the GPU, or deletes the chunk's mesh if there's nothing to draw.
 /// </summary>
-/// <param name="t_origin">The origin point (the current mouse position).</param>
-/// <param name="t_direction">The ray direction.</param>
-/// <param name="t_hitPoint">The coordinates of the voxel that was hit with the ray.</param>
-/// <returns>True if an intersection was found.</returns>
-bool Game::checkForVoxelIntersections(glm::vec3 t_origin, glm::vec3 t_direction, glm::vec3& t_hitPoint)
+/// <param name="t_position">The chunk position.</param>
+/// <param name="t_vertices">The mesh from Mesher::meshChunk().</param>
+void Game::uploadChunkMesh(const Indices &t_position, const std::vector<PackedVertex> &t_vertices)
 {
-	// Only check neighbouring chunks for intersections
-	glm::vec3 worldPosition = m_camera->getEye();
+	if (t_vertices.empty())
+	{
+		deleteChunkMesh(t_position);
+		return;
+	}
 
-	// This is the chunk to start checking at
-	Indices chunkStart = getChunkXYZ(worldPosition.x, worldPosition.y, worldPosition.z);
+	auto f_found = m_chunkMeshes.find(t_position);
 
-	// Set chunk starting point [x, y, z]
-	chunkStart.x--;
-	chunkStart.y--;
-	chunkStart.z--;
+	if (f_found == m_chunkMeshes.end())
+	{
+		ChunkMesh f_mesh;
 
-	// Get chunk map array dimensions
-	int map_w = MAP_WIDTH / CHUNK_WIDTH;
-	int map_d = MAP_DEPTH / CHUNK_DEPTH;
-	
-	// Check all the immediate chunks around you (including the one you're in)
-	//for (int z = 0; z < 3; ++z)
-	//{
-	//	for (int y = 0; y < 3; ++y)
-	//	{
-	//		for (int x = 0; x < 3; ++x)
-	//		{
-	//			int index = Utility::at(chunkStart.x + x, chunkStart.y + y, chunkStart.z + z, map_w, map_d);
-
-	//			if (index < 0 || index > map->chunks.size())
-	//			{
-	//				continue; // If chunk is out of bounds then go to next iteration
-	//			}
-
-	//			// If chunk is a null pointer then the chunk is air (and also doesn't exist)
-	//			if (map->chunks[index] != nullptr)
-	//			{
-	//				Indices chunkIndex = { chunkStart.x + x, chunkStart.y + y, chunkStart.z + z };
-
-	//				if (map->chunks[index]->checkAllCubesIntersect(t_origin, t_direction, chunkIndex, m_hitInfo))
-	//				{
-	//					return true;
-	//				}
-	//			}
-	//		}
-	//	}
-	//}
-
-	return false;
+		// This VAO stores all draw states below
+		glGenVertexArrays(1, &f_mesh.vertexArrayObjectID);
+		glBindVertexArray(f_mesh.vertexArrayObjectID);
+
+		glGenBuffers(1, &f_mesh.vertexBufferID);
+		glBindBuffer(GL_ARRAY_BUFFER, f_mesh.vertexBufferID);
+
+		// Each vertex is a single packed integer, the vertex shader unpacks it
+		glEnableVertexAttribArray(0);
+		glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(PackedVertex), (void*)0);
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_quadElementBufferID);
+
+		f_found = m_chunkMeshes.emplace(t_position, f_mesh).first;
+	}
+	else
+	{
+		glBindVertexArray(f_found->second.vertexArrayObjectID);
+		glBindBuffer(GL_ARRAY_BUFFER, f_found->second.vertexBufferID);
+		m_meshBytes -= f_found->second.quadCount * 4 * sizeof(PackedVertex);
+	}
+
+	glBufferData(GL_ARRAY_BUFFER, t_vertices.size() * sizeof(PackedVertex), &t_vertices[0], GL_STATIC_DRAW);
+	f_found->second.quadCount = (GLsizei)(t_vertices.size() / 4);
+	m_meshBytes += f_found->second.quadCount * 4 * sizeof(PackedVertex);
+
+	glBindVertexArray(0);
+}
+
+/// <summary>
+/// Deletes a chunk's mesh from the GPU (if it has one).
+/// </summary>
+/// <param name="t_position">The chunk position.</param>
+void Game::deleteChunkMesh(const Indices &t_position)
+{
+	auto f_found = m_chunkMeshes.find(t_position);
+
+	if (f_found == m_chunkMeshes.end())
+	{
+		return;
+	}
+
+	glDeleteBuffers(1, &f_found->second.vertexBufferID);
+	glDeleteVertexArrays(1, &f_found->second.vertexArrayObjectID);
+	m_meshBytes -= f_found->second.quadCount * 4 * sizeof(PackedVertex);
+	m_chunkMeshes.erase(f_found);
+}
+
+/// <summary>
+/// Casts a ray from the camera through the mouse position to find the voxel under the mouse.
+/// The result is stored in m_raycastHit.
+/// </summary>
+/// <returns>True if a voxel is under the mouse.</returns>
+bool Game::pickVoxel()
+{
+	m_rayDirection = m_camera->getRayFromMousePos(m_mousePos.x, m_mousePos.y);
+
+	if (!world->raycast(m_camera->getEye(), m_rayDirection, PICK_DISTANCE, m_raycastHit))
+	{
+		return false;
+	}
+
+	m_selectedCube = glm::vec4(m_raycastHit.voxel.x, m_raycastHit.voxel.y, m_raycastHit.voxel.z, m_raycastHit.type);
+
+	return true;
+}
+
+/// <summary>
+/// Creates the tree that the middle mouse button plants, a trunk with a pointy top like the generated trees.
+/// The trunk is in the middle of the template's bottom row and the rest of the template is air.
+/// </summary>
+void Game::createTreeTemplate()
+{
+	const int f_trunkHeight = ab::Terrain::TREE_MIN_HEIGHT + 2;
+	const int f_top = ab::Terrain::TREE_MIN_TOP;
+
+	m_treeTemplate.width = 2 * f_top + 1;
+	m_treeTemplate.height = f_trunkHeight + f_top + 1;
+	m_treeTemplate.depth = 2 * f_top + 1;
+	m_treeTemplate.voxels.assign(m_treeTemplate.width * m_treeTemplate.height * m_treeTemplate.depth, BLOCK_AIR);
+
+	for (int y = 0; y < f_trunkHeight; ++y)
+	{
+		m_treeTemplate.voxels[Utility::at(f_top, y, f_top, m_treeTemplate.height, m_treeTemplate.depth)] = BLOCK_TREE;
+	}
+
+	// Each layer of leaves is one voxel smaller on every side than the one below it
+	for (int i = 0; i <= f_top; ++i)
+	{
+		for (int x = i; x < m_treeTemplate.width - i; ++x)
+		{
+			for (int z = i; z < m_treeTemplate.depth - i; ++z)
+			{
+				m_treeTemplate.voxels[Utility::at(x, f_trunkHeight + i, z, m_treeTemplate.height, m_treeTemplate.depth)] = BLOCK_LEAF;
+			}
+		}
+	}
 }
 
 /// <summary>
@@ -709,10 +1214,11 @@ void Game::initialiseRaytracing()
 /// </summary>
 void Game::raytrace()
 {
+	PROFILE_SCOPE("Game::raytrace");
 	glUseProgram(m_computeShader->m_programID);
 
 	// Set viewing frustum corner rays in shader
-	ab::OpenGL::uniform3f(*m_computeShader, "eye", m_camera->getEye().x, m_camera->getEye().y, m_camera->getEye().z);	
+	ab::OpenGL::uniform3f(*m_computeShader, "eye", m_renderEye.x, m_renderEye.y, m_renderEye.z);	
 
 	m_camera->getEyeRay(-1, -1, m_eyeRay);
 	ab::OpenGL::uniform3f(*m_computeShader, "ray00", m_eyeRay.x, m_eyeRay.y, m_eyeRay.z);
@@ -768,6 +1274,7 @@ void Game::renderTextureToQuad(GLuint &t_textureID)
 
 	// Draw
 	glDrawArrays(GL_TRIANGLES, 0, 6);
+	m_drawCalls++;
 
 	// Disable vertex attribute array
 	glDisableVertexAttribArray(0);
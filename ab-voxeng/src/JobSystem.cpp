@@ -0,0 +1,457 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <algorithm>
+
+// A single job
+struct ab::JobSystem::Job
+{
+	std::function<void()> function;
+	std::atomic<int> waitingFor; // Unfinished dependencies (plus one while the job is being added)
+	std::atomic<bool> finished;
+	bool mainThread;
+
+	std::mutex mutex; // Guards the continuations
+	std::vector<JobHandle> continuations; // Jobs that depend on this one
+};
+
+namespace
+{
+	// The job system and queue that the current thread works for (if it's a worker)
+	thread_local const ab::JobSystem *s_owner = nullptr;
+	thread_local int s_queueIndex = -1;
+}
+
+/// <summary>
+/// Constructor for the JobSystem class.
+/// </summary>
+/// <param name="t_workerCount">[OPTIONAL] The number of worker threads, by default there's one for every core except the main thread's.</param>
+ab::JobSystem::JobSystem(int t_workerCount)
+{
+	if (t_workerCount < 0)
+	{
+		t_workerCount = getDefaultWorkerCount();
+	}
+
+	m_mainThreadID = std::this_thread::get_id();
+	m_nextQueue = 0;
+	m_queued = 0;
+	m_sleeping = 0;
+	m_stopping = false;
+	m_executed = 0;
+	m_stolen = 0;
+
+	for (int i = 0; i <= t_workerCount; ++i)
+	{
+		m_queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+	}
+
+	for (int i = 0; i < t_workerCount; ++i)
+	{
+		m_workers.push_back(std::thread(&JobSystem::workerLoop, this, i));
+	}
+}
+
+/// <summary>
+/// Destructor for the JobSystem class.
+/// Workers finish the job they're running and then stop, jobs that haven't started are dropped.
+/// </summary>
+ab::JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> f_lock(m_wakeMutex);
+		m_stopping = true;
+	}
+
+	m_wake.notify_all();
+
+	for (std::thread &f_worker : m_workers)
+	{
+		f_worker.join();
+	}
+}
+
+/// <summary>
+/// Adds a job that can run on any thread.
+/// </summary>
+/// <param name="t_function">The work to do.</param>
+/// <param name="t_dependencies">[OPTIONAL] Jobs that have to finish before this one starts.</param>
+/// <returns>A handle to the new job.</returns>
+ab::JobSystem::JobHandle ab::JobSystem::add(const std::function<void()> &t_function, const std::vector<JobHandle> &t_dependencies)
+{
+	return create(t_function, t_dependencies, false);
+}
+
+/// <summary>
+/// Adds a job that can only run on the main thread (e.g. uploading data to OpenGL).
+/// It runs during pump() or wait() on the main thread once its dependencies have finished.
+/// </summary>
+/// <param name="t_function">The work to do.</param>
+/// <param name="t_dependencies">[OPTIONAL] Jobs that have to finish before this one starts.</param>
+/// <returns>A handle to the new job.</returns>
+ab::JobSystem::JobHandle ab::JobSystem::addMainThread(const std::function<void()> &t_function, const std::vector<JobHandle> &t_dependencies)
+{
+	return create(t_function, t_dependencies, true);
+}
+
+/// <summary>
+/// Waits for a job to finish. The calling thread runs other jobs while it waits.
+/// </summary>
+/// <param name="t_job">The job to wait for.</param>
+void ab::JobSystem::wait(const JobHandle &t_job)
+{
+	bool f_mainThread = isMainThread();
+
+	while (!isFinished(t_job))
+	{
+		JobHandle f_job;
+
+		if (f_mainThread && runMainThreadJob())
+		{
+			continue;
+		}
+
+		if (takeJob(f_job))
+		{
+			execute(f_job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+/// <summary>
+/// Waits for a number of jobs to finish. The calling thread runs other jobs while it waits.
+/// </summary>
+/// <param name="t_jobs">The jobs to wait for.</param>
+void ab::JobSystem::wait(const std::vector<JobHandle> &t_jobs)
+{
+	for (const JobHandle &f_job : t_jobs)
+	{
+		wait(f_job);
+	}
+}
+
+/// <summary>
+/// Splits a range into jobs of (at most) t_grainSize items and waits for them all to finish.
+/// </summary>
+/// <param name="t_begin">The first item.</param>
+/// <param name="t_end">One past the last item.</param>
+/// <param name="t_grainSize">The number of items in each job.</param>
+/// <param name="t_function">Called with the first item and one past the last item of each job.</param>
+void ab::JobSystem::parallelFor(int t_begin, int t_end, int t_grainSize, const std::function<void(int, int)> &t_function)
+{
+	t_grainSize = std::max(t_grainSize, 1);
+
+	std::vector<JobHandle> f_jobs;
+	f_jobs.reserve((t_end - t_begin + t_grainSize - 1) / t_grainSize);
+
+	for (int f_start = t_begin; f_start < t_end; f_start += t_grainSize)
+	{
+		int f_finish = std::min(f_start + t_grainSize, t_end);
+
+		f_jobs.push_back(add([f_start, f_finish, &t_function]()
+		{
+			t_function(f_start, f_finish);
+		}));
+	}
+
+	wait(f_jobs);
+}
+
+/// <summary>
+/// Runs the main thread jobs that are ready. Call this once a frame from the main thread.
+/// </summary>
+/// <returns>The number of jobs that were run.</returns>
+int ab::JobSystem::pump()
+{
+	PROFILE_SCOPE("JobSystem::pump");
+	int f_count = 0;
+
+	while (runMainThreadJob())
+	{
+		f_count++;
+	}
+
+	return f_count;
+}
+
+/// <summary>
+/// Checks if a job has finished.
+/// </summary>
+/// <param name="t_job">The job (an empty handle counts as finished).</param>
+/// <returns>True if the job has finished.</returns>
+bool ab::JobSystem::isFinished(const JobHandle &t_job) const
+{
+	return t_job == nullptr || t_job->finished.load();
+}
+
+/// <summary>
+/// Checks if the calling thread is the main thread (the one that created the job system).
+/// </summary>
+/// <returns>True if this is the main thread.</returns>
+bool ab::JobSystem::isMainThread() const
+{
+	return std::this_thread::get_id() == m_mainThreadID;
+}
+
+/// <summary>
+/// Gets the number of worker threads.
+/// </summary>
+/// <returns>The number of workers (not counting the main thread).</returns>
+int ab::JobSystem::getWorkerCount() const
+{
+	return (int)m_workers.size();
+}
+
+/// <summary>
+/// Gets the number of jobs run and stolen so far.
+/// </summary>
+/// <returns>The statistics.</returns>
+ab::JobSystem::Stats ab::JobSystem::getStats() const
+{
+	return { m_executed.load(), m_stolen.load() };
+}
+
+/// <summary>
+/// Gets the default number of worker threads, one for every core except the main thread's.
+/// </summary>
+/// <returns>The number of workers.</returns>
+int ab::JobSystem::getDefaultWorkerCount()
+{
+	int f_cores = (int)std::thread::hardware_concurrency();
+	return std::max(f_cores - 1, 0);
+}
+
+/// <summary>
+/// Creates a job and schedules it once its dependencies have finished.
+/// </summary>
+/// <param name="t_function">The work to do.</param>
+/// <param name="t_dependencies">Jobs that have to finish first.</param>
+/// <param name="t_mainThread">True if the job can only run on the main thread.</param>
+/// <returns>A handle to the new job.</returns>
+ab::JobSystem::JobHandle ab::JobSystem::create(const std::function<void()> &t_function, const std::vector<JobHandle> &t_dependencies, bool t_mainThread)
+{
+	JobHandle f_job = std::make_shared<Job>();
+	f_job->function = t_function;
+	f_job->waitingFor = 1; // Stops the job starting before all of its dependencies have been added
+	f_job->finished = false;
+	f_job->mainThread = t_mainThread;
+
+	for (const JobHandle &f_dependency : t_dependencies)
+	{
+		if (f_dependency == nullptr)
+		{
+			continue;
+		}
+
+		std::lock_guard<std::mutex> f_lock(f_dependency->mutex);
+
+		if (!f_dependency->finished)
+		{
+			f_dependency->continuations.push_back(f_job);
+			f_job->waitingFor++;
+		}
+	}
+
+	release(f_job);
+
+	return f_job;
+}
+
+/// <summary>
+/// Marks one of a job's dependencies as finished, and schedules the job if it was the last one.
+/// </summary>
+/// <param name="t_job">The job.</param>
+void ab::JobSystem::release(const JobHandle &t_job)
+{
+	if (--t_job->waitingFor == 0)
+	{
+		schedule(t_job);
+	}
+}
+
+/// <summary>
+/// Puts a job that's ready to run into a queue.
+/// Workers add jobs to their own queue, other threads spread their jobs across all of the queues.
+/// </summary>
+/// <param name="t_job">The job.</param>
+void ab::JobSystem::schedule(const JobHandle &t_job)
+{
+	if (t_job->mainThread)
+	{
+		std::lock_guard<std::mutex> f_lock(m_mainThreadQueue.mutex);
+		m_mainThreadQueue.jobs.push_back(t_job);
+		return;
+	}
+
+	int f_index = getQueueIndex();
+
+	if (f_index < 0)
+	{
+		f_index = (int)(m_nextQueue++ % m_queues.size());
+	}
+
+	{
+		std::lock_guard<std::mutex> f_lock(m_queues[f_index]->mutex);
+		m_queues[f_index]->jobs.push_back(t_job);
+	}
+
+	m_queued++;
+
+	// Only take the lock if someone might be asleep
+	if (m_sleeping > 0)
+	{
+		std::lock_guard<std::mutex> f_lock(m_wakeMutex);
+		m_wake.notify_one();
+	}
+}
+
+/// <summary>
+/// Takes the next job for the calling thread: the newest job from its own queue, or else
+/// the oldest job from another queue.
+/// </summary>
+/// <param name="t_job">Set to the job.</param>
+/// <returns>True if a job was found.</returns>
+bool ab::JobSystem::takeJob(JobHandle &t_job)
+{
+	int f_home = getQueueIndex();
+	int f_count = (int)m_queues.size();
+
+	if (f_home >= 0)
+	{
+		WorkQueue &f_queue = *m_queues[f_home];
+		std::lock_guard<std::mutex> f_lock(f_queue.mutex);
+
+		if (!f_queue.jobs.empty())
+		{
+			t_job = std::move(f_queue.jobs.back());
+			f_queue.jobs.pop_back();
+			m_queued--;
+			return true;
+		}
+	}
+
+	// Steal, starting with the queue after our own so thieves spread out
+	for (int i = 1; i <= f_count; ++i)
+	{
+		int f_index = (f_home + i + f_count) % f_count;
+
+		if (f_index == f_home)
+		{
+			continue;
+		}
+
+		WorkQueue &f_queue = *m_queues[f_index];
+		std::lock_guard<std::mutex> f_lock(f_queue.mutex);
+
+		if (!f_queue.jobs.empty())
+		{
+			t_job = std::move(f_queue.jobs.front());
+			f_queue.jobs.pop_front();
+			m_queued--;
+			m_stolen++;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/// <summary>
+/// Runs the oldest main thread job, if there is one. Only call this from the main thread.
+/// </summary>
+/// <returns>True if a job was run.</returns>
+bool ab::JobSystem::runMainThreadJob()
+{
+	JobHandle f_job;
+
+	{
+		std::lock_guard<std::mutex> f_lock(m_mainThreadQueue.mutex);
+
+		if (m_mainThreadQueue.jobs.empty())
+		{
+			return false;
+		}
+
+		f_job = std::move(m_mainThreadQueue.jobs.front());
+		m_mainThreadQueue.jobs.pop_front();
+	}
+
+	execute(f_job);
+
+	return true;
+}
+
+/// <summary>
+/// Runs a job, marks it as finished and releases the jobs that depend on it.
+/// </summary>
+/// <param name="t_job">The job.</param>
+void ab::JobSystem::execute(const JobHandle &t_job)
+{
+	if (t_job->function)
+	{
+		PROFILE_SCOPE("Job");
+		t_job->function();
+	}
+
+	// Drop the function straight away so anything it captured is freed
+	t_job->function = nullptr;
+
+	std::vector<JobHandle> f_continuations;
+
+	{
+		std::lock_guard<std::mutex> f_lock(t_job->mutex);
+		t_job->finished = true;
+		f_continuations.swap(t_job->continuations);
+	}
+
+	m_executed++;
+
+	for (const JobHandle &f_continuation : f_continuations)
+	{
+		release(f_continuation);
+	}
+}
+
+/// <summary>
+/// The loop each worker thread runs until the job system is destroyed.
+/// </summary>
+/// <param name="t_index">The worker's queue index.</param>
+void ab::JobSystem::workerLoop(int t_index)
+{
+	s_owner = this;
+	s_queueIndex = t_index;
+	PROFILE_THREAD("Worker " + std::to_string(t_index));
+
+	while (!m_stopping)
+	{
+		JobHandle f_job;
+
+		if (takeJob(f_job))
+		{
+			execute(f_job);
+			continue;
+		}
+
+		// Nothing to do, sleep until a job is added
+		std::unique_lock<std::mutex> f_lock(m_wakeMutex);
+		m_sleeping++;
+		m_wake.wait(f_lock, [this]() { return m_queued > 0 || m_stopping; });
+		m_sleeping--;
+	}
+
+	s_owner = nullptr;
+	s_queueIndex = -1;
+}
+
+/// <summary>
+/// Gets the calling thread's own queue.
+/// </summary>
+/// <returns>The queue index, or -1 if the calling thread isn't one of this job system's workers.</returns>
+int ab::JobSystem::getQueueIndex() const
+{
+	return s_owner == this ? s_queueIndex : -1;
+}
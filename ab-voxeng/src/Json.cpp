@@ -0,0 +1,52 @@
+#include "Json.h"
+
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+
+/// <summary>
+/// Writes a string as a JSON string literal.
+/// </summary>
+/// <param name="t_stream">The stream to write to.</param>
+/// <param name="t_string">The string.</param>
+void ab::Json::writeString(std::ostream &t_stream, const std::string &t_string)
+{
+	t_stream << '"';
+
+	for (char f_char : t_string)
+	{
+		if (f_char == '"' || f_char == '\\')
+		{
+			t_stream << '\\' << f_char;
+		}
+		else if ((unsigned char)f_char < 0x20)
+		{
+			char f_escape[7];
+			std::snprintf(f_escape, sizeof(f_escape), "\\u%04x", f_char);
+			t_stream << f_escape;
+		}
+		else
+		{
+			t_stream << f_char;
+		}
+	}
+
+	t_stream << '"';
+}
+
+/// <summary>
+/// Writes a number as a JSON number (JSON has no infinity or NaN, so they're written as null).
+/// </summary>
+/// <param name="t_stream">The stream to write to.</param>
+/// <param name="t_value">The number.</param>
+void ab::Json::writeNumber(std::ostream &t_stream, double t_value)
+{
+	if (std::isfinite(t_value))
+	{
+		t_stream << std::setprecision(6) << std::fixed << t_value;
+	}
+	else
+	{
+		t_stream << "null";
+	}
+}
@@ -6,6 +6,8 @@
 #include "Game.h"
 #include "SDL.h"
 
+#include <cstring>
+
 int main(int argc, char *argv[])
 {
 	// Initialise SDL here because it needs to be done BEFORE creating the window and renderer
@@ -18,6 +20,27 @@ int main(int argc, char *argv[])
 
 	// Create Game object and start the game loop
 	Game *m_game = new Game(1280, 720);
+
+	// --uncapped turns the frame rate cap off, for benchmarking
+	// --flythrough [path] replays a recorded camera path (CAMERA_PATH_FILE by default), writes the results and exits
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--uncapped") == 0)
+		{
+			m_game->setUncapped(true);
+		}
+		else if (std::strcmp(argv[i], "--flythrough") == 0)
+		{
+			const char *f_path = i + 1 < argc && std::strncmp(argv[i + 1], "--", 2) != 0 ? argv[++i] : CAMERA_PATH_FILE;
+
+			if (!m_game->startFlythrough(f_path, true))
+			{
+				delete m_game;
+				return -1;
+			}
+		}
+	}
+
 	m_game->start();
 
 	// Delete Game object before exiting
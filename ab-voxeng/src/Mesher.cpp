@@ -0,0 +1,447 @@
+#include "Mesher.h"
+
+#include <cstring>
+
+namespace
+{
+	// For each face: the axis it faces along, which way it faces, and the two axes
+	// that run across it (used for the quad's corners and texture coordinates)
+	const int FACE_AXIS[6] = { 0, 0, 1, 1, 2, 2 };
+	const int FACE_DIRECTION[6] = { 1, -1, 1, -1, 1, -1 };
+	const int FACE_S_AXIS[6] = { 2, 2, 0, 0, 0, 0 };
+	const int FACE_T_AXIS[6] = { 1, 1, 2, 2, 1, 1 };
+
+	// Faces where (s, t) would wind clockwise when viewed from outside, so their corners are reversed
+	const bool FACE_REVERSED[6] = { true, false, true, false, false, true };
+
+	// Offset to the neighbouring voxel for each face in the padded array
+	const int FACE_OFFSET[6] =
+	{
+		Mesher::PADDED_HEIGHT * Mesher::PADDED_DEPTH,
+		-Mesher::PADDED_HEIGHT * Mesher::PADDED_DEPTH,
+		Mesher::PADDED_DEPTH,
+		-Mesher::PADDED_DEPTH,
+		1,
+		-1
+	};
+
+	// Distance between neighbouring voxels along each axis in the padded array
+	const int AXIS_STRIDE[3] = { Mesher::PADDED_HEIGHT * Mesher::PADDED_DEPTH, Mesher::PADDED_DEPTH, 1 };
+
+	// The corners of a face in (s, t), ambient occlusion values are stored in this order
+	const int CORNERS[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+
+	/// <summary>
+	/// Adds a quad covering t_width x t_height voxel faces, starting at voxel (x, y, z).
+	/// The quad's diagonal is chosen so that ambient occlusion is interpolated evenly.
+	/// </summary>
+	void addQuad(std::vector<PackedVertex> &t_vertices, int t_face, int x, int y, int z, int t_width, int t_height, char t_type, int t_ao)
+	{
+		// Indices into CORNERS, wound anticlockwise when viewed from outside
+		static const int f_order[2][4] =
+		{
+			{ 0, 1, 2, 3 },
+			{ 0, 3, 2, 1 }
+		};
+
+		const int f_voxel[3] = { x, y, z };
+		int f_axis = FACE_AXIS[t_face];
+		int f_s = FACE_S_AXIS[t_face];
+		int f_t = FACE_T_AXIS[t_face];
+
+		MeshVertex f_vertices[4];
+
+		for (int i = 0; i < 4; ++i)
+		{
+			int f_cornerIndex = f_order[FACE_REVERSED[t_face]][i];
+			const int *f_corner = CORNERS[f_cornerIndex];
+			int f_position[3];
+
+			// Voxel (x, y, z) spans x to x + 1 (and so on) in corner positions
+			f_position[f_axis] = f_voxel[f_axis] + (FACE_DIRECTION[t_face] > 0 ? 1 : 0);
+			f_position[f_s] = f_voxel[f_s] + f_corner[0] * t_width;
+			f_position[f_t] = f_voxel[f_t] + f_corner[1] * t_height;
+
+			f_vertices[i].x = f_position[0];
+			f_vertices[i].y = f_position[1];
+			f_vertices[i].z = f_position[2];
+			f_vertices[i].face = t_face;
+			f_vertices[i].ao = (t_ao >> (f_cornerIndex * 2)) & 3;
+			f_vertices[i].layer = t_type - 1;
+		}
+
+		// The index buffer splits each quad along 0-2, start one corner later to split along 1-3 instead
+		int f_start = f_vertices[0].ao + f_vertices[2].ao < f_vertices[1].ao + f_vertices[3].ao ? 1 : 0;
+
+		for (int i = 0; i < 4; ++i)
+		{
+			t_vertices.push_back(Mesher::packVertex(f_vertices[(f_start + i) & 3]));
+		}
+	}
+
+	/// <summary>
+	/// Checks if a voxel darkens the corners next to it.
+	/// </summary>
+	bool isOccluder(char t_type)
+	{
+		return !BLOCK_TRANSPARENT[(int)t_type];
+	}
+}
+
+/// <summary>
+/// Builds the mesh for a chunk.
+/// </summary>
+/// <param name="t_world">The world the chunk is in.</param>
+/// <param name="t_chunkPosition">The chunk position.</param>
+/// <param name="t_vertices">The mesh's vertices are written here (4 for each quad).</param>
+/// <param name="t_mode">[OPTIONAL] The meshing mode, greedy is used by default.</param>
+void Mesher::meshChunk(World &t_world, const Indices &t_chunkPosition, std::vector<PackedVertex> &t_vertices, MeshMode t_mode)
+{
+	char f_padded[PADDED_SIZE];
+
+	gatherNeighbourhood(t_world, t_chunkPosition, f_padded);
+
+	switch (t_mode)
+	{
+	case MESH_NAIVE:
+		meshNaive(f_padded, t_vertices);
+		break;
+	case MESH_CULLED:
+		meshCulled(f_padded, t_vertices);
+		break;
+	default:
+		meshGreedy(f_padded, t_vertices);
+		break;
+	}
+}
+
+/// <summary>
+/// Copies a chunk and a one voxel border around it (from the 26 neighbouring chunks) into a padded array.
+/// Chunks that don't exist are filled with air.
+/// </summary>
+/// <param name="t_world">The world the chunk is in.</param>
+/// <param name="t_chunkPosition">The chunk position.</param>
+/// <param name="t_padded">An array of PADDED_SIZE voxels, use paddedIndex() to read it.</param>
+void Mesher::gatherNeighbourhood(World &t_world, const Indices &t_chunkPosition, char *t_padded)
+{
+	std::memset(t_padded, 0, PADDED_SIZE);
+
+	const int f_size[3] = { CHUNK_WIDTH, CHUNK_HEIGHT, CHUNK_DEPTH };
+
+	for (int dx = -1; dx <= 1; ++dx)
+	{
+		for (int dy = -1; dy <= 1; ++dy)
+		{
+			for (int dz = -1; dz <= 1; ++dz)
+			{
+				Chunk *f_chunk = t_world.chunks.find({ t_chunkPosition.x + dx, t_chunkPosition.y + dy, t_chunkPosition.z + dz });
+
+				if (f_chunk == nullptr)
+				{
+					continue;
+				}
+
+				// The part of the padded array covered by this chunk (in local voxel positions)
+				const int f_offset[3] = { dx, dy, dz };
+				int f_start[3];
+				int f_end[3];
+
+				for (int a = 0; a < 3; ++a)
+				{
+					f_start[a] = f_offset[a] < 0 ? -1 : (f_offset[a] > 0 ? f_size[a] : 0);
+					f_end[a] = f_offset[a] < 0 ? -1 : (f_offset[a] > 0 ? f_size[a] : f_size[a] - 1);
+				}
+
+				for (int x = f_start[0]; x <= f_end[0]; ++x)
+				{
+					for (int y = f_start[1]; y <= f_end[1]; ++y)
+					{
+						for (int z = f_start[2]; z <= f_end[2]; ++z)
+						{
+							// Position within the neighbouring chunk
+							int f_x = x - dx * CHUNK_WIDTH;
+							int f_y = y - dy * CHUNK_HEIGHT;
+							int f_z = z - dz * CHUNK_DEPTH;
+
+							t_padded[paddedIndex(x, y, z)] = f_chunk->getVoxel(f_x, f_y, f_z);
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Builds a mesh with one quad for every face of every voxel, hidden or not.
+/// </summary>
+/// <param name="t_padded">A padded chunk from gatherNeighbourhood().</param>
+/// <param name="t_vertices">The mesh's vertices are written here (4 for each quad).</param>
+void Mesher::meshNaive(const char *t_padded, std::vector<PackedVertex> &t_vertices)
+{
+	t_vertices.clear();
+
+	for (int x = 0; x < CHUNK_WIDTH; ++x)
+	{
+		for (int y = 0; y < CHUNK_HEIGHT; ++y)
+		{
+			for (int z = 0; z < CHUNK_DEPTH; ++z)
+			{
+				int f_index = paddedIndex(x, y, z);
+				char f_type = t_padded[f_index];
+
+				if (f_type == BLOCK_AIR)
+				{
+					continue;
+				}
+
+				for (int f_face = 0; f_face < 6; ++f_face)
+				{
+					addQuad(t_vertices, f_face, x, y, z, 1, 1, f_type, getFaceAO(t_padded, f_index, f_face));
+				}
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Builds a mesh with one quad for every visible voxel face.
+/// </summary>
+/// <param name="t_padded">A padded chunk from gatherNeighbourhood().</param>
+/// <param name="t_vertices">The mesh's vertices are written here (4 for each quad).</param>
+void Mesher::meshCulled(const char *t_padded, std::vector<PackedVertex> &t_vertices)
+{
+	t_vertices.clear();
+
+	for (int x = 0; x < CHUNK_WIDTH; ++x)
+	{
+		for (int y = 0; y < CHUNK_HEIGHT; ++y)
+		{
+			for (int z = 0; z < CHUNK_DEPTH; ++z)
+			{
+				int f_index = paddedIndex(x, y, z);
+				char f_type = t_padded[f_index];
+
+				if (f_type == BLOCK_AIR)
+				{
+					continue;
+				}
+
+				for (int f_face = 0; f_face < 6; ++f_face)
+				{
+					if (isFaceVisible(f_type, t_padded[f_index + FACE_OFFSET[f_face]]))
+					{
+						addQuad(t_vertices, f_face, x, y, z, 1, 1, f_type, getFaceAO(t_padded, f_index, f_face));
+					}
+				}
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Builds a mesh from the visible voxel faces, merging neighbouring faces into larger quads.
+/// Each slice of the chunk is handled separately for each face direction: the visible faces
+/// in the slice are put into a 2D mask, then rectangles with the same block type and ambient occlusion are grown
+/// from the mask (first along s and then along t) until every face is covered.
+/// </summary>
+/// <param name="t_padded">A padded chunk from gatherNeighbourhood().</param>
+/// <param name="t_vertices">The mesh's vertices are written here (4 for each quad).</param>
+void Mesher::meshGreedy(const char *t_padded, std::vector<PackedVertex> &t_vertices)
+{
+	t_vertices.clear();
+
+	const int f_size[3] = { CHUNK_WIDTH, CHUNK_HEIGHT, CHUNK_DEPTH };
+	const int f_maxSide = CHUNK_WIDTH > CHUNK_HEIGHT ? (CHUNK_WIDTH > CHUNK_DEPTH ? CHUNK_WIDTH : CHUNK_DEPTH) : (CHUNK_HEIGHT > CHUNK_DEPTH ? CHUNK_HEIGHT : CHUNK_DEPTH);
+
+	// Block type and ambient occlusion (bits 8-15) of each visible face in the slice (0 where there's no face)
+	unsigned short f_mask[f_maxSide * f_maxSide];
+
+	for (int f_face = 0; f_face < 6; ++f_face)
+	{
+		int f_axis = FACE_AXIS[f_face];
+		int f_s = FACE_S_AXIS[f_face];
+		int f_t = FACE_T_AXIS[f_face];
+		int f_width = f_size[f_s];
+		int f_height = f_size[f_t];
+
+		for (int f_slice = 0; f_slice < f_size[f_axis]; ++f_slice)
+		{
+			int f_voxel[3] = { 0, 0, 0 };
+			f_voxel[f_axis] = f_slice;
+
+			int f_sliceStart = paddedIndex(f_voxel[0], f_voxel[1], f_voxel[2]);
+			int f_sStride = AXIS_STRIDE[f_s];
+			int f_tStride = AXIS_STRIDE[f_t];
+
+			// Build the mask for this slice
+			for (int t = 0; t < f_height; ++t)
+			{
+				for (int s = 0; s < f_width; ++s)
+				{
+					int f_index = f_sliceStart + s * f_sStride + t * f_tStride;
+					char f_type = t_padded[f_index];
+
+					if (f_type != BLOCK_AIR && isFaceVisible(f_type, t_padded[f_index + FACE_OFFSET[f_face]]))
+					{
+						f_mask[t * f_width + s] = (unsigned short)(f_type | (getFaceAO(t_padded, f_index, f_face) << 8));
+					}
+					else
+					{
+						f_mask[t * f_width + s] = 0;
+					}
+				}
+			}
+
+			// Cover the mask with rectangles
+			for (int t = 0; t < f_height; ++t)
+			{
+				for (int s = 0; s < f_width; )
+				{
+					unsigned short f_key = f_mask[t * f_width + s];
+
+					if (f_key == 0)
+					{
+						++s;
+						continue;
+					}
+
+					// Grow along s
+					int f_quadWidth = 1;
+
+					while (s + f_quadWidth < f_width && f_mask[t * f_width + s + f_quadWidth] == f_key)
+					{
+						++f_quadWidth;
+					}
+
+					// Grow along t while the whole row matches
+					int f_quadHeight = 1;
+
+					for (; t + f_quadHeight < f_height; ++f_quadHeight)
+					{
+						const unsigned short *f_row = &f_mask[(t + f_quadHeight) * f_width + s];
+						bool f_matches = true;
+
+						for (int i = 0; i < f_quadWidth; ++i)
+						{
+							if (f_row[i] != f_key)
+							{
+								f_matches = false;
+								break;
+							}
+						}
+
+						if (!f_matches)
+						{
+							break;
+						}
+					}
+
+					f_voxel[f_s] = s;
+					f_voxel[f_t] = t;
+					addQuad(t_vertices, f_face, f_voxel[0], f_voxel[1], f_voxel[2], f_quadWidth, f_quadHeight, (char)(f_key & 0xFF), f_key >> 8);
+
+					// Clear the faces that are now covered
+					for (int j = 0; j < f_quadHeight; ++j)
+					{
+						for (int i = 0; i < f_quadWidth; ++i)
+						{
+							f_mask[(t + j) * f_width + s + i] = 0;
+						}
+					}
+
+					s += f_quadWidth;
+				}
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Converts a position within a chunk into an index in the padded array.
+/// Positions can go from -1 to the chunk size (inclusive) to reach the border.
+/// </summary>
+/// <param name="x">The X position within the chunk.</param>
+/// <param name="y">The Y position within the chunk.</param>
+/// <param name="z">The Z position within the chunk.</param>
+/// <returns>The padded array index.</returns>
+int Mesher::paddedIndex(int x, int y, int z)
+{
+	return Utility::at(x + 1, y + 1, z + 1, PADDED_HEIGHT, PADDED_DEPTH);
+}
+
+/// <summary>
+/// Checks if the face between a voxel and its neighbour should be drawn.
+/// </summary>
+/// <param name="t_type">The voxel's type.</param>
+/// <param name="t_neighbour">The neighbouring voxel's type.</param>
+/// <returns>True if the face is visible.</returns>
+bool Mesher::isFaceVisible(char t_type, char t_neighbour)
+{
+	return BLOCK_TRANSPARENT[(int)t_neighbour] && t_neighbour != t_type;
+}
+
+/// <summary>
+/// Packs a vertex into 32 bits.
+/// </summary>
+/// <param name="t_vertex">The vertex (every value must fit in its bits).</param>
+/// <returns>The packed vertex.</returns>
+PackedVertex Mesher::packVertex(const MeshVertex &t_vertex)
+{
+	return ((PackedVertex)t_vertex.x << X_SHIFT) |
+		((PackedVertex)t_vertex.y << Y_SHIFT) |
+		((PackedVertex)t_vertex.z << Z_SHIFT) |
+		((PackedVertex)t_vertex.face << FACE_SHIFT) |
+		((PackedVertex)t_vertex.ao << AO_SHIFT) |
+		((PackedVertex)t_vertex.layer << LAYER_SHIFT);
+}
+
+/// <summary>
+/// Unpacks a vertex, the same way passthrough.vert does.
+/// </summary>
+/// <param name="t_packed">The packed vertex.</param>
+/// <returns>The vertex.</returns>
+MeshVertex Mesher::unpackVertex(PackedVertex t_packed)
+{
+	MeshVertex f_vertex;
+	f_vertex.x = (t_packed >> X_SHIFT) & ((1u << POSITION_BITS) - 1);
+	f_vertex.y = (t_packed >> Y_SHIFT) & ((1u << POSITION_BITS) - 1);
+	f_vertex.z = (t_packed >> Z_SHIFT) & ((1u << POSITION_BITS) - 1);
+	f_vertex.face = (t_packed >> FACE_SHIFT) & ((1u << FACE_BITS) - 1);
+	f_vertex.ao = (t_packed >> AO_SHIFT) & ((1u << AO_BITS) - 1);
+	f_vertex.layer = (t_packed >> LAYER_SHIFT) & ((1u << LAYER_BITS) - 1);
+
+	return f_vertex;
+}
+
+/// <summary>
+/// Works out the ambient occlusion at each corner of a voxel face.
+/// A corner is darkened by the two voxels beside it and the one diagonal to it, in the layer in front of the face.
+/// </summary>
+/// <param name="t_padded">A padded chunk from gatherNeighbourhood().</param>
+/// <param name="t_index">The voxel's index in the padded array.</param>
+/// <param name="t_face">The face.</param>
+/// <returns>2 bits for each corner (0 is fully occluded, 3 is not occluded), in the order (0, 0), (1, 0), (1, 1), (0, 1) in (s, t).</returns>
+int Mesher::getFaceAO(const char *t_padded, int t_index, int t_face)
+{
+	int f_front = t_index + FACE_OFFSET[t_face];
+	int f_sStride = AXIS_STRIDE[FACE_S_AXIS[t_face]];
+	int f_tStride = AXIS_STRIDE[FACE_T_AXIS[t_face]];
+	int f_ao = 0;
+
+	for (int i = 0; i < 4; ++i)
+	{
+		int f_sStep = CORNERS[i][0] ? f_sStride : -f_sStride;
+		int f_tStep = CORNERS[i][1] ? f_tStride : -f_tStride;
+
+		int f_side1 = isOccluder(t_padded[f_front + f_sStep]) ? 1 : 0;
+		int f_side2 = isOccluder(t_padded[f_front + f_tStep]) ? 1 : 0;
+		int f_corner = isOccluder(t_padded[f_front + f_sStep + f_tStep]) ? 1 : 0;
+
+		// Two sides block the corner completely
+		int f_value = (f_side1 && f_side2) ? 0 : 3 - (f_side1 + f_side2 + f_corner);
+		f_ao |= f_value << (i * 2);
+	}
+
+	return f_ao;
+}
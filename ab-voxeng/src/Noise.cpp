@@ -8,6 +8,17 @@ ab::Noise::Noise()
 	initialise();
 }
 
+/// <summary>
+/// Constructor for the Noise class.
+/// The permutation table is shuffled by the seed, so every seed gives different noise.
+/// </summary>
+/// <param name="t_seed">The seed used to shuffle the permutation table.</param>
+ab::Noise::Noise(unsigned int t_seed)
+{
+	shuffle(t_seed);
+	initialise();
+}
+
 /// <summary>
 /// Destructor for the Noise class.
 /// </summary>
@@ -24,6 +35,30 @@ void ab::Noise::initialise()
 	for (int i = 0; i < 512; i++)
 	{
 		perm[i] = p[i & 255]; 
+		m_gradX[i] = grad3[perm[i] % 12][0];
+		m_gradY[i] = grad3[perm[i] % 12][1];
+		m_gradZ[i] = grad3[perm[i] % 12][2];
+		m_grad4X[i] = grad4[perm[i] % 32][0];
+		m_grad4Y[i] = grad4[perm[i] % 32][1];
+		m_grad4Z[i] = grad4[perm[i] % 32][2];
+		m_grad4W[i] = grad4[perm[i] % 32][3];
+	}
+
+	m_simdLevel = getSupportedSimdLevel();
+}
+
+/// <summary>
+/// Shuffles the permutation table (Fisher-Yates).
+/// The random numbers come from Utility::hash rather than std::shuffle, which isn't
+/// guaranteed to give the same order with every standard library.
+/// </summary>
+/// <param name="t_seed">The seed to shuffle with.</param>
+void ab::Noise::shuffle(unsigned int t_seed)
+{
+	for (int i = 255; i > 0; --i)
+	{
+		int j = Utility::hash(t_seed, i, 0) % (i + 1);
+		std::swap(p[i], p[j]);
 	}
 }
 
@@ -175,6 +210,497 @@ double ab::Noise::noise(double t_xin, double t_yin)
 	return normaliseToRange(v, -1, 1);	 
 }
 
+/// <summary>
+/// 3D noise generation function. Returns a value between 0 and 1.
+/// </summary>
+/// <param name="t_xin">The X coordinate.</param>
+/// <param name="t_yin">The Y coordinate.</param>
+/// <param name="t_zin">The Z coordinate.</param>
+/// <returns>The resulting noise value.</returns>
+double ab::Noise::noise(double t_xin, double t_yin, double t_zin)
+{
+	// Noise contributions from the four corners
+	double n0;
+	double n1;
+	double n2;
+	double n3;
+
+	// Skew the input space to determine which simplex cell we're in
+	const double F3 = 1.0 / 3.0;
+
+	// Very nice and simple skew factor for 3D
+	double s = (t_xin + t_yin + t_zin) * F3;
+	int i = fastFloor(t_xin + s);
+	int j = fastFloor(t_yin + s);
+	int k = fastFloor(t_zin + s);
+	const double G3 = 1.0 / 6.0;
+	double t = ((double)i + j + k) * G3;
+
+	// Unskew the cell origin back to (x, y, z) space
+	double X0 = i - t;
+	double Y0 = j - t;
+	double Z0 = k - t;
+
+	// The (x, y, z) distances from the cell origin
+	double x0 = t_xin - X0;
+	double y0 = t_yin - Y0;
+	double z0 = t_zin - Z0;
+
+	// For the 3D case, the simplex shape is a slightly irregular tetrahedron
+	// Determine which simplex we are in
+
+	// Offsets for second corner of simplex in (i, j, k) coords
+	int i1;
+	int j1;
+	int k1;
+
+	// Offsets for third corner of simplex in (i, j, k) coords
+	int i2;
+	int j2;
+	int k2;
+
+	if (x0 >= y0)
+	{
+		// X Y Z order
+		if (y0 >= z0)
+		{
+			i1 = 1; j1 = 0; k1 = 0; i2 = 1; j2 = 1; k2 = 0;
+		}
+		// X Z Y order
+		else if (x0 >= z0)
+		{
+			i1 = 1; j1 = 0; k1 = 0; i2 = 1; j2 = 0; k2 = 1;
+		}
+		// Z X Y order
+		else
+		{
+			i1 = 0; j1 = 0; k1 = 1; i2 = 1; j2 = 0; k2 = 1;
+		}
+	}
+	else
+	{
+		// Z Y X order
+		if (y0 < z0)
+		{
+			i1 = 0; j1 = 0; k1 = 1; i2 = 0; j2 = 1; k2 = 1;
+		}
+		// Y Z X order
+		else if (x0 < z0)
+		{
+			i1 = 0; j1 = 1; k1 = 0; i2 = 0; j2 = 1; k2 = 1;
+		}
+		// Y X Z order
+		else
+		{
+			i1 = 0; j1 = 1; k1 = 0; i2 = 1; j2 = 1; k2 = 0;
+		}
+	}
+
+	// A step of (1, 0, 0) in (i, j, k) means a step of (1 - c, -c, -c) in (x, y, z),
+	// a step of (0, 1, 0) in (i, j, k) means a step of (-c, 1 - c, -c) in (x, y, z), and
+	// a step of (0, 0, 1) in (i, j, k) means a step of (-c, -c, 1 - c) in (x, y, z), where c = 1 / 6
+
+	// Offsets for second corner in (x, y, z) coords
+	double x1 = x0 - i1 + G3;
+	double y1 = y0 - j1 + G3;
+	double z1 = z0 - k1 + G3;
+
+	// Offsets for third corner in (x, y, z) coords
+	double x2 = x0 - i2 + 2.0 * G3;
+	double y2 = y0 - j2 + 2.0 * G3;
+	double z2 = z0 - k2 + 2.0 * G3;
+
+	// Offsets for last corner in (x, y, z) coords
+	double x3 = x0 - 1.0 + 3.0 * G3;
+	double y3 = y0 - 1.0 + 3.0 * G3;
+	double z3 = z0 - 1.0 + 3.0 * G3;
+
+	// Work out the hashed gradient indices of the four simplex corners
+	int ii = i & 255;
+	int jj = j & 255;
+	int kk = k & 255;
+	int gi0 = perm[ii + perm[jj + perm[kk]]] % 12;
+	int gi1 = perm[ii + i1 + perm[jj + j1 + perm[kk + k1]]] % 12;
+	int gi2 = perm[ii + i2 + perm[jj + j2 + perm[kk + k2]]] % 12;
+	int gi3 = perm[ii + 1 + perm[jj + 1 + perm[kk + 1]]] % 12;
+
+	// Calculate the contribution from the four corners
+	double t0 = 0.6 - x0 * x0 - y0 * y0 - z0 * z0;
+
+	if (t0 < 0)
+	{
+		n0 = 0.0;
+	}
+	else
+	{
+		t0 *= t0;
+		n0 = t0 * t0 * dot(grad3[gi0], x0, y0, z0);
+	}
+
+	double t1 = 0.6 - x1 * x1 - y1 * y1 - z1 * z1;
+
+	if (t1 < 0)
+	{
+		n1 = 0.0;
+	}
+	else
+	{
+		t1 *= t1;
+		n1 = t1 * t1 * dot(grad3[gi1], x1, y1, z1);
+	}
+
+	double t2 = 0.6 - x2 * x2 - y2 * y2 - z2 * z2;
+
+	if (t2 < 0)
+	{
+		n2 = 0.0;
+	}
+	else
+	{
+		t2 *= t2;
+		n2 = t2 * t2 * dot(grad3[gi2], x2, y2, z2);
+	}
+
+	double t3 = 0.6 - x3 * x3 - y3 * y3 - z3 * z3;
+
+	if (t3 < 0)
+	{
+		n3 = 0.0;
+	}
+	else
+	{
+		t3 *= t3;
+		n3 = t3 * t3 * dot(grad3[gi3], x3, y3, z3);
+	}
+
+	// Add contributions from each corner to get the final noise value
+	// The result is scaled to stay just inside [-1, 1], then moved to [0, 1]
+	double v = 32.0 * (n0 + n1 + n2 + n3);
+	return (v + 1.0) * 0.5;
+}
+
+/// <summary>
+/// 4D noise generation function. Returns a value between 0 and 1.
+/// </summary>
+/// <param name="t_xin">The X coordinate.</param>
+/// <param name="t_yin">The Y coordinate.</param>
+/// <param name="t_zin">The Z coordinate.</param>
+/// <param name="t_win">The W coordinate.</param>
+/// <returns>The resulting noise value.</returns>
+double ab::Noise::noise(double t_xin, double t_yin, double t_zin, double t_win)
+{
+	// The skewing and unskewing factors are hairy again for the 4D case
+	const double F4 = (sqrt(5.0) - 1.0) / 4.0;
+	const double G4 = (5.0 - sqrt(5.0)) / 20.0;
+
+	// Noise contributions from the five corners
+	double n0;
+	double n1;
+	double n2;
+	double n3;
+	double n4;
+
+	// Skew the (x, y, z, w) space to determine which cell of 24 simplices we're in
+	double s = (t_xin + t_yin + t_zin + t_win) * F4;
+	int i = fastFloor(t_xin + s);
+	int j = fastFloor(t_yin + s);
+	int k = fastFloor(t_zin + s);
+	int l = fastFloor(t_win + s);
+	double t = ((double)i + j + k + l) * G4;
+
+	// Unskew the cell origin back to (x, y, z, w) space
+	double X0 = i - t;
+	double Y0 = j - t;
+	double Z0 = k - t;
+	double W0 = l - t;
+
+	// The (x, y, z, w) distances from the cell origin
+	double x0 = t_xin - X0;
+	double y0 = t_yin - Y0;
+	double z0 = t_zin - Z0;
+	double w0 = t_win - W0;
+
+	// For the 4D case, the simplex is a 4D shape I won't even try to describe.
+	// To find out which of the 24 possible simplices we're in, we need to determine the
+	// magnitude ordering of x0, y0, z0 and w0. The method below is a good way of finding
+	// the ordering of x, y, z, w and then find the correct traversal order for the simplex we're in.
+	// First, six pair-wise comparisons are performed between each possible pair of the four
+	// coordinates, and the results are used to add up binary bits for an integer index.
+	int c1 = (x0 > y0) ? 32 : 0;
+	int c2 = (x0 > z0) ? 16 : 0;
+	int c3 = (y0 > z0) ? 8 : 0;
+	int c4 = (x0 > w0) ? 4 : 0;
+	int c5 = (y0 > w0) ? 2 : 0;
+	int c6 = (z0 > w0) ? 1 : 0;
+	int c = c1 + c2 + c3 + c4 + c5 + c6;
+
+	// simplex[c] is a 4-vector with the numbers 0, 1, 2 and 3 in some order.
+	// Many values of c will never occur, since e.g. x > y > z > w makes x < z, y < w and x < w
+	// impossible. Only the 24 indices which have non-zero entries make any sense.
+	// We use a thresholding to set the coordinates in turn from the largest magnitude.
+
+	// The number 3 in the "simplex" array is at the position of the largest coordinate
+	int i1 = simplex[c][0] >= 3 ? 1 : 0;
+	int j1 = simplex[c][1] >= 3 ? 1 : 0;
+	int k1 = simplex[c][2] >= 3 ? 1 : 0;
+	int l1 = simplex[c][3] >= 3 ? 1 : 0;
+
+	// The number 2 in the "simplex" array is at the second largest coordinate
+	int i2 = simplex[c][0] >= 2 ? 1 : 0;
+	int j2 = simplex[c][1] >= 2 ? 1 : 0;
+	int k2 = simplex[c][2] >= 2 ? 1 : 0;
+	int l2 = simplex[c][3] >= 2 ? 1 : 0;
+
+	// The number 1 in the "simplex" array is at the second smallest coordinate
+	int i3 = simplex[c][0] >= 1 ? 1 : 0;
+	int j3 = simplex[c][1] >= 1 ? 1 : 0;
+	int k3 = simplex[c][2] >= 1 ? 1 : 0;
+	int l3 = simplex[c][3] >= 1 ? 1 : 0;
+
+	// The fifth corner has all coordinate offsets = 1, so no need to look that up
+
+	// Offsets for second corner in (x, y, z, w) coords
+	double x1 = x0 - i1 + G4;
+	double y1 = y0 - j1 + G4;
+	double z1 = z0 - k1 + G4;
+	double w1 = w0 - l1 + G4;
+
+	// Offsets for third corner in (x, y, z, w) coords
+	double x2 = x0 - i2 + 2.0 * G4;
+	double y2 = y0 - j2 + 2.0 * G4;
+	double z2 = z0 - k2 + 2.0 * G4;
+	double w2 = w0 - l2 + 2.0 * G4;
+
+	// Offsets for fourth corner in (x, y, z, w) coords
+	double x3 = x0 - i3 + 3.0 * G4;
+	double y3 = y0 - j3 + 3.0 * G4;
+	double z3 = z0 - k3 + 3.0 * G4;
+	double w3 = w0 - l3 + 3.0 * G4;
+
+	// Offsets for last corner in (x, y, z, w) coords
+	double x4 = x0 - 1.0 + 4.0 * G4;
+	double y4 = y0 - 1.0 + 4.0 * G4;
+	double z4 = z0 - 1.0 + 4.0 * G4;
+	double w4 = w0 - 1.0 + 4.0 * G4;
+
+	// Work out the hashed gradient indices of the five simplex corners
+	int ii = i & 255;
+	int jj = j & 255;
+	int kk = k & 255;
+	int ll = l & 255;
+	int gi0 = perm[ii + perm[jj + perm[kk + perm[ll]]]] % 32;
+	int gi1 = perm[ii + i1 + perm[jj + j1 + perm[kk + k1 + perm[ll + l1]]]] % 32;
+	int gi2 = perm[ii + i2 + perm[jj + j2 + perm[kk + k2 + perm[ll + l2]]]] % 32;
+	int gi3 = perm[ii + i3 + perm[jj + j3 + perm[kk + k3 + perm[ll + l3]]]] % 32;
+	int gi4 = perm[ii + 1 + perm[jj + 1 + perm[kk + 1 + perm[ll + 1]]]] % 32;
+
+	// Calculate the contribution from the five corners
+	double t0 = 0.6 - x0 * x0 - y0 * y0 - z0 * z0 - w0 * w0;
+
+	if (t0 < 0)
+	{
+		n0 = 0.0;
+	}
+	else
+	{
+		t0 *= t0;
+		n0 = t0 * t0 * dot(grad4[gi0], x0, y0, z0, w0);
+	}
+
+	double t1 = 0.6 - x1 * x1 - y1 * y1 - z1 * z1 - w1 * w1;
+
+	if (t1 < 0)
+	{
+		n1 = 0.0;
+	}
+	else
+	{
+		t1 *= t1;
+		n1 = t1 * t1 * dot(grad4[gi1], x1, y1, z1, w1);
+	}
+
+	double t2 = 0.6 - x2 * x2 - y2 * y2 - z2 * z2 - w2 * w2;
+
+	if (t2 < 0)
+	{
+		n2 = 0.0;
+	}
+	else
+	{
+		t2 *= t2;
+		n2 = t2 * t2 * dot(grad4[gi2], x2, y2, z2, w2);
+	}
+
+	double t3 = 0.6 - x3 * x3 - y3 * y3 - z3 * z3 - w3 * w3;
+
+	if (t3 < 0)
+	{
+		n3 = 0.0;
+	}
+	else
+	{
+		t3 *= t3;
+		n3 = t3 * t3 * dot(grad4[gi3], x3, y3, z3, w3);
+	}
+
+	double t4 = 0.6 - x4 * x4 - y4 * y4 - z4 * z4 - w4 * w4;
+
+	if (t4 < 0)
+	{
+		n4 = 0.0;
+	}
+	else
+	{
+		t4 *= t4;
+		n4 = t4 * t4 * dot(grad4[gi4], x4, y4, z4, w4);
+	}
+
+	// Sum up and scale the result to cover the range [-1, 1], then move it to [0, 1]
+	double v = 27.0 * (n0 + n1 + n2 + n3 + n4);
+	return (v + 1.0) * 0.5;
+}
+
+/// <summary>
+/// 2D noise generation function for arrays of coordinates. Returns values between 0 and 1.
+/// </summary>
+/// <param name="t_x">The X coordinates.</param>
+/// <param name="t_y">The Y coordinates.</param>
+/// <param name="t_results">Filled with the noise value for each coordinate.</param>
+/// <param name="t_count">The number of coordinates.</param>
+void ab::Noise::noise(const float *t_x, const float *t_y, float *t_results, int t_count) const
+{
+	const float *f_coordinates[] = { t_x, t_y };
+	noiseBatch(2, f_coordinates, t_results, t_count);
+}
+
+/// <summary>
+/// 2D noise generation function for arrays of coordinates (in double precision). Returns values between 0 and 1.
+/// </summary>
+/// <param name="t_x">The X coordinates.</param>
+/// <param name="t_y">The Y coordinates.</param>
+/// <param name="t_results">Filled with the noise value for each coordinate.</param>
+/// <param name="t_count">The number of coordinates.</param>
+void ab::Noise::noise(const double *t_x, const double *t_y, double *t_results, int t_count) const
+{
+	const double *f_coordinates[] = { t_x, t_y };
+	noiseBatch(2, f_coordinates, t_results, t_count);
+}
+
+/// <summary>
+/// 3D noise generation function for arrays of coordinates. Returns values between 0 and 1.
+/// </summary>
+/// <param name="t_x">The X coordinates.</param>
+/// <param name="t_y">The Y coordinates.</param>
+/// <param name="t_z">The Z coordinates.</param>
+/// <param name="t_results">Filled with the noise value for each coordinate.</param>
+/// <param name="t_count">The number of coordinates.</param>
+void ab::Noise::noise(const float *t_x, const float *t_y, const float *t_z, float *t_results, int t_count) const
+{
+	const float *f_coordinates[] = { t_x, t_y, t_z };
+	noiseBatch(3, f_coordinates, t_results, t_count);
+}
+
+/// <summary>
+/// 3D noise generation function for arrays of coordinates (in double precision). Returns values between 0 and 1.
+/// </summary>
+/// <param name="t_x">The X coordinates.</param>
+/// <param name="t_y">The Y coordinates.</param>
+/// <param name="t_z">The Z coordinates.</param>
+/// <param name="t_results">Filled with the noise value for each coordinate.</param>
+/// <param name="t_count">The number of coordinates.</param>
+void ab::Noise::noise(const double *t_x, const double *t_y, const double *t_z, double *t_results, int t_count) const
+{
+	const double *f_coordinates[] = { t_x, t_y, t_z };
+	noiseBatch(3, f_coordinates, t_results, t_count);
+}
+
+/// <summary>
+/// 4D noise generation function for arrays of coordinates. Returns values between 0 and 1.
+/// </summary>
+/// <param name="t_x">The X coordinates.</param>
+/// <param name="t_y">The Y coordinates.</param>
+/// <param name="t_z">The Z coordinates.</param>
+/// <param name="t_w">The W coordinates.</param>
+/// <param name="t_results">Filled with the noise value for each coordinate.</param>
+/// <param name="t_count">The number of coordinates.</param>
+void ab::Noise::noise(const float *t_x, const float *t_y, const float *t_z, const float *t_w, float *t_results, int t_count) const
+{
+	const float *f_coordinates[] = { t_x, t_y, t_z, t_w };
+	noiseBatch(4, f_coordinates, t_results, t_count);
+}
+
+/// <summary>
+/// 4D noise generation function for arrays of coordinates (in double precision). Returns values between 0 and 1.
+/// </summary>
+/// <param name="t_x">The X coordinates.</param>
+/// <param name="t_y">The Y coordinates.</param>
+/// <param name="t_z">The Z coordinates.</param>
+/// <param name="t_w">The W coordinates.</param>
+/// <param name="t_results">Filled with the noise value for each coordinate.</param>
+/// <param name="t_count">The number of coordinates.</param>
+void ab::Noise::noise(const double *t_x, const double *t_y, const double *t_z, const double *t_w, double *t_results, int t_count) const
+{
+	const double *f_coordinates[] = { t_x, t_y, t_z, t_w };
+	noiseBatch(4, f_coordinates, t_results, t_count);
+}
+
+/// <summary>
+/// Evaluates noise for arrays of coordinates with the chosen instruction set.
+/// </summary>
+/// <param name="t_dimensions">The number of dimensions (2, 3 or 4).</param>
+/// <param name="t_coordinates">One array of coordinates for each dimension.</param>
+/// <param name="t_results">Filled with the noise value for each coordinate.</param>
+/// <param name="t_count">The number of coordinates.</param>
+template <typename T>
+void ab::Noise::noiseBatch(int t_dimensions, const T *const *t_coordinates, T *t_results, int t_count) const
+{
+	NoiseTables f_tables{ perm, m_gradX, m_gradY, m_gradZ, m_grad4X, m_grad4Y, m_grad4Z, m_grad4W };
+
+	switch (m_simdLevel)
+	{
+	case SIMD_AVX2:
+		NoiseKernel::simplexAVX2(f_tables, t_dimensions, t_coordinates, t_results, t_count);
+		break;
+	case SIMD_SSE2:
+		NoiseKernel::simplexSSE2(f_tables, t_dimensions, t_coordinates, t_results, t_count);
+		break;
+	default:
+		NoiseKernel::simplexScalar(f_tables, t_dimensions, t_coordinates, t_results, t_count);
+		break;
+	}
+}
+
+/// <summary>
+/// Gets the instruction set used by the array versions of noise().
+/// </summary>
+/// <returns>The instruction set.</returns>
+ab::Noise::SimdLevel ab::Noise::getSimdLevel() const
+{
+	return m_simdLevel;
+}
+
+/// <summary>
+/// Sets the instruction set used by the array versions of noise() (e.g. to compare them).
+/// Asking for more than the CPU supports gives the best it does support.
+/// </summary>
+/// <param name="t_level">The instruction set.</param>
+void ab::Noise::setSimdLevel(SimdLevel t_level)
+{
+	SimdLevel f_supported = getSupportedSimdLevel();
+	m_simdLevel = t_level < f_supported ? t_level : f_supported;
+}
+
+/// <summary>
+/// Gets the best instruction set the CPU supports (checked once, the first time it's needed).
+/// </summary>
+/// <returns>The instruction set.</returns>
+ab::Noise::SimdLevel ab::Noise::getSupportedSimdLevel()
+{
+	static const SimdLevel s_supported = NoiseKernel::isAVX2Supported() ? SIMD_AVX2 : (NoiseKernel::isSSE2Supported() ? SIMD_SSE2 : SIMD_SCALAR);
+
+	return s_supported;
+}
+
 /// <summary>
 /// Normalise value to a specified range.
 /// </summary>
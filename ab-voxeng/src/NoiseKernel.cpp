@@ -0,0 +1,241 @@
+#include "NoiseKernel.h"
+
+#ifdef NOISE_KERNEL_X86
+#include <emmintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace
+{
+	// One value at a time, used when there's no SSE2 (and as the reference for the other kernels)
+	template <typename Type>
+	struct Scalar
+	{
+		typedef Type T;
+		typedef Type V;
+		typedef int I;
+		static const int WIDTH = 1;
+
+		static V set(T t_value) { return t_value; }
+		static V load(const T *t_values) { return *t_values; }
+		static void store(T *t_values, V t_value) { *t_values = t_value; }
+		static V add(V a, V b) { return a + b; }
+		static V sub(V a, V b) { return a - b; }
+		static V mul(V a, V b) { return a * b; }
+		static V max(V a, V b) { return a > b ? a : b; }
+		static bool greater(V a, V b) { return a > b; }
+		static V select(bool t_mask, V t_value) { return t_mask ? t_value : (T)0; }
+		static I toInt(V t_value) { return (int)t_value; }
+		static I addInt(I a, I b) { return a + b; }
+		static I intOne() { return 1; }
+		static I wrap(I t_value) { return t_value & 255; }
+		static I gather(const int *t_table, I t_index) { return t_table[t_index]; }
+		static V gatherGradient(const int *t_table, I t_index) { return (T)t_table[t_index]; }
+
+		// Truncates, then steps down for negative values (the same as the SSE2 version)
+		static V floor(V t_value, I &t_int)
+		{
+			t_int = (int)t_value;
+			T f_floor = (T)t_int;
+
+			if (f_floor > t_value)
+			{
+				f_floor -= (T)1;
+				t_int -= 1;
+			}
+
+			return f_floor;
+		}
+	};
+
+#ifdef NOISE_KERNEL_X86
+	// Four floats at a time
+	struct SSE2Float
+	{
+		typedef float T;
+		typedef __m128 V;
+		typedef __m128i I;
+		static const int WIDTH = 4;
+
+		static V set(T t_value) { return _mm_set1_ps(t_value); }
+		static V load(const T *t_values) { return _mm_loadu_ps(t_values); }
+		static void store(T *t_values, V t_value) { _mm_storeu_ps(t_values, t_value); }
+		static V add(V a, V b) { return _mm_add_ps(a, b); }
+		static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+		static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+		static V max(V a, V b) { return _mm_max_ps(a, b); }
+		static V greater(V a, V b) { return _mm_cmpgt_ps(a, b); }
+		static V select(V t_mask, V t_value) { return _mm_and_ps(t_mask, t_value); }
+		static I toInt(V t_value) { return _mm_cvttps_epi32(t_value); }
+		static I addInt(I a, I b) { return _mm_add_epi32(a, b); }
+		static I intOne() { return _mm_set1_epi32(1); }
+		static I wrap(I t_value) { return _mm_and_si128(t_value, _mm_set1_epi32(255)); }
+
+		// SSE2 has no gather instruction, so the lanes are looked up one by one
+		static I gather(const int *t_table, I t_index)
+		{
+			int f_index[4];
+			_mm_storeu_si128((__m128i *)f_index, t_index);
+
+			return _mm_setr_epi32(t_table[f_index[0]], t_table[f_index[1]], t_table[f_index[2]], t_table[f_index[3]]);
+		}
+
+		static V gatherGradient(const int *t_table, I t_index)
+		{
+			return _mm_cvtepi32_ps(gather(t_table, t_index));
+		}
+
+		// SSE2 has no floor instruction: truncate, then subtract one where that rounded up (negative values)
+		static V floor(V t_value, I &t_int)
+		{
+			I f_truncated = _mm_cvttps_epi32(t_value);
+			V f_roundedUp = _mm_cmpgt_ps(_mm_cvtepi32_ps(f_truncated), t_value);
+			t_int = _mm_add_epi32(f_truncated, _mm_castps_si128(f_roundedUp)); // The mask is -1 where it rounded up
+
+			return _mm_cvtepi32_ps(t_int);
+		}
+	};
+
+	// Two doubles at a time (the integers are in the lower two lanes)
+	struct SSE2Double
+	{
+		typedef double T;
+		typedef __m128d V;
+		typedef __m128i I;
+		static const int WIDTH = 2;
+
+		static V set(T t_value) { return _mm_set1_pd(t_value); }
+		static V load(const T *t_values) { return _mm_loadu_pd(t_values); }
+		static void store(T *t_values, V t_value) { _mm_storeu_pd(t_values, t_value); }
+		static V add(V a, V b) { return _mm_add_pd(a, b); }
+		static V sub(V a, V b) { return _mm_sub_pd(a, b); }
+		static V mul(V a, V b) { return _mm_mul_pd(a, b); }
+		static V max(V a, V b) { return _mm_max_pd(a, b); }
+		static V greater(V a, V b) { return _mm_cmpgt_pd(a, b); }
+		static V select(V t_mask, V t_value) { return _mm_and_pd(t_mask, t_value); }
+		static I toInt(V t_value) { return _mm_cvttpd_epi32(t_value); }
+		static I addInt(I a, I b) { return _mm_add_epi32(a, b); }
+		static I intOne() { return _mm_set1_epi32(1); }
+		static I wrap(I t_value) { return _mm_and_si128(t_value, _mm_set1_epi32(255)); }
+
+		static I gather(const int *t_table, I t_index)
+		{
+			int f_index[4];
+			_mm_storeu_si128((__m128i *)f_index, t_index);
+
+			return _mm_setr_epi32(t_table[f_index[0]], t_table[f_index[1]], 0, 0);
+		}
+
+		static V gatherGradient(const int *t_table, I t_index)
+		{
+			return _mm_cvtepi32_pd(gather(t_table, t_index));
+		}
+
+		static V floor(V t_value, I &t_int)
+		{
+			V f_truncated = _mm_cvtepi32_pd(_mm_cvttpd_epi32(t_value));
+			V f_roundedUp = _mm_cmpgt_pd(f_truncated, t_value);
+			V f_floor = _mm_sub_pd(f_truncated, _mm_and_pd(f_roundedUp, _mm_set1_pd(1.0)));
+			t_int = _mm_cvttpd_epi32(f_floor);
+
+			return f_floor;
+		}
+	};
+#endif
+}
+
+/// <summary>
+/// Evaluates simplex noise for arrays of float coordinates, one at a time.
+/// </summary>
+void ab::NoiseKernel::simplexScalar(const NoiseTables &t_tables, int t_dimensions, const float *const *t_coordinates, float *t_results, int t_count)
+{
+	simplexBatch<Scalar<float>>(t_tables, t_dimensions, t_coordinates, t_results, t_count);
+}
+
+/// <summary>
+/// Evaluates simplex noise for arrays of double coordinates, one at a time.
+/// </summary>
+void ab::NoiseKernel::simplexScalar(const NoiseTables &t_tables, int t_dimensions, const double *const *t_coordinates, double *t_results, int t_count)
+{
+	simplexBatch<Scalar<double>>(t_tables, t_dimensions, t_coordinates, t_results, t_count);
+}
+
+/// <summary>
+/// Evaluates simplex noise for arrays of float coordinates, four at a time.
+/// </summary>
+void ab::NoiseKernel::simplexSSE2(const NoiseTables &t_tables, int t_dimensions, const float *const *t_coordinates, float *t_results, int t_count)
+{
+#ifdef NOISE_KERNEL_X86
+	simplexBatch<SSE2Float>(t_tables, t_dimensions, t_coordinates, t_results, t_count);
+#else
+	simplexScalar(t_tables, t_dimensions, t_coordinates, t_results, t_count);
+#endif
+}
+
+/// <summary>
+/// Evaluates simplex noise for arrays of double coordinates, two at a time.
+/// </summary>
+void ab::NoiseKernel::simplexSSE2(const NoiseTables &t_tables, int t_dimensions, const double *const *t_coordinates, double *t_results, int t_count)
+{
+#ifdef NOISE_KERNEL_X86
+	simplexBatch<SSE2Double>(t_tables, t_dimensions, t_coordinates, t_results, t_count);
+#else
+	simplexScalar(t_tables, t_dimensions, t_coordinates, t_results, t_count);
+#endif
+}
+
+/// <summary>
+/// Checks if the CPU supports SSE2 (every 64-bit x86 CPU does).
+/// </summary>
+/// <returns>True if the SSE2 kernels can be used.</returns>
+bool ab::NoiseKernel::isSSE2Supported()
+{
+#if defined(_M_X64) || defined(__x86_64__)
+	return true;
+#elif defined(NOISE_KERNEL_X86) && defined(_MSC_VER)
+	int f_info[4];
+	__cpuid(f_info, 1);
+
+	return (f_info[3] & (1 << 26)) != 0;
+#elif defined(NOISE_KERNEL_X86)
+	return __builtin_cpu_supports("sse2");
+#else
+	return false;
+#endif
+}
+
+/// <summary>
+/// Checks if the CPU supports AVX2, and that the operating system saves the AVX registers.
+/// </summary>
+/// <returns>True if the AVX2 kernels can be used.</returns>
+bool ab::NoiseKernel::isAVX2Supported()
+{
+#if defined(NOISE_KERNEL_X86) && defined(_MSC_VER)
+	int f_info[4];
+	__cpuid(f_info, 0);
+
+	if (f_info[0] < 7)
+	{
+		return false;
+	}
+
+	// OSXSAVE and AVX, then check the OS has enabled the SSE and AVX state
+	__cpuid(f_info, 1);
+
+	if ((f_info[2] & (1 << 27)) == 0 || (f_info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 6) != 6)
+	{
+		return false;
+	}
+
+	__cpuidex(f_info, 7, 0);
+
+	return (f_info[1] & (1 << 5)) != 0;
+#elif defined(NOISE_KERNEL_X86)
+	return __builtin_cpu_supports("avx2");
+#else
+	return false;
+#endif
+}
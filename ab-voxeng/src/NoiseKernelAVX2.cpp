@@ -0,0 +1,103 @@
+// This file is compiled with AVX2 enabled (/arch:AVX2 or -mavx2), and nothing in it
+// may run unless NoiseKernel::isAVX2Supported() returns true.
+// Only intrinsics are used here, not the standard library, so there's no chance of an
+// AVX2 copy of a shared inline function being picked by the linker for the rest of the program.
+
+#include "NoiseKernel.h"
+
+#ifdef NOISE_KERNEL_X86
+#include <immintrin.h>
+
+namespace
+{
+	// Eight floats at a time
+	struct AVX2Float
+	{
+		typedef float T;
+		typedef __m256 V;
+		typedef __m256i I;
+		static const int WIDTH = 8;
+
+		static V set(T t_value) { return _mm256_set1_ps(t_value); }
+		static V load(const T *t_values) { return _mm256_loadu_ps(t_values); }
+		static void store(T *t_values, V t_value) { _mm256_storeu_ps(t_values, t_value); }
+		static V add(V a, V b) { return _mm256_add_ps(a, b); }
+		static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+		static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+		static V max(V a, V b) { return _mm256_max_ps(a, b); }
+		static V greater(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+		static V select(V t_mask, V t_value) { return _mm256_and_ps(t_mask, t_value); }
+		static I toInt(V t_value) { return _mm256_cvttps_epi32(t_value); }
+		static I addInt(I a, I b) { return _mm256_add_epi32(a, b); }
+		static I intOne() { return _mm256_set1_epi32(1); }
+		static I wrap(I t_value) { return _mm256_and_si256(t_value, _mm256_set1_epi32(255)); }
+		static I gather(const int *t_table, I t_index) { return _mm256_i32gather_epi32(t_table, t_index, 4); }
+		static V gatherGradient(const int *t_table, I t_index) { return _mm256_cvtepi32_ps(gather(t_table, t_index)); }
+
+		static V floor(V t_value, I &t_int)
+		{
+			V f_floor = _mm256_floor_ps(t_value);
+			t_int = _mm256_cvttps_epi32(f_floor);
+
+			return f_floor;
+		}
+	};
+
+	// Four doubles at a time (with four 32-bit integers)
+	struct AVX2Double
+	{
+		typedef double T;
+		typedef __m256d V;
+		typedef __m128i I;
+		static const int WIDTH = 4;
+
+		static V set(T t_value) { return _mm256_set1_pd(t_value); }
+		static V load(const T *t_values) { return _mm256_loadu_pd(t_values); }
+		static void store(T *t_values, V t_value) { _mm256_storeu_pd(t_values, t_value); }
+		static V add(V a, V b) { return _mm256_add_pd(a, b); }
+		static V sub(V a, V b) { return _mm256_sub_pd(a, b); }
+		static V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+		static V max(V a, V b) { return _mm256_max_pd(a, b); }
+		static V greater(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+		static V select(V t_mask, V t_value) { return _mm256_and_pd(t_mask, t_value); }
+		static I toInt(V t_value) { return _mm256_cvttpd_epi32(t_value); }
+		static I addInt(I a, I b) { return _mm_add_epi32(a, b); }
+		static I intOne() { return _mm_set1_epi32(1); }
+		static I wrap(I t_value) { return _mm_and_si128(t_value, _mm_set1_epi32(255)); }
+		static I gather(const int *t_table, I t_index) { return _mm_i32gather_epi32(t_table, t_index, 4); }
+		static V gatherGradient(const int *t_table, I t_index) { return _mm256_cvtepi32_pd(gather(t_table, t_index)); }
+
+		static V floor(V t_value, I &t_int)
+		{
+			V f_floor = _mm256_floor_pd(t_value);
+			t_int = _mm256_cvttpd_epi32(f_floor);
+
+			return f_floor;
+		}
+	};
+}
+#endif
+
+/// <summary>
+/// Evaluates simplex noise for arrays of float coordinates, eight at a time.
+/// </summary>
+void ab::NoiseKernel::simplexAVX2(const NoiseTables &t_tables, int t_dimensions, const float *const *t_coordinates, float *t_results, int t_count)
+{
+#ifdef NOISE_KERNEL_X86
+	simplexBatch<AVX2Float>(t_tables, t_dimensions, t_coordinates, t_results, t_count);
+#else
+	simplexScalar(t_tables, t_dimensions, t_coordinates, t_results, t_count);
+#endif
+}
+
+/// <summary>
+/// Evaluates simplex noise for arrays of double coordinates, four at a time.
+/// </summary>
+void ab::NoiseKernel::simplexAVX2(const NoiseTables &t_tables, int t_dimensions, const double *const *t_coordinates, double *t_results, int t_count)
+{
+#ifdef NOISE_KERNEL_X86
+	simplexBatch<AVX2Double>(t_tables, t_dimensions, t_coordinates, t_results, t_count);
+#else
+	simplexScalar(t_tables, t_dimensions, t_coordinates, t_results, t_count);
+#endif
+}
@@ -1,4 +1,5 @@
 #include "OpenGL.h"
+#include "Profiler.h"
 
 /// <summary>
 /// Import a model.
@@ -183,6 +184,7 @@ GLuint ab::OpenGL::createFBO(GLsizei t_width, GLsizei t_height)
 /// <returns>The assigned ID.</returns>
 GLuint ab::OpenGL::loadSkyBoxCubeMap(std::vector<std::string> &t_faces)
 {
+	PROFILE_SCOPE("OpenGL::loadSkyBoxCubeMap");
 	GLuint f_textureID;
 	glGenTextures(1, &f_textureID);
 	glActiveTexture(GL_TEXTURE11);
@@ -219,6 +221,75 @@ GLuint ab::OpenGL::loadSkyBoxCubeMap(std::vector<std::string> &t_faces)
 	return f_textureID;
 }
 
+/// <summary>
+/// Loads a set of images into a 2D texture array, one image per layer.
+/// All of the images must be RGBA and the same size as the first one.
+/// </summary>
+/// <param name="t_layers">The image filenames in layer order.</param>
+/// <param name="t_jobs">[OPTIONAL] If given, the images are decoded in parallel (they're always uploaded on the calling thread).</param>
+/// <returns>The texture ID.</returns>
+GLuint ab::OpenGL::loadTextureArray(std::vector<std::string> &t_layers, JobSystem *t_jobs)
+{
+	PROFILE_SCOPE("OpenGL::loadTextureArray");
+	int f_layerCount = (int)t_layers.size();
+	std::vector<unsigned char*> f_data(f_layerCount, nullptr);
+	std::vector<int> f_widths(f_layerCount, 0);
+	std::vector<int> f_heights(f_layerCount, 0);
+
+	stbi_set_flip_vertically_on_load(false);
+
+	// Decoding doesn't touch OpenGL, so it can happen on any thread
+	auto f_decode = [&](int t_begin, int t_end)
+	{
+		for (int i = t_begin; i < t_end; ++i)
+		{
+			int f_compCount;
+			f_data[i] = stbi_load(t_layers[i].c_str(), &f_widths[i], &f_heights[i], &f_compCount, 4);
+		}
+	};
+
+	if (t_jobs != nullptr)
+	{
+		t_jobs->parallelFor(0, f_layerCount, 1, f_decode);
+	}
+	else
+	{
+		f_decode(0, f_layerCount);
+	}
+
+	GLuint f_textureID;
+	glGenTextures(1, &f_textureID);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, f_textureID);
+
+	for (int i = 0; i < f_layerCount; i++)
+	{
+		if (f_data[i] == nullptr)
+		{
+			std::cout << "Texture array layer failed to load at path: " << t_layers[i] << std::endl;
+			continue;
+		}
+
+		// The size of the first image is used for the whole array
+		if (i == 0)
+		{
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, f_widths[i], f_heights[i], f_layerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		}
+
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, f_widths[i], f_heights[i], 1, GL_RGBA, GL_UNSIGNED_BYTE, f_data[i]);
+		stbi_image_free(f_data[i]);
+	}
+
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	return f_textureID;
+}
+
 /// <summary>
 /// Next power of two utility function.
 /// </summary>
@@ -0,0 +1,291 @@
+#include "Profiler.h"
+#include "Json.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+std::mutex ab::Profiler::s_mutex;
+std::vector<std::unique_ptr<ab::Profiler::ThreadBuffer>> ab::Profiler::s_buffers;
+std::uint32_t ab::Profiler::s_threadCount = 0;
+
+namespace
+{
+	/// <summary>
+	/// Writes a time in nanoseconds as microseconds (what Chrome traces use).
+	/// </summary>
+	void writeMicroseconds(std::ostream &t_stream, std::int64_t t_nanoseconds)
+	{
+		char f_text[32];
+		std::snprintf(f_text, sizeof(f_text), "%lld.%03lld", (long long)(t_nanoseconds / 1000), (long long)(t_nanoseconds % 1000));
+		t_stream << f_text;
+	}
+}
+
+/// <summary>
+/// Constructor for the Zone class. Starts timing.
+/// </summary>
+/// <param name="t_name">The zone's name (a string literal, only the pointer is kept).</param>
+ab::Profiler::Zone::Zone(const char *t_name) :
+	m_name(t_name)
+{
+	getBuffer().depth++;
+	m_start = now();
+}
+
+/// <summary>
+/// Destructor for the Zone class. Records the zone.
+/// </summary>
+ab::Profiler::Zone::~Zone()
+{
+	std::int64_t f_end = now();
+	ThreadBuffer &f_buffer = getBuffer();
+	f_buffer.depth--;
+
+	record(f_buffer, { m_name, m_start, f_end - m_start, 0.0, f_buffer.depth, EventType::ZONE });
+}
+
+/// <summary>
+/// Records the value of a counter, use PROFILE_COUNTER() instead of calling this directly.
+/// </summary>
+/// <param name="t_name">The counter's name (a string literal, only the pointer is kept).</param>
+/// <param name="t_value">The value.</param>
+void ab::Profiler::counter(const char *t_name, double t_value)
+{
+	ThreadBuffer &f_buffer = getBuffer();
+	record(f_buffer, { t_name, now(), 0, t_value, f_buffer.depth, EventType::COUNTER });
+}
+
+/// <summary>
+/// Names the calling thread, use PROFILE_THREAD() instead of calling this directly.
+/// </summary>
+/// <param name="t_name">The name shown on the timeline.</param>
+void ab::Profiler::setThreadName(const std::string &t_name)
+{
+	ThreadBuffer &f_buffer = getBuffer();
+	std::lock_guard<std::mutex> f_lock(s_mutex);
+	f_buffer.name = t_name;
+}
+
+/// <summary>
+/// Gets the time on the profiler's clock.
+/// </summary>
+/// <returns>Nanoseconds since the profiler was first used.</returns>
+std::int64_t ab::Profiler::now()
+{
+	static const std::chrono::steady_clock::time_point s_epoch = std::chrono::steady_clock::now();
+
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_epoch).count();
+}
+
+/// <summary>
+/// Copies every thread's recorded events. The threads carry on recording while this happens,
+/// so any events that might have been overwritten during the copy are left out.
+/// </summary>
+/// <returns>The events of each thread that has recorded anything.</returns>
+std::vector<ab::Profiler::ThreadEvents> ab::Profiler::capture()
+{
+	std::lock_guard<std::mutex> f_lock(s_mutex);
+	std::vector<ThreadEvents> f_threads;
+
+	for (const std::unique_ptr<ThreadBuffer> &f_buffer : s_buffers)
+	{
+		std::uint64_t f_head = f_buffer->head.load(std::memory_order_acquire);
+		std::uint64_t f_first = std::max(f_buffer->tail.load(), f_head > EVENTS_PER_THREAD ? f_head - EVENTS_PER_THREAD : 0);
+
+		ThreadEvents f_thread;
+		f_thread.id = f_buffer->id;
+		f_thread.name = f_buffer->name;
+
+		for (std::uint64_t i = f_first; i < f_head; ++i)
+		{
+			f_thread.events.push_back(f_buffer->events[i % EVENTS_PER_THREAD]);
+		}
+
+		// A running thread may have wrapped around onto the oldest events while they were copied (it could be writing the next slot now)
+		std::uint64_t f_after = f_buffer->head.load(std::memory_order_acquire);
+		std::uint64_t f_safe = !f_buffer->retired && f_after >= EVENTS_PER_THREAD ? f_after - EVENTS_PER_THREAD + 1 : 0;
+
+		if (f_safe > f_first)
+		{
+			f_thread.events.erase(f_thread.events.begin(), f_thread.events.begin() + (std::ptrdiff_t)std::min<std::uint64_t>(f_safe - f_first, f_thread.events.size()));
+		}
+
+		f_threads.push_back(std::move(f_thread));
+	}
+
+	return f_threads;
+}
+
+/// <summary>
+/// Copies the calling thread's most recent events, e.g. the zones of the last frame. This only reads
+/// the calling thread's own buffer, from the newest event back, so it's cheap enough to call every frame.
+/// </summary>
+/// <param name="t_since">Events that started before this time (see now()) are left out.</param>
+/// <returns>The events, in the order they were recorded (zones are recorded when they end, so children come before their parents).</returns>
+std::vector<ab::Profiler::Event> ab::Profiler::getRecentEvents(std::int64_t t_since)
+{
+	ThreadBuffer &f_buffer = getBuffer();
+	std::uint64_t f_head = f_buffer.head.load(std::memory_order_relaxed);
+	std::uint64_t f_first = std::max(f_buffer.tail.load(), f_head > EVENTS_PER_THREAD ? f_head - EVENTS_PER_THREAD : 0);
+	std::vector<Event> f_events;
+
+	// Events are recorded in the order they end, so nothing earlier can have started after t_since
+	for (std::uint64_t i = f_head; i > f_first; --i)
+	{
+		const Event &f_event = f_buffer.events[(i - 1) % EVENTS_PER_THREAD];
+
+		if (f_event.start + f_event.duration < t_since)
+		{
+			break;
+		}
+
+		if (f_event.start >= t_since)
+		{
+			f_events.push_back(f_event);
+		}
+	}
+
+	std::reverse(f_events.begin(), f_events.end());
+
+	return f_events;
+}
+
+/// <summary>
+/// Writes the recorded events as a Chrome trace (the JSON object format), zones as complete events and counters as counter events.
+/// </summary>
+/// <param name="t_path">The file to write.</param>
+/// <returns>True if the file was written.</returns>
+bool ab::Profiler::writeChromeTrace(const std::string &t_path)
+{
+	std::vector<ThreadEvents> f_threads = capture();
+	std::ofstream f_file(t_path);
+
+	if (!f_file)
+	{
+		return false;
+	}
+
+	f_file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool f_first = true;
+
+	for (ThreadEvents &f_thread : f_threads)
+	{
+		// Parents start no later than their children, so sorting by start (then depth) puts them first
+		std::stable_sort(f_thread.events.begin(), f_thread.events.end(), [](const Event &a, const Event &b)
+		{
+			return a.start < b.start || (a.start == b.start && a.depth < b.depth);
+		});
+
+		if (!f_thread.name.empty())
+		{
+			f_file << (f_first ? "" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << f_thread.id << ",\"args\":{\"name\":";
+			ab::Json::writeString(f_file, f_thread.name);
+			f_file << "}}";
+			f_first = false;
+		}
+
+		for (const Event &f_event : f_thread.events)
+		{
+			f_file << (f_first ? "" : ",\n") << "{\"ph\":\"" << (f_event.type == EventType::ZONE ? 'X' : 'C') << "\",\"name\":";
+			ab::Json::writeString(f_file, f_event.name);
+			f_file << ",\"pid\":1,\"tid\":" << f_thread.id << ",\"ts\":";
+			writeMicroseconds(f_file, f_event.start);
+
+			if (f_event.type == EventType::ZONE)
+			{
+				f_file << ",\"dur\":";
+				writeMicroseconds(f_file, f_event.duration);
+			}
+			else
+			{
+				f_file << ",\"args\":{\"value\":" << f_event.value << "}";
+			}
+
+			f_file << "}";
+			f_first = false;
+		}
+	}
+
+	f_file << "\n]}\n";
+
+	return (bool)f_file;
+}
+
+/// <summary>
+/// Forgets the events recorded so far, so the next capture only has what happens after this.
+/// </summary>
+void ab::Profiler::clear()
+{
+	std::lock_guard<std::mutex> f_lock(s_mutex);
+
+	for (const std::unique_ptr<ThreadBuffer> &f_buffer : s_buffers)
+	{
+		f_buffer->tail = f_buffer->head.load(std::memory_order_acquire);
+	}
+}
+
+/// <summary>
+/// Destructor for the BufferOwner class. Lets a new thread reuse the buffer.
+/// </summary>
+ab::Profiler::BufferOwner::~BufferOwner()
+{
+	if (buffer != nullptr)
+	{
+		std::lock_guard<std::mutex> f_lock(s_mutex);
+		buffer->retired = true;
+	}
+}
+
+/// <summary>
+/// Gets the calling thread's buffer. The first time a thread records anything it takes the buffer of
+/// a thread that has ended (dropping its events), or a new one if there isn't one.
+/// </summary>
+/// <returns>The buffer.</returns>
+ab::Profiler::ThreadBuffer &ab::Profiler::getBuffer()
+{
+	thread_local BufferOwner s_owner;
+
+	if (s_owner.buffer == nullptr)
+	{
+		std::lock_guard<std::mutex> f_lock(s_mutex);
+
+		for (const std::unique_ptr<ThreadBuffer> &f_buffer : s_buffers)
+		{
+			if (f_buffer->retired)
+			{
+				s_owner.buffer = f_buffer.get();
+				break;
+			}
+		}
+
+		if (s_owner.buffer == nullptr)
+		{
+			s_buffers.emplace_back(new ThreadBuffer());
+			s_owner.buffer = s_buffers.back().get();
+			s_owner.buffer->head = 0;
+		}
+
+		s_owner.buffer->id = ++s_threadCount;
+		s_owner.buffer->name.clear();
+		s_owner.buffer->depth = 0;
+		s_owner.buffer->retired = false;
+		s_owner.buffer->tail = s_owner.buffer->head.load();
+	}
+
+	return *s_owner.buffer;
+}
+
+/// <summary>
+/// Adds an event to a thread's ring buffer. Only the buffer's own thread calls this, so the event is
+/// filled in first and then published by moving the head on, no lock needed.
+/// </summary>
+/// <param name="t_buffer">The calling thread's buffer.</param>
+/// <param name="t_event">The event.</param>
+void ab::Profiler::record(ThreadBuffer &t_buffer, const Event &t_event)
+{
+	std::uint64_t f_head = t_buffer.head.load(std::memory_order_relaxed);
+	t_buffer.events[f_head % EVENTS_PER_THREAD] = t_event;
+	t_buffer.head.store(f_head + 1, std::memory_order_release);
+}
@@ -0,0 +1,485 @@
+#include "RegionFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	const char MAGIC[4] = { 'A', 'B', 'R', 'G' };
+	const std::size_t COLUMN_FLAGS_OFFSET = 20;
+	const std::size_t TABLE_OFFSET = COLUMN_FLAGS_OFFSET + ab::RegionFile::COLUMNS * ab::RegionFile::COLUMNS;
+	const std::size_t HEADER_SIZE = TABLE_OFFSET + ab::RegionFile::CHUNKS * 8;
+
+	std::uint32_t readU32(const unsigned char *t_data)
+	{
+		return (std::uint32_t)t_data[0] | (std::uint32_t)t_data[1] << 8 | (std::uint32_t)t_data[2] << 16 | (std::uint32_t)t_data[3] << 24;
+	}
+
+	void writeU32(unsigned char *t_data, std::uint32_t t_value)
+	{
+		t_data[0] = (unsigned char)t_value;
+		t_data[1] = (unsigned char)(t_value >> 8);
+		t_data[2] = (unsigned char)(t_value >> 16);
+		t_data[3] = (unsigned char)(t_value >> 24);
+	}
+}
+
+/// <summary>
+/// Constructor for the RegionFile class.
+/// </summary>
+ab::RegionFile::RegionFile() :
+	m_data(nullptr),
+	m_size(0),
+	m_regionX(0),
+	m_regionZ(0)
+#ifdef _WIN32
+	, m_file(INVALID_HANDLE_VALUE),
+	m_mapping(nullptr)
+#endif
+{
+}
+
+/// <summary>
+/// Destructor for the RegionFile class.
+/// </summary>
+ab::RegionFile::~RegionFile()
+{
+	close();
+}
+
+/// <summary>
+/// Maps a region file into memory and checks its header. Nothing else is read until chunks are asked for.
+/// </summary>
+/// <param name="t_path">The path of the region file.</param>
+/// <returns>True if the file was opened, false if it doesn't exist, is damaged, or was saved by a different version.</returns>
+bool ab::RegionFile::open(const std::string &t_path)
+{
+	close();
+
+#ifdef _WIN32
+	m_file = CreateFileA(t_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (m_file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER f_size;
+
+	if (!GetFileSizeEx(m_file, &f_size) || f_size.QuadPart < (LONGLONG)HEADER_SIZE)
+	{
+		close();
+		return false;
+	}
+
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	m_data = m_mapping != nullptr ? (const unsigned char *)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	m_size = (std::size_t)f_size.QuadPart;
+#else
+	int f_file = ::open(t_path.c_str(), O_RDONLY);
+
+	if (f_file < 0)
+	{
+		return false;
+	}
+
+	struct stat f_stat;
+
+	if (fstat(f_file, &f_stat) != 0 || f_stat.st_size < (off_t)HEADER_SIZE)
+	{
+		::close(f_file);
+		return false;
+	}
+
+	// The mapping stays valid once the file is closed
+	void *f_data = mmap(nullptr, (std::size_t)f_stat.st_size, PROT_READ, MAP_SHARED, f_file, 0);
+	::close(f_file);
+	m_data = f_data != MAP_FAILED ? (const unsigned char *)f_data : nullptr;
+	m_size = (std::size_t)f_stat.st_size;
+#endif
+
+	if (m_data == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	// Only files with the same layout and chunk size can be read
+	if (std::memcmp(m_data, MAGIC, 4) != 0 || readU32(m_data + 4) != VERSION ||
+		m_data[16] != CHUNK_WIDTH || m_data[17] != CHUNK_HEIGHT || m_data[18] != CHUNK_DEPTH || m_data[19] != COLUMN_CHUNKS)
+	{
+		close();
+		return false;
+	}
+
+	m_regionX = (int)readU32(m_data + 8);
+	m_regionZ = (int)readU32(m_data + 12);
+
+	return true;
+}
+
+/// <summary>
+/// Unmaps the file.
+/// </summary>
+void ab::RegionFile::close()
+{
+#ifdef _WIN32
+	if (m_data != nullptr)
+	{
+		UnmapViewOfFile(m_data);
+	}
+
+	if (m_mapping != nullptr)
+	{
+		CloseHandle(m_mapping);
+	}
+
+	if (m_file != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_file);
+	}
+
+	m_mapping = nullptr;
+	m_file = INVALID_HANDLE_VALUE;
+#else
+	if (m_data != nullptr)
+	{
+		munmap((void *)m_data, m_size);
+	}
+#endif
+
+	m_data = nullptr;
+	m_size = 0;
+}
+
+/// <summary>
+/// Checks if a region file is open.
+/// </summary>
+/// <returns>True if the file is open.</returns>
+bool ab::RegionFile::isOpen() const
+{
+	return m_data != nullptr;
+}
+
+/// <summary>
+/// Checks if a column was saved in this region.
+/// </summary>
+/// <param name="t_column">The column, from getColumn().</param>
+/// <returns>True if the column was saved.</returns>
+bool ab::RegionFile::hasColumn(int t_column) const
+{
+	return m_data != nullptr && m_data[COLUMN_FLAGS_OFFSET + t_column] != 0;
+}
+
+/// <summary>
+/// Gets a chunk's compressed data, straight from the mapped file.
+/// </summary>
+/// <param name="t_chunk">The chunk, from getChunkIndex().</param>
+/// <returns>The compressed data, with a size of 0 if the chunk is all air or the table entry is damaged.</returns>
+ab::RegionFile::ChunkData ab::RegionFile::getChunk(int t_chunk) const
+{
+	ChunkData f_chunk = { nullptr, 0 };
+
+	if (m_data == nullptr)
+	{
+		return f_chunk;
+	}
+
+	std::uint32_t f_offset = readU32(m_data + TABLE_OFFSET + t_chunk * 8);
+	std::uint32_t f_size = readU32(m_data + TABLE_OFFSET + t_chunk * 8 + 4);
+
+	if (f_size > 0 && f_offset >= HEADER_SIZE && f_offset <= m_size && f_size <= m_size - f_offset)
+	{
+		f_chunk.data = m_data + f_offset;
+		f_chunk.size = f_size;
+	}
+
+	return f_chunk;
+}
+
+/// <summary>
+/// Reads and decompresses a chunk.
+/// </summary>
+/// <param name="t_chunk">The chunk, from getChunkIndex().</param>
+/// <param name="t_voxels">Filled with the chunk's voxels (CHUNK_VOXELS of them), using Utility::at() ordering.</param>
+/// <returns>False if the chunk's data is damaged (the voxels are then all air).</returns>
+bool ab::RegionFile::readChunk(int t_chunk, char *t_voxels) const
+{
+	ChunkData f_chunk = getChunk(t_chunk);
+
+	if (f_chunk.size == 0)
+	{
+		std::memset(t_voxels, 0, CHUNK_VOXELS);
+		return true;
+	}
+
+	if (!decompress(f_chunk.data, f_chunk.size, t_voxels))
+	{
+		std::memset(t_voxels, 0, CHUNK_VOXELS);
+		return false;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Asks for the data of a range of chunks to be read from disk in one go, rather than a page at a time as it's touched.
+/// </summary>
+/// <param name="t_firstChunk">The first chunk, from getChunkIndex().</param>
+/// <param name="t_lastChunk">The last chunk (inclusive).</param>
+void ab::RegionFile::prefetch(int t_firstChunk, int t_lastChunk) const
+{
+	std::size_t f_begin = m_size;
+	std::size_t f_end = 0;
+
+	for (int i = t_firstChunk; i <= t_lastChunk; ++i)
+	{
+		ChunkData f_chunk = getChunk(i);
+
+		if (f_chunk.size > 0)
+		{
+			f_begin = std::min(f_begin, (std::size_t)(f_chunk.data - m_data));
+			f_end = std::max(f_end, (std::size_t)(f_chunk.data - m_data) + f_chunk.size);
+		}
+	}
+
+	if (f_begin >= f_end)
+	{
+		return;
+	}
+
+	const std::size_t PAGE_BYTES = 4096;
+	f_begin -= f_begin % PAGE_BYTES;
+
+#ifdef _WIN32
+	// Touching the pages in order lets the system's read ahead fetch the rest of the range
+	volatile unsigned char f_sink = 0;
+
+	for (std::size_t i = f_begin; i < f_end; i += PAGE_BYTES)
+	{
+		f_sink += m_data[i];
+	}
+#else
+	madvise((void *)(m_data + f_begin), f_end - f_begin, MADV_WILLNEED);
+#endif
+}
+
+/// <summary>
+/// Gets the X position of the region (in regions).
+/// </summary>
+/// <returns>The X position.</returns>
+int ab::RegionFile::getRegionX() const
+{
+	return m_regionX;
+}
+
+/// <summary>
+/// Gets the Z position of the region (in regions).
+/// </summary>
+/// <returns>The Z position.</returns>
+int ab::RegionFile::getRegionZ() const
+{
+	return m_regionZ;
+}
+
+/// <summary>
+/// Gets the size of the open file.
+/// </summary>
+/// <returns>The size in bytes.</returns>
+std::size_t ab::RegionFile::getFileSize() const
+{
+	return m_size;
+}
+
+/// <summary>
+/// Gets the index of a column within a region.
+/// </summary>
+/// <param name="t_localX">The X position of the column within the region (0 to COLUMNS - 1).</param>
+/// <param name="t_localZ">The Z position of the column within the region (0 to COLUMNS - 1).</param>
+/// <returns>The column index.</returns>
+int ab::RegionFile::getColumn(int t_localX, int t_localZ)
+{
+	return t_localX * COLUMNS + t_localZ;
+}
+
+/// <summary>
+/// Gets the index of a chunk within a region.
+/// </summary>
+/// <param name="t_column">The column, from getColumn().</param>
+/// <param name="t_chunkY">The Y position of the chunk (in chunks).</param>
+/// <returns>The chunk index.</returns>
+int ab::RegionFile::getChunkIndex(int t_column, int t_chunkY)
+{
+	return t_column * COLUMN_CHUNKS + t_chunkY;
+}
+
+/// <summary>
+/// Writes a region file. Write to a temporary file and replace() the region with it afterwards so a region is never left half written.
+/// </summary>
+/// <param name="t_path">The path of the region file.</param>
+/// <param name="t_regionX">The X position of the region (in regions).</param>
+/// <param name="t_regionZ">The Z position of the region (in regions).</param>
+/// <param name="t_columns">Which columns are saved (COLUMNS * COLUMNS of them).</param>
+/// <param name="t_chunks">The compressed chunks (CHUNKS of them).</param>
+/// <returns>True if the file was written.</returns>
+bool ab::RegionFile::write(const std::string &t_path, int t_regionX, int t_regionZ, const bool *t_columns, const ChunkData *t_chunks)
+{
+	std::vector<unsigned char> f_header(HEADER_SIZE, 0);
+	std::memcpy(f_header.data(), MAGIC, 4);
+	writeU32(&f_header[4], VERSION);
+	writeU32(&f_header[8], (std::uint32_t)t_regionX);
+	writeU32(&f_header[12], (std::uint32_t)t_regionZ);
+	f_header[16] = CHUNK_WIDTH;
+	f_header[17] = CHUNK_HEIGHT;
+	f_header[18] = CHUNK_DEPTH;
+	f_header[19] = COLUMN_CHUNKS;
+
+	for (int i = 0; i < COLUMNS * COLUMNS; ++i)
+	{
+		f_header[COLUMN_FLAGS_OFFSET + i] = t_columns[i] ? 1 : 0;
+	}
+
+	std::uint32_t f_offset = (std::uint32_t)HEADER_SIZE;
+
+	for (int i = 0; i < CHUNKS; ++i)
+	{
+		writeU32(&f_header[TABLE_OFFSET + i * 8], t_chunks[i].size > 0 ? f_offset : 0);
+		writeU32(&f_header[TABLE_OFFSET + i * 8 + 4], t_chunks[i].size);
+		f_offset += t_chunks[i].size;
+	}
+
+	std::FILE *f_file = std::fopen(t_path.c_str(), "wb");
+
+	if (f_file == nullptr)
+	{
+		return false;
+	}
+
+	bool f_written = std::fwrite(f_header.data(), 1, f_header.size(), f_file) == f_header.size();
+
+	for (int i = 0; i < CHUNKS && f_written; ++i)
+	{
+		if (t_chunks[i].size > 0)
+		{
+			f_written = std::fwrite(t_chunks[i].data, 1, t_chunks[i].size, f_file) == t_chunks[i].size;
+		}
+	}
+
+	return std::fclose(f_file) == 0 && f_written;
+}
+
+/// <summary>
+/// Moves a file over another one (e.g. a region written by write()) in a single step, so whatever happens
+/// there's always a complete copy of the file: the old one if this fails, the new one if it succeeds.
+/// The file being replaced mustn't be open.
+/// </summary>
+/// <param name="t_from">The path of the new file.</param>
+/// <param name="t_to">The path of the file to replace (it doesn't have to exist).</param>
+/// <returns>True if the file was replaced.</returns>
+bool ab::RegionFile::replace(const std::string &t_from, const std::string &t_to)
+{
+#ifdef _WIN32
+	return MoveFileExA(t_from.c_str(), t_to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	return std::rename(t_from.c_str(), t_to.c_str()) == 0;
+#endif
+}
+
+/// <summary>
+/// Compresses a chunk's voxels as runs of the same voxel type.
+/// </summary>
+/// <param name="t_voxels">The chunk's voxels (CHUNK_VOXELS of them), using Utility::at() ordering.</param>
+/// <param name="t_data">Replaced with the compressed data.</param>
+void ab::RegionFile::compress(const char *t_voxels, std::vector<unsigned char> &t_data)
+{
+	t_data.clear();
+	int i = 0;
+
+	while (i < CHUNK_VOXELS)
+	{
+		char f_type = t_voxels[i];
+		int f_start = i;
+
+		while (i < CHUNK_VOXELS && t_voxels[i] == f_type)
+		{
+			i++;
+		}
+
+		// The type, then the run length 7 bits at a time (the top bit means another byte follows)
+		unsigned int f_length = (unsigned int)(i - f_start);
+		t_data.push_back((unsigned char)f_type);
+
+		while (f_length >= 0x80)
+		{
+			t_data.push_back((unsigned char)(f_length | 0x80));
+			f_length >>= 7;
+		}
+
+		t_data.push_back((unsigned char)f_length);
+	}
+}
+
+/// <summary>
+/// Decompresses a chunk written by compress().
+/// </summary>
+/// <param name="t_data">The compressed data.</param>
+/// <param name="t_size">The size of the compressed data.</param>
+/// <param name="t_voxels">Filled with the chunk's voxels (CHUNK_VOXELS of them).</param>
+/// <returns>False if the data is damaged (it doesn't describe exactly one chunk, or has a voxel type that doesn't exist).</returns>
+bool ab::RegionFile::decompress(const unsigned char *t_data, std::size_t t_size, char *t_voxels)
+{
+	std::size_t f_read = 0;
+	int f_written = 0;
+
+	while (f_read < t_size)
+	{
+		unsigned char f_type = t_data[f_read++];
+		unsigned int f_length = 0;
+		int f_shift = 0;
+
+		// Types past the last one would index past the block tables when the chunk is meshed
+		if (f_type >= (unsigned char)BLOCK_TYPE_COUNT)
+		{
+			return false;
+		}
+
+		while (true)
+		{
+			if (f_read >= t_size || f_shift > 14)
+			{
+				return false;
+			}
+
+			unsigned char f_byte = t_data[f_read++];
+			f_length |= (unsigned int)(f_byte & 0x7f) << f_shift;
+			f_shift += 7;
+
+			if ((f_byte & 0x80) == 0)
+			{
+				break;
+			}
+		}
+
+		if (f_length == 0 || f_length > (unsigned int)(CHUNK_VOXELS - f_written))
+		{
+			return false;
+		}
+
+		std::memset(t_voxels + f_written, (char)f_type, f_length);
+		f_written += (int)f_length;
+	}
+
+	return f_written == CHUNK_VOXELS;
+}
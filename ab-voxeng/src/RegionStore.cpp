@@ -0,0 +1,486 @@
+#include "RegionStore.h"
+#include "World.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+/// <summary>
+/// Constructor for the RegionStore class.
+/// The directory is created the first time columns are flushed to it.
+/// </summary>
+/// <param name="t_directory">The directory that holds the region files.</param>
+RegionStore::RegionStore(const std::string &t_directory) :
+	m_directory(t_directory)
+{
+}
+
+/// <summary>
+/// Destructor for the RegionStore class.
+/// Columns that haven't been flushed are lost.
+/// </summary>
+RegionStore::~RegionStore()
+{
+}
+
+/// <summary>
+/// Checks if a column has been saved.
+/// </summary>
+/// <param name="t_columnX">The X position of the column (in chunks).</param>
+/// <param name="t_columnZ">The Z position of the column (in chunks).</param>
+/// <returns>True if the column has been saved (flushed or not).</returns>
+bool RegionStore::hasColumn(int t_columnX, int t_columnZ)
+{
+	if (findPending(t_columnX, t_columnZ) != nullptr)
+	{
+		return true;
+	}
+
+	int f_regionX;
+	int f_regionZ;
+	int f_column;
+	getRegionPosition(t_columnX, t_columnZ, f_regionX, f_regionZ, f_column);
+
+	std::lock_guard<std::mutex> f_lock(m_fileMutex);
+
+	return getRegion(f_regionX, f_regionZ).hasColumn(f_column);
+}
+
+/// <summary>
+/// Reads a saved column, in the same layout as Terrain::generateColumn().
+/// This can be called from any thread.
+/// </summary>
+/// <param name="t_columnX">The X position of the column (in chunks).</param>
+/// <param name="t_columnZ">The Z position of the column (in chunks).</param>
+/// <param name="t_voxels">Filled with the column's voxels, one chunk after another from the bottom up.</param>
+/// <param name="t_used">Filled with whether each chunk has anything other than air in it.</param>
+/// <returns>True if the column was read, false if it hasn't been saved or its data is damaged.</returns>
+bool RegionStore::readColumn(int t_columnX, int t_columnZ, char *t_voxels, bool *t_used)
+{
+	PendingPtr f_pending = findPending(t_columnX, t_columnZ);
+
+	if (f_pending != nullptr)
+	{
+		return readPending(*f_pending, t_voxels, t_used);
+	}
+
+	int f_regionX;
+	int f_regionZ;
+	int f_column;
+	getRegionPosition(t_columnX, t_columnZ, f_regionX, f_regionZ, f_column);
+
+	std::lock_guard<std::mutex> f_lock(m_fileMutex);
+
+	return readFile(getRegion(f_regionX, f_regionZ), f_column, t_voxels, t_used);
+}
+
+/// <summary>
+/// Reads a batch of saved columns. Columns that haven't been flushed are read from memory, the rest are read in
+/// the order they're stored, a region at a time, and the data for each region's columns is asked for from disk in one go.
+/// This can be called from any thread.
+/// </summary>
+/// <param name="t_reads">The columns to read. Each one's found flag is set if it was read.</param>
+void RegionStore::readColumns(std::vector<ColumnRead> &t_reads)
+{
+	struct Key
+	{
+		int regionX;
+		int regionZ;
+		int column;
+	};
+
+	std::vector<PendingPtr> f_pending(t_reads.size());
+
+	{
+		std::lock_guard<std::mutex> f_lock(m_mutex);
+
+		for (std::size_t i = 0; i < t_reads.size(); ++i)
+		{
+			auto f_found = m_pending.find({ t_reads[i].x, 0, t_reads[i].z });
+
+			if (f_found != m_pending.end())
+			{
+				f_pending[i] = f_found->second;
+			}
+		}
+	}
+
+	std::vector<Key> f_keys(t_reads.size());
+	std::vector<std::size_t> f_order;
+
+	for (std::size_t i = 0; i < t_reads.size(); ++i)
+	{
+		if (f_pending[i] != nullptr)
+		{
+			t_reads[i].found = readPending(*f_pending[i], t_reads[i].voxels, t_reads[i].used);
+		}
+		else
+		{
+			getRegionPosition(t_reads[i].x, t_reads[i].z, f_keys[i].regionX, f_keys[i].regionZ, f_keys[i].column);
+			f_order.push_back(i);
+		}
+	}
+
+	std::sort(f_order.begin(), f_order.end(), [&](std::size_t a, std::size_t b)
+	{
+		const Key &f_a = f_keys[a];
+		const Key &f_b = f_keys[b];
+
+		if (f_a.regionX != f_b.regionX)
+		{
+			return f_a.regionX < f_b.regionX;
+		}
+
+		return f_a.regionZ != f_b.regionZ ? f_a.regionZ < f_b.regionZ : f_a.column < f_b.column;
+	});
+
+	std::lock_guard<std::mutex> f_lock(m_fileMutex);
+	std::size_t f_first = 0;
+
+	while (f_first < f_order.size())
+	{
+		// The reads that are in the same region as the first one
+		const Key &f_key = f_keys[f_order[f_first]];
+		std::size_t f_last = f_first;
+
+		while (f_last + 1 < f_order.size() && f_keys[f_order[f_last + 1]].regionX == f_key.regionX && f_keys[f_order[f_last + 1]].regionZ == f_key.regionZ)
+		{
+			f_last++;
+		}
+
+		ab::RegionFile &f_file = getRegion(f_key.regionX, f_key.regionZ);
+		f_file.prefetch(ab::RegionFile::getChunkIndex(f_key.column, 0), ab::RegionFile::getChunkIndex(f_keys[f_order[f_last]].column, ab::RegionFile::COLUMN_CHUNKS - 1));
+
+		for (std::size_t i = f_first; i <= f_last; ++i)
+		{
+			ColumnRead &f_read = t_reads[f_order[i]];
+			f_read.found = readFile(f_file, f_keys[f_order[i]].column, f_read.voxels, f_read.used);
+		}
+
+		f_first = f_last + 1;
+	}
+}
+
+/// <summary>
+/// Saves a column. It's compressed straight away but not written to disk until flush().
+/// Only the lock on the columns waiting to be flushed is taken, and only to add this one, so this never waits for the disk.
+/// </summary>
+/// <param name="t_columnX">The X position of the column (in chunks).</param>
+/// <param name="t_columnZ">The Z position of the column (in chunks).</param>
+/// <param name="t_voxels">The column's voxels, in the same layout as Terrain::generateColumn().</param>
+/// <param name="t_used">Whether each chunk has anything other than air in it (chunks that don't aren't looked at).</param>
+void RegionStore::writeColumn(int t_columnX, int t_columnZ, const char *t_voxels, const bool *t_used)
+{
+	std::shared_ptr<PendingColumn> f_pending = std::make_shared<PendingColumn>();
+	f_pending->chunks.resize(ab::RegionFile::COLUMN_CHUNKS);
+
+	for (int cy = 0; cy < ab::RegionFile::COLUMN_CHUNKS; ++cy)
+	{
+		if (t_used[cy])
+		{
+			ab::RegionFile::compress(t_voxels + cy * ab::RegionFile::CHUNK_VOXELS, f_pending->chunks[cy]);
+		}
+	}
+
+	std::lock_guard<std::mutex> f_lock(m_mutex);
+	m_pending[{ t_columnX, 0, t_columnZ }] = f_pending;
+}
+
+/// <summary>
+/// Saves a column of the world. It's compressed straight away but not written to disk until flush().
+/// Call this from the main thread.
+/// </summary>
+/// <param name="t_columnX">The X position of the column (in chunks).</param>
+/// <param name="t_columnZ">The Z position of the column (in chunks).</param>
+/// <param name="t_world">The world to save the column from.</param>
+void RegionStore::writeColumn(int t_columnX, int t_columnZ, const World &t_world)
+{
+	std::vector<char> f_voxels(ab::RegionFile::COLUMN_CHUNKS * ab::RegionFile::CHUNK_VOXELS);
+	bool f_used[ab::RegionFile::COLUMN_CHUNKS];
+	t_world.copyColumn(t_columnX, t_columnZ, f_voxels.data(), f_used);
+
+	writeColumn(t_columnX, t_columnZ, f_voxels.data(), f_used);
+}
+
+/// <summary>
+/// Writes the saved columns into their region files, keeping the columns already in them.
+/// The saved columns are taken while their lock is held, then each region is copied while the region files are
+/// locked, written to a temporary file without any lock, and the region files are only locked again to swap the
+/// new file in. Columns are only forgotten once their region file has been swapped in, so reads never miss them.
+/// </summary>
+/// <returns>True if every region was written.</returns>
+bool RegionStore::flush()
+{
+	// A column waiting to be flushed, and where it goes in its region file
+	struct FlushColumn
+	{
+		Indices position;
+		int column;
+		PendingPtr pending;
+	};
+
+	std::lock_guard<std::mutex> f_flushLock(m_flushMutex);
+	std::unordered_map<Indices, std::vector<FlushColumn>, IndicesHash> f_regions; // Keyed by region position (y is always 0)
+
+	{
+		std::lock_guard<std::mutex> f_lock(m_mutex);
+
+		for (const auto &f_pair : m_pending)
+		{
+			int f_regionX;
+			int f_regionZ;
+			int f_column;
+			getRegionPosition(f_pair.first.x, f_pair.first.z, f_regionX, f_regionZ, f_column);
+			f_regions[{ f_regionX, 0, f_regionZ }].push_back({ f_pair.first, f_column, f_pair.second });
+		}
+	}
+
+	if (f_regions.empty())
+	{
+		return true;
+	}
+
+#ifdef _WIN32
+	_mkdir(m_directory.c_str());
+#else
+	mkdir(m_directory.c_str(), 0755);
+#endif
+
+	const int COLUMN_COUNT = ab::RegionFile::COLUMNS * ab::RegionFile::COLUMNS;
+	bool f_succeeded = true;
+	std::vector<unsigned char> f_data;
+	std::vector<std::size_t> f_offsets(ab::RegionFile::CHUNKS);
+	std::vector<ab::RegionFile::ChunkData> f_chunks(ab::RegionFile::CHUNKS);
+	std::vector<const PendingColumn *> f_pending(COLUMN_COUNT);
+	bool f_columns[COLUMN_COUNT];
+
+	for (const auto &f_region : f_regions)
+	{
+		const Indices &f_position = f_region.first;
+		f_data.clear();
+		std::fill(f_pending.begin(), f_pending.end(), nullptr);
+
+		for (const FlushColumn &f_column : f_region.second)
+		{
+			f_pending[f_column.column] = f_column.pending.get();
+		}
+
+		// Copy the new file's chunks, from the pending columns or the old file
+		{
+			std::lock_guard<std::mutex> f_lock(m_fileMutex);
+			const ab::RegionFile &f_file = getRegion(f_position.x, f_position.z);
+
+			for (int c = 0; c < COLUMN_COUNT; ++c)
+			{
+				f_columns[c] = f_pending[c] != nullptr || f_file.hasColumn(c);
+
+				for (int cy = 0; cy < ab::RegionFile::COLUMN_CHUNKS; ++cy)
+				{
+					int f_chunk = ab::RegionFile::getChunkIndex(c, cy);
+					f_offsets[f_chunk] = f_data.size();
+
+					if (f_pending[c] != nullptr)
+					{
+						const std::vector<unsigned char> &f_new = f_pending[c]->chunks[cy];
+						f_data.insert(f_data.end(), f_new.begin(), f_new.end());
+						f_chunks[f_chunk].size = (std::uint32_t)f_new.size();
+					}
+					else
+					{
+						ab::RegionFile::ChunkData f_old = f_file.getChunk(f_chunk);
+						f_data.insert(f_data.end(), f_old.data, f_old.data + f_old.size);
+						f_chunks[f_chunk].size = f_old.size;
+					}
+				}
+			}
+		}
+
+		for (int i = 0; i < ab::RegionFile::CHUNKS; ++i)
+		{
+			f_chunks[i].data = f_data.data() + f_offsets[i];
+		}
+
+		std::string f_path = getRegionPath(f_position.x, f_position.z);
+		std::string f_temporary = f_path + ".tmp";
+		bool f_saved = ab::RegionFile::write(f_temporary, f_position.x, f_position.z, f_columns, f_chunks.data());
+
+		// Swap the new file in, the old one can't stay mapped while it's replaced
+		if (f_saved)
+		{
+			std::lock_guard<std::mutex> f_lock(m_fileMutex);
+			ab::RegionFile &f_file = getRegion(f_position.x, f_position.z);
+			f_file.close();
+			f_saved = ab::RegionFile::replace(f_temporary, f_path);
+			f_file.open(f_path);
+		}
+
+		// The old file is still there if either step failed
+		if (!f_saved)
+		{
+			std::remove(f_temporary.c_str());
+			f_succeeded = false;
+			continue;
+		}
+
+		// Columns saved again since they were copied stay pending
+		std::lock_guard<std::mutex> f_lock(m_mutex);
+
+		for (const FlushColumn &f_column : f_region.second)
+		{
+			auto f_found = m_pending.find(f_column.position);
+
+			if (f_found != m_pending.end() && f_found->second == f_column.pending)
+			{
+				m_pending.erase(f_found);
+			}
+		}
+	}
+
+	return f_succeeded;
+}
+
+/// <summary>
+/// Gets the number of saved columns that haven't been flushed yet.
+/// </summary>
+/// <returns>The number of columns.</returns>
+int RegionStore::getPendingCount() const
+{
+	std::lock_guard<std::mutex> f_lock(m_mutex);
+
+	return (int)m_pending.size();
+}
+
+/// <summary>
+/// Gets the directory that holds the region files.
+/// </summary>
+/// <returns>The directory.</returns>
+const std::string &RegionStore::getDirectory() const
+{
+	return m_directory;
+}
+
+/// <summary>
+/// Gets the path of a region file.
+/// </summary>
+/// <param name="t_regionX">The X position of the region (in regions).</param>
+/// <param name="t_regionZ">The Z position of the region (in regions).</param>
+/// <returns>The path.</returns>
+std::string RegionStore::getRegionPath(int t_regionX, int t_regionZ) const
+{
+	return m_directory + "/r." + std::to_string(t_regionX) + "." + std::to_string(t_regionZ) + ".abr";
+}
+
+/// <summary>
+/// Gets the region that holds a column.
+/// </summary>
+/// <param name="t_columnX">The X position of the column (in chunks).</param>
+/// <param name="t_columnZ">The Z position of the column (in chunks).</param>
+/// <param name="t_regionX">Set to the X position of the region (in regions).</param>
+/// <param name="t_regionZ">Set to the Z position of the region (in regions).</param>
+/// <param name="t_column">Set to the index of the column within the region.</param>
+void RegionStore::getRegionPosition(int t_columnX, int t_columnZ, int &t_regionX, int &t_regionZ, int &t_column)
+{
+	// Round down, so negative columns go into negative regions
+	t_regionX = (t_columnX >= 0 ? t_columnX : t_columnX - ab::RegionFile::COLUMNS + 1) / ab::RegionFile::COLUMNS;
+	t_regionZ = (t_columnZ >= 0 ? t_columnZ : t_columnZ - ab::RegionFile::COLUMNS + 1) / ab::RegionFile::COLUMNS;
+	t_column = ab::RegionFile::getColumn(t_columnX - t_regionX * ab::RegionFile::COLUMNS, t_columnZ - t_regionZ * ab::RegionFile::COLUMNS);
+}
+
+/// <summary>
+/// Gets a column that's waiting to be flushed.
+/// </summary>
+/// <param name="t_columnX">The X position of the column (in chunks).</param>
+/// <param name="t_columnZ">The Z position of the column (in chunks).</param>
+/// <returns>The column, or nullptr if it isn't waiting to be flushed.</returns>
+RegionStore::PendingPtr RegionStore::findPending(int t_columnX, int t_columnZ) const
+{
+	std::lock_guard<std::mutex> f_lock(m_mutex);
+	auto f_found = m_pending.find({ t_columnX, 0, t_columnZ });
+
+	return f_found != m_pending.end() ? f_found->second : nullptr;
+}
+
+/// <summary>
+/// Gets a region file, mapping it the first time it's used.
+/// The region files have to be locked.
+/// </summary>
+/// <param name="t_regionX">The X position of the region (in regions).</param>
+/// <param name="t_regionZ">The Z position of the region (in regions).</param>
+/// <returns>The region file (it isn't open if the region hasn't been saved).</returns>
+ab::RegionFile &RegionStore::getRegion(int t_regionX, int t_regionZ)
+{
+	std::unique_ptr<ab::RegionFile> &f_file = m_regions[{ t_regionX, 0, t_regionZ }];
+
+	if (f_file == nullptr)
+	{
+		f_file.reset(new ab::RegionFile());
+		f_file->open(getRegionPath(t_regionX, t_regionZ));
+	}
+
+	return *f_file;
+}
+
+/// <summary>
+/// Reads a column that's waiting to be flushed. No lock is needed, pending columns never change.
+/// </summary>
+/// <param name="t_pending">The column.</param>
+/// <param name="t_voxels">Filled with the column's voxels.</param>
+/// <param name="t_used">Filled with whether each chunk has anything other than air in it.</param>
+/// <returns>True if the column was read, false if its data is damaged.</returns>
+bool RegionStore::readPending(const PendingColumn &t_pending, char *t_voxels, bool *t_used)
+{
+	for (int cy = 0; cy < ab::RegionFile::COLUMN_CHUNKS; ++cy)
+	{
+		char *f_voxels = t_voxels + cy * ab::RegionFile::CHUNK_VOXELS;
+		const std::vector<unsigned char> &f_data = t_pending.chunks[cy];
+		t_used[cy] = !f_data.empty();
+
+		if (f_data.empty())
+		{
+			std::memset(f_voxels, 0, ab::RegionFile::CHUNK_VOXELS);
+		}
+		else if (!ab::RegionFile::decompress(f_data.data(), f_data.size(), f_voxels))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Reads a column from a region file.
+/// The region files have to be locked.
+/// </summary>
+/// <param name="t_file">The region file.</param>
+/// <param name="t_column">The index of the column within the region.</param>
+/// <param name="t_voxels">Filled with the column's voxels.</param>
+/// <param name="t_used">Filled with whether each chunk has anything other than air in it.</param>
+/// <returns>True if the column was read, false if it hasn't been saved or its data is damaged.</returns>
+bool RegionStore::readFile(const ab::RegionFile &t_file, int t_column, char *t_voxels, bool *t_used)
+{
+	if (!t_file.hasColumn(t_column))
+	{
+		return false;
+	}
+
+	for (int cy = 0; cy < ab::RegionFile::COLUMN_CHUNKS; ++cy)
+	{
+		int f_chunk = ab::RegionFile::getChunkIndex(t_column, cy);
+
+		if (!t_file.readChunk(f_chunk, t_voxels + cy * ab::RegionFile::CHUNK_VOXELS))
+		{
+			return false;
+		}
+
+		t_used[cy] = t_file.getChunk(f_chunk).size > 0;
+	}
+
+	return true;
+}
@@ -0,0 +1,128 @@
+#include "RemeshQueue.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+
+/// <summary>
+/// Takes the world's dirty chunks and adds them to the end of the queue.
+/// </summary>
+/// <param name="t_world">The world.</param>
+void RemeshQueue::collect(World &t_world)
+{
+	m_dirty.clear();
+	t_world.takeDirtyChunks(m_dirty);
+
+	for (const Indices &f_position : m_dirty)
+	{
+		push(f_position);
+	}
+}
+
+/// <summary>
+/// Adds a chunk to the end of the queue, unless it's already waiting.
+/// </summary>
+/// <param name="t_position">The chunk position.</param>
+void RemeshQueue::push(const Indices &t_position)
+{
+	if (m_queued.insert({ t_position, std::chrono::steady_clock::now() }).second)
+	{
+		m_queue.push_back(t_position);
+	}
+}
+
+/// <summary>
+/// Reorders the queue so the chunks with the lowest priority values are meshed first.
+/// Chunks with the same priority stay in the order they were edited.
+/// </summary>
+/// <param name="t_priority">Gets a chunk's priority (e.g. its distance from the camera).</param>
+void RemeshQueue::sort(const std::function<float(const Indices &)> &t_priority)
+{
+	m_sorted.clear();
+
+	for (const Indices &f_position : m_queue)
+	{
+		m_sorted.push_back({ t_priority(f_position), f_position });
+	}
+
+	std::stable_sort(m_sorted.begin(), m_sorted.end(), [](const std::pair<float, Indices> &a, const std::pair<float, Indices> &b)
+	{
+		return a.first < b.first;
+	});
+
+	for (std::size_t i = 0; i < m_sorted.size(); ++i)
+	{
+		m_queue[i] = m_sorted[i].second;
+	}
+}
+
+/// <summary>
+/// Meshes chunks from the front of the queue until it's empty or the time budget runs out.
+/// At least one chunk is meshed every time (if there are any), so the queue always makes progress.
+/// </summary>
+/// <param name="t_budgetMs">The time budget in milliseconds.</param>
+/// <param name="t_remesh">The function that meshes a chunk.</param>
+/// <returns>The number of chunks meshed.</returns>
+int RemeshQueue::process(double t_budgetMs, const std::function<void(const Indices &)> &t_remesh)
+{
+	PROFILE_SCOPE("RemeshQueue::process");
+	auto f_start = std::chrono::steady_clock::now();
+	int f_count = 0;
+
+	while (!m_queue.empty())
+	{
+		Indices f_position = m_queue.front();
+		m_queue.pop_front();
+		auto f_queued = m_queued.find(f_position);
+		std::chrono::steady_clock::time_point f_queuedAt = f_queued->second;
+		m_queued.erase(f_queued);
+
+		t_remesh(f_position);
+		f_count++;
+		m_latency.add(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - f_queuedAt).count());
+
+		std::chrono::duration<double, std::milli> f_elapsed = std::chrono::steady_clock::now() - f_start;
+
+		if (f_elapsed.count() >= t_budgetMs)
+		{
+			break;
+		}
+	}
+
+	return f_count;
+}
+
+/// <summary>
+/// Gets the number of chunks waiting to be meshed.
+/// </summary>
+/// <returns>The number of chunks.</returns>
+std::size_t RemeshQueue::getCount() const
+{
+	return m_queue.size();
+}
+
+/// <summary>
+/// Empties the queue (e.g. after meshing the whole world).
+/// </summary>
+void RemeshQueue::clear()
+{
+	m_queue.clear();
+	m_queued.clear();
+}
+
+/// <summary>
+/// Gets the latencies of the chunks meshed so far, from being queued to being meshed.
+/// </summary>
+/// <returns>The latency histogram, in microseconds.</returns>
+const ChunkIO::LatencyHistogram &RemeshQueue::getLatency() const
+{
+	return m_latency;
+}
+
+/// <summary>
+/// Forgets the latencies so far, e.g. before a benchmark run.
+/// </summary>
+void RemeshQueue::clearLatency()
+{
+	m_latency = ChunkIO::LatencyHistogram();
+}
@@ -0,0 +1,224 @@
+#include "Stats.h"
+#include "Json.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+
+std::mutex ab::Stats::s_mutex;
+std::vector<ab::Stats::Entry> ab::Stats::s_stats;
+std::unordered_map<std::string, std::size_t> ab::Stats::s_indices;
+
+/// <summary>
+/// Sets the latest value of a stat, adding the stat if it's new.
+/// </summary>
+/// <param name="t_group">The group it's shown in (e.g. "World").</param>
+/// <param name="t_name">The stat's name.</param>
+/// <param name="t_value">The value.</param>
+/// <param name="t_unit">The unit (e.g. "ms", "MB" or "" for counts).</param>
+void ab::Stats::set(const std::string &t_group, const std::string &t_name, double t_value, const std::string &t_unit)
+{
+	std::lock_guard<std::mutex> f_lock(s_mutex);
+	find(t_group, t_name, t_unit).stat.value = t_value;
+}
+
+/// <summary>
+/// Sets the latest value of a stat and adds it to the stat's history, replacing the oldest value once the history is full.
+/// </summary>
+/// <param name="t_group">The group it's shown in (e.g. "Frame").</param>
+/// <param name="t_name">The stat's name.</param>
+/// <param name="t_value">The value.</param>
+/// <param name="t_unit">The unit.</param>
+void ab::Stats::addSample(const std::string &t_group, const std::string &t_name, double t_value, const std::string &t_unit)
+{
+	std::lock_guard<std::mutex> f_lock(s_mutex);
+	Entry &f_entry = find(t_group, t_name, t_unit);
+	f_entry.stat.value = t_value;
+
+	if ((int)f_entry.stat.history.size() < HISTORY_LENGTH)
+	{
+		f_entry.stat.history.push_back((float)t_value);
+	}
+	else
+	{
+		f_entry.stat.history[f_entry.next] = (float)t_value;
+		f_entry.next = (f_entry.next + 1) % HISTORY_LENGTH;
+	}
+}
+
+/// <summary>
+/// Gets a copy of a stat.
+/// </summary>
+/// <param name="t_group">The stat's group.</param>
+/// <param name="t_name">The stat's name.</param>
+/// <param name="t_stat">Set to the stat if it's found.</param>
+/// <returns>True if the stat has been set.</returns>
+bool ab::Stats::get(const std::string &t_group, const std::string &t_name, Stat &t_stat)
+{
+	std::lock_guard<std::mutex> f_lock(s_mutex);
+	auto f_found = s_indices.find(t_group + '\n' + t_name);
+
+	if (f_found == s_indices.end())
+	{
+		return false;
+	}
+
+	t_stat = copy(s_stats[f_found->second]);
+
+	return true;
+}
+
+/// <summary>
+/// Gets a copy of every stat.
+/// </summary>
+/// <returns>The stats, in the order they were first set.</returns>
+std::vector<ab::Stats::Stat> ab::Stats::getAll()
+{
+	std::lock_guard<std::mutex> f_lock(s_mutex);
+	std::vector<Stat> f_stats;
+	f_stats.reserve(s_stats.size());
+
+	for (const Entry &f_entry : s_stats)
+	{
+		f_stats.push_back(copy(f_entry));
+	}
+
+	return f_stats;
+}
+
+/// <summary>
+/// Gets a percentile of a stat's history (the nearest rank, so the 99th percentile of fewer than 100 samples is the highest).
+/// </summary>
+/// <param name="t_stat">The stat.</param>
+/// <param name="t_percentile">The percentile (0 to 100).</param>
+/// <returns>The percentile, or the latest value if the stat has no history.</returns>
+double ab::Stats::getPercentile(const Stat &t_stat, double t_percentile)
+{
+	if (t_stat.history.empty())
+	{
+		return t_stat.value;
+	}
+
+	std::vector<float> f_sorted = t_stat.history;
+	std::size_t f_rank = (std::size_t)std::ceil(t_percentile / 100.0 * f_sorted.size());
+	std::size_t f_index = std::min(std::max(f_rank, (std::size_t)1), f_sorted.size()) - 1;
+	std::nth_element(f_sorted.begin(), f_sorted.begin() + f_index, f_sorted.end());
+
+	return f_sorted[f_index];
+}
+
+/// <summary>
+/// Writes every stat as text, one per line, with the 50th and 99th percentiles of sampled stats.
+/// </summary>
+/// <param name="t_stream">The stream to write to.</param>
+void ab::Stats::write(std::ostream &t_stream)
+{
+	std::string f_group;
+
+	for (const Stat &f_stat : getAll())
+	{
+		if (f_stat.group != f_group)
+		{
+			f_group = f_stat.group;
+			t_stream << "=== " << f_group << " ===" << std::endl;
+		}
+
+		t_stream << "  " << std::left << std::setw(40) << f_stat.name << std::right << std::setw(14) << std::fixed << std::setprecision(2) << f_stat.value << " " << f_stat.unit;
+
+		if (!f_stat.history.empty())
+		{
+			t_stream << " (p50 " << getPercentile(f_stat, 50.0) << ", p99 " << getPercentile(f_stat, 99.0) << ")";
+		}
+
+		t_stream << std::endl;
+	}
+}
+
+/// <summary>
+/// Writes every stat as JSON, so runs can be compared between builds.
+/// </summary>
+/// <param name="t_path">The file to write.</param>
+/// <returns>True if the file was written.</returns>
+bool ab::Stats::writeJson(const std::string &t_path)
+{
+	std::vector<Stat> f_stats = getAll();
+	std::ofstream f_file(t_path);
+
+	if (!f_file)
+	{
+		return false;
+	}
+
+	f_file << "{\n\t\"stats\": [";
+
+	for (std::size_t i = 0; i < f_stats.size(); ++i)
+	{
+		const Stat &f_stat = f_stats[i];
+		f_file << (i == 0 ? "\n" : ",\n") << "\t\t{ \"group\": ";
+		ab::Json::writeString(f_file, f_stat.group);
+		f_file << ", \"name\": ";
+		ab::Json::writeString(f_file, f_stat.name);
+		f_file << ", \"value\": ";
+		ab::Json::writeNumber(f_file, f_stat.value);
+		f_file << ", \"unit\": ";
+		ab::Json::writeString(f_file, f_stat.unit);
+
+		if (!f_stat.history.empty())
+		{
+			f_file << ", \"samples\": " << f_stat.history.size() << ", \"p50\": ";
+			ab::Json::writeNumber(f_file, getPercentile(f_stat, 50.0));
+			f_file << ", \"p99\": ";
+			ab::Json::writeNumber(f_file, getPercentile(f_stat, 99.0));
+		}
+
+		f_file << " }";
+	}
+
+	f_file << "\n\t]\n}\n";
+
+	return (bool)f_file;
+}
+
+/// <summary>
+/// Removes every stat.
+/// </summary>
+void ab::Stats::clear()
+{
+	std::lock_guard<std::mutex> f_lock(s_mutex);
+	s_stats.clear();
+	s_indices.clear();
+}
+
+/// <summary>
+/// Finds a stat, adding it if it's new. s_mutex must be locked.
+/// </summary>
+/// <param name="t_group">The stat's group.</param>
+/// <param name="t_name">The stat's name.</param>
+/// <param name="t_unit">The unit, used if the stat is new.</param>
+/// <returns>The stat.</returns>
+ab::Stats::Entry &ab::Stats::find(const std::string &t_group, const std::string &t_name, const std::string &t_unit)
+{
+	auto f_found = s_indices.insert({ t_group + '\n' + t_name, s_stats.size() });
+
+	if (f_found.second)
+	{
+		s_stats.push_back({ { t_group, t_name, t_unit, 0.0, std::vector<float>() }, 0 });
+	}
+
+	return s_stats[f_found.first->second];
+}
+
+/// <summary>
+/// Copies a stat, putting its history in order (oldest first).
+/// </summary>
+/// <param name="t_entry">The stat.</param>
+/// <returns>The copy.</returns>
+ab::Stats::Stat ab::Stats::copy(const Entry &t_entry)
+{
+	Stat f_stat = t_entry.stat;
+	std::rotate(f_stat.history.begin(), f_stat.history.begin() + t_entry.next, f_stat.history.end());
+
+	return f_stat;
+}
@@ -1,21 +1,21 @@
 #include "Terrain.h"
+#include <algorithm>
+#include <cstdio>
 #include <iostream>
 
 /// <summary>
 /// Constructor for the Terrain class.
 /// </summary>
-/// <param name="t_width">The width of the window.</param>
-/// <param name="t_height">The height of the window.</param>
-ab::Terrain::Terrain()
+/// <param name="t_seed">The world seed, the same seed always generates the same terrain.</param>
+ab::Terrain::Terrain(unsigned int t_seed) :
+	m_seed(t_seed)
 {
 	initialise();
 }
 
 /// <summary>
-/// Constructor for the Terrain class.
+/// Destructor for the Terrain class.
 /// </summary>
-/// <param name="t_width">The width of the window.</param>
-/// <param name="t_height">The height of the window.</param>
 ab::Terrain::~Terrain()
 {
 	delete m_noise;
@@ -24,165 +24,606 @@ ab::Terrain::~Terrain()
 
 /// <summary>
 /// Initialise the Terrain class.
+/// The elevation range is sampled every few columns over the generated area, so it only depends on the seed.
 /// </summary>
 void ab::Terrain::initialise()
 {
-	m_noise = new Noise();
+	m_noise = new Noise(m_seed);
+
+	const int SAMPLE_STEP = 8;
+	const int SAMPLES_X = WORLD_WIDTH / SAMPLE_STEP;
+	const int SAMPLES_Z = WORLD_DEPTH / SAMPLE_STEP;
+
+	std::vector<float> f_x(SAMPLES_X);
+	std::vector<float> f_z(SAMPLES_X);
+	std::vector<float> f_elevation(SAMPLES_X);
+
+	m_elevationMin = 0.0f;
+	m_elevationMax = 0.0f;
+
+	for (int j = 0; j < SAMPLES_Z; ++j)
+	{
+		for (int i = 0; i < SAMPLES_X; ++i)
+		{
+			f_x[i] = (float)(i * SAMPLE_STEP);
+			f_z[i] = (float)(j * SAMPLE_STEP);
+		}
+
+		sampleElevation(f_x.data(), f_z.data(), f_elevation.data(), SAMPLES_X);
+
+		for (int i = 0; i < SAMPLES_X; ++i)
+		{
+			if ((i == 0 && j == 0) || f_elevation[i] < m_elevationMin)
+			{
+				m_elevationMin = f_elevation[i];
+			}
+
+			if ((i == 0 && j == 0) || f_elevation[i] > m_elevationMax)
+			{
+				m_elevationMax = f_elevation[i];
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Gets the world seed.
+/// </summary>
+/// <returns>The world seed.</returns>
+unsigned int ab::Terrain::getSeed() const
+{
+	return m_seed;
+}
+
+/// <summary>
+/// Gets a hash of everything that decides what the terrain looks like: the seed, the generation values in Globals.h and GENERATOR_VERSION.
+/// Terrain with the same key always generates the same columns, so they can be cached.
+/// </summary>
+/// <returns>The key (a 64 bit FNV-1a hash).</returns>
+std::uint64_t ab::Terrain::getCacheKey() const
+{
+	std::uint64_t f_hash = 14695981039346656037ull;
+
+	auto f_add = [&f_hash](const void *t_value, std::size_t t_size)
+	{
+		const unsigned char *f_bytes = (const unsigned char *)t_value;
+
+		for (std::size_t i = 0; i < t_size; ++i)
+		{
+			f_hash = (f_hash ^ f_bytes[i]) * 1099511628211ull;
+		}
+	};
 
-	// This seed can be used to regenerate the exact same world every time
-	std::srand(12345);
+	// The elevation range is sampled over the generated area, so its size matters too
+	const std::int32_t INTS[] = { (std::int32_t)GENERATOR_VERSION, (std::int32_t)m_seed, WORLD_WIDTH, WORLD_HEIGHT, WORLD_DEPTH,
+		CHUNK_WIDTH, CHUNK_HEIGHT, CHUNK_DEPTH, WATER_HEIGHT, TREE_SPACING, TREE_MIN_HEIGHT, TREE_HEIGHT_RANGE, TREE_MIN_TOP,
+		TREE_TOP_RANGE, DENSITY_TERRAIN ? 1 : 0, DENSITY_SURFACE_HEIGHT, DENSITY_STEP, BLOCK_TYPE_COUNT };
+	const float FLOATS[] = { EXP, DENSITY_FALLOFF, DENSITY_FREQUENCY };
+
+	f_add(INTS, sizeof(INTS));
+	f_add(FLOATS, sizeof(FLOATS));
+
+	return f_hash;
 }
 
 /// <summary>
-/// Generate a terrain map.
+/// Gets the directory that generated columns are cached in. It's named after the cache key, so a change to
+/// the seed or the generation values uses a different directory and the old columns are never read.
 /// </summary>
-/// <param name="t_width">The width of the map.</param>
-/// <param name="t_height">The height of the map.</param>
-void ab::Terrain::generate(int t_width, int t_height)
+/// <param name="t_prefix">The start of the directory name (e.g. WORLD_CACHE_DIRECTORY).</param>
+/// <returns>The directory, e.g. "cache-0123456789abcdef".</returns>
+std::string ab::Terrain::getCacheDirectory(const std::string &t_prefix) const
 {
-	// Temporary storage for map values
-	std::vector<std::vector<float>> f_elevationMap;
-	std::vector<std::vector<float>> f_treeMap;
+	char f_key[17];
+	std::snprintf(f_key, sizeof(f_key), "%016llx", (unsigned long long)getCacheKey());
+
+	return t_prefix + "-" + f_key;
+}
 
-	// Initialise arrays
-	f_elevationMap.resize(t_width, std::vector<float>(t_height));
-	f_treeMap.resize(t_width, std::vector<float>(t_height));
+/// <summary>
+/// Evaluates the elevation noise for a batch of columns.
+/// </summary>
+/// <param name="t_x">The X values of the columns' world positions.</param>
+/// <param name="t_z">The Z values of the columns' world positions.</param>
+/// <param name="t_elevation">Receives the elevation of each column (before it's normalised).</param>
+/// <param name="t_count">The number of columns.</param>
+void ab::Terrain::sampleElevation(const float *t_x, const float *t_z, float *t_elevation, int t_count) const
+{
+	// Frequencies and weights of the elevation noise octaves
+	const int OCTAVE_COUNT = 6;
+	const float OCTAVE_FREQUENCY[OCTAVE_COUNT] = { 1.0f, 2.0f, 4.0f, 8.0f, 16.0f, 32.0f };
+	const float OCTAVE_WEIGHT[OCTAVE_COUNT] = { 1.00f, 0.50f, 0.25f, 0.13f, 0.06f, 0.03f };
 
-	// Create random values using seed
-	float val_1 = rand() % 9 + 1;
+	std::vector<float> f_sampleX(t_count);
+	std::vector<float> f_sampleY(t_count);
+	std::vector<float> f_samples(t_count);
+	std::vector<double> f_elevation(t_count, 0.0);
 
-	// Generate terrain
-	for (int y = 0; y < t_height; ++y)
+	for (int f_octave = 0; f_octave < OCTAVE_COUNT; ++f_octave)
 	{
-		for (int x = 0; x < t_width; ++x)
+		for (int i = 0; i < t_count; ++i)
 		{
-			float freqX = x / (float)t_width - 0.5f;
-			float freqY = y / (float)t_height - 0.5f;
-			float distance = sqrt(freqX * freqX + freqY * freqY) / sqrt(0.5f);
-			distance = pow(distance, 2.0);
+			float freqX = t_x[i] / (float)WORLD_WIDTH - 0.5f;
+			float freqY = t_z[i] / (float)WORLD_DEPTH - 0.5f;
+			f_sampleX[i] = OCTAVE_FREQUENCY[f_octave] * freqX;
+			f_sampleY[i] = OCTAVE_FREQUENCY[f_octave] * freqY;
+		}
 
-			double e = (1.00f * m_noise->noise(1.0 * (double)freqX, 1.0 * (double)freqY)
-				+ 0.50f * m_noise->noise(2.0 * (double)freqX, 2.0 * (double)freqY)
-				+ 0.25f * m_noise->noise(4.0 * (double)freqX, 4.0 * (double)freqY)
-				+ 0.13f * m_noise->noise(8.0 * (double)freqX, 8.0 * (double)freqY)
-				+ 0.06f * m_noise->noise(16.0 * (double)freqX, 16.0 * (double)freqY)
-				+ 0.03f * m_noise->noise(32.0 * (double)freqX, 32.0 * (double)freqY));
+		m_noise->noise(f_sampleX.data(), f_sampleY.data(), f_samples.data(), t_count);
 
-			e /= (3.00 + 0.50 + 0.25 + 0.13 + 0.06 + 0.03);
-			//e = (1 + e - distance) / 2; // Uncommenting this line will produce maps like islands
-			e = pow(e, EXP);
-			f_elevationMap[x][y] = e;
+		for (int i = 0; i < t_count; ++i)
+		{
+			f_elevation[i] += OCTAVE_WEIGHT[f_octave] * f_samples[i];
 		}
 	}
 
-	float f_min = 0;
-	float f_max = 0;
+	for (int i = 0; i < t_count; ++i)
+	{
+		double e = f_elevation[i];
+
+		e /= (3.00 + 0.50 + 0.25 + 0.13 + 0.06 + 0.03);
+		//e = (1 + e - distance) / 2; // Subtracting the squared distance from the centre produces maps like islands
+		e = pow(e, EXP);
+
+		t_elevation[i] = (float)e;
+	}
+}
+
+/// <summary>
+/// Evaluates the tree noise for a batch of columns.
+/// A tiny offset from a hash of the seed and the column's position is added, so neighbouring
+/// columns never have exactly the same value (the same column always gets the same offset).
+/// </summary>
+/// <param name="t_x">The X values of the columns' world positions.</param>
+/// <param name="t_z">The Z values of the columns' world positions.</param>
+/// <param name="t_treeNoise">Receives the tree noise of each column.</param>
+/// <param name="t_count">The number of columns.</param>
+void ab::Terrain::sampleTreeNoise(const float *t_x, const float *t_z, float *t_treeNoise, int t_count) const
+{
+	// Higher frequency value means higher tree density
+	float freq = 16.0f;
+
+	const double TREE_JITTER = 1.0e-6;
 
-	// Initialise min and max from first two elevation map elements
-	if (f_elevationMap[0][0] > f_elevationMap[0][1])
+	std::vector<float> f_sampleX(t_count);
+	std::vector<float> f_sampleY(t_count);
+
+	for (int i = 0; i < t_count; ++i)
 	{
-		f_max = f_elevationMap[0][0];
-		f_min = f_elevationMap[0][1];
+		double nx = t_x[i] / (double)WORLD_WIDTH - 0.5;
+		double ny = t_z[i] / (double)WORLD_DEPTH - 0.5;
+		f_sampleX[i] = (float)(freq * nx);
+		f_sampleY[i] = (float)(freq * ny);
 	}
-	else
+
+	m_noise->noise(f_sampleX.data(), f_sampleY.data(), t_treeNoise, t_count);
+
+	for (int i = 0; i < t_count; ++i)
 	{
-		f_max = f_elevationMap[0][1];
-		f_min = f_elevationMap[0][0];
+		double f_jitter = Utility::hash(m_seed, (int)t_x[i], (int)t_z[i]) / 4294967296.0;
+		t_treeNoise[i] = (float)(t_treeNoise[i] + f_jitter * TREE_JITTER);
 	}
+}
+
+/// <summary>
+/// Converts an elevation into a surface height, using the fixed elevation range.
+/// </summary>
+/// <param name="t_elevation">The elevation.</param>
+/// <returns>The height of the surface voxel (0 to 63).</returns>
+int ab::Terrain::toHeight(float t_elevation) const
+{
+	float f_yValue = m_noise->normaliseToRange(t_elevation, m_elevationMin, m_elevationMax) * 63.0f;
+
+	// The range was sampled, so a few columns fall just outside it
+	return std::min(std::max(int(f_yValue), 0), 63);
+}
+
+/// <summary>
+/// Gets the height of the surface at a column (not counting trees).
+/// </summary>
+/// <param name="x">The column's world position X value.</param>
+/// <param name="z">The column's world position Z value.</param>
+/// <returns>The height of the surface voxel.</returns>
+int ab::Terrain::getHeight(int x, int z) const
+{
+	float f_x = (float)x;
+	float f_z = (float)z;
+	float f_elevation;
+
+	sampleElevation(&f_x, &f_z, &f_elevation, 1);
 
-	// First pass of array to find MIN and MAX values
-	for (int z = 0; z < t_height; ++z)
+	return toHeight(f_elevation);
+}
+
+/// <summary>
+/// Generates the voxels of a column of chunks: grass, water and trees (or density terrain if DENSITY_TERRAIN is set).
+/// Trees are placed on columns that have the highest tree noise within TREE_SPACING columns, and the tops of
+/// trees up to TREE_MAX_TOP columns away reach into this column, so the tree noise is evaluated for a border
+/// of TREE_MAX_TOP + TREE_SPACING columns around it. Only reads the noise tables, so columns can be generated
+/// on any number of threads at once.
+/// </summary>
+/// <param name="t_chunkX">The X position of the column (in chunks).</param>
+/// <param name="t_chunkZ">The Z position of the column (in chunks).</param>
+/// <param name="t_voxels">Receives COLUMN_VOXELS voxels, the column's chunks from the bottom up, each using Utility::at() ordering.</param>
+/// <param name="t_used">Receives COLUMN_CHUNKS values, true for the chunks that aren't all air.</param>
+void ab::Terrain::generateColumn(int t_chunkX, int t_chunkZ, char *t_voxels, bool *t_used) const
+{
+	if (DENSITY_TERRAIN)
 	{
-		for (int x = 0; x < t_width; ++x)
+		for (int cy = 0; cy < COLUMN_CHUNKS; ++cy)
 		{
-			float f_yValue = (f_elevationMap[x][z]);
+			t_used[cy] = generateChunkDensity({ t_chunkX, cy, t_chunkZ }, t_voxels + cy * CHUNK_VOXELS);
+		}
 
-			// Set min and max values from array
-			if (f_yValue > f_max)
-			{
-				f_max = f_yValue;
-			}
-			else if (f_yValue < f_min)
-			{
-				f_min = f_yValue;
-			}
+		return;
+	}
+
+	std::fill(t_voxels, t_voxels + COLUMN_VOXELS, (char)BLOCK_AIR);
+	std::fill(t_used, t_used + COLUMN_CHUNKS, false);
+
+	int f_originX = t_chunkX * CHUNK_WIDTH;
+	int f_originZ = t_chunkZ * CHUNK_DEPTH;
+
+	// Writes a voxel if it's inside this column
+	auto f_set = [&](int x, int y, int z, char t_type)
+	{
+		int lx = x - f_originX;
+		int lz = z - f_originZ;
+
+		if (lx < 0 || lx >= CHUNK_WIDTH || lz < 0 || lz >= CHUNK_DEPTH || y < 0 || y >= WORLD_HEIGHT)
+		{
+			return;
 		}
+
+		int f_chunk = y >> CHUNK_HEIGHT_SHIFT;
+		t_voxels[f_chunk * CHUNK_VOXELS + Utility::at(lx, y & (CHUNK_HEIGHT - 1), lz, CHUNK_HEIGHT, CHUNK_DEPTH)] = t_type;
+		t_used[f_chunk] |= t_type != BLOCK_AIR;
+	};
+
+	// Columns whose trees can reach this column, and the columns whose tree noise they're compared with
+	// (column x, z of each area is at x * size + z)
+	const int TREE_BORDER = TREE_MAX_TOP;
+	const int TREE_SIZE_X = CHUNK_WIDTH + 2 * TREE_BORDER;
+	const int TREE_SIZE_Z = CHUNK_DEPTH + 2 * TREE_BORDER;
+	const int NOISE_BORDER = TREE_BORDER + TREE_SPACING;
+	const int NOISE_SIZE_X = CHUNK_WIDTH + 2 * NOISE_BORDER;
+	const int NOISE_SIZE_Z = CHUNK_DEPTH + 2 * NOISE_BORDER;
+
+	std::vector<float> f_x(NOISE_SIZE_X * NOISE_SIZE_Z);
+	std::vector<float> f_z(NOISE_SIZE_X * NOISE_SIZE_Z);
+	std::vector<float> f_treeNoise(NOISE_SIZE_X * NOISE_SIZE_Z);
+	std::vector<float> f_treeMax(NOISE_SIZE_X * NOISE_SIZE_Z);
+
+	for (int i = 0; i < NOISE_SIZE_X * NOISE_SIZE_Z; ++i)
+	{
+		f_x[i] = (float)(f_originX - NOISE_BORDER + i / NOISE_SIZE_Z);
+		f_z[i] = (float)(f_originZ - NOISE_BORDER + i % NOISE_SIZE_Z);
 	}
 
-	float f_yValue = 0.0f;
+	sampleTreeNoise(f_x.data(), f_z.data(), f_treeNoise.data(), NOISE_SIZE_X * NOISE_SIZE_Z);
+
+	// The highest tree noise within TREE_SPACING columns of each column, found one axis at a time
+	// (only the tree area is used, which is far enough from the edges that nothing past them is missed)
+	for (int z = 0; z < NOISE_SIZE_Z; ++z)
+	{
+		maxFilter(&f_treeNoise[z], &f_treeMax[z], NOISE_SIZE_X, NOISE_SIZE_Z, TREE_SPACING);
+	}
+
+	for (int x = 0; x < NOISE_SIZE_X; ++x)
+	{
+		maxFilter(&f_treeMax[x * NOISE_SIZE_Z], &f_treeMax[x * NOISE_SIZE_Z], NOISE_SIZE_Z, 1, TREE_SPACING);
+	}
+
+	// Heights of this column, then grass and water
+	for (int i = 0; i < CHUNK_WIDTH * CHUNK_DEPTH; ++i)
+	{
+		f_x[i] = (float)(f_originX + i / CHUNK_DEPTH);
+		f_z[i] = (float)(f_originZ + i % CHUNK_DEPTH);
+	}
+
+	std::vector<float> f_elevation(CHUNK_WIDTH * CHUNK_DEPTH);
+	sampleElevation(f_x.data(), f_z.data(), f_elevation.data(), CHUNK_WIDTH * CHUNK_DEPTH);
+
 	float f_waterHeight = WATER_HEIGHT;
 
-	// Second pass of array to normalise values using MIN and MAX
-	for (int z = 0; z < t_height; ++z)
+	for (int i = 0; i < CHUNK_WIDTH * CHUNK_DEPTH; ++i)
+	{
+		float f_arrVal = f_elevation[i];
+		int f_waterY = f_arrVal < f_waterHeight ? WATER_HEIGHT - 1 : 0;
+
+		f_set((int)f_x[i], toHeight(f_arrVal), (int)f_z[i], BLOCK_GRASS);
+		f_set((int)f_x[i], f_waterY, (int)f_z[i], BLOCK_WATER);
+	}
+
+	// Columns in the tree area that have the highest tree noise, in the same order everywhere
+	// so overlapping trees always overwrite each other the same way
+	int f_treeCount = 0;
+
+	for (int tz = 0; tz < TREE_SIZE_Z; ++tz)
 	{
-		for (int x = 0; x < t_width; ++x)
+		for (int tx = 0; tx < TREE_SIZE_X; ++tx)
 		{
-			float f_arrVal = f_elevationMap[x][z];
-			f_yValue = m_noise->normaliseToRange(f_arrVal, f_min, f_max) * 63.0f;
-			heightMap[x][z] = int(f_yValue);
+			int f_noiseIndex = (tx + TREE_SPACING) * NOISE_SIZE_Z + tz + TREE_SPACING;
 
-			if (f_arrVal < f_waterHeight)
+			if (f_treeNoise[f_noiseIndex] == f_treeMax[f_noiseIndex])
 			{
-				waterMap[x][z] = f_waterHeight - 1;
+				f_x[f_treeCount] = (float)(f_originX - TREE_BORDER + tx);
+				f_z[f_treeCount] = (float)(f_originZ - TREE_BORDER + tz);
+				f_treeCount++;
 			}
-			else
+		}
+	}
+
+	sampleElevation(f_x.data(), f_z.data(), f_elevation.data(), f_treeCount);
+
+	for (int f_tree = 0; f_tree < f_treeCount; ++f_tree)
+	{
+		int x = (int)f_x[f_tree];
+		int y = (int)f_z[f_tree];
+		int f_height = toHeight(f_elevation[f_tree]);
+
+		// Place a tree if it's above the water
+		if (f_height + 1 <= f_waterHeight)
+		{
+			continue;
+		}
+
+		// Slightly random values for the tree height and tree top size, from a hash of the position
+		unsigned int f_hash = Utility::hash(~m_seed, x, y);
+		int f_treeHeight = f_hash % TREE_HEIGHT_RANGE + TREE_MIN_HEIGHT;
+		int f_treeTopScale = (f_hash >> 16) % TREE_TOP_RANGE + TREE_MIN_TOP;
+
+		// Creates tree trunk
+		for (int i = 0; i < f_treeHeight; i++)
+		{
+			f_set(x, f_height + 1 + i, y, BLOCK_TREE);
+		}
+
+		int yBegin = f_height + 1 + f_treeHeight;
+
+		// Creates a pointy tree top
+		int modifier = 0;
+
+		for (int height = yBegin; height < yBegin + f_treeTopScale + 1; ++height)
+		{
+			for (int depth = y - f_treeTopScale + modifier; depth < y + f_treeTopScale - modifier + 1; ++depth)
 			{
-				waterMap[x][z] = 0;
+				for (int width = x - f_treeTopScale + modifier; width < x + f_treeTopScale - modifier + 1; ++width)
+				{
+					f_set(width, height, depth, BLOCK_LEAF);
+				}
 			}
-			
-			//treeMap[x][z] = int(f_yValue);
+
+			modifier += 1;
 		}
 	}
+}
 
-	// Higher frequency value means higher tree density
-	int R = 8;
-	float freq = 16.0f;
+/// <summary>
+/// Finds the max of every window of 2 * t_radius + 1 values along a line (the van Herk/Gil-Werman algorithm).
+/// The line is split into blocks the size of the window and the running max is taken forwards and backwards
+/// through each block. Every window covers the end of one block and the start of the next, so its max is
+/// the max of two running maxes. This takes about three comparisons per value, whatever the radius.
+/// Values past the ends of the line count as zero. t_values and t_results can be the same.
+/// </summary>
+/// <param name="t_values">The first value of the line.</param>
+/// <param name="t_results">Receives the max of the window centred on each value (using the same stride).</param>
+/// <param name="t_count">The number of values in the line.</param>
+/// <param name="t_stride">The distance between neighbouring values of the line.</param>
+/// <param name="t_radius">The number of values either side of the centre of the window.</param>
+void ab::Terrain::maxFilter(const float *t_values, float *t_results, int t_count, int t_stride, int t_radius)
+{
+	int f_window = 2 * t_radius + 1;
+
+	// The line with t_radius zeros at each end, rounded up to a whole number of blocks
+	int f_padded = (t_count + 2 * t_radius + f_window - 1) / f_window * f_window;
+	std::vector<float> f_forward(f_padded);
+	std::vector<float> f_backward(f_padded);
+
+	for (int i = 0; i < f_padded; ++i)
+	{
+		int f_index = i - t_radius;
+		f_forward[i] = (f_index >= 0 && f_index < t_count) ? t_values[f_index * t_stride] : 0.0f;
+		f_backward[i] = f_forward[i];
+	}
+
+	for (int f_block = 0; f_block < f_padded; f_block += f_window)
+	{
+		for (int i = f_block + 1; i < f_block + f_window; ++i)
+		{
+			f_forward[i] = std::max(f_forward[i], f_forward[i - 1]);
+		}
+
+		for (int i = f_block + f_window - 2; i >= f_block; --i)
+		{
+			f_backward[i] = std::max(f_backward[i], f_backward[i + 1]);
+		}
+	}
+
+	// The window centred on value i is padded values i to i + 2 * t_radius
+	for (int i = 0; i < t_count; ++i)
+	{
+		t_results[i * t_stride] = std::max(f_backward[i], f_forward[i + 2 * t_radius]);
+	}
+}
+
+/// <summary>
+/// Evaluates the density function for a batch of voxel positions.
+/// Density falls off with height and 3D noise is added on top, so the ground has caves and overhangs.
+/// Positive density is solid and the surface is where the density is zero.
+/// </summary>
+/// <param name="t_x">The X values of the world positions.</param>
+/// <param name="t_y">The Y values of the world positions.</param>
+/// <param name="t_z">The Z values of the world positions.</param>
+/// <param name="t_density">Receives the density at each position.</param>
+/// <param name="t_count">The number of positions (at most Terrain::DENSITY_POINTS).</param>
+void ab::Terrain::sampleDensity(const float *t_x, const float *t_y, const float *t_z, float *t_density, int t_count) const
+{
+	// Frequencies and weights of the density noise octaves
+	const int OCTAVE_COUNT = 3;
+	const float OCTAVE_FREQUENCY[OCTAVE_COUNT] = { 1.0f, 2.0f, 4.0f };
+	const float OCTAVE_WEIGHT[OCTAVE_COUNT] = { 1.00f, 0.50f, 0.25f };
+
+	float f_sampleX[DENSITY_POINTS];
+	float f_sampleY[DENSITY_POINTS];
+	float f_sampleZ[DENSITY_POINTS];
+	float f_samples[DENSITY_POINTS];
+	float f_noise[DENSITY_POINTS];
+
+	for (int i = 0; i < t_count; ++i)
+	{
+		f_noise[i] = 0.0f;
+	}
 
-	for (int y = 0; y < t_height; y++)
+	for (int f_octave = 0; f_octave < OCTAVE_COUNT; ++f_octave)
 	{
-		for (int x = 0; x < t_width; x++)
+		float f_frequency = OCTAVE_FREQUENCY[f_octave] * DENSITY_FREQUENCY;
+
+		for (int i = 0; i < t_count; ++i)
+		{
+			f_sampleX[i] = f_frequency * t_x[i];
+			f_sampleY[i] = f_frequency * t_y[i];
+			f_sampleZ[i] = f_frequency * t_z[i];
+		}
+
+		m_noise->noise(f_sampleX, f_sampleY, f_sampleZ, f_samples, t_count);
+
+		for (int i = 0; i < t_count; ++i)
+		{
+			f_noise[i] += OCTAVE_WEIGHT[f_octave] * f_samples[i];
+		}
+	}
+
+	for (int i = 0; i < t_count; ++i)
+	{
+		float f_height = (DENSITY_SURFACE_HEIGHT - t_y[i]) / DENSITY_FALLOFF;
+		float f_fbm = f_noise[i] / (1.00f + 0.50f + 0.25f);
+
+		t_density[i] = f_height + (f_fbm - 0.5f) * 2.0f;
+	}
+}
+
+/// <summary>
+/// Gets the density at a single voxel, without any interpolation.
+/// Used to check how closely generateChunkDensity() follows the full resolution density.
+/// </summary>
+/// <param name="x">The voxel's world position X value.</param>
+/// <param name="y">The voxel's world position Y value.</param>
+/// <param name="z">The voxel's world position Z value.</param>
+/// <returns>The density, the voxel is solid if it's positive.</returns>
+float ab::Terrain::getDensity(int x, int y, int z) const
+{
+	float f_x = (float)x;
+	float f_y = (float)y;
+	float f_z = (float)z;
+	float f_density;
+
+	sampleDensity(&f_x, &f_y, &f_z, &f_density, 1);
+
+	return f_density;
+}
+
+/// <summary>
+/// Generates the voxels of a single chunk of density terrain (3D terrain with caves and overhangs, but no trees).
+/// The density is only evaluated every DENSITY_STEP voxels and trilinearly interpolated in between, which
+/// is 64 times fewer noise samples than evaluating every voxel. Interpolated values never go above the
+/// largest corner, so if no lattice point is solid then the whole chunk is air and nothing is interpolated.
+/// Only reads the noise tables, so chunks can be generated on any number of threads at once.
+/// </summary>
+/// <param name="t_chunkPosition">The chunk position.</param>
+/// <param name="t_voxels">Receives the chunk's voxels, using Utility::at() ordering.</param>
+/// <returns>True if any voxel isn't air.</returns>
+bool ab::Terrain::generateChunkDensity(const Indices &t_chunkPosition, char *t_voxels) const
+{
+	int f_originX = t_chunkPosition.x * CHUNK_WIDTH;
+	int f_originY = t_chunkPosition.y * CHUNK_HEIGHT;
+	int f_originZ = t_chunkPosition.z * CHUNK_DEPTH;
+
+	float f_x[DENSITY_POINTS];
+	float f_y[DENSITY_POINTS];
+	float f_z[DENSITY_POINTS];
+	float f_density[DENSITY_POINTS];
+
+	for (int i = 0; i < DENSITY_POINTS; ++i)
+	{
+		Indices f_point = Utility::at(i, DENSITY_POINTS_Y, DENSITY_POINTS_Z);
+		f_x[i] = (float)(f_originX + f_point.x * DENSITY_STEP);
+		f_y[i] = (float)(f_originY + f_point.y * DENSITY_STEP);
+		f_z[i] = (float)(f_originZ + f_point.z * DENSITY_STEP);
+	}
+
+	sampleDensity(f_x, f_y, f_z, f_density, DENSITY_POINTS);
+
+	bool f_anySolid = false;
+
+	for (int i = 0; i < DENSITY_POINTS; ++i)
+	{
+		f_anySolid |= f_density[i] > 0.0f;
+	}
+
+	int f_voxelCount = CHUNK_WIDTH * CHUNK_HEIGHT * CHUNK_DEPTH;
+
+	// All air, apart from any water
+	if (!f_anySolid)
+	{
+		bool f_anyWater = false;
+
+		for (int i = 0; i < f_voxelCount; ++i)
 		{
-			double nx = x / (double)t_width - 0.5;
-			double ny = y / (double)t_height - 0.5;
-			f_treeMap[x][y] = m_noise->noise(freq * nx, freq * ny);
+			Indices f_local = Utility::at(i, CHUNK_HEIGHT, CHUNK_DEPTH);
+			t_voxels[i] = f_originY + f_local.y < WATER_HEIGHT ? BLOCK_WATER : BLOCK_AIR;
+			f_anyWater |= t_voxels[i] != BLOCK_AIR;
 		}
+
+		return f_anyWater;
 	}
 
-	// Set max value
-	for (int yc = 0; yc < t_height; yc++)
+	const float STEP = 1.0f / DENSITY_STEP;
+
+	for (int x = 0; x < CHUNK_WIDTH; ++x)
 	{
-		for (int xc = 0; xc < t_width; xc++)
+		int px = x / DENSITY_STEP;
+		float fx = (x % DENSITY_STEP) * STEP;
+
+		for (int y = 0; y < CHUNK_HEIGHT; ++y)
 		{
-			double max = 0;
+			int py = y / DENSITY_STEP;
+			float fy = (y % DENSITY_STEP) * STEP;
 
-			for (int yn = yc - R; yn <= yc + R; yn++)
+			for (int z = 0; z < CHUNK_DEPTH; ++z)
 			{
-				for (int xn = xc - R; xn <= xc + R; xn++)
+				int pz = z / DENSITY_STEP;
+				float fz = (z % DENSITY_STEP) * STEP;
+
+				// The eight lattice points around the voxel
+				auto f_corner = [&](int dx, int dy, int dz)
 				{
-					if (0 <= yn && yn < t_height && 0 <= xn && xn < t_width)
-					{
-						float e = f_treeMap[xn][yn];
-
-						if (e > max)
-						{
-							max = e;
-						}
-					}
-				}
-			}
+					return f_density[Utility::at(px + dx, py + dy, pz + dz, DENSITY_POINTS_Y, DENSITY_POINTS_Z)];
+				};
 
-			// Place a tree is the current value is equal to the max value
-			if (f_treeMap[xc][yc] == max)
-			{
-				if (heightMap[xc][yc] + 1 > f_waterHeight)
+				float f_x00 = f_corner(0, 0, 0) + (f_corner(1, 0, 0) - f_corner(0, 0, 0)) * fx;
+				float f_x01 = f_corner(0, 0, 1) + (f_corner(1, 0, 1) - f_corner(0, 0, 1)) * fx;
+				float f_x10 = f_corner(0, 1, 0) + (f_corner(1, 1, 0) - f_corner(0, 1, 0)) * fx;
+				float f_x11 = f_corner(0, 1, 1) + (f_corner(1, 1, 1) - f_corner(0, 1, 1)) * fx;
+				float f_y0 = f_x00 + (f_x10 - f_x00) * fy;
+				float f_y1 = f_x01 + (f_x11 - f_x01) * fy;
+				float f_value = f_y0 + (f_y1 - f_y0) * fz;
+
+				char f_type = BLOCK_AIR;
+
+				if (f_value > 0.0f)
 				{
-					treeMap[xc][yc] = heightMap[xc][yc] + 1;
+					f_type = BLOCK_GRASS;
 				}
-			}
-			else
-			{
-				treeMap[xc][yc] = 0;
+				else if (f_originY + y < WATER_HEIGHT)
+				{
+					f_type = BLOCK_WATER;
+				}
+
+				t_voxels[Utility::at(x, y, z, CHUNK_HEIGHT, CHUNK_DEPTH)] = f_type;
 			}
 		}
 	}
+
+	return true;
 }
@@ -1,24 +1,21 @@
 #include "World.h"
+#include "Terrain.h"
+#include "JobSystem.h"
+#include "RegionStore.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
 
 /// <summary>
 /// Constructor for the World class.
+/// The world starts off empty, chunks are only created when voxels are written to them.
 /// </summary>
 World::World()
 {
-	// Set world dimensions
-	int x = WORLD_WIDTH / MAP_WIDTH;
-	int y = WORLD_HEIGHT / MAP_HEIGHT;
-	int z = WORLD_DEPTH / MAP_DEPTH;
-
-	int size = x * y * z; // Array size
-
-	maps.resize(size);
 
-	// Create maps
-	for (unsigned int i = 0; i < size; ++i)
-	{
-		maps[i] = new Map();
-	}
 }
 
 /// <summary>
@@ -26,56 +23,37 @@ World::World()
 /// </summary>
 World::~World()
 {
-	// Set world dimensions
-	int x = WORLD_WIDTH / MAP_WIDTH;
-	int y = WORLD_HEIGHT / MAP_HEIGHT;
-	int z = WORLD_DEPTH / MAP_DEPTH;
-
-	int size = x * y * z; // Array size
-
-	// Delete chunks
-	for (unsigned int i = 0; i < size; ++i)
-	{
-		delete maps[i];
-		maps[i] = nullptr;
-	}
+	chunks.clear();
 }
 
 /// <summary>
-/// Checks maps and chunks to see if they're empty.
-/// If they are, then chunk and/or map deletion occurs.
+/// Checks chunks to see if they're empty.
+/// If they are, then chunk deletion occurs.
+/// Chunks are already removed by setVoxel() when they become empty, so this
+/// is only a safety net in case voxels were written to chunks directly.
 /// </summary>
 void World::optimiseWorldStorage()
 {
-	// Find out how many maps are in the world
-	int world_w = WORLD_WIDTH / MAP_WIDTH;
-	int world_h = WORLD_HEIGHT / MAP_HEIGHT;
-	int world_d = WORLD_DEPTH / MAP_DEPTH;
+	std::vector<Indices> f_emptyChunks;
 
-	for (int z = 0; z < world_d; ++z)
+	chunks.forEach([&](const Indices &t_position, Chunk *t_chunk)
 	{
-		for (int y = 0; y < world_h; ++y)
+		if (t_chunk->checkIsEmpty())
 		{
-			for (int x = 0; x < world_w; ++x)
-			{
-				if (maps[Utility::at(x, y, z, world_h, world_d)] != nullptr)
-				{
-					maps[Utility::at(x, y, z, world_h, world_d)]->checkAllChunks();
-
-					if (maps[Utility::at(x, y, z, world_h, world_d)]->checkIsEmpty())
-					{
-						delete maps[Utility::at(x, y, z, world_h, world_d)];
-						maps[Utility::at(x, y, z, world_h, world_d)] = nullptr;
-					}
-				}
-			}
+			f_emptyChunks.push_back(t_position);
 		}
+	});
+
+	for (const Indices &f_position : f_emptyChunks)
+	{
+		chunks.erase(f_position);
 	}
 }
 
 /// <summary>
 /// Sets a voxel to the specified type.
 /// 0 = AIR / 1 = GRASS / 2 = WATER / 3 - TREE / 4 - LEAF
+/// Voxels above or below the world's height are left alone.
 /// </summary>
 /// <param name="x">The voxel's world position X value.</param>
 /// <param name="y">The voxel's world position Y value.</param>
@@ -83,51 +61,17 @@ void World::optimiseWorldStorage()
 /// <param name="type">The voxel type.</param>
 void World::setVoxel(int x, int y, int z, char type)
 {
-	// Check if voxel is a valid position within the bounds of the world map
-	if (x >= WORLD_WIDTH || x < 0 || y >= WORLD_HEIGHT || y < 0 || z >= WORLD_DEPTH || z < 0)
+	if (!isEditable(y))
 	{
 		return;
 	}
 
-	// Get map array index
-	int mapX = std::floor(x / MAP_WIDTH);
-	int mapY = std::floor(y / MAP_HEIGHT);
-	int mapZ = std::floor(z / MAP_DEPTH);
-
-	// Get chunk array index
-	int offsetX = std::floor(mapX * MAP_WIDTH);
-	int offsetY = std::floor(mapY * MAP_HEIGHT);
-	int offsetZ = std::floor(mapZ * MAP_DEPTH);
-
-	// Get voxel array index
-	int voxX = std::floor(x - offsetX);
-	int voxY = std::floor(y - offsetY);
-	int voxZ = std::floor(z - offsetZ);
-
-	// Get array size
-	int mapH = WORLD_HEIGHT / MAP_HEIGHT;
-	int mapD = WORLD_DEPTH / MAP_DEPTH;
-
-	// Convert 3d index to 1d index
-	int index = Utility::at(mapX, mapY, mapZ, mapH, mapD);
-
-	// If the voxel is being placed somewhere where a map doesn't
-	// exist then create the map
-	if (maps[index] == nullptr)
-	{
-		maps[index] = new Map();
-	}
-
-	// Set voxel type
-	// int voxelIndex = Utility::at(voxX, voxY, voxZ, CHUNK_HEIGHT, CHUNK_DEPTH);
-	maps[index]->setVoxel(voxX, voxY, voxZ, type);
+	Indices f_position = getChunkPosition(x, y, z);
+	Chunk *f_chunk = chunks.find(f_position);
 
-	// If the map is now empty then delete it
-	if (maps[index]->checkIsEmpty())
-	{
-		delete maps[index];
-		maps[index] = nullptr;
-	}
+	EditBounds f_edit = {};
+	writeVoxel(f_chunk, f_position, getVoxelIndex(x, y, z), type, f_edit);
+	finishChunkEdit(f_chunk, f_position, f_edit, true);
 }
 
 /// <summary>
@@ -140,136 +84,754 @@ void World::setVoxel(int x, int y, int z, char type)
 /// <returns>The voxel type.</returns>
 char World::getVoxel(int x, int y, int z)
 {
-	// Check if voxel is a valid position within the bounds of the world map
-	if (x >= WORLD_WIDTH || x < 0 || y >= WORLD_HEIGHT || y < 0 || z >= WORLD_DEPTH || z < 0)
+	Chunk *f_chunk = chunks.find(getChunkPosition(x, y, z));
+
+	// If the chunk doesn't exist then the voxel is air
+	if (f_chunk == nullptr)
 	{
 		return 0;
 	}
 
-	// Get map array index
-	int mapX = std::floor(x / MAP_WIDTH);
-	int mapY = std::floor(y / MAP_HEIGHT);
-	int mapZ = std::floor(z / MAP_DEPTH);
+	return f_chunk->getVoxel(getVoxelIndex(x, y, z));
+}
+
+/// <summary>
+/// Sets every voxel in a box to the specified type.
+/// The box includes both corners and the corners can be given in any order.
+/// Each chunk is only marked dirty once, and the part of the box above or below the world's height is left alone.
+/// </summary>
+/// <param name="x1">The X value of the first corner.</param>
+/// <param name="y1">The Y value of the first corner.</param>
+/// <param name="z1">The Z value of the first corner.</param>
+/// <param name="x2">The X value of the second corner.</param>
+/// <param name="y2">The Y value of the second corner.</param>
+/// <param name="z2">The Z value of the second corner.</param>
+/// <param name="type">The voxel type.</param>
+void World::fillBox(int x1, int y1, int z1, int x2, int y2, int z2, char type)
+{
+	Indices f_min = { std::min(x1, x2), std::min(y1, y2), std::min(z1, z2) };
+	Indices f_max = { std::max(x1, x2), std::max(y1, y2), std::max(z1, z2) };
+
+	forEachChunkInBox(f_min, f_max, [&](const Indices &t_position, const Indices &t_start, const Indices &t_end)
+	{
+		Chunk *f_chunk = chunks.find(t_position);
+
+		if (f_chunk == nullptr && type == 0)
+		{
+			return; // Already air
+		}
+
+		EditBounds f_edit = {};
+
+		for (int x = t_start.x; x <= t_end.x; ++x)
+		{
+			for (int y = t_start.y; y <= t_end.y; ++y)
+			{
+				for (int z = t_start.z; z <= t_end.z; ++z)
+				{
+					writeVoxel(f_chunk, t_position, getVoxelIndex(x, y, z), type, f_edit);
+				}
+			}
+		}
 
-	// Get chunk array index
-	int offsetX = std::floor(mapX * MAP_WIDTH);
-	int offsetY = std::floor(mapY * MAP_HEIGHT);
-	int offsetZ = std::floor(mapZ * MAP_DEPTH);
+		finishChunkEdit(f_chunk, t_position, f_edit, true);
+	});
+}
 
-	// Get voxel array index
-	int voxX = std::floor(x - offsetX);
-	int voxY = std::floor(y - offsetY);
-	int voxZ = std::floor(z - offsetZ);
+/// <summary>
+/// Applies a list of voxel edits.
+/// The edits are grouped by chunk so each chunk is looked up and marked dirty once. If the same voxel is edited more than
+/// once then the last edit in the list wins. Edits above or below the world's height are skipped.
+/// </summary>
+/// <param name="edits">The edits to apply.</param>
+void World::setVoxels(const std::vector<VoxelEdit> &edits)
+{
+	struct ChunkEdit
+	{
+		Indices position;
+		int index;
+		char type;
+	};
 
-	// Convert 3d index to 1d index
-	int index = Utility::at(mapX, mapY, mapZ, MAP_HEIGHT, MAP_DEPTH);
+	std::vector<ChunkEdit> f_sorted;
+	f_sorted.reserve(edits.size());
 
-	// If the voxel doesn't exist then return air
-	if (maps[index] == nullptr)
+	for (const VoxelEdit &f_edit : edits)
 	{
-		return 0;
+		if (!isEditable(f_edit.y))
+		{
+			continue;
+		}
+
+		f_sorted.push_back({ getChunkPosition(f_edit.x, f_edit.y, f_edit.z), getVoxelIndex(f_edit.x, f_edit.y, f_edit.z), f_edit.type });
+	}
+
+	auto f_compare = [](const ChunkEdit &a, const ChunkEdit &b)
+	{
+		if (a.position.x != b.position.x) return a.position.x < b.position.x;
+		if (a.position.y != b.position.y) return a.position.y < b.position.y;
+		return a.position.z < b.position.z;
+	};
+
+	// A stable sort keeps the edits to each chunk in their original order
+	if (!std::is_sorted(f_sorted.begin(), f_sorted.end(), f_compare))
+	{
+		std::stable_sort(f_sorted.begin(), f_sorted.end(), f_compare);
 	}
 
-	// Return voxel type
-	return maps[index]->getVoxel(voxX, voxY, voxZ);
+	std::size_t i = 0;
+
+	while (i < f_sorted.size())
+	{
+		Indices f_position = f_sorted[i].position;
+		Chunk *f_chunk = chunks.find(f_position);
+		EditBounds f_edit = {};
+
+		// Apply every edit for this chunk
+		for (; i < f_sorted.size() && f_sorted[i].position == f_position; ++i)
+		{
+			writeVoxel(f_chunk, f_position, f_sorted[i].index, f_sorted[i].type, f_edit);
+		}
+
+		finishChunkEdit(f_chunk, f_position, f_edit, true);
+	}
 }
 
 /// <summary>
-/// This function populates the map with grass, water and trees.
-/// 0 = AIR / 1 = GRASS / 2 = WATER / 3 - TREE / 4 - LEAF
+/// Stamps a voxel template into the world. Air voxels in the template are skipped, and so is any part of
+/// the template above or below the world's height. Each chunk is only marked dirty once.
 /// </summary>
-/// <param name="heightMap">An array of height map values.</param>
-void World::populate(int heightMap[WORLD_WIDTH][WORLD_DEPTH], int treeMap[WORLD_WIDTH][WORLD_DEPTH], int waterMap[WORLD_WIDTH][WORLD_DEPTH])
+/// <param name="voxelTemplate">The template to stamp.</param>
+/// <param name="x">The world position X value of the template's minimum corner.</param>
+/// <param name="y">The world position Y value of the template's minimum corner.</param>
+/// <param name="z">The world position Z value of the template's minimum corner.</param>
+void World::stamp(const VoxelTemplate &voxelTemplate, int x, int y, int z)
 {
-	// Find out how many maps are in the world
-	Indices world;
-	world.x = WORLD_WIDTH / MAP_WIDTH;
-	world.y = WORLD_HEIGHT / MAP_HEIGHT;
-	world.z = WORLD_DEPTH / MAP_DEPTH;
-
-	// Offset
-	int offsetX = MAP_WIDTH;
-	int offsetY = MAP_DEPTH;
+	if (voxelTemplate.width <= 0 || voxelTemplate.height <= 0 || voxelTemplate.depth <= 0)
+	{
+		return;
+	}
 
-	// Temp arrays
-	auto heightMapSection = new int[MAP_WIDTH][MAP_DEPTH];
-	auto treeMapSection = new int[MAP_WIDTH][MAP_DEPTH];
-	auto waterMapSection = new int[MAP_WIDTH][MAP_DEPTH];
+	Indices f_min = { x, y, z };
+	Indices f_max = { x + voxelTemplate.width - 1, y + voxelTemplate.height - 1, z + voxelTemplate.depth - 1 };
 
-	// Divide world into map sections for population
-	for (int z = 0; z < world.z; ++z)
+	forEachChunkInBox(f_min, f_max, [&](const Indices &t_position, const Indices &t_start, const Indices &t_end)
 	{
-		for (int y = 0; y < world.y; ++y)
+		Chunk *f_chunk = chunks.find(t_position);
+		EditBounds f_edit = {};
+
+		for (int wx = t_start.x; wx <= t_end.x; ++wx)
 		{
-			for (int x = 0; x < world.x; ++x)
+			for (int wy = t_start.y; wy <= t_end.y; ++wy)
 			{
-				if (maps[Utility::at(x, y, z, world.y, world.z)] != nullptr)
+				for (int wz = t_start.z; wz <= t_end.z; ++wz)
 				{
-					for (int mY = 0; mY < MAP_DEPTH; ++mY)
+					char f_type = voxelTemplate.voxels[Utility::at(wx - x, wy - y, wz - z, voxelTemplate.height, voxelTemplate.depth)];
+
+					if (f_type != 0)
 					{
-						for (int mX = 0; mX < MAP_WIDTH; ++mX)
-						{
-							heightMapSection[mX][mY] = heightMap[mX + (x * offsetX)][mY + (z * offsetY)];
-							treeMapSection[mX][mY] = treeMap[mX + (x * offsetX)][mY + (z * offsetY)];
-							waterMapSection[mX][mY] = waterMap[mX + (x * offsetX)][mY + (z * offsetY)];
-						}
+						writeVoxel(f_chunk, t_position, getVoxelIndex(wx, wy, wz), f_type, f_edit);
 					}
-
-					// Populate map
-					maps[Utility::at(x, y, z, world.y, world.z)]->populate(heightMapSection, treeMapSection, waterMapSection);
 				}
 			}
 		}
+
+		finishChunkEdit(f_chunk, t_position, f_edit, true);
+	});
+}
+
+/// <summary>
+/// Marks a chunk as needing to be meshed again.
+/// </summary>
+/// <param name="position">The chunk position.</param>
+void World::markDirty(const Indices &position)
+{
+	// Edits often hit the same chunk many times in a row (e.g. populate()), so skip the set lookup
+	if (!m_dirtyChunks.empty() && m_dirtyChunks.back() == position)
+	{
+		return;
+	}
+
+	if (m_dirtySet.insert(position).second)
+	{
+		m_dirtyChunks.push_back(position);
 	}
+}
+
+/// <summary>
+/// Moves the dirty chunks into a list (in the order they were marked) and clears them.
+/// Chunks in the list may no longer exist if an edit emptied them.
+/// </summary>
+/// <param name="positions">The dirty chunk positions are added to the end of this list.</param>
+void World::takeDirtyChunks(std::vector<Indices> &positions)
+{
+	positions.insert(positions.end(), m_dirtyChunks.begin(), m_dirtyChunks.end());
+	clearDirtyChunks();
+}
+
+/// <summary>
+/// Clears the dirty chunks without returning them (e.g. after meshing the whole world).
+/// </summary>
+void World::clearDirtyChunks()
+{
+	m_dirtyChunks.clear();
+	m_dirtySet.clear();
+}
+
+/// <summary>
+/// Gets the number of dirty chunks.
+/// </summary>
+/// <returns>The number of dirty chunks.</returns>
+std::size_t World::getDirtyCount() const
+{
+	return m_dirtyChunks.size();
+}
+
+/// <summary>
+/// Checks if a column has been edited (by setVoxel(), fillBox(), setVoxels() or stamp()) since it was loaded.
+/// Loading voxels with setChunkVoxels() doesn't count as an edit.
+/// </summary>
+/// <param name="columnX">The X position of the column (in chunks).</param>
+/// <param name="columnZ">The Z position of the column (in chunks).</param>
+/// <returns>True if the column has been edited.</returns>
+bool World::isColumnModified(int columnX, int columnZ) const
+{
+	return m_modifiedColumns.count({ columnX, 0, columnZ }) > 0;
+}
 
-	placeScenery(treeMap);
+/// <summary>
+/// Forgets that a column has been edited, e.g. once it's been saved.
+/// </summary>
+/// <param name="columnX">The X position of the column (in chunks).</param>
+/// <param name="columnZ">The Z position of the column (in chunks).</param>
+void World::clearColumnModified(int columnX, int columnZ)
+{
+	m_modifiedColumns.erase({ columnX, 0, columnZ });
 }
 
 /// <summary>
-/// Place scenery.
-/// Currently places trees on the map using a generated noise map.
+/// Counts the loaded chunks and their voxels. This visits every chunk, so it's too slow to call every frame.
 /// </summary>
-/// <param name="treeMap"></param>
-void World::placeScenery(int treeMap[WORLD_WIDTH][WORLD_DEPTH])
+/// <returns>The stats.</returns>
+World::Stats World::getStats() const
 {
-	for (int y = 0; y < WORLD_DEPTH; ++y)
+	Stats f_stats = { chunks.getCount(), 0, chunks.getMemoryUsage() };
+
+	chunks.forEach([&](const Indices &t_position, Chunk *t_chunk)
 	{
-		for (int x = 0; x < WORLD_WIDTH; ++x)
+		f_stats.solidVoxels += t_chunk->getSolidCount();
+	});
+
+	return f_stats;
+}
+
+/// <summary>
+/// Casts a ray through the world and finds the first voxel that isn't air.
+/// Uses the Amanatides and Woo voxel traversal, stepping one voxel at a time through chunks
+/// that exist and jumping straight across chunks that don't (they're all air), so the cost
+/// depends on how far the ray travels rather than how many voxels there are.
+/// Voxels are unit cubes centred on their positions, the same as they're drawn.
+/// </summary>
+/// <param name="origin">The ray's origin point.</param>
+/// <param name="direction">The ray's direction (doesn't need to be normalised).</param>
+/// <param name="maxDistance">The furthest distance to check.</param>
+/// <param name="hit">Stores the information about the voxel that was hit.</param>
+/// <returns>True if a voxel was hit.</returns>
+bool World::raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, RaycastHit &hit)
+{
+	float f_length = glm::length(direction);
+
+	if (f_length == 0.0f)
+	{
+		return false;
+	}
+
+	const float f_infinity = std::numeric_limits<float>::infinity();
+	const int f_chunkSize[3] = { CHUNK_WIDTH, CHUNK_HEIGHT, CHUNK_DEPTH };
+
+	// Shift by half a voxel so that voxel n covers [n, n + 1)
+	glm::vec3 f_start = origin + glm::vec3(0.5f);
+	glm::vec3 f_direction = direction / f_length;
+
+	int f_voxel[3];
+	int f_step[3];
+	float f_tMax[3]; // Distance along the ray to the next voxel boundary on each axis
+	float f_tDelta[3]; // Distance along the ray between voxel boundaries on each axis
+
+	for (int a = 0; a < 3; ++a)
+	{
+		f_voxel[a] = (int)std::floor(f_start[a]);
+
+		if (f_direction[a] > 0.0f)
+		{
+			f_step[a] = 1;
+			f_tDelta[a] = 1.0f / f_direction[a];
+			f_tMax[a] = (f_voxel[a] + 1 - f_start[a]) * f_tDelta[a];
+		}
+		else if (f_direction[a] < 0.0f)
+		{
+			f_step[a] = -1;
+			f_tDelta[a] = -1.0f / f_direction[a];
+			f_tMax[a] = (f_start[a] - f_voxel[a]) * f_tDelta[a];
+		}
+		else
 		{
-			if (treeMap[x][y] == 0) // 0 means no tree
+			f_step[a] = 0;
+			f_tDelta[a] = f_infinity;
+			f_tMax[a] = f_infinity;
+		}
+	}
+
+	float f_distance = 0.0f;
+	int f_normalAxis = -1;
+	Indices f_previous = { f_voxel[0], f_voxel[1], f_voxel[2] };
+
+	while (f_distance <= maxDistance)
+	{
+		Indices f_chunkPosition = getChunkPosition(f_voxel[0], f_voxel[1], f_voxel[2]);
+		Chunk *f_chunk = chunks.find(f_chunkPosition);
+
+		if (f_chunk != nullptr)
+		{
+			char f_type = f_chunk->getVoxel(getVoxelIndex(f_voxel[0], f_voxel[1], f_voxel[2]));
+
+			if (f_type != 0)
+			{
+				// There's no face normal if the ray starts inside a voxel
+				int f_normal[3] = { 0, 0, 0 };
+
+				if (f_normalAxis >= 0)
+				{
+					f_normal[f_normalAxis] = -f_step[f_normalAxis];
+				}
+
+				hit.voxel = { f_voxel[0], f_voxel[1], f_voxel[2] };
+				hit.previous = f_previous;
+				hit.normal = { f_normal[0], f_normal[1], f_normal[2] };
+				hit.distance = f_distance;
+				hit.type = f_type;
+
+				return true;
+			}
+
+			f_previous = { f_voxel[0], f_voxel[1], f_voxel[2] };
+
+			// Step to the next voxel
+			int f_axis = f_tMax[0] < f_tMax[1] ? (f_tMax[0] < f_tMax[2] ? 0 : 2) : (f_tMax[1] < f_tMax[2] ? 1 : 2);
+
+			f_distance = f_tMax[f_axis];
+			f_voxel[f_axis] += f_step[f_axis];
+			f_tMax[f_axis] += f_tDelta[f_axis];
+			f_normalAxis = f_axis;
+
+			continue;
+		}
+
+		// The chunk doesn't exist so it's all air, find where the ray leaves it.
+		// On each axis the ray has to cross f_crossings[a] more boundaries to get out of the chunk.
+		const int f_chunkStart[3] = { f_chunkPosition.x, f_chunkPosition.y, f_chunkPosition.z };
+		int f_crossings[3];
+		int f_exitAxis = 0;
+		float f_exit = f_infinity;
+
+		for (int a = 0; a < 3; ++a)
+		{
+			int f_first = f_chunkStart[a] * f_chunkSize[a];
+			f_crossings[a] = f_step[a] > 0 ? f_first + f_chunkSize[a] - f_voxel[a] : f_voxel[a] - f_first + 1;
+
+			float f_axisExit = f_tMax[a] + (f_crossings[a] - 1) * f_tDelta[a];
+
+			if (f_step[a] != 0 && f_axisExit < f_exit)
+			{
+				f_exit = f_axisExit;
+				f_exitAxis = a;
+			}
+		}
+
+		// Move to the last voxel in the chunk, counting the boundaries that are crossed before the exit
+		for (int a = 0; a < 3; ++a)
+		{
+			if (f_step[a] == 0 || a == f_exitAxis)
 			{
 				continue;
 			}
 
-			// Generate slightly random values for the tree height and tree top size
-			int f_treeHeight = rand() % 7 + 4;
-			int f_treeTopScale = rand() % 4 + 4;
+			int f_count = (int)std::ceil((f_exit - f_tMax[a]) / f_tDelta[a]);
+			f_count = std::max(0, std::min(f_count, f_crossings[a] - 1));
+
+			f_voxel[a] += f_step[a] * f_count;
+			f_tMax[a] += f_tDelta[a] * f_count;
+		}
+
+		f_voxel[f_exitAxis] += f_step[f_exitAxis] * (f_crossings[f_exitAxis] - 1);
+		f_previous = { f_voxel[0], f_voxel[1], f_voxel[2] };
+
+		// Then step out of the chunk
+		f_distance = f_exit;
+		f_voxel[f_exitAxis] += f_step[f_exitAxis];
+		f_tMax[f_exitAxis] = f_exit + f_tDelta[f_exitAxis];
+		f_normalAxis = f_exitAxis;
+	}
 
-			// Creates tree trunk
-			for (int i = 0; i < f_treeHeight; i++)
+	return false;
+}
+
+/// <summary>
+/// This function populates the map with grass, water and trees (or density terrain), a column of chunks at a time.
+/// Columns are generated in batches on the job system and then written into the world on this thread,
+/// so the chunk table is never touched by more than one thread.
+/// With a cache, columns that are already in it are read instead of generated, and the rest are added to it.
+/// </summary>
+/// <param name="terrain">The terrain to generate the columns with.</param>
+/// <param name="jobs">The job system used to generate columns in parallel (or nullptr to generate on this thread).</param>
+/// <param name="cache">The generated columns for this terrain (see Terrain::getCacheDirectory()), or nullptr to always generate.</param>
+void World::populate(const ab::Terrain &terrain, ab::JobSystem *jobs, RegionStore *cache)
+{
+	const int COLUMNS_X = WORLD_WIDTH / CHUNK_WIDTH;
+	const int COLUMNS_Z = WORLD_DEPTH / CHUNK_DEPTH;
+	const int COLUMN_COUNT = COLUMNS_X * COLUMNS_Z;
+	const int BATCH_SIZE = 64; // Columns generated before they're written to the world (2MB of voxels)
+
+	std::vector<char> f_voxels((std::size_t)BATCH_SIZE * ab::Terrain::COLUMN_VOXELS);
+	std::unique_ptr<bool[]> f_used(new bool[BATCH_SIZE * ab::Terrain::COLUMN_CHUNKS]); // Not vector<bool>, different threads write neighbouring entries
+	std::unique_ptr<bool[]> f_generated(new bool[BATCH_SIZE]);
+	bool f_cacheChanged = false;
+
+	for (int f_first = 0; f_first < COLUMN_COUNT; f_first += BATCH_SIZE)
+	{
+		int f_count = std::min(BATCH_SIZE, COLUMN_COUNT - f_first);
+
+		auto f_generate = [&](int t_begin, int t_end)
+		{
+			for (int i = t_begin; i < t_end; ++i)
 			{
-				setVoxel(x, treeMap[x][y] + i, y, 3); // Tree
+				int f_column = f_first + i;
+				char *f_columnVoxels = &f_voxels[(std::size_t)i * ab::Terrain::COLUMN_VOXELS];
+				bool *f_columnUsed = &f_used[i * ab::Terrain::COLUMN_CHUNKS];
+				f_generated[i] = cache == nullptr || !cache->readColumn(f_column / COLUMNS_Z, f_column % COLUMNS_Z, f_columnVoxels, f_columnUsed);
+
+				if (f_generated[i])
+				{
+					terrain.generateColumn(f_column / COLUMNS_Z, f_column % COLUMNS_Z, f_columnVoxels, f_columnUsed);
+				}
 			}
+		};
 
-			int yBegin = treeMap[x][y] + f_treeHeight;
+		if (jobs != nullptr)
+		{
+			jobs->parallelFor(0, f_count, 1, f_generate);
+		}
+		else
+		{
+			f_generate(0, f_count);
+		}
 
-			// Creates a pointy tree top of a random size
-			int modifier = 0;
+		for (int i = 0; i < f_count; ++i)
+		{
+			int f_column = f_first + i;
 
-			for (int height = yBegin; height < yBegin + f_treeTopScale + 1; ++height)
+			for (int cy = 0; cy < ab::Terrain::COLUMN_CHUNKS; ++cy)
 			{
-				for (int depth = y - f_treeTopScale + modifier; depth < y + f_treeTopScale - modifier + 1; ++depth)
+				if (f_used[i * ab::Terrain::COLUMN_CHUNKS + cy])
 				{
-					for (int width = x - f_treeTopScale + modifier; width < x + f_treeTopScale - modifier + 1; ++width)
-					{
-						setVoxel(width, height, depth, 4); // Leaf
-					}
+					const char *f_chunkVoxels = &f_voxels[(std::size_t)i * ab::Terrain::COLUMN_VOXELS + cy * ab::Terrain::CHUNK_VOXELS];
+					setChunkVoxels({ f_column / COLUMNS_Z, cy, f_column % COLUMNS_Z }, f_chunkVoxels);
+				}
+			}
+
+			if (cache != nullptr && f_generated[i])
+			{
+				cache->writeColumn(f_column / COLUMNS_Z, f_column % COLUMNS_Z, &f_voxels[(std::size_t)i * ab::Terrain::COLUMN_VOXELS], &f_used[i * ab::Terrain::COLUMN_CHUNKS]);
+				f_cacheChanged = true;
+			}
+		}
+	}
+
+	if (f_cacheChanged)
+	{
+		cache->flush();
+	}
+}
+
+/// <summary>
+/// Replaces every voxel in a chunk. The chunk is only marked dirty once.
+/// </summary>
+/// <param name="position">The chunk position.</param>
+/// <param name="voxels">The chunk's voxels, using Utility::at() ordering.</param>
+void World::setChunkVoxels(const Indices &position, const char *voxels)
+{
+	Chunk *f_chunk = chunks.find(position);
+	EditBounds f_edit = {};
+
+	for (int i = 0; i < CHUNK_WIDTH * CHUNK_HEIGHT * CHUNK_DEPTH; ++i)
+	{
+		writeVoxel(f_chunk, position, i, voxels[i], f_edit);
+	}
+
+	finishChunkEdit(f_chunk, position, f_edit, false);
+}
+
+/// <summary>
+/// Removes a chunk from the world without marking its neighbours dirty (e.g. when it's too far from the camera).
+/// The chunk itself is marked dirty so its mesh gets deleted.
+/// </summary>
+/// <param name="position">The chunk position.</param>
+void World::unloadChunk(const Indices &position)
+{
+	if (chunks.erase(position))
+	{
+		markDirty(position);
+	}
+}
+
+/// <summary>
+/// Copies the voxels of a column of chunks, in the same layout as Terrain::generateColumn().
+/// </summary>
+/// <param name="columnX">The X position of the column (in chunks).</param>
+/// <param name="columnZ">The Z position of the column (in chunks).</param>
+/// <param name="voxels">Filled with the column's voxels, one chunk after another from the bottom up.</param>
+/// <param name="used">Filled with whether each chunk has anything other than air in it.</param>
+void World::copyColumn(int columnX, int columnZ, char *voxels, bool *used) const
+{
+	for (int cy = 0; cy < ab::RegionFile::COLUMN_CHUNKS; ++cy)
+	{
+		Chunk *f_chunk = chunks.find({ columnX, cy, columnZ });
+		char *f_voxels = voxels + cy * ab::RegionFile::CHUNK_VOXELS;
+		used[cy] = f_chunk != nullptr && f_chunk->getSolidCount() > 0;
+
+		if (!used[cy])
+		{
+			std::memset(f_voxels, 0, ab::RegionFile::CHUNK_VOXELS);
+			continue;
+		}
+
+		for (int i = 0; i < ab::RegionFile::CHUNK_VOXELS; ++i)
+		{
+			f_voxels[i] = f_chunk->getVoxel(i);
+		}
+	}
+}
+
+/// <summary>
+/// Saves every column that has chunks in it to a set of region files.
+/// </summary>
+/// <param name="regions">The region files to save to.</param>
+/// <returns>True if the region files were written.</returns>
+bool World::save(RegionStore &regions) const
+{
+	std::unordered_set<Indices, IndicesHash> f_columns;
+
+	chunks.forEach([&](const Indices &t_position, Chunk *t_chunk)
+	{
+		f_columns.insert({ t_position.x, 0, t_position.z });
+	});
+
+	for (const Indices &f_column : f_columns)
+	{
+		regions.writeColumn(f_column.x, f_column.z, *this);
+	}
+
+	return regions.flush();
+}
+
+/// <summary>
+/// Loads a saved column of chunks, replacing whatever is there.
+/// Only the chunks of this column are read from the region file.
+/// </summary>
+/// <param name="regions">The region files to load from.</param>
+/// <param name="columnX">The X position of the column (in chunks).</param>
+/// <param name="columnZ">The Z position of the column (in chunks).</param>
+/// <returns>True if the column was loaded, false if it hasn't been saved.</returns>
+bool World::loadColumn(RegionStore &regions, int columnX, int columnZ)
+{
+	std::vector<char> f_voxels(ab::RegionFile::COLUMN_CHUNKS * ab::RegionFile::CHUNK_VOXELS);
+	bool f_used[ab::RegionFile::COLUMN_CHUNKS];
+
+	if (!regions.readColumn(columnX, columnZ, f_voxels.data(), f_used))
+	{
+		return false;
+	}
+
+	for (int cy = 0; cy < ab::RegionFile::COLUMN_CHUNKS; ++cy)
+	{
+		Indices f_position = { columnX, cy, columnZ };
+
+		// Air chunks only need writing if there's a chunk to clear
+		if (f_used[cy] || chunks.find(f_position) != nullptr)
+		{
+			setChunkVoxels(f_position, &f_voxels[cy * ab::RegionFile::CHUNK_VOXELS]);
+		}
+	}
+
+	clearColumnModified(columnX, columnZ);
+
+	return true;
+}
+
+/// <summary>
+/// Writes a voxel to a chunk as part of an edit.
+/// The chunk is created the first time something other than air is written to it.
+/// </summary>
+/// <param name="t_chunk">The chunk, or nullptr if it doesn't exist yet.</param>
+/// <param name="t_position">The chunk position.</param>
+/// <param name="t_index">The voxel's 1D array index within the chunk.</param>
+/// <param name="t_type">The voxel type.</param>
+/// <param name="t_edit">Grown to include the voxel if it changed.</param>
+/// <returns>True if the voxel changed.</returns>
+bool World::writeVoxel(Chunk *&t_chunk, const Indices &t_position, int t_index, char t_type, EditBounds &t_edit)
+{
+	if (t_chunk == nullptr)
+	{
+		if (t_type == 0)
+		{
+			return false; // Air doesn't need a chunk
+		}
+
+		t_chunk = chunks.findOrCreate(t_position);
+	}
+
+	if (t_chunk->getVoxel(t_index) == t_type)
+	{
+		return false;
+	}
+
+	t_chunk->setVoxel(t_index, t_type);
+
+	// Local position from the index (the inverse of Utility::at())
+	Indices f_local = { t_index >> (CHUNK_HEIGHT_SHIFT + CHUNK_DEPTH_SHIFT), (t_index >> CHUNK_DEPTH_SHIFT) & (CHUNK_HEIGHT - 1), t_index & (CHUNK_DEPTH - 1) };
+
+	if (!t_edit.changed)
+	{
+		t_edit.changed = true;
+		t_edit.min = f_local;
+		t_edit.max = f_local;
+	}
+	else
+	{
+		t_edit.min = { std::min(t_edit.min.x, f_local.x), std::min(t_edit.min.y, f_local.y), std::min(t_edit.min.z, f_local.z) };
+		t_edit.max = { std::max(t_edit.max.x, f_local.x), std::max(t_edit.max.y, f_local.y), std::max(t_edit.max.z, f_local.z) };
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Finishes editing a chunk.
+/// Deletes the chunk if it's now empty and marks it dirty if it changed. Chunk meshes look one
+/// voxel past their edges (for culling and ambient occlusion), so if the changed voxels touch
+/// the chunk's border then the existing chunks on the other side are marked dirty as well.
+/// </summary>
+/// <param name="t_chunk">The chunk, or nullptr if it doesn't exist.</param>
+/// <param name="t_position">The chunk position.</param>
+/// <param name="t_edit">The voxels that changed.</param>
+/// <param name="t_modified">True for edits to the world (rather than loading it), so the column is saved again when it's unloaded.</param>
+void World::finishChunkEdit(Chunk *t_chunk, const Indices &t_position, const EditBounds &t_edit, bool t_modified)
+{
+	if (!t_edit.changed)
+	{
+		return;
+	}
+
+	if (t_modified)
+	{
+		m_modifiedColumns.insert({ t_position.x, 0, t_position.z });
+	}
+
+	if (t_chunk->checkIsEmpty())
+	{
+		chunks.erase(t_position);
+	}
+
+	markDirty(t_position);
+
+	Indices f_from = { t_edit.min.x == 0 ? -1 : 0, t_edit.min.y == 0 ? -1 : 0, t_edit.min.z == 0 ? -1 : 0 };
+	Indices f_to = { t_edit.max.x == CHUNK_WIDTH - 1 ? 1 : 0, t_edit.max.y == CHUNK_HEIGHT - 1 ? 1 : 0, t_edit.max.z == CHUNK_DEPTH - 1 ? 1 : 0 };
+
+	for (int dx = f_from.x; dx <= f_to.x; ++dx)
+	{
+		for (int dy = f_from.y; dy <= f_to.y; ++dy)
+		{
+			for (int dz = f_from.z; dz <= f_to.z; ++dz)
+			{
+				Indices f_neighbour = { t_position.x + dx, t_position.y + dy, t_position.z + dz };
+
+				// Chunks that don't exist have no mesh to update
+				if ((dx != 0 || dy != 0 || dz != 0) && chunks.find(f_neighbour) != nullptr)
+				{
+					markDirty(f_neighbour);
 				}
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Calls a function for every chunk that a box overlaps, along with the part of the box inside that chunk.
+/// The box is cut down to the world's height first, so the function is only called for chunks that can be edited.
+/// </summary>
+/// <param name="t_min">The minimum corner of the box (world position).</param>
+/// <param name="t_max">The maximum corner of the box (world position).</param>
+/// <param name="t_function">The function to call with the chunk position and the first and last voxels (world position) inside the chunk.</param>
+void World::forEachChunkInBox(const Indices &t_min, const Indices &t_max, const std::function<void(const Indices &, const Indices &, const Indices &)> &t_function)
+{
+	Indices f_min = { t_min.x, std::max(t_min.y, 0), t_min.z };
+	Indices f_max = { t_max.x, std::min(t_max.y, WORLD_HEIGHT - 1), t_max.z };
+
+	if (f_min.y > f_max.y)
+	{
+		return;
+	}
+
+	Indices f_minChunk = getChunkPosition(f_min.x, f_min.y, f_min.z);
+	Indices f_maxChunk = getChunkPosition(f_max.x, f_max.y, f_max.z);
+
+	for (int cx = f_minChunk.x; cx <= f_maxChunk.x; ++cx)
+	{
+		for (int cy = f_minChunk.y; cy <= f_maxChunk.y; ++cy)
+		{
+			for (int cz = f_minChunk.z; cz <= f_maxChunk.z; ++cz)
+			{
+				Indices f_start = { std::max(f_min.x, cx * CHUNK_WIDTH), std::max(f_min.y, cy * CHUNK_HEIGHT), std::max(f_min.z, cz * CHUNK_DEPTH) };
+				Indices f_end = { std::min(f_max.x, cx * CHUNK_WIDTH + CHUNK_WIDTH - 1), std::min(f_max.y, cy * CHUNK_HEIGHT + CHUNK_HEIGHT - 1), std::min(f_max.z, cz * CHUNK_DEPTH + CHUNK_DEPTH - 1) };
 
-				modifier += 1;
+				t_function({ cx, cy, cz }, f_start, f_end);
 			}
 		}
 	}
 }
 
+/// <summary>
+/// Gets the position of the chunk that a voxel is in.
+/// </summary>
+/// <param name="x">The voxel's world position X value.</param>
+/// <param name="y">The voxel's world position Y value.</param>
+/// <param name="z">The voxel's world position Z value.</param>
+/// <returns>The chunk position.</returns>
+Indices World::getChunkPosition(int x, int y, int z)
+{
+	// Arithmetic shifts round towards negative infinity, so negative positions work too
+	return { x >> CHUNK_WIDTH_SHIFT, y >> CHUNK_HEIGHT_SHIFT, z >> CHUNK_DEPTH_SHIFT };
+}
+
+/// <summary>
+/// Checks if voxels at a height can be edited. Saved columns (and the chunks the streamer unloads) only
+/// go from 0 to WORLD_HEIGHT - 1, so chunks outside that would never be saved or unloaded.
+/// </summary>
+/// <param name="y">The voxel's world position Y value.</param>
+/// <returns>True if the height is within the world.</returns>
+bool World::isEditable(int y)
+{
+	return y >= 0 && y < WORLD_HEIGHT;
+}
 
+/// <summary>
+/// Gets the 1D array index of a voxel within its chunk.
+/// </summary>
+/// <param name="x">The voxel's world position X value.</param>
+/// <param name="y">The voxel's world position Y value.</param>
+/// <param name="z">The voxel's world position Z value.</param>
+/// <returns>The voxel index within the chunk.</returns>
+int World::getVoxelIndex(int x, int y, int z)
+{
+	return Utility::at(x & (CHUNK_WIDTH - 1), y & (CHUNK_HEIGHT - 1), z & (CHUNK_DEPTH - 1), CHUNK_HEIGHT, CHUNK_DEPTH);
+}